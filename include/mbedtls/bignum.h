@@ -75,6 +75,19 @@
 
 #define MBEDTLS_MPI_MAX_BITS                              (8 * MBEDTLS_MPI_MAX_SIZE)      /**< Maximum number of bits for usable MPIs. */
 
+#if defined(MBEDTLS_MPI_SMALL_BUFFER)
+#if !defined(MBEDTLS_MPI_INLINE_LIMBS)
+/*
+ * Number of limbs stored inside each MPI when MBEDTLS_MPI_SMALL_BUFFER is
+ * enabled. Default: 17, which holds the products of 256-bit numbers with
+ * 32-bit limbs and of 384-bit numbers with 64-bit limbs.
+ */
+#define MBEDTLS_MPI_INLINE_LIMBS                          17       /**< Number of limbs stored inside each MPI. */
+#elif MBEDTLS_MPI_INLINE_LIMBS < 1 || MBEDTLS_MPI_INLINE_LIMBS > 1024
+#error "MBEDTLS_MPI_INLINE_LIMBS must be between 1 and 1024"
+#endif
+#endif /* MBEDTLS_MPI_SMALL_BUFFER */
+
 /*
  * When reading from files with mbedtls_mpi_read_file() and writing to files with
  * mbedtls_mpi_write_file() the buffer should have space
@@ -235,6 +248,14 @@ typedef struct mbedtls_mpi {
 #if MBEDTLS_MPI_MAX_LIMBS > 65535
 #error "MBEDTLS_MPI_MAX_LIMBS > 65535 is not supported"
 #endif
+
+#if defined(MBEDTLS_MPI_SMALL_BUFFER)
+    /** Storage for the limbs while there are at most
+     * #MBEDTLS_MPI_INLINE_LIMBS of them. \c p points here in that case,
+     * so the structure must not be copied by assignment.
+     */
+    mbedtls_mpi_uint MBEDTLS_PRIVATE(inline_limbs)[MBEDTLS_MPI_INLINE_LIMBS];
+#endif
 }
 mbedtls_mpi;
 
@@ -94,6 +94,18 @@
 #error "MBEDTLS_DHM_C defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_GENPRIME_SIEVE) && !defined(MBEDTLS_GENPRIME)
+#error "MBEDTLS_GENPRIME_SIEVE defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_MPI_SMALL_BUFFER) && !defined(MBEDTLS_BIGNUM_C)
+#error "MBEDTLS_MPI_SMALL_BUFFER defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_FFDHE_FIXED_BASE) && !defined(MBEDTLS_BIGNUM_C)
+#error "MBEDTLS_FFDHE_FIXED_BASE defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_CMAC_C) && \
     ( !defined(MBEDTLS_CIPHER_C ) || ( !defined(MBEDTLS_AES_C) && !defined(MBEDTLS_DES_C) ) )
 #error "MBEDTLS_CMAC_C defined, but not all prerequisites"
@@ -186,6 +198,14 @@
 #error "MBEDTLS_ECP_RESTARTABLE defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_ECP_GLV_OPTIM) && !defined(MBEDTLS_ECP_C)
+#error "MBEDTLS_ECP_GLV_OPTIM defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_ECP_CURVE448_OPTIM) && !defined(MBEDTLS_ECP_DP_CURVE448_ENABLED)
+#error "MBEDTLS_ECP_CURVE448_OPTIM defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_ECDSA_DETERMINISTIC) && !defined(MBEDTLS_HMAC_DRBG_C)
 #error "MBEDTLS_ECDSA_DETERMINISTIC defined, but not all prerequisites"
 #endif
@@ -739,6 +759,17 @@
 #error "MBEDTLS_RSA_C defined, but none of the PKCS1 versions enabled"
 #endif
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME) && \
+    ( !defined(MBEDTLS_RSA_C) || defined(MBEDTLS_RSA_NO_CRT) || \
+    defined(MBEDTLS_RSA_ALT) )
+#error "MBEDTLS_RSA_MULTI_PRIME defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_RSA_BLINDING_POOL) && \
+    ( !defined(MBEDTLS_RSA_C) || defined(MBEDTLS_RSA_ALT) )
+#error "MBEDTLS_RSA_BLINDING_POOL defined, but not all prerequisites"
+#endif
+
 #if defined(MBEDTLS_X509_RSASSA_PSS_SUPPORT) &&                        \
     ( !defined(MBEDTLS_RSA_C) || !defined(MBEDTLS_PKCS1_V21) )
 #error "MBEDTLS_X509_RSASSA_PSS_SUPPORT defined, but not all prerequisites"
@@ -904,6 +935,13 @@
 #error "MBEDTLS_SSL_DTLS_ANTI_REPLAY  defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY) && \
+    defined(MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX) && \
+    (MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX < 64 || \
+     MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX > 4096)
+#error "MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX must be between 64 and 4096"
+#endif
+
 #if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID) &&                              \
     ( !defined(MBEDTLS_SSL_TLS_C) || !defined(MBEDTLS_SSL_PROTO_DTLS) )
 #error "MBEDTLS_SSL_DTLS_CONNECTION_ID  defined, but not all prerequisites"
@@ -949,6 +987,42 @@
 #error "MBEDTLS_SSL_RENEGOTIATION defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_CACHE_SHM_C) && ( !defined(MBEDTLS_SSL_TLS_C) || \
+                                          !defined(MBEDTLS_THREADING_PTHREAD) )
+#error "MBEDTLS_SSL_CACHE_SHM_C defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_SSL_DTLS_MUX_C) && \
+    ( !defined(MBEDTLS_SSL_SRV_C) || !defined(MBEDTLS_SSL_PROTO_DTLS) || \
+      !defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY) || \
+      !defined(MBEDTLS_SSL_DTLS_CONNECTION_ID) || \
+      !defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY) || !defined(MBEDTLS_HAVE_TIME) )
+#error "MBEDTLS_SSL_DTLS_MUX_C defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_SSL_EARLY_DATA_REPLAY_C) && \
+    ( !defined(MBEDTLS_SSL_EARLY_DATA) || !defined(MBEDTLS_SSL_SRV_C) || \
+      !defined(MBEDTLS_HAVE_TIME) )
+#error "MBEDTLS_SSL_EARLY_DATA_REPLAY_C defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_SSL_SESSION_STORE_C) && \
+    ( !defined(MBEDTLS_SSL_CLI_C) || !defined(MBEDTLS_X509_CRT_PARSE_C) || \
+      !defined(MBEDTLS_HAVE_TIME) )
+#error "MBEDTLS_SSL_SESSION_STORE_C defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_CACHE_C) && \
+    ( !defined(MBEDTLS_SSL_PROTO_TLS1_3) || !defined(MBEDTLS_SSL_CLI_C) || \
+      !defined(MBEDTLS_X509_CRT_PARSE_C) )
+#error "MBEDTLS_SSL_KEY_SHARE_CACHE_C defined, but not all prerequisites"
+#endif
+
+#if defined(MBEDTLS_SSL_TICKET_C) && defined(MBEDTLS_SSL_TICKET_MAX_KEYS) && \
+    MBEDTLS_SSL_TICKET_MAX_KEYS < 2
+#error "MBEDTLS_SSL_TICKET_MAX_KEYS too small (min 2)"
+#endif
+
 #if defined(MBEDTLS_SSL_TICKET_C) && ( !defined(MBEDTLS_CIPHER_C) && \
                                        !defined(MBEDTLS_USE_PSA_CRYPTO) )
 #error "MBEDTLS_SSL_TICKET_C defined, but not all prerequisites"
@@ -1051,6 +1125,11 @@
 #error "MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH defined, but not all prerequisites"
 #endif
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND) && defined(MBEDTLS_SSL_OUT_QUEUE_LEN) && \
+    (MBEDTLS_SSL_OUT_QUEUE_LEN < 1 || MBEDTLS_SSL_OUT_QUEUE_LEN > 64)
+#error "MBEDTLS_SSL_OUT_QUEUE_LEN must be between 1 and 64"
+#endif
+
 #if defined(MBEDTLS_SSL_RECORD_SIZE_LIMIT) && ( !defined(MBEDTLS_SSL_PROTO_TLS1_3) )
 #error "MBEDTLS_SSL_RECORD_SIZE_LIMIT defined, but not all prerequisites"
 #endif
@@ -32,6 +32,13 @@
 #undef MBEDTLS_SSL_PROTO_TLS1_3
 #undef MBEDTLS_SSL_PROTO_TLS1_2
 #undef MBEDTLS_SSL_PROTO_DTLS
+#undef MBEDTLS_SSL_VECTORED_SEND
+#undef MBEDTLS_SSL_KTLS
+#undef MBEDTLS_SSL_DYNAMIC_RECORD_SIZING
+#undef MBEDTLS_SSL_BUFFER_POOL_C
+#undef MBEDTLS_SSL_HANDSHAKE_ARENA
+#undef MBEDTLS_SSL_CACHE_HASH_C
+#undef MBEDTLS_SSL_CACHE_SHM_C
 #endif
 
 #if !(defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_SSL_SESSION_TICKETS))
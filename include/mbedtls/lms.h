@@ -7,6 +7,11 @@
  *        MBEDTLS_LMS_SHA256_M32_H10 in order to reduce complexity. This is one
  *        of the signature schemes recommended by the IETF draft SUIT standard
  *        for IOT firmware upgrades (RFC9019).
+ *
+ *        The multi-level HSS scheme of RFC8554 section 6 is provided on top
+ *        of it, so that the signing capacity can be extended to
+ *        2^(10 * L) signatures while key generation only ever needs to build
+ *        L trees of height 10.
  */
 /*
  *  Copyright The Mbed TLS Contributors
@@ -63,6 +68,19 @@
                                           MBEDTLS_LMOTS_I_KEY_ID_LEN + \
                                           MBEDTLS_LMS_M_NODE_BYTES(type))
 
+/* RFC8554 section 6 allows between 1 and 8 levels in an HSS key */
+#define MBEDTLS_HSS_L_LEVELS_MAX        (8u)
+#define MBEDTLS_HSS_L_LEVELS_LEN        (4u)
+
+#define MBEDTLS_HSS_PUBLIC_KEY_LEN(type) (MBEDTLS_HSS_L_LEVELS_LEN + \
+                                          MBEDTLS_LMS_PUBLIC_KEY_LEN(type))
+
+#define MBEDTLS_HSS_SIG_LEN(levels, type, otstype) (MBEDTLS_HSS_L_LEVELS_LEN + \
+                                                    ((levels) - 1) * \
+                                                    (MBEDTLS_LMS_SIG_LEN(type, otstype) + \
+                                                     MBEDTLS_LMS_PUBLIC_KEY_LEN(type)) + \
+                                                    MBEDTLS_LMS_SIG_LEN(type, otstype))
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -227,11 +245,81 @@ typedef struct {
                                                                    non-NULL otherwise.
                                                                    Is 2^MBEDTLS_LMS_H_TREE_HEIGHT(type)
                                                                    in length. */
+    unsigned char *MBEDTLS_PRIVATE(tree); /*!< The Merkle tree built from the OTS
+                                             public keys, cached so that signing
+                                             does not have to rebuild it. NULL
+                                             when have_private_key is 0 and
+                                             non-NULL otherwise. Is
+                                             2^(MBEDTLS_LMS_H_TREE_HEIGHT(type) + 1)
+                                             nodes in length. */
     unsigned char MBEDTLS_PRIVATE(have_private_key); /*!< Whether the context contains a private key.
                                                         Boolean values only. */
 } mbedtls_lms_private_t;
 #endif /* defined(MBEDTLS_LMS_PRIVATE) */
 
+/** HSS public context structure.
+ *
+ * A HSS public key is the number of levels of the hierarchy and the LMS
+ * public key of the top-level tree.
+ *
+ * The context must be initialized before it is used. A public key must either
+ * be imported or generated from a private context.
+ *
+ * \dot
+ * digraph hss_public_t {
+ *   UNINITIALIZED -> INIT [label="init"];
+ *   HAVE_PUBLIC_KEY -> INIT [label="free"];
+ *   INIT -> HAVE_PUBLIC_KEY [label="import_public_key"];
+ *   INIT -> HAVE_PUBLIC_KEY [label="calculate_public_key from private key"];
+ *   HAVE_PUBLIC_KEY -> HAVE_PUBLIC_KEY [label="export_public_key"];
+ * }
+ * \enddot
+ */
+typedef struct {
+    uint32_t MBEDTLS_PRIVATE(levels); /*!< The number of levels L of the
+                                         hierarchy, between 1 and
+                                         #MBEDTLS_HSS_L_LEVELS_MAX. */
+    mbedtls_lms_public_t MBEDTLS_PRIVATE(root_pub_key); /*!< The public key of the
+                                                           top-level LMS tree. */
+} mbedtls_hss_public_t;
+
+#if defined(MBEDTLS_LMS_PRIVATE)
+/** HSS private context structure.
+ *
+ * A HSS private key is one LMS private key per level, the LMS public keys of
+ * the levels below the top, and the signatures of each of those public keys
+ * by the level above it. Only the bottom level signs messages; when it runs
+ * out of keys a new tree is generated and signed by its parent.
+ *
+ * The context must be initialized before it is used.
+ *
+ * \dot
+ * digraph hss_private_t {
+ *   UNINITIALIZED -> INIT [label="init"];
+ *   HAVE_PRIVATE_KEY -> INIT [label="free"];
+ *   INIT -> HAVE_PRIVATE_KEY [label="generate_private_key"];
+ * }
+ * \enddot
+ */
+typedef struct {
+    uint32_t MBEDTLS_PRIVATE(levels); /*!< The number of levels L of the
+                                         hierarchy. */
+    mbedtls_lms_private_t MBEDTLS_PRIVATE(priv_keys)[MBEDTLS_HSS_L_LEVELS_MAX]; /*!< The
+                                                                                   current LMS private
+                                                                                   key of each level. */
+    mbedtls_lms_public_t MBEDTLS_PRIVATE(pub_keys)[MBEDTLS_HSS_L_LEVELS_MAX]; /*!< The
+                                                                                 public keys matching
+                                                                                 priv_keys. */
+    unsigned char MBEDTLS_PRIVATE(pub_key_sigs)[MBEDTLS_HSS_L_LEVELS_MAX - 1][
+        MBEDTLS_LMS_SIG_LEN(MBEDTLS_LMS_SHA256_M32_H10, MBEDTLS_LMOTS_SHA256_N32_W8)]; /*!< The
+                                                                                         signature of
+                                                                                         pub_keys[i + 1]
+                                                                                         by priv_keys[i]. */
+    unsigned char MBEDTLS_PRIVATE(have_private_key); /*!< Whether the context contains a private key.
+                                                        Boolean values only. */
+} mbedtls_hss_private_t;
+#endif /* defined(MBEDTLS_LMS_PRIVATE) */
+
 /**
  * \brief                    This function initializes an LMS public context
  *
@@ -433,6 +521,206 @@ int mbedtls_lms_sign(mbedtls_lms_private_t *ctx,
                      size_t *sig_len);
 #endif /* defined(MBEDTLS_LMS_PRIVATE) */
 
+/**
+ * \brief                    This function initializes an HSS public context
+ *
+ * \param ctx                The uninitialized HSS context that will then be
+ *                           initialized.
+ */
+void mbedtls_hss_public_init(mbedtls_hss_public_t *ctx);
+
+/**
+ * \brief                    This function uninitializes an HSS public context
+ *
+ * \param ctx                The initialized HSS context that will then be
+ *                           uninitialized.
+ */
+void mbedtls_hss_public_free(mbedtls_hss_public_t *ctx);
+
+/**
+ * \brief                    This function imports an HSS public key into a
+ *                           public HSS context.
+ *
+ * \note                     Before this function is called, the context must
+ *                           have been initialized.
+ *
+ * \note                     See IETF RFC8554 section 6 for details of the
+ *                           encoding of this public key.
+ *
+ * \param ctx                The initialized HSS context store the key in.
+ * \param key                The buffer from which the key will be read.
+ *                           #MBEDTLS_HSS_PUBLIC_KEY_LEN bytes will be read from
+ *                           this.
+ * \param key_size           The size of the key being imported.
+ *
+ * \return         \c 0 on success.
+ * \return         A non-zero error code on failure.
+ */
+int mbedtls_hss_import_public_key(mbedtls_hss_public_t *ctx,
+                                  const unsigned char *key, size_t key_size);
+
+/**
+ * \brief                    This function exports an HSS public key from a
+ *                           HSS public context that already contains a public
+ *                           key.
+ *
+ * \note                     Before this function is called, the context must
+ *                           have been initialized and the context must contain
+ *                           a public key.
+ *
+ * \param ctx                The initialized HSS public context that contains
+ *                           the public key.
+ * \param key                The buffer into which the key will be output. Must
+ *                           be at least #MBEDTLS_HSS_PUBLIC_KEY_LEN in size.
+ * \param key_size           The size of the key buffer.
+ * \param key_len            If not NULL, will be written with the size of the
+ *                           key.
+ *
+ * \return         \c 0 on success.
+ * \return         A non-zero error code on failure.
+ */
+int mbedtls_hss_export_public_key(const mbedtls_hss_public_t *ctx,
+                                  unsigned char *key, size_t key_size,
+                                  size_t *key_len);
+
+/**
+ * \brief                    This function verifies a HSS signature, using a
+ *                           HSS context that contains a public key.
+ *
+ * \note                     Before this function is called, the context must
+ *                           have been initialized and must contain a public key
+ *                           (either by import or generation).
+ *
+ * \param ctx                The initialized HSS public context from which the
+ *                           public key will be read.
+ * \param msg                The buffer from which the message will be read.
+ * \param msg_size           The size of the message that will be read.
+ * \param sig                The buf from which the signature will be read.
+ *                           #MBEDTLS_HSS_SIG_LEN bytes will be read from
+ *                           this.
+ * \param sig_size           The size of the signature to be verified.
+ *
+ * \return         \c 0 on successful verification.
+ * \return         A non-zero error code on failure.
+ */
+int mbedtls_hss_verify(const mbedtls_hss_public_t *ctx,
+                       const unsigned char *msg, size_t msg_size,
+                       const unsigned char *sig, size_t sig_size);
+
+#if defined(MBEDTLS_LMS_PRIVATE)
+/**
+ * \brief                    This function initializes an HSS private context
+ *
+ * \param ctx                The uninitialized HSS private context that will
+ *                           then be initialized. */
+void mbedtls_hss_private_init(mbedtls_hss_private_t *ctx);
+
+/**
+ * \brief                    This function uninitializes an HSS private context
+ *
+ * \param ctx                The initialized HSS private context that will then
+ *                           be uninitialized.
+ */
+void mbedtls_hss_private_free(mbedtls_hss_private_t *ctx);
+
+/**
+ * \brief                    This function generates an HSS private key, and
+ *                           stores in into an HSS private context.
+ *
+ * \warning                  This function is **not intended for use in
+ *                           production**, due to as-yet unsolved problems with
+ *                           handling stateful keys. The API for this function
+ *                           may change considerably in future versions.
+ *
+ * \note                     The seed must have at least 256 bits of entropy.
+ *                           It is used for the top-level tree only; the seeds
+ *                           of the lower-level trees are drawn from \p f_rng,
+ *                           here and when they are replaced by mbedtls_hss_sign().
+ *
+ * \param ctx                The initialized HSS context to generate the key
+ *                           into.
+ * \param levels             The number of levels L, between 1 and
+ *                           #MBEDTLS_HSS_L_LEVELS_MAX. The key can produce
+ *                           2^(10 * L) signatures.
+ * \param type               The LMS parameter set identifier, used at every
+ *                           level.
+ * \param otstype            The LMOTS parameter set identifier, used at every
+ *                           level.
+ * \param f_rng              The RNG function to be used to generate the key
+ *                           IDs and the lower-level seeds.
+ * \param p_rng              The RNG context to be passed to f_rng
+ * \param seed               The seed used to deterministically generate the
+ *                           top-level key.
+ * \param seed_size          The length of the seed.
+ *
+ * \return         \c 0 on success.
+ * \return         A non-zero error code on failure.
+ */
+int mbedtls_hss_generate_private_key(mbedtls_hss_private_t *ctx,
+                                     unsigned int levels,
+                                     mbedtls_lms_algorithm_type_t type,
+                                     mbedtls_lmots_algorithm_type_t otstype,
+                                     int (*f_rng)(void *, unsigned char *, size_t),
+                                     void *p_rng, const unsigned char *seed,
+                                     size_t seed_size);
+
+/**
+ * \brief                    This function calculates an HSS public key from a
+ *                           HSS context that already contains a private key.
+ *
+ * \param ctx                The initialized HSS public context to store the
+ *                           key into.
+ * \param priv_ctx           The HSS private context to read the private key
+ *                           from. This must have been initialized and contain a
+ *                           private key.
+ *
+ * \return         \c 0 on success.
+ * \return         A non-zero error code on failure.
+ */
+int mbedtls_hss_calculate_public_key(mbedtls_hss_public_t *ctx,
+                                     const mbedtls_hss_private_t *priv_ctx);
+
+/**
+ * \brief                    This function creates a HSS signature, using a
+ *                           HSS context that contains unused private keys.
+ *
+ * \warning                  This function is **not intended for use in
+ *                           production**, due to as-yet unsolved problems with
+ *                           handling stateful keys. The API for this function
+ *                           may change considerably in future versions.
+ *
+ * \note                     When the bottom-level tree has used all of its
+ *                           keys, it is replaced by a freshly generated tree
+ *                           signed by the level above, which costs one LMS key
+ *                           generation. If this fails, the context is freed
+ *                           rather than left in a state that could reuse keys.
+ *
+ * \param ctx                The initialized HSS private context from which the
+ *                           private key will be read.
+ * \param f_rng              The RNG function to be used for signature
+ *                           generation and for lower-level key generation.
+ * \param p_rng              The RNG context to be passed to f_rng
+ * \param msg                The buffer from which the message will be read.
+ * \param msg_size           The size of the message that will be read.
+ * \param sig                The buf into which the signature will be stored.
+ *                           Must be at least #MBEDTLS_HSS_SIG_LEN in size.
+ * \param sig_size           The size of the buffer the signature will be
+ *                           written into.
+ * \param sig_len            If not NULL, will be written with the size of the
+ *                           signature.
+ *
+ * \return         \c 0 on success.
+ * \return         #MBEDTLS_ERR_LMS_OUT_OF_PRIVATE_KEYS if every level has
+ *                 used all of its keys.
+ * \return         A non-zero error code on failure.
+ */
+int mbedtls_hss_sign(mbedtls_hss_private_t *ctx,
+                     int (*f_rng)(void *, unsigned char *, size_t),
+                     void *p_rng, const unsigned char *msg,
+                     unsigned int msg_size, unsigned char *sig, size_t sig_size,
+                     size_t *sig_len);
+#endif /* defined(MBEDTLS_LMS_PRIVATE) */
+
 #ifdef __cplusplus
 }
 #endif
@@ -783,6 +783,47 @@
  */
 #define MBEDTLS_ECP_NIST_OPTIM
 
+/**
+ * \def MBEDTLS_ECP_GLV_OPTIM
+ *
+ * Use the GLV endomorphism method for scalar multiplication on secp256k1.
+ *
+ * The scalar is split into two half-length scalars, which halves the number
+ * of point doublings in multiplications by a point other than the base
+ * point. This makes mbedtls_ecp_mul() with an arbitrary point and
+ * mbedtls_ecp_muladd() (used by ECDSA verification) about 30% faster on
+ * secp256k1, at the cost of about 2KB of code and a second table of
+ * precomputed points on the stack.
+ *
+ * This has no effect on other curves, when MBEDTLS_ECP_DP_SECP256K1_ENABLED
+ * is not defined, or when restartable operations are enabled with
+ * mbedtls_ecp_set_max_ops().
+ *
+ * Requires: MBEDTLS_ECP_C
+ *
+ * Uncomment this macro to enable the GLV method for secp256k1.
+ */
+//#define MBEDTLS_ECP_GLV_OPTIM
+
+/**
+ * \def MBEDTLS_ECP_CURVE448_OPTIM
+ *
+ * Use dedicated field arithmetic and Montgomery ladder for Curve448.
+ *
+ * X448 then works on fixed-size field elements on the stack, with 56-bit
+ * limbs on platforms with a 128-bit integer type and 28-bit limbs otherwise,
+ * instead of the generic bignum code. This makes X448 key generation and
+ * key agreement several times faster, in ECDH, PSA and TLS alike, at the
+ * cost of about 3KB of code.
+ *
+ * This has no effect unless MBEDTLS_ECP_C is defined.
+ *
+ * Requires: MBEDTLS_ECP_DP_CURVE448_ENABLED
+ *
+ * Comment this macro to use the generic code for Curve448.
+ */
+#define MBEDTLS_ECP_CURVE448_OPTIM
+
 /**
  * \def MBEDTLS_ECP_RESTARTABLE
  *
@@ -1178,6 +1219,72 @@
  */
 #define MBEDTLS_GENPRIME
 
+/**
+ * \def MBEDTLS_GENPRIME_SIEVE
+ *
+ * Make mbedtls_mpi_gen_prime() search for a prime among the odd numbers
+ * following a random starting point, instead of drawing a fresh random
+ * candidate each time. Candidates with a small prime factor are struck out
+ * of a window of successive odd numbers with a sieve, so that only the
+ * remaining ones go through the Miller-Rabin test. This makes prime and RSA
+ * key generation noticeably faster, at the cost of about 1KB of extra stack.
+ *
+ * \note The primes generated this way are not uniformly distributed: a
+ *       prime that follows a long gap is more likely to be chosen. This is
+ *       not known to weaken RSA or DH keys, but the candidate selection does
+ *       not follow FIPS 186-4 §B.3.3 to the letter.
+ *
+ * Requires: MBEDTLS_GENPRIME
+ *
+ * Uncomment this macro to enable sieving in prime generation.
+ */
+//#define MBEDTLS_GENPRIME_SIEVE
+
+/**
+ * \def MBEDTLS_MPI_SMALL_BUFFER
+ *
+ * Give every mbedtls_mpi a small buffer of MBEDTLS_MPI_INLINE_LIMBS limbs
+ * inside the structure itself. Numbers that fit in it are stored there,
+ * and the limbs are only moved to the heap once the number outgrows the
+ * buffer. Most numbers used by elliptic curve cryptography, Diffie-Hellman
+ * key agreement over small groups and key parsing then never touch the
+ * heap.
+ *
+ * \note This makes every mbedtls_mpi larger by MBEDTLS_MPI_INLINE_LIMBS
+ *       limbs, including those in structures and in the constant tables
+ *       of precomputed curve points, which increases both RAM and ROM use.
+ *
+ * \warning With this option, the limbs of an mbedtls_mpi may point into
+ *          the structure itself, so an mbedtls_mpi must not be copied or
+ *          moved with a plain structure assignment or memcpy(). Use
+ *          mbedtls_mpi_copy() or mbedtls_mpi_swap() instead.
+ *
+ * Requires: MBEDTLS_BIGNUM_C
+ *
+ * Uncomment this macro to store small MPIs without heap allocation.
+ */
+//#define MBEDTLS_MPI_SMALL_BUFFER
+
+/**
+ * \def MBEDTLS_FFDHE_FIXED_BASE
+ *
+ * Speed up Diffie-Hellman key generation in the RFC 7919 groups ffdhe2048
+ * to ffdhe8192, in mbedtls_dhm_make_params(), mbedtls_dhm_make_public() and
+ * the PSA FFDH driver. The first key generated in each group builds a table
+ * of precomputed powers of the generator 2, which is then shared by all
+ * later computations in that group. This makes computing the public key
+ * about three times faster.
+ *
+ * \note The tables are stored in static memory: about 8KB for ffdhe2048,
+ *       12KB for ffdhe3072, 16KB for ffdhe4096, 24KB for ffdhe6144 and
+ *       32KB for ffdhe8192.
+ *
+ * Requires: MBEDTLS_BIGNUM_C
+ *
+ * Uncomment this macro to precompute tables for the RFC 7919 groups.
+ */
+//#define MBEDTLS_FFDHE_FIXED_BASE
+
 /**
  * \def MBEDTLS_FS_IO
  *
@@ -1499,6 +1606,45 @@
  */
 //#define MBEDTLS_RSA_NO_CRT
 
+/**
+ * \def MBEDTLS_RSA_MULTI_PRIME
+ *
+ * Enable support for multi-prime RSA keys (RFC 8017 §3), whose modulus is
+ * the product of more than two primes. This adds parsing and writing of the
+ * otherPrimeInfos structure of PKCS#1 private keys, key generation with
+ * mbedtls_rsa_gen_key_multi(), and CRT private key operations using all the
+ * primes, which are faster than with a two-prime key of the same size.
+ *
+ * The maximum number of primes is set by MBEDTLS_RSA_MAX_PRIMES.
+ *
+ * Requires: MBEDTLS_RSA_C
+ *
+ * This option is incompatible with MBEDTLS_RSA_NO_CRT and MBEDTLS_RSA_ALT.
+ *
+ * Uncomment this macro to enable support for multi-prime RSA keys.
+ */
+//#define MBEDTLS_RSA_MULTI_PRIME
+
+/**
+ * \def MBEDTLS_RSA_BLINDING_POOL
+ *
+ * Keep a per-key pool of precomputed blinding values for the RSA private
+ * operation. The pool is filled by mbedtls_rsa_blinding_precompute(), which
+ * can be called ahead of time, for example from a low-priority thread, so
+ * that mbedtls_rsa_private() does not have to derive a new blinding pair on
+ * the critical path. When the pool is empty, the private operation falls
+ * back to updating its cached blinding values as usual.
+ *
+ * The size of the pool is set by MBEDTLS_RSA_BLINDING_POOL_SIZE.
+ *
+ * Requires: MBEDTLS_RSA_C
+ *
+ * This option is incompatible with MBEDTLS_RSA_ALT.
+ *
+ * Uncomment this macro to enable the RSA blinding pool.
+ */
+//#define MBEDTLS_RSA_BLINDING_POOL
+
 /**
  * \def MBEDTLS_SELF_TEST
  *
@@ -2014,6 +2160,68 @@
  */
 //#define MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH
 
+/**
+ * \def MBEDTLS_SSL_VECTORED_SEND
+ *
+ * Enable support for a vectored (gather) send callback, see
+ * mbedtls_ssl_set_bio_vec(). When such a callback is set on a TLS connection,
+ * the records of a handshake flight, and the records of a large
+ * mbedtls_ssl_write() call, are queued and sent with a single call.
+ *
+ * This costs up to #MBEDTLS_SSL_OUT_QUEUE_LEN additional output buffers per
+ * connection that uses the callback.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C
+ *
+ * Uncomment this to enable vectored sends.
+ */
+//#define MBEDTLS_SSL_VECTORED_SEND
+
+/**
+ * \def MBEDTLS_SSL_KTLS
+ *
+ * Enable handing record protection over to the operating system kernel once
+ * the handshake is completed, see mbedtls_ssl_get_ktls_info() and
+ * mbedtls_ssl_set_ktls(). On Linux, mbedtls_net_ktls_enable() uses this to
+ * configure kernel TLS on a socket, which allows sending files with
+ * sendfile() without copying them to user space.
+ *
+ * Only TLS connections using AES-GCM or ChaCha20-Poly1305 can be handed
+ * over. This keeps a copy of the traffic keys in each transform.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C
+ *
+ * Uncomment this to enable kernel TLS offload.
+ */
+//#define MBEDTLS_SSL_KTLS
+
+/**
+ * \def MBEDTLS_SSL_DYNAMIC_RECORD_SIZING
+ *
+ * Enable mbedtls_ssl_conf_dynamic_record_sizing(), which makes TLS
+ * connections send small application data records while they are new or
+ * after they have been idle, and full-size records afterwards.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C
+ *
+ * Comment this macro to disable support for dynamic record sizing.
+ */
+#define MBEDTLS_SSL_DYNAMIC_RECORD_SIZING
+
+/**
+ * \def MBEDTLS_SSL_HANDSHAKE_ARENA
+ *
+ * Enable mbedtls_ssl_conf_handshake_arena(), which lets each handshake
+ * allocate its transient state, such as buffered DTLS messages, cookies and
+ * TLS 1.3 handshake traffic keys, from a single block of memory that is
+ * released in one step when the handshake completes.
+ *
+ * Requires: MBEDTLS_SSL_TLS_C
+ *
+ * Comment this macro to disable support for handshake arenas.
+ */
+#define MBEDTLS_SSL_HANDSHAKE_ARENA
+
 /**
  * \def MBEDTLS_TEST_CONSTANT_FLOW_MEMSAN
  *
@@ -3510,6 +3718,21 @@
  */
 //#define MBEDTLS_SHA512_USE_A64_CRYPTO_ONLY
 
+/**
+ * \def MBEDTLS_SSL_BUFFER_POOL_C
+ *
+ * Enable a pool of I/O buffers shared between TLS connections, see
+ * mbedtls_ssl_conf_buffer_pool().
+ *
+ * Module:  library/ssl_buffer_pool.c
+ * Caller:  library/ssl_tls.c
+ *
+ * Requires: MBEDTLS_SSL_TLS_C
+ *
+ * This module reduces the memory used by idle TLS connections.
+ */
+#define MBEDTLS_SSL_BUFFER_POOL_C
+
 /**
  * \def MBEDTLS_SSL_CACHE_C
  *
@@ -3522,6 +3745,38 @@
  */
 #define MBEDTLS_SSL_CACHE_C
 
+/**
+ * \def MBEDTLS_SSL_CACHE_HASH_C
+ *
+ * Enable an SSL session cache with a hash table, LRU eviction and lock
+ * striping, for servers that cache many sessions.
+ *
+ * Module:  library/ssl_cache_hash.c
+ * Caller:
+ *
+ * Requires: MBEDTLS_SSL_TLS_C
+ */
+#define MBEDTLS_SSL_CACHE_HASH_C
+
+/**
+ * \def MBEDTLS_SSL_CACHE_SHM_C
+ *
+ * Enable an SSL session cache in memory shared between processes, so that
+ * the worker processes of a pre-forking server can resume each other's
+ * sessions.
+ *
+ * This module uses robust process-shared POSIX mutexes and mmap(), and
+ * only works on Linux and FreeBSD.
+ *
+ * Module:  library/ssl_cache_shm.c
+ * Caller:
+ *
+ * Requires: MBEDTLS_SSL_TLS_C, MBEDTLS_THREADING_PTHREAD
+ *
+ * Uncomment this to enable the shared-memory session cache.
+ */
+//#define MBEDTLS_SSL_CACHE_SHM_C
+
 /**
  * \def MBEDTLS_SSL_COOKIE_C
  *
@@ -3532,6 +3787,74 @@
  */
 #define MBEDTLS_SSL_COOKIE_C
 
+/**
+ * \def MBEDTLS_SSL_DTLS_MUX_C
+ *
+ * Enable a DTLS server multiplexer, which serves many clients over a single
+ * datagram socket and dispatches the datagrams it receives to the right
+ * connection by connection ID or by client address.
+ *
+ * Module:  library/ssl_dtls_mux.c
+ * Caller:
+ *
+ * Requires: MBEDTLS_SSL_SRV_C, MBEDTLS_SSL_PROTO_DTLS,
+ *           MBEDTLS_SSL_DTLS_HELLO_VERIFY, MBEDTLS_SSL_DTLS_CONNECTION_ID,
+ *           MBEDTLS_SSL_DTLS_ANTI_REPLAY, MBEDTLS_HAVE_TIME
+ *
+ * Uncomment this to enable the DTLS server multiplexer.
+ */
+//#define MBEDTLS_SSL_DTLS_MUX_C
+
+/**
+ * \def MBEDTLS_SSL_EARLY_DATA_REPLAY_C
+ *
+ * Enable an anti-replay store for TLS 1.3 early data, to be passed to
+ * mbedtls_ssl_conf_early_data_replay() by servers that accept early data.
+ * The store can be shared between processes if MBEDTLS_SSL_CACHE_SHM_C is
+ * enabled.
+ *
+ * Module:  library/ssl_early_data_replay.c
+ * Caller:
+ *
+ * Requires: MBEDTLS_SSL_EARLY_DATA, MBEDTLS_SSL_SRV_C, MBEDTLS_HAVE_TIME
+ *
+ * Uncomment this to enable the early data anti-replay store.
+ */
+//#define MBEDTLS_SSL_EARLY_DATA_REPLAY_C
+
+/**
+ * \def MBEDTLS_SSL_KEY_SHARE_CACHE_C
+ *
+ * Enable a client-side cache of the TLS 1.3 groups selected by servers, to
+ * be passed to mbedtls_ssl_conf_key_share_cache() so that clients offer a
+ * key share for the group a server prefers and avoid a HelloRetryRequest.
+ *
+ * Module:  library/ssl_key_share_cache.c
+ * Caller:
+ *
+ * Requires: MBEDTLS_SSL_PROTO_TLS1_3, MBEDTLS_SSL_CLI_C,
+ *           MBEDTLS_X509_CRT_PARSE_C
+ *
+ * Uncomment this to enable the client-side key share cache.
+ */
+//#define MBEDTLS_SSL_KEY_SHARE_CACHE_C
+
+/**
+ * \def MBEDTLS_SSL_SESSION_STORE_C
+ *
+ * Enable a client-side store of resumable sessions, indexed by server, to
+ * be passed to mbedtls_ssl_conf_session_store() so that clients resume
+ * sessions automatically.
+ *
+ * Module:  library/ssl_session_store.c
+ * Caller:
+ *
+ * Requires: MBEDTLS_SSL_CLI_C, MBEDTLS_X509_CRT_PARSE_C, MBEDTLS_HAVE_TIME
+ *
+ * Uncomment this to enable the client-side session store.
+ */
+//#define MBEDTLS_SSL_SESSION_STORE_C
+
 /**
  * \def MBEDTLS_SSL_TICKET_C
  *
@@ -3906,6 +4229,7 @@
 /* MPI / BIGNUM options */
 //#define MBEDTLS_MPI_WINDOW_SIZE            2 /**< Maximum window size used. */
 //#define MBEDTLS_MPI_MAX_SIZE            1024 /**< Maximum number of bytes for usable MPIs. */
+//#define MBEDTLS_MPI_INLINE_LIMBS          17 /**< Number of limbs stored inside each MPI with MBEDTLS_MPI_SMALL_BUFFER. */
 
 /* CTR_DRBG options */
 //#define MBEDTLS_CTR_DRBG_ENTROPY_LEN               48 /**< Amount of entropy used per seed by default (48 with SHA-512, 32 with SHA-256) */
@@ -4037,10 +4361,25 @@
 
 /* RSA OPTIONS */
 //#define MBEDTLS_RSA_GEN_KEY_MIN_BITS            1024 /**<  Minimum RSA key size that can be generated in bits (Minimum possible value is 128 bits) */
+//#define MBEDTLS_RSA_MAX_PRIMES                     3 /**<  Maximum number of primes of a multi-prime RSA key (between 3 and 5) */
+//#define MBEDTLS_RSA_BLINDING_POOL_SIZE             4 /**<  Number of precomputed blinding pairs kept per RSA key (between 1 and 64) */
 
 /* SSL Cache options */
 //#define MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT       86400 /**< 1 day  */
 //#define MBEDTLS_SSL_CACHE_DEFAULT_MAX_ENTRIES      50 /**< Maximum entries in cache */
+//#define MBEDTLS_SSL_CACHE_HASH_DEFAULT_STRIPES     16 /**< Number of lock stripes in a hash-indexed cache */
+//#define MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE          1024 /**< Maximum size of a serialized session in a shared-memory cache */
+
+/* DTLS multiplexer options */
+//#define MBEDTLS_SSL_DTLS_MUX_ADDR_MAX_LEN          32 /**< Maximum length of a client address in a DTLS multiplexer */
+
+/* SSL key share cache options */
+//#define MBEDTLS_SSL_KEY_SHARE_CACHE_DEFAULT_MAX_ENTRIES    50 /**< Maximum entries in a key share cache */
+
+/* SSL session store options */
+//#define MBEDTLS_SSL_SESSION_STORE_DEFAULT_TIMEOUT       86400 /**< Timeout of stored TLS 1.2 sessions: 1 day */
+//#define MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_ENTRIES      50 /**< Maximum entries in a session store */
+//#define MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_PER_PEER      4 /**< Maximum entries per server in a session store */
 
 /* SSL options */
 
@@ -4115,6 +4454,16 @@
  */
 //#define MBEDTLS_SSL_OUT_CONTENT_LEN             16384
 
+/** \def MBEDTLS_SSL_OUT_QUEUE_LEN
+ *
+ * Maximum number of complete outgoing records that are held back to be sent
+ * together with the next one, when MBEDTLS_SSL_VECTORED_SEND is enabled and
+ * a vectored send callback is set.
+ *
+ * Each queued record uses a buffer of the size of the output buffer.
+ */
+//#define MBEDTLS_SSL_OUT_QUEUE_LEN               3
+
 /** \def MBEDTLS_SSL_DTLS_MAX_BUFFERING
  *
  * Maximum number of heap-allocated bytes for the purpose of
@@ -4132,6 +4481,19 @@
  */
 //#define MBEDTLS_SSL_DTLS_MAX_BUFFERING             32768
 
+/** \def MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX
+ *
+ * Maximum size of the DTLS anti-replay window, in records, between 64 and
+ * 4096. The window is 64 records unless a larger one is set with
+ * mbedtls_ssl_conf_dtls_replay_window().
+ *
+ * Each SSL context uses one bit per record of the window, rounded up to a
+ * multiple of 64, plus 64 bits. Contexts serialized with
+ * mbedtls_ssl_context_save() can only be loaded by a build with the same
+ * value.
+ */
+//#define MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX         64
+
 //#define MBEDTLS_PSK_MAX_LEN               32 /**< Max size of TLS pre-shared keys, in bytes (default 256 or 384 bits) */
 //#define MBEDTLS_SSL_COOKIE_TIMEOUT        60 /**< Default expiration delay of DTLS cookies, in seconds if HAVE_TIME, or in number of cookies issued */
 
@@ -4204,6 +4566,17 @@
  */
 //#define MBEDTLS_SSL_TLS1_3_DEFAULT_NEW_SESSION_TICKETS 1
 
+/**
+ * \def MBEDTLS_SSL_TICKET_MAX_KEYS
+ *
+ * Maximum number of session ticket keys that can be accepted at the same
+ * time, see mbedtls_ssl_ticket_set_max_keys(). Each key uses a small
+ * amount of memory in each ticket context only while it is accepted.
+ *
+ * This must be at least 2.
+ */
+//#define MBEDTLS_SSL_TICKET_MAX_KEYS 4
+
 /* X509 options */
 //#define MBEDTLS_X509_MAX_INTERMEDIATE_CA   8   /**< Maximum number of intermediate CAs in a verification chain. */
 //#define MBEDTLS_X509_MAX_FILE_PATH_LEN     512 /**< Maximum length of a path/filename string in bytes including the null terminator character ('\0'). */
@@ -241,6 +241,104 @@ int mbedtls_net_recv(void *ctx, unsigned char *buf, size_t len);
  */
 int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len);
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+/**
+ * \brief          Write the content of several buffers at once, as with
+ *                 writev(). If no error occurs, the actual amount written is
+ *                 returned; it may be less than the total length of the
+ *                 buffers.
+ *
+ * \param ctx      Socket
+ * \param iov      The buffers to read from
+ * \param iovcnt   The number of buffers in \p iov
+ *
+ * \return         the number of bytes sent,
+ *                 or a non-zero error code; with a non-blocking socket,
+ *                 MBEDTLS_ERR_SSL_WANT_WRITE indicates writev() would block.
+ *
+ * \note           On Windows, only the first buffer is written on each call.
+ */
+int mbedtls_net_send_vec(void *ctx, const mbedtls_ssl_iovec *iov, size_t iovcnt);
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
+#if defined(MBEDTLS_SSL_DTLS_MUX_C)
+/**
+ * \brief          Receive a datagram on an unconnected UDP socket, along
+ *                 with the address of its sender.
+ *
+ *                 This is meant to be passed to
+ *                 mbedtls_ssl_dtls_mux_set_bio().
+ *
+ * \param ctx      Socket
+ * \param buf      The buffer to write to
+ * \param len      Maximum length of the buffer
+ * \param addr     The buffer to write the address of the sender to: the IP
+ *                 address (4 bytes for IPv4, 16 bytes for IPv6) followed
+ *                 by the port (2 bytes, big endian)
+ * \param addr_size Size of the \p addr buffer
+ * \param addr_len On success, the length of the address
+ *
+ * \return         the number of bytes received,
+ *                 or a non-zero error code; with a non-blocking socket,
+ *                 MBEDTLS_ERR_SSL_WANT_READ indicates recvfrom() would block.
+ */
+int mbedtls_net_recv_from(void *ctx, unsigned char *buf, size_t len,
+                          unsigned char *addr, size_t addr_size,
+                          size_t *addr_len);
+
+/**
+ * \brief          Send a datagram on an unconnected UDP socket.
+ *
+ *                 This is meant to be passed to
+ *                 mbedtls_ssl_dtls_mux_set_bio().
+ *
+ * \param ctx      Socket
+ * \param buf      The buffer to read from
+ * \param len      The length of the buffer
+ * \param addr     The address of the recipient, as written by
+ *                 mbedtls_net_recv_from()
+ * \param addr_len The length of the address
+ *
+ * \return         the number of bytes sent,
+ *                 or a non-zero error code; with a non-blocking socket,
+ *                 MBEDTLS_ERR_SSL_WANT_WRITE indicates sendto() would block.
+ */
+int mbedtls_net_send_to(void *ctx, const unsigned char *buf, size_t len,
+                        const unsigned char *addr, size_t addr_len);
+#endif /* MBEDTLS_SSL_DTLS_MUX_C */
+
+#if defined(MBEDTLS_SSL_KTLS)
+/**
+ * \brief          Hand record protection of an established TLS connection
+ *                 over to the kernel (Linux kernel TLS), so that data can
+ *                 be sent or received directly on the socket, for example
+ *                 with sendfile().
+ *
+ *                 This configures the socket with the keys obtained from
+ *                 mbedtls_ssl_get_ktls_info(), then calls
+ *                 mbedtls_ssl_set_ktls(). The SSL context keeps handling
+ *                 alerts and post-handshake messages, and
+ *                 mbedtls_ssl_read() and mbedtls_ssl_write() keep working.
+ *
+ * \param ctx      Socket of the connection
+ * \param ssl      SSL context using \p ctx, with the handshake completed
+ * \param directions #MBEDTLS_SSL_KTLS_TX, #MBEDTLS_SSL_KTLS_RX, or both
+ *                 combined with a bitwise or.
+ *
+ * \return         The directions actually handed over (a subset of
+ *                 \p directions) on success: older kernels only support
+ *                 #MBEDTLS_SSL_KTLS_TX.
+ * \return         #MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE if the platform,
+ *                 the kernel or the negotiated ciphersuite does not support
+ *                 kernel TLS. The connection can then be used as before.
+ * \return         Another negative error code from
+ *                 mbedtls_ssl_get_ktls_info() on failure.
+ */
+int mbedtls_net_ktls_enable(mbedtls_net_context *ctx,
+                            mbedtls_ssl_context *ssl,
+                            int directions);
+#endif /* MBEDTLS_SSL_KTLS */
+
 /**
  * \brief          Read at most 'len' characters, blocking for at most
  *                 'timeout' seconds. If no error occurs, the actual amount
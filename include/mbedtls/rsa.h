@@ -79,6 +79,33 @@ extern "C" {
 #error "MBEDTLS_RSA_GEN_KEY_MIN_BITS must be at least 128 bits"
 #endif
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+#if !defined(MBEDTLS_RSA_MAX_PRIMES)
+#define MBEDTLS_RSA_MAX_PRIMES 3
+#elif MBEDTLS_RSA_MAX_PRIMES < 3 || MBEDTLS_RSA_MAX_PRIMES > 5
+#error "MBEDTLS_RSA_MAX_PRIMES must be between 3 and 5"
+#endif
+
+/**
+ * \brief   An additional prime of a multi-prime RSA key (RFC 8017 §3.2).
+ */
+typedef struct mbedtls_rsa_prime_info {
+    mbedtls_mpi MBEDTLS_PRIVATE(R);              /*!<  The prime factor \c r_i. */
+    mbedtls_mpi MBEDTLS_PRIVATE(D);              /*!<  <code>D % (r_i - 1)</code>. */
+    mbedtls_mpi MBEDTLS_PRIVATE(T);              /*!<  <code>1 / (P * Q * ... * r_(i-1)) % r_i</code>. */
+    mbedtls_mpi MBEDTLS_PRIVATE(RR);             /*!<  cached <code>R^2 mod r_i</code>. */
+}
+mbedtls_rsa_prime_info;
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
+#if defined(MBEDTLS_RSA_BLINDING_POOL)
+#if !defined(MBEDTLS_RSA_BLINDING_POOL_SIZE)
+#define MBEDTLS_RSA_BLINDING_POOL_SIZE 4
+#elif MBEDTLS_RSA_BLINDING_POOL_SIZE < 1 || MBEDTLS_RSA_BLINDING_POOL_SIZE > 64
+#error "MBEDTLS_RSA_BLINDING_POOL_SIZE must be between 1 and 64"
+#endif
+#endif /* MBEDTLS_RSA_BLINDING_POOL */
+
 /**
  * \brief   The RSA context structure.
  */
@@ -108,6 +135,22 @@ typedef struct mbedtls_rsa_context {
     mbedtls_mpi MBEDTLS_PRIVATE(Vi);             /*!<  The cached blinding value. */
     mbedtls_mpi MBEDTLS_PRIVATE(Vf);             /*!<  The cached un-blinding value. */
 
+#if defined(MBEDTLS_RSA_BLINDING_POOL)
+    size_t MBEDTLS_PRIVATE(pool_count);          /*!<  The number of precomputed
+                                                  *    blinding pairs available. */
+    mbedtls_mpi MBEDTLS_PRIVATE(pool_Vi)[MBEDTLS_RSA_BLINDING_POOL_SIZE]; /*!< The
+                                                  *    precomputed blinding values. */
+    mbedtls_mpi MBEDTLS_PRIVATE(pool_Vf)[MBEDTLS_RSA_BLINDING_POOL_SIZE]; /*!< The
+                                                  *    precomputed un-blinding values. */
+#endif
+
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    size_t MBEDTLS_PRIVATE(other_count);         /*!<  The number of primes beyond
+                                                  *    \p P and \p Q. */
+    mbedtls_rsa_prime_info MBEDTLS_PRIVATE(other)[MBEDTLS_RSA_MAX_PRIMES - 2]; /*!< The
+                                                  *    additional primes, if any. */
+#endif
+
     int MBEDTLS_PRIVATE(padding);                /*!< Selects padding mode:
                                                   #MBEDTLS_RSA_PKCS_V15 for 1.5 padding and
                                                   #MBEDTLS_RSA_PKCS_V21 for OAEP or PSS. */
@@ -446,6 +489,21 @@ size_t mbedtls_rsa_get_bitlen(const mbedtls_rsa_context *ctx);
  */
 size_t mbedtls_rsa_get_len(const mbedtls_rsa_context *ctx);
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/**
+ * \brief          This function retrieves the number of prime factors
+ *                 of the RSA modulus.
+ *
+ * \param ctx      The initialized RSA context.
+ *
+ * \return         The number of prime factors of the modulus: \c 2 for
+ *                 a regular key, more for a multi-prime key, or \c 0
+ *                 if the context does not hold a private key.
+ *
+ */
+size_t mbedtls_rsa_get_prime_count(const mbedtls_rsa_context *ctx);
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
 /**
  * \brief          This function generates an RSA keypair.
  *
@@ -469,6 +527,48 @@ int mbedtls_rsa_gen_key(mbedtls_rsa_context *ctx,
                         void *p_rng,
                         unsigned int nbits, int exponent);
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/**
+ * \brief          This function generates a multi-prime RSA keypair,
+ *                 as defined in RFC 8017 §3.
+ *
+ *                 The modulus is the product of \p nprimes distinct primes
+ *                 of roughly equal size. Private key operations with such
+ *                 a key use shorter operands for each exponentiation and
+ *                 are therefore faster than with a two-prime key of the
+ *                 same size.
+ *
+ * \note           mbedtls_rsa_init() must be called before this function,
+ *                 to set up the RSA context.
+ *
+ * \note           Not every implementation of PKCS#1 supports multi-prime
+ *                 keys. The security of a multi-prime key also degrades
+ *                 as the size of its primes decreases: use at most
+ *                 3 primes for 2048 to 4095-bit keys, and at most 4 primes
+ *                 below 8192 bits.
+ *
+ * \param ctx      The initialized RSA context used to hold the key.
+ * \param f_rng    The RNG function to be used for key generation.
+ *                 This is mandatory and must not be \c NULL.
+ * \param p_rng    The RNG context to be passed to \p f_rng.
+ *                 This may be \c NULL if \p f_rng doesn't need a context.
+ * \param nbits    The size of the public key in bits.
+ * \param exponent The public exponent to use. For example, \c 65537.
+ *                 This must be odd and greater than \c 1.
+ * \param nprimes  The number of primes. This must be between \c 2
+ *                 and #MBEDTLS_RSA_MAX_PRIMES. If this is \c 2, this
+ *                 function is equivalent to mbedtls_rsa_gen_key().
+ *
+ * \return         \c 0 on success.
+ * \return         An \c MBEDTLS_ERR_RSA_XXX error code on failure.
+ */
+int mbedtls_rsa_gen_key_multi(mbedtls_rsa_context *ctx,
+                              int (*f_rng)(void *, unsigned char *, size_t),
+                              void *p_rng,
+                              unsigned int nbits, int exponent,
+                              unsigned int nprimes);
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
 /**
  * \brief          This function checks if a context contains at least an RSA
  *                 public key.
@@ -595,6 +695,40 @@ int mbedtls_rsa_private(mbedtls_rsa_context *ctx,
                         const unsigned char *input,
                         unsigned char *output);
 
+#if defined(MBEDTLS_RSA_BLINDING_POOL)
+/**
+ * \brief          This function fills the pool of precomputed blinding
+ *                 values of an RSA context.
+ *
+ *                 Each call to mbedtls_rsa_private() consumes one pair from
+ *                 the pool if one is available. Calling this function ahead
+ *                 of time moves the cost of deriving fresh blinding values
+ *                 off the private key operation.
+ *
+ * \note           The context mutex is only held while a single pair is
+ *                 being computed, so this function can run concurrently
+ *                 with private key operations on the same context when
+ *                 #MBEDTLS_THREADING_C is enabled.
+ *
+ * \note           The pool is tied to the modulus. It is emptied by
+ *                 mbedtls_rsa_free() and is not copied by mbedtls_rsa_copy().
+ *
+ * \param ctx      The initialized RSA context to use. This must hold at
+ *                 least a public key.
+ * \param f_rng    The RNG function. It is mandatory.
+ * \param p_rng    The RNG context to pass to \p f_rng. This may be \c NULL
+ *                 if \p f_rng doesn't need a context.
+ *
+ * \return         \c 0 on success, once the pool holds
+ *                 #MBEDTLS_RSA_BLINDING_POOL_SIZE pairs.
+ * \return         An \c MBEDTLS_ERR_RSA_XXX or \c MBEDTLS_ERR_MPI_XXX error
+ *                 code on failure.
+ */
+int mbedtls_rsa_blinding_precompute(mbedtls_rsa_context *ctx,
+                                    int (*f_rng)(void *, unsigned char *, size_t),
+                                    void *p_rng);
+#endif /* MBEDTLS_RSA_BLINDING_POOL */
+
 /**
  * \brief          This function adds the message padding, then performs an RSA
  *                 operation.
@@ -310,6 +310,9 @@
 #define MBEDTLS_SSL_ANTI_REPLAY_DISABLED        0
 #define MBEDTLS_SSL_ANTI_REPLAY_ENABLED         1
 
+#define MBEDTLS_SSL_READ_AHEAD_DISABLED         0
+#define MBEDTLS_SSL_READ_AHEAD_ENABLED          1
+
 #define MBEDTLS_SSL_RENEGOTIATION_NOT_ENFORCED  -1
 #define MBEDTLS_SSL_RENEGO_MAX_RECORDS_DEFAULT  16
 
@@ -408,6 +411,20 @@
 #define MBEDTLS_SSL_DTLS_MAX_BUFFERING 32768
 #endif
 
+/*
+ * Maximum size of the DTLS anti-replay window, in records.
+ */
+#if !defined(MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX)
+#define MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX 64
+#endif
+
+/*
+ * Maximum number of complete outgoing records held back for a vectored send.
+ */
+#if !defined(MBEDTLS_SSL_OUT_QUEUE_LEN)
+#define MBEDTLS_SSL_OUT_QUEUE_LEN 3
+#endif
+
 /*
  * Maximum length of CIDs for incoming and outgoing messages.
  */
@@ -449,6 +466,13 @@
 #define MBEDTLS_SSL_DTLS_CONNECTION_ID_COMPAT 0
 #endif
 
+/*
+ * Number of 64-bit words of the circular DTLS anti-replay bitmap: one more
+ * than the largest window needs, so that it fits whatever its alignment.
+ */
+#define MBEDTLS_SSL_DTLS_REPLAY_WINDOW_WORDS \
+    ((MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX + 63) / 64 + 1)
+
 /*
  * Length of the verify data for secure renegotiation
  */
@@ -770,6 +794,86 @@ typedef int mbedtls_ssl_send_t(void *ctx,
                                const unsigned char *buf,
                                size_t len);
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+/**
+ * \brief          One contiguous chunk of data to be sent, see
+ *                 \c mbedtls_ssl_send_vec_t.
+ */
+typedef struct mbedtls_ssl_iovec {
+    const unsigned char *base;  /*!< Start of the chunk */
+    size_t len;                 /*!< Length of the chunk in bytes */
+} mbedtls_ssl_iovec;
+
+/**
+ * \brief          Callback type: send several chunks of data on the network
+ *                 at once (gather write, as with POSIX \c writev()).
+ *
+ * \note           That callback may be either blocking or non-blocking.
+ *
+ * \param ctx      Context for the send callback (typically a file descriptor)
+ * \param iov      Array of \p iovcnt chunks to send, in order
+ * \param iovcnt   Number of entries in \p iov. This is at least \c 1.
+ *
+ * \return         The callback must return the number of bytes sent if any,
+ *                 or a non-zero error code.
+ *                 If performing non-blocking I/O, \c MBEDTLS_ERR_SSL_WANT_WRITE
+ *                 must be returned when the operation would block.
+ *
+ * \note           The callback is allowed to send fewer bytes than the total
+ *                 length of the chunks, in which case it must have sent a
+ *                 prefix of their concatenation. It must always return the
+ *                 number of bytes actually sent.
+ */
+typedef int mbedtls_ssl_send_vec_t(void *ctx,
+                                   const mbedtls_ssl_iovec *iov,
+                                   size_t iovcnt);
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
+#if defined(MBEDTLS_SSL_KTLS)
+#define MBEDTLS_SSL_KTLS_TX                     1   /*!< Outgoing records */
+#define MBEDTLS_SSL_KTLS_RX                     2   /*!< Incoming records */
+
+/**
+ * \brief          Callback type: send a record whose protection is done by
+ *                 the kernel, see mbedtls_ssl_set_ktls().
+ *
+ * \param ctx      Context for the callback (typically a file descriptor)
+ * \param record_type The content type of the record, for example
+ *                 #MBEDTLS_SSL_MSG_ALERT.
+ * \param buf      Plaintext content of the record
+ * \param len      Length of the content
+ *
+ * \return         The callback must return the number of bytes sent if any,
+ *                 or a non-zero error code.
+ *                 If performing non-blocking I/O, \c MBEDTLS_ERR_SSL_WANT_WRITE
+ *                 must be returned when the operation would block.
+ */
+typedef int mbedtls_ssl_ktls_send_t(void *ctx,
+                                    int record_type,
+                                    const unsigned char *buf,
+                                    size_t len);
+
+/**
+ * \brief          Callback type: receive the content of a record whose
+ *                 protection is done by the kernel, see mbedtls_ssl_set_ktls().
+ *
+ * \param ctx      Context for the callback (typically a file descriptor)
+ * \param record_type On success, the content type of the record read.
+ * \param buf      Buffer to write the plaintext content to
+ * \param len      Length of the buffer
+ *
+ * \return         The callback must return the number of bytes received,
+ *                 or a non-zero error code. It must not return content from
+ *                 records of different types in one call.
+ *                 If performing non-blocking I/O, \c MBEDTLS_ERR_SSL_WANT_READ
+ *                 must be returned when the operation would block.
+ */
+typedef int mbedtls_ssl_ktls_recv_t(void *ctx,
+                                    int *record_type,
+                                    unsigned char *buf,
+                                    size_t len);
+#endif /* MBEDTLS_SSL_KTLS */
+
 /**
  * \brief          Callback type: receive data from the network.
  *
@@ -874,6 +978,14 @@ typedef struct mbedtls_ssl_key_cert mbedtls_ssl_key_cert;
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
 typedef struct mbedtls_ssl_flight_item mbedtls_ssl_flight_item;
 #endif
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+typedef struct mbedtls_ssl_out_queue mbedtls_ssl_out_queue;
+#endif
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+/* Defined in mbedtls/ssl_buffer_pool.h */
+typedef struct mbedtls_ssl_buffer_pool mbedtls_ssl_buffer_pool;
+#endif
 
 #if defined(MBEDTLS_SSL_PROTO_TLS1_3) && defined(MBEDTLS_SSL_SESSION_TICKETS)
 #define MBEDTLS_SSL_TLS1_3_TICKET_ALLOW_PSK_RESUMPTION                          \
@@ -1428,6 +1540,7 @@ struct mbedtls_ssl_config {
     uint8_t MBEDTLS_PRIVATE(authmode);      /*!< MBEDTLS_SSL_VERIFY_XXX             */
     /* needed even with renego disabled for LEGACY_BREAK_HANDSHAKE          */
     uint8_t MBEDTLS_PRIVATE(allow_legacy_renegotiation); /*!< MBEDTLS_LEGACY_XXX   */
+    uint8_t MBEDTLS_PRIVATE(read_ahead);    /*!< read ahead on TLS transport?       */
 #if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
     uint8_t MBEDTLS_PRIVATE(mfl_code);      /*!< desired fragment length indicator
                                                  (MBEDTLS_SSL_MAX_FRAG_LEN_XXX) */
@@ -1482,6 +1595,10 @@ struct mbedtls_ssl_config {
 #if defined(MBEDTLS_SSL_PROTO_TLS1_3)
     /** Allowed TLS 1.3 key exchange modes.                                 */
     int MBEDTLS_PRIVATE(tls13_kex_modes);
+#if defined(MBEDTLS_SSL_CLI_C)
+    /** Number of key shares offered in the first ClientHello (1 or 2)     */
+    int MBEDTLS_PRIVATE(tls13_key_shares);
+#endif /* MBEDTLS_SSL_CLI_C */
 #endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
 
     /** Callback for printing debug output                                  */
@@ -1537,6 +1654,23 @@ struct mbedtls_ssl_config {
     int(*MBEDTLS_PRIVATE(f_ticket_parse))(void *, mbedtls_ssl_session *, unsigned char *, size_t);
     void *MBEDTLS_PRIVATE(p_ticket);                 /*!< context for the ticket callbacks   */
 #endif /* MBEDTLS_SSL_SESSION_TICKETS && MBEDTLS_SSL_SRV_C */
+
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+    /** Callback to store a session the client can resume                  */
+    int(*MBEDTLS_PRIVATE(f_session_store_put))(void *, const char *, uint16_t,
+                                               const mbedtls_ssl_session *);
+    /** Callback to retrieve a session to resume                            */
+    int(*MBEDTLS_PRIVATE(f_session_store_take))(void *, const char *, uint16_t,
+                                                mbedtls_ssl_session *);
+    void *MBEDTLS_PRIVATE(p_session_store);          /*!< context for the store callbacks    */
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+    /** Callback to retrieve the group a server selected last time          */
+    int(*MBEDTLS_PRIVATE(f_key_share_get))(void *, const char *, uint16_t, uint16_t *);
+    /** Callback to remember the group a server selected                    */
+    int(*MBEDTLS_PRIVATE(f_key_share_set))(void *, const char *, uint16_t, uint16_t);
+    void *MBEDTLS_PRIVATE(p_key_share_cache);        /*!< context for the cache callbacks    */
+#endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
+#endif /* MBEDTLS_SSL_CLI_C && MBEDTLS_X509_CRT_PARSE_C */
 #if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
     size_t MBEDTLS_PRIVATE(cid_len); /*!< The length of CIDs for incoming DTLS records.      */
 #endif /* MBEDTLS_SSL_DTLS_CONNECTION_ID */
@@ -1622,6 +1756,13 @@ struct mbedtls_ssl_config {
 #if defined(MBEDTLS_SSL_SRV_C)
     /* The maximum amount of 0-RTT data. RFC 8446 section 4.6.1 */
     uint32_t MBEDTLS_PRIVATE(max_early_data_size);
+
+#if defined(MBEDTLS_HAVE_TIME)
+    /** Callback to detect replayed early data. RFC 8446 section 8 */
+    int(*MBEDTLS_PRIVATE(f_early_data_replay))(void *, const unsigned char *,
+                                               size_t, mbedtls_ms_time_t);
+    void *MBEDTLS_PRIVATE(p_early_data_replay); /*!< context for the callback */
+#endif /* MBEDTLS_HAVE_TIME */
 #endif /* MBEDTLS_SSL_SRV_C */
 
 #endif /* MBEDTLS_SSL_EARLY_DATA */
@@ -1643,6 +1784,25 @@ struct mbedtls_ssl_config {
 
     uint32_t MBEDTLS_PRIVATE(read_timeout);          /*!< timeout for mbedtls_ssl_read (ms)  */
 
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+    uint16_t MBEDTLS_PRIVATE(drs_initial_len);       /*!< record payload limit on new or
+                                                        idle connections, 0 if disabled */
+    uint32_t MBEDTLS_PRIVATE(drs_boost_threshold);   /*!< data sent in small records before
+                                                        switching to full-size records  */
+    uint32_t MBEDTLS_PRIVATE(drs_idle_timeout);      /*!< idle time (ms) after which
+                                                        records are small again         */
+#endif
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    mbedtls_ssl_buffer_pool *MBEDTLS_PRIVATE(buffer_pool); /*!< pool lending I/O
+                                                              buffers, or NULL    */
+#endif
+
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+    size_t MBEDTLS_PRIVATE(hs_arena_size);           /*!< size of the per-handshake
+                                                        arena, 0 if disabled    */
+#endif
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     uint32_t MBEDTLS_PRIVATE(hs_timeout_min);        /*!< initial value of the handshake
                                                         retransmission timeout (ms)        */
@@ -1658,6 +1818,10 @@ struct mbedtls_ssl_config {
 
     unsigned int MBEDTLS_PRIVATE(badmac_limit);      /*!< limit of records with a bad MAC    */
 
+#if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
+    uint16_t MBEDTLS_PRIVATE(replay_window);         /*!< size of the anti-replay window     */
+#endif
+
 #if defined(MBEDTLS_DHM_C) && defined(MBEDTLS_SSL_CLI_C)
     unsigned int MBEDTLS_PRIVATE(dhm_min_bitlen);    /*!< min. bit length of the DHM prime   */
 #endif
@@ -1730,6 +1894,18 @@ struct mbedtls_ssl_context {
     mbedtls_ssl_recv_t *MBEDTLS_PRIVATE(f_recv); /*!< Callback for network receive */
     mbedtls_ssl_recv_timeout_t *MBEDTLS_PRIVATE(f_recv_timeout);
     /*!< Callback for network receive with timeout */
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    mbedtls_ssl_send_vec_t *MBEDTLS_PRIVATE(f_send_vec);
+    /*!< Callback for vectored network send */
+#endif
+#if defined(MBEDTLS_SSL_KTLS)
+    mbedtls_ssl_ktls_send_t *MBEDTLS_PRIVATE(f_ktls_send);
+    /*!< Callback for sending records protected by the kernel */
+    mbedtls_ssl_ktls_recv_t *MBEDTLS_PRIVATE(f_ktls_recv);
+    /*!< Callback for receiving records protected by the kernel */
+    uint8_t MBEDTLS_PRIVATE(ktls);          /*!< directions handed over to the
+                                               kernel, MBEDTLS_SSL_KTLS_xX */
+#endif
 
     void *MBEDTLS_PRIVATE(p_bio);                /*!< context for I/O operations   */
 
@@ -1776,6 +1952,15 @@ struct mbedtls_ssl_context {
     mbedtls_ssl_set_timer_t *MBEDTLS_PRIVATE(f_set_timer);       /*!< set timer callback */
     mbedtls_ssl_get_timer_t *MBEDTLS_PRIVATE(f_get_timer);       /*!< get timer callback */
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    mbedtls_ssl_buffer_pool *MBEDTLS_PRIVATE(buffer_pool); /*!< pool the I/O buffers
+                                                              are borrowed from,
+                                                              or NULL           */
+    unsigned char MBEDTLS_PRIVATE(pool_in_ctr)[MBEDTLS_SSL_SEQUENCE_NUMBER_LEN]; /*!< in_ctr
+                                                              while the buffers
+                                                              are returned      */
+#endif
+
     /*
      * Record layer (incoming data)
      */
@@ -1801,12 +1986,14 @@ struct mbedtls_ssl_context {
 #endif
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     uint16_t MBEDTLS_PRIVATE(in_epoch);          /*!< DTLS epoch for incoming records  */
-    size_t MBEDTLS_PRIVATE(next_record_offset);  /*!< offset of the next record in datagram
-                                                    (equal to in_left if none)       */
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
+    size_t MBEDTLS_PRIVATE(next_record_offset);  /*!< offset of the next record in datagram,
+                                                    or in data read ahead (TLS)
+                                                    (equal to in_left if none)       */
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
     uint64_t MBEDTLS_PRIVATE(in_window_top);     /*!< last validated record seq_num    */
-    uint64_t MBEDTLS_PRIVATE(in_window);         /*!< bitmask for replay detection     */
+    uint64_t MBEDTLS_PRIVATE(in_window)[MBEDTLS_SSL_DTLS_REPLAY_WINDOW_WORDS]; /*!< circular
+                                                    bitmap for replay detection      */
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
     size_t MBEDTLS_PRIVATE(in_hslen);            /*!< current handshake message length,
@@ -1864,12 +2051,32 @@ struct mbedtls_ssl_context {
     int MBEDTLS_PRIVATE(out_msgtype);            /*!< record header: message type      */
     size_t MBEDTLS_PRIVATE(out_msglen);          /*!< record header: message length    */
     size_t MBEDTLS_PRIVATE(out_left);            /*!< amount of data not yet written   */
+    size_t MBEDTLS_PRIVATE(out_reserved);        /*!< capacity handed out by
+                                                    mbedtls_ssl_write_reserve(),
+                                                    0 if no reservation is active */
+    int MBEDTLS_PRIVATE(out_commit_pending);     /*!< a record committed with
+                                                    mbedtls_ssl_write_commit()
+                                                    is not fully sent yet */
 #if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
     size_t MBEDTLS_PRIVATE(out_buf_len);         /*!< length of output buffer          */
 #endif
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    mbedtls_ssl_out_queue *MBEDTLS_PRIVATE(out_queue); /*!< complete records
+                                                          held back for a
+                                                          vectored send */
+#endif
 
     unsigned char MBEDTLS_PRIVATE(cur_out_ctr)[MBEDTLS_SSL_SEQUENCE_NUMBER_LEN]; /*!<  Outgoing record sequence  number. */
 
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+    uint32_t MBEDTLS_PRIVATE(drs_bytes_sent);    /*!< application data sent in small
+                                                    records, up to the boost threshold */
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_ms_time_t MBEDTLS_PRIVATE(drs_last_write); /*!< time of the last
+                                                          application data write */
+#endif
+#endif /* MBEDTLS_SSL_DYNAMIC_RECORD_SIZING */
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     uint16_t MBEDTLS_PRIVATE(mtu);               /*!< path mtu, used to fragment outgoing messages */
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
@@ -1880,6 +2087,9 @@ struct mbedtls_ssl_context {
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
     char *MBEDTLS_PRIVATE(hostname);             /*!< expected peer CN for verification
                                                     (and SNI if available)                 */
+#if defined(MBEDTLS_SSL_CLI_C)
+    uint16_t MBEDTLS_PRIVATE(peer_port);         /*!< server port, for the session store   */
+#endif /* MBEDTLS_SSL_CLI_C */
 #endif /* MBEDTLS_X509_CRT_PARSE_C */
 
 #if defined(MBEDTLS_SSL_ALPN)
@@ -2133,6 +2343,57 @@ void mbedtls_ssl_conf_early_data(mbedtls_ssl_config *conf,
  */
 void mbedtls_ssl_conf_max_early_data_size(
     mbedtls_ssl_config *conf, uint32_t max_early_data_size);
+
+#if defined(MBEDTLS_HAVE_TIME)
+/**
+ * \brief           Callback type: check that a ClientHello offering early
+ *                  data is not a replay
+ *
+ * \note            This describes what a callback implementation should do.
+ *                  The callback is called for a ClientHello whose early data
+ *                  the server would otherwise accept. It should reject the
+ *                  early data if the same ClientHello may have been accepted
+ *                  before, or if it did not arrive close enough to
+ *                  \p expected_arrival_time, and record the ClientHello
+ *                  otherwise. See RFC 8446 section 8.
+ *
+ * \param p_replay  Context for the callback
+ * \param binder    The PSK binder of the ClientHello, which identifies it
+ * \param binder_len Length of the binder
+ * \param expected_arrival_time The time, in milliseconds on the
+ *                  mbedtls_ms_time() clock, at which the ClientHello was
+ *                  expected to arrive: the creation time of the ticket plus
+ *                  the ticket age reported by the client.
+ *
+ * \return          0 if the early data can be accepted, or any non-zero
+ *                  code to reject it. The handshake then goes on without
+ *                  early data.
+ */
+typedef int mbedtls_ssl_early_data_replay_t(void *p_replay,
+                                            const unsigned char *binder,
+                                            size_t binder_len,
+                                            mbedtls_ms_time_t expected_arrival_time);
+
+/**
+ * \brief           Configure the early data anti-replay callback (server
+ *                  only).
+ *                  (Default: none.)
+ *
+ * \warning         Without a callback, a server that enables early data
+ *                  accepts any ClientHello that passes the other checks,
+ *                  including a copy of one that was already accepted, so
+ *                  an attacker can make it process the same early data
+ *                  several times. mbedtls_ssl_early_data_replay_check() in
+ *                  ssl_early_data_replay.h implements this callback.
+ *
+ * \param conf      SSL configuration context
+ * \param f_early_data_replay Anti-replay callback, or \c NULL to disable it
+ * \param p_early_data_replay Context for the callback
+ */
+void mbedtls_ssl_conf_early_data_replay(mbedtls_ssl_config *conf,
+                                        mbedtls_ssl_early_data_replay_t *f_early_data_replay,
+                                        void *p_early_data_replay);
+#endif /* MBEDTLS_HAVE_TIME */
 #endif /* MBEDTLS_SSL_SRV_C */
 
 #endif /* MBEDTLS_SSL_EARLY_DATA */
@@ -2239,6 +2500,147 @@ void mbedtls_ssl_set_bio(mbedtls_ssl_context *ssl,
                          mbedtls_ssl_recv_t *f_recv,
                          mbedtls_ssl_recv_timeout_t *f_recv_timeout);
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+/**
+ * \brief          Set a vectored send callback, to be used in addition to the
+ *                 callbacks set with mbedtls_ssl_set_bio().
+ *
+ *                 When this callback is set and the transport is a stream
+ *                 (TLS), complete records are held back in a small queue and
+ *                 handed to \p f_send_vec together, instead of being sent one
+ *                 by one with the \c f_send callback:
+ *                 - the handshake messages of a flight are sent when the
+ *                   handshake next waits for input from the peer, or when it
+ *                   completes;
+ *                 - mbedtls_ssl_write() accepts up to
+ *                   #MBEDTLS_SSL_OUT_QUEUE_LEN + 1 records worth of data in a
+ *                   single call, and sends them at once.
+ *
+ *                 This reduces the number of system calls and lets the
+ *                 network stack pack the records into fewer segments.
+ *
+ * \param ssl      SSL context
+ * \param f_send_vec vectored write callback, using the \c p_bio context
+ *                 passed to mbedtls_ssl_set_bio(), or \c NULL to send
+ *                 records one by one again.
+ *
+ * \note           If mbedtls_ssl_write() returns
+ *                 #MBEDTLS_ERR_SSL_WANT_WRITE, it must be called again with
+ *                 the same arguments, as usual. It then returns the amount of
+ *                 data accepted by the first call once it has all been sent.
+ *
+ * \note           Each record held back occupies an additional buffer of
+ *                 the size of the output buffer, which is allocated the
+ *                 first time it is needed and kept until the context is
+ *                 freed.
+ *
+ * \note           This has no effect for DTLS, where records are already
+ *                 packed into datagrams.
+ *
+ * \note           On some platforms, net_sockets.c provides
+ *                 \c mbedtls_net_send_vec() that is suitable to be used here.
+ */
+void mbedtls_ssl_set_bio_vec(mbedtls_ssl_context *ssl,
+                             mbedtls_ssl_send_vec_t *f_send_vec);
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
+#if defined(MBEDTLS_SSL_KTLS)
+/**
+ * \brief          Traffic keys and record state of one direction of a
+ *                 connection, as needed to hand record protection over to
+ *                 the operating system kernel (kTLS),
+ *                 see mbedtls_ssl_get_ktls_info().
+ */
+typedef struct mbedtls_ssl_ktls_info {
+    mbedtls_ssl_protocol_version tls_version;   /*!< Negotiated version */
+    mbedtls_cipher_type_t cipher;   /*!< #MBEDTLS_CIPHER_AES_128_GCM,
+                                         #MBEDTLS_CIPHER_AES_256_GCM or
+                                         #MBEDTLS_CIPHER_CHACHA20_POLY1305 */
+    unsigned char key[32];          /*!< Traffic key */
+    size_t key_len;                 /*!< Length of \c key in bytes */
+    unsigned char iv[12];           /*!< Static IV: the 4-byte implicit
+                                         nonce for TLS 1.2 with AES-GCM,
+                                         the 12-byte IV otherwise */
+    size_t iv_len;                  /*!< Length of \c iv in bytes */
+    unsigned char rec_seq[8];       /*!< Sequence number of the next record,
+                                         big endian */
+} mbedtls_ssl_ktls_info;
+
+/**
+ * \brief          Get the traffic key, IV and sequence number of one
+ *                 direction of an established TLS connection, in order to
+ *                 hand record protection over to the kernel (for example
+ *                 with Linux kernel TLS).
+ *
+ * \param ssl      SSL context, with the handshake completed
+ * \param direction #MBEDTLS_SSL_KTLS_TX or #MBEDTLS_SSL_KTLS_RX
+ * \param info     On success, the state of the given direction.
+ *
+ * \note           The information is only valid until the next record is
+ *                 sent or received in that direction. In the receive
+ *                 direction, no data must be buffered in the context, see
+ *                 mbedtls_ssl_check_pending().
+ *
+ * \warning        \p info holds secret keys. Erase it with
+ *                 mbedtls_platform_zeroize() once it has been used.
+ *
+ * \return         \c 0 on success.
+ * \return         #MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE if the negotiated
+ *                 ciphersuite is not AES-GCM or ChaCha20-Poly1305, or the
+ *                 transport is DTLS.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if the handshake is not
+ *                 completed, data is pending in that direction, the
+ *                 direction is already handed over to the kernel, or
+ *                 renegotiation is enabled.
+ */
+int mbedtls_ssl_get_ktls_info(const mbedtls_ssl_context *ssl,
+                              int direction,
+                              mbedtls_ssl_ktls_info *info);
+
+/**
+ * \brief          Declare that record protection for some directions of
+ *                 the connection is now done by the kernel, with the keys
+ *                 obtained from mbedtls_ssl_get_ktls_info().
+ *
+ *                 In these directions, records are then no longer protected
+ *                 by the library: their plaintext content is passed to
+ *                 \p f_ktls_send or received from \p f_ktls_recv with its
+ *                 content type, using the \c p_bio context passed to
+ *                 mbedtls_ssl_set_bio(). mbedtls_ssl_read(),
+ *                 mbedtls_ssl_write() and mbedtls_ssl_close_notify() keep
+ *                 working as usual, so alerts and post-handshake messages
+ *                 such as TLS 1.3 NewSessionTicket are still handled by the
+ *                 library. Application data may also be sent or received
+ *                 directly on the underlying socket, for example with
+ *                 \c sendfile().
+ *
+ * \param ssl      SSL context, with the handshake completed
+ * \param directions #MBEDTLS_SSL_KTLS_TX, #MBEDTLS_SSL_KTLS_RX, or both
+ *                 combined with a bitwise or.
+ * \param f_ktls_send Callback to send records, required if
+ *                 #MBEDTLS_SSL_KTLS_TX is in \p directions.
+ * \param f_ktls_recv Callback to receive records, required if
+ *                 #MBEDTLS_SSL_KTLS_RX is in \p directions.
+ *
+ * \note           Renegotiation must be disabled (this is the default).
+ *                 TLS 1.3 KeyUpdate is not supported on such connections.
+ *
+ * \note           This cannot be undone, except by mbedtls_ssl_session_reset().
+ *
+ * \note           On Linux, net_sockets.c provides \c mbedtls_net_ktls_enable()
+ *                 which configures the kernel and calls this function.
+ *
+ * \return         \c 0 on success.
+ * \return         #MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE or
+ *                 #MBEDTLS_ERR_SSL_BAD_INPUT_DATA under the same conditions as
+ *                 mbedtls_ssl_get_ktls_info(), or if a callback is missing.
+ */
+int mbedtls_ssl_set_ktls(mbedtls_ssl_context *ssl,
+                         int directions,
+                         mbedtls_ssl_ktls_send_t *f_ktls_send,
+                         mbedtls_ssl_ktls_recv_t *f_ktls_recv);
+#endif /* MBEDTLS_SSL_KTLS */
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
 
 #if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
@@ -2495,6 +2897,137 @@ void mbedtls_ssl_set_verify(mbedtls_ssl_context *ssl,
  */
 void mbedtls_ssl_conf_read_timeout(mbedtls_ssl_config *conf, uint32_t timeout);
 
+/**
+ * \brief          Enable or disable read-ahead for TLS.
+ *                 (TLS only, no effect on DTLS.)
+ *                 Default: disabled.
+ *
+ *                 By default, the receive callback is asked for exactly the
+ *                 data needed: first the record header, then the rest of
+ *                 the record. With read-ahead enabled, it is asked for as
+ *                 much data as fits in the input buffer, and further
+ *                 records are then processed from the input buffer without
+ *                 calling it again. With many small records, this roughly
+ *                 halves the number of calls to the receive callback.
+ *
+ * \param conf     SSL configuration
+ * \param mode     MBEDTLS_SSL_READ_AHEAD_ENABLED or
+ *                 MBEDTLS_SSL_READ_AHEAD_DISABLED.
+ *
+ * \note           With read-ahead, data may be pending in the input buffer
+ *                 while the underlying transport has nothing to read. See
+ *                 mbedtls_ssl_check_pending().
+ *
+ * \warning        Data read ahead belongs to the SSL context. Don't enable
+ *                 this if the application reads from the underlying
+ *                 transport itself after some point, e.g. after receiving a
+ *                 close_notify alert or when upgrading a connection.
+ */
+void mbedtls_ssl_conf_read_ahead(mbedtls_ssl_config *conf, char mode);
+
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+/**
+ * \brief          Set the dynamic record sizing policy for application data.
+ *                 (TLS only, no effect on DTLS.)
+ *                 Default: disabled, records are always filled up to the
+ *                 maximum payload, see mbedtls_ssl_get_max_out_record_payload().
+ *
+ *                 When enabled, mbedtls_ssl_write() and
+ *                 mbedtls_ssl_write_reserve() limit records to
+ *                 \p initial_len bytes of payload on new connections, until
+ *                 \p boost_threshold bytes of application data have been
+ *                 sent. Records then grow to the maximum payload for
+ *                 throughput. After \p idle_timeout milliseconds without
+ *                 any application data written, records are small again.
+ *
+ *                 Records that fit in a single TCP segment can be decrypted
+ *                 by the peer as soon as that segment arrives, which reduces
+ *                 the time to first byte at the start of a response.
+ *
+ * \param conf     SSL configuration
+ * \param initial_len Payload limit of records on new or idle connections,
+ *                 or 0 to disable dynamic record sizing. With a typical
+ *                 Ethernet MSS of 1460 bytes and AES-GCM, a value of 1400
+ *                 leaves room for the record header and expansion, see
+ *                 mbedtls_ssl_get_record_expansion().
+ * \param boost_threshold Amount of application data, in bytes, to send in
+ *                 small records before switching to full-size records,
+ *                 for example 1 MB.
+ * \param idle_timeout Idle time in milliseconds after which records are
+ *                 small again, or 0 to never go back to small records,
+ *                 for example 1000. This is ignored without
+ *                 MBEDTLS_HAVE_TIME.
+ *
+ * \note           The limit does not change while a write is being retried
+ *                 after #MBEDTLS_ERR_SSL_WANT_WRITE.
+ */
+void mbedtls_ssl_conf_dynamic_record_sizing(mbedtls_ssl_config *conf,
+                                            uint16_t initial_len,
+                                            uint32_t boost_threshold,
+                                            uint32_t idle_timeout);
+#endif /* MBEDTLS_SSL_DYNAMIC_RECORD_SIZING */
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+/**
+ * \brief          Set the buffer pool that TLS connections borrow their input
+ *                 and output buffers from, instead of allocating their own.
+ *                 (TLS only, DTLS connections always allocate their own.)
+ *                 Default: NULL, no pool.
+ *
+ *                 A connection holds buffers from the pool only while it has
+ *                 data in flight, that is during the handshake, while a
+ *                 record is partially received or not yet fully sent, and
+ *                 while received application data has not been read. After
+ *                 mbedtls_ssl_read() returns #MBEDTLS_ERR_SSL_WANT_READ or
+ *                 has returned all pending data, and after a write has
+ *                 completed, the buffers are wiped and returned to the pool.
+ *
+ * \note           This must be called before mbedtls_ssl_setup(), and the
+ *                 pool must outlive all SSL contexts using it.
+ *
+ * \note           Functions that read or write records can fail with
+ *                 #MBEDTLS_ERR_SSL_ALLOC_FAILED if no buffer is available.
+ *                 They can be called again later.
+ *
+ * \note           Buffers from the pool always have the maximum size, even
+ *                 with MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH.
+ *
+ * \param conf     SSL configuration
+ * \param pool     Buffer pool set up with mbedtls_ssl_buffer_pool_setup(),
+ *                 or NULL to allocate buffers for each connection.
+ */
+void mbedtls_ssl_conf_buffer_pool(mbedtls_ssl_config *conf,
+                                  mbedtls_ssl_buffer_pool *pool);
+#endif /* MBEDTLS_SSL_BUFFER_POOL_C */
+
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+/**
+ * \brief          Set the size of the per-handshake arena (Default: 0)
+ *
+ *                 When the size is not 0, each handshake allocates one block
+ *                 of this size when it starts, and serves the state that is
+ *                 only needed until the handshake completes from it: buffered
+ *                 and retransmitted DTLS messages, cookies, the client's
+ *                 EC J-PAKE and supported groups caches, and TLS 1.3 handshake
+ *                 traffic keys and certificate request context. The block is
+ *                 wiped and freed in one step when the handshake completes,
+ *                 instead of each item being freed separately.
+ *
+ * \note           Allocations that do not fit in the remaining space of the
+ *                 arena, and memory allocated by the crypto and X.509 modules,
+ *                 use the regular allocator. If the arena itself cannot be
+ *                 allocated, the handshake uses the regular allocator only.
+ *
+ * \note           A few kilobytes are enough for TLS handshakes. DTLS
+ *                 handshakes that buffer out-of-order messages can use up to
+ *                 #MBEDTLS_SSL_DTLS_MAX_BUFFERING more.
+ *
+ * \param conf     SSL configuration
+ * \param size     Arena size in bytes, or 0 to allocate each item separately.
+ */
+void mbedtls_ssl_conf_handshake_arena(mbedtls_ssl_config *conf, size_t size);
+#endif /* MBEDTLS_SSL_HANDSHAKE_ARENA */
+
 /**
  * \brief          Check whether a buffer contains a valid and authentic record
  *                 that has not been seen before. (DTLS only).
@@ -3064,6 +3597,28 @@ int mbedtls_ssl_set_client_transport_id(mbedtls_ssl_context *ssl,
  *                 transmission strategy, then you'll want to disable this.
  */
 void mbedtls_ssl_conf_dtls_anti_replay(mbedtls_ssl_config *conf, char mode);
+
+/**
+ * \brief          Set the size of the DTLS anti-replay window.
+ *                 (DTLS only, no effect on TLS.)
+ *                 Default: 64.
+ *
+ *                 A record is rejected as too old when its sequence number
+ *                 is this many or more below the highest one seen. A wider
+ *                 window accepts records that are reordered further on the
+ *                 network, such as with high packet rates over several
+ *                 paths, without slowing down the processing of records.
+ *
+ * \param conf     SSL configuration
+ * \param window   Size of the window in records, between 64 and
+ *                 #MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX.
+ *
+ * \return         0 on success,
+ *                 #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p window is out of
+ *                 range.
+ */
+int mbedtls_ssl_conf_dtls_replay_window(mbedtls_ssl_config *conf,
+                                        unsigned window);
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
 /**
@@ -3252,6 +3807,142 @@ void mbedtls_ssl_conf_session_cache(mbedtls_ssl_config *conf,
 int mbedtls_ssl_set_session(mbedtls_ssl_context *ssl, const mbedtls_ssl_session *session);
 #endif /* MBEDTLS_SSL_CLI_C */
 
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+/**
+ * \brief          Callback type: store a resumable session
+ *
+ * \param p_store  Context for the callback
+ * \param hostname The host name of the server the session is with
+ * \param port     The port of the server, as set with
+ *                 mbedtls_ssl_set_peer_port()
+ * \param session  The session to store. The callback must copy it, for
+ *                 example with mbedtls_ssl_session_save().
+ *
+ * \return         \c 0 on success, or a negative error code. Errors are
+ *                 not fatal to the connection.
+ */
+typedef int mbedtls_ssl_session_store_put_t(void *p_store,
+                                            const char *hostname,
+                                            uint16_t port,
+                                            const mbedtls_ssl_session *session);
+
+/**
+ * \brief          Callback type: retrieve a session to resume
+ *
+ * \param p_store  Context for the callback
+ * \param hostname The host name of the server
+ * \param port     The port of the server
+ * \param session  The session to populate, initialized with
+ *                 mbedtls_ssl_session_init()
+ *
+ * \return         \c 0 if a session was retrieved, or a negative error
+ *                 code, in which case the handshake goes on without
+ *                 resumption.
+ */
+typedef int mbedtls_ssl_session_store_take_t(void *p_store,
+                                             const char *hostname,
+                                             uint16_t port,
+                                             mbedtls_ssl_session *session);
+
+/**
+ * \brief          Set the client-side session store callbacks
+ *
+ *                 When they are set, each initial handshake of a context
+ *                 that has a host name, set with mbedtls_ssl_set_hostname(),
+ *                 and no session set with mbedtls_ssl_set_session() tries to
+ *                 resume a session retrieved with \p f_take. Every resumable
+ *                 session the client gets is given to \p f_put: each TLS 1.3
+ *                 ticket as it is received, and each TLS 1.2 session at the
+ *                 end of the handshake. The application still receives
+ *                 #MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET for TLS 1.3
+ *                 tickets.
+ *
+ *                 mbedtls_ssl_session_store_put() and
+ *                 mbedtls_ssl_session_store_take() in ssl_session_store.h
+ *                 implement these callbacks.
+ *
+ * \param conf     SSL configuration
+ * \param f_put    Callback storing a session, or \c NULL
+ * \param f_take   Callback retrieving a session, or \c NULL
+ * \param p_store  Context for both callbacks
+ */
+void mbedtls_ssl_conf_session_store(mbedtls_ssl_config *conf,
+                                    mbedtls_ssl_session_store_put_t *f_put,
+                                    mbedtls_ssl_session_store_take_t *f_take,
+                                    void *p_store);
+
+/**
+ * \brief          Set the port of the server, which identifies it in the
+ *                 session store together with the host name.
+ *                 (Default: 0)
+ *
+ * \param ssl      SSL context
+ * \param port     The port of the server
+ */
+void mbedtls_ssl_set_peer_port(mbedtls_ssl_context *ssl, uint16_t port);
+
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+/**
+ * \brief          Callback type: retrieve the group a server selected
+ *
+ * \param p_cache  Context for the callback
+ * \param hostname The host name of the server
+ * \param port     The port of the server, as set with
+ *                 mbedtls_ssl_set_peer_port()
+ * \param group_id On success, the IANA NamedGroup the server selected in
+ *                 its last TLS 1.3 handshake with this client
+ *
+ * \return         \c 0 if the group is known, or a negative error code.
+ */
+typedef int mbedtls_ssl_key_share_get_t(void *p_cache,
+                                        const char *hostname,
+                                        uint16_t port,
+                                        uint16_t *group_id);
+
+/**
+ * \brief          Callback type: remember the group a server selected
+ *
+ * \param p_cache  Context for the callback
+ * \param hostname The host name of the server
+ * \param port     The port of the server
+ * \param group_id The IANA NamedGroup the server selected
+ *
+ * \return         \c 0 on success, or a negative error code. Errors are
+ *                 not fatal to the connection.
+ */
+typedef int mbedtls_ssl_key_share_set_t(void *p_cache,
+                                        const char *hostname,
+                                        uint16_t port,
+                                        uint16_t group_id);
+
+/**
+ * \brief          Set the TLS 1.3 client-side key share cache callbacks
+ *
+ *                 When they are set, the first ClientHello of a context
+ *                 that has a host name, set with mbedtls_ssl_set_hostname(),
+ *                 offers a key share for the group the server selected last
+ *                 time, as returned by \p f_get, if it is still among the
+ *                 configured groups. This avoids a HelloRetryRequest when the
+ *                 server prefers another group than the first configured
+ *                 one. The group the server selects, in a ServerHello with a
+ *                 key share, is given to \p f_set.
+ *
+ *                 mbedtls_ssl_key_share_cache_get() and
+ *                 mbedtls_ssl_key_share_cache_set() in ssl_key_share_cache.h
+ *                 implement these callbacks.
+ *
+ * \param conf     SSL configuration
+ * \param f_get    Callback retrieving a group, or \c NULL
+ * \param f_set    Callback remembering a group, or \c NULL
+ * \param p_cache  Context for both callbacks
+ */
+void mbedtls_ssl_conf_key_share_cache(mbedtls_ssl_config *conf,
+                                      mbedtls_ssl_key_share_get_t *f_get,
+                                      mbedtls_ssl_key_share_set_t *f_set,
+                                      void *p_cache);
+#endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
+#endif /* MBEDTLS_SSL_CLI_C && MBEDTLS_X509_CRT_PARSE_C */
+
 /**
  * \brief          Load serialized session data into a session structure.
  *                 On client, this can be used for loading saved sessions
@@ -3905,6 +4596,28 @@ void MBEDTLS_DEPRECATED mbedtls_ssl_conf_curves(mbedtls_ssl_config *conf,
 void mbedtls_ssl_conf_groups(mbedtls_ssl_config *conf,
                              const uint16_t *groups);
 
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3) && defined(MBEDTLS_SSL_CLI_C)
+/**
+ * \brief          Set the number of key shares a TLS 1.3 client offers in
+ *                 its first ClientHello.
+ *                 (Default: 1)
+ *
+ *                 With one key share, the client offers the group the server
+ *                 selected last time if it is known (see
+ *                 mbedtls_ssl_conf_key_share_cache()), or else the first
+ *                 configured group. With two key shares, it also offers the
+ *                 next configured group, so that a server preferring either
+ *                 of them doesn't need a HelloRetryRequest, at the cost of
+ *                 an extra key generation and a larger ClientHello.
+ *
+ * \param conf           SSL configuration
+ * \param num_key_shares Number of key shares: 1 or 2. Other values are
+ *                       clamped to this range.
+ */
+void mbedtls_ssl_conf_tls13_key_shares(mbedtls_ssl_config *conf,
+                                       int num_key_shares);
+#endif /* MBEDTLS_SSL_PROTO_TLS1_3 && MBEDTLS_SSL_CLI_C */
+
 #if defined(MBEDTLS_SSL_HANDSHAKE_WITH_CERT_ENABLED)
 #if !defined(MBEDTLS_DEPRECATED_REMOVED) && defined(MBEDTLS_SSL_PROTO_TLS1_2)
 /**
@@ -4642,7 +5355,9 @@ void mbedtls_ssl_conf_renegotiation_period(mbedtls_ssl_config *conf,
  *                 also signal pending data, but the converse does
  *                 not hold. For example, in DTLS there might be
  *                 further records waiting to be processed from
- *                 the current underlying transport's datagram.
+ *                 the current underlying transport's datagram, and in TLS
+ *                 with read-ahead (see mbedtls_ssl_conf_read_ahead()),
+ *                 from the data read ahead.
  *
  * \note           If this function returns 1 (data pending), this
  *                 does not imply that a subsequent call to
@@ -5096,6 +5811,52 @@ int mbedtls_ssl_renegotiate(mbedtls_ssl_context *ssl);
  */
 int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len);
 
+/**
+ * \brief          Get a pointer to the decrypted application data that has
+ *                 not been read yet, without copying it.
+ *
+ *                 This is a zero-copy alternative to mbedtls_ssl_read(): the
+ *                 data is left in place in the input buffer, and the
+ *                 application marks how much of it it has processed with
+ *                 mbedtls_ssl_read_consume(). If no data is pending, records
+ *                 are read and processed exactly as by mbedtls_ssl_read().
+ *
+ * \param ssl      SSL context
+ * \param buf      On success, set to the first byte of pending application
+ *                 data, or to \c NULL if \p *len is \c 0. The data is
+ *                 valid until the next call to mbedtls_ssl_read_consume(),
+ *                 mbedtls_ssl_read() or any other function that reads from
+ *                 the connection.
+ * \param len      On success, set to the number of bytes available at
+ *                 \p *buf. This is at most the plaintext length of a
+ *                 single record. Empty records are skipped, so \c 0 means
+ *                 that the read end of the underlying transport was closed,
+ *                 as when mbedtls_ssl_read() returns \c 0.
+ *
+ * \return         \c 0 if successful.
+ * \return         Another error code, with the same meaning as for
+ *                 mbedtls_ssl_read().
+ */
+int mbedtls_ssl_read_peek(mbedtls_ssl_context *ssl,
+                          const unsigned char **buf, size_t *len);
+
+/**
+ * \brief          Mark application data returned by mbedtls_ssl_read_peek()
+ *                 as processed.
+ *
+ * \param ssl      SSL context
+ * \param len      The number of bytes consumed from the start of the
+ *                 pending data. This must not exceed the number of pending
+ *                 bytes. If it is less, the next call to
+ *                 mbedtls_ssl_read_peek() or mbedtls_ssl_read() returns the
+ *                 remaining bytes first.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p len exceeds the
+ *                 number of pending bytes.
+ */
+int mbedtls_ssl_read_consume(mbedtls_ssl_context *ssl, size_t len);
+
 /**
  * \brief          Try to write exactly 'len' application data bytes
  *
@@ -5166,6 +5927,64 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len);
  */
 int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t len);
 
+/**
+ * \brief          Reserve space for the plaintext of the next application
+ *                 data record directly in the output buffer.
+ *
+ *                 This is a zero-copy alternative to mbedtls_ssl_write(): the
+ *                 application writes its data at \p *buf and then calls
+ *                 mbedtls_ssl_write_commit() to encrypt and send it in
+ *                 place, saving the copy of the data into the output buffer.
+ *
+ * \param ssl      SSL context
+ * \param buf      On success, set to the start of the plaintext area of the
+ *                 next record. It remains valid until the reservation ends.
+ * \param len      On success, set to the number of bytes that may be
+ *                 written at \p *buf. This is the value returned by
+ *                 mbedtls_ssl_get_max_out_record_payload().
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_WANT_READ or #MBEDTLS_ERR_SSL_WANT_WRITE
+ *                 if the handshake is incomplete or previously written data
+ *                 is still waiting to be sent - in this case you must call
+ *                 this function again when the underlying transport is ready.
+ * \return         Another SSL error code, with the same meaning as for
+ *                 mbedtls_ssl_write().
+ *
+ * \note           The reservation ends when mbedtls_ssl_write_commit() is
+ *                 called, or when any other function writes a record to the
+ *                 connection (for example mbedtls_ssl_write(),
+ *                 mbedtls_ssl_send_alert_message(), or mbedtls_ssl_read()
+ *                 answering a post-handshake message). The area at \p *buf
+ *                 must not be used after that, and a later call to
+ *                 mbedtls_ssl_write_commit() fails.
+ */
+int mbedtls_ssl_write_reserve(mbedtls_ssl_context *ssl,
+                              unsigned char **buf, size_t *len);
+
+/**
+ * \brief          Encrypt and send the plaintext written into the area
+ *                 returned by mbedtls_ssl_write_reserve().
+ *
+ * \param ssl      SSL context
+ * \param len      The number of bytes written at the start of the reserved
+ *                 area. This must not exceed the reserved length. \c 0 sends
+ *                 an empty application record.
+ *
+ * \return         \p len if successful.
+ * \return         #MBEDTLS_ERR_SSL_WANT_WRITE if the record was encrypted
+ *                 but could not be sent in full yet - in this case the
+ *                 data is owned by the library and you must call this
+ *                 function again with the same \p len, without writing to
+ *                 the reserved area, when the transport is ready.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if neither a reservation
+ *                 nor a commit that returned #MBEDTLS_ERR_SSL_WANT_WRITE is
+ *                 pending, or if \p len exceeds the reserved length.
+ * \return         Another SSL error code, with the same meaning as for
+ *                 mbedtls_ssl_write().
+ */
+int mbedtls_ssl_write_commit(mbedtls_ssl_context *ssl, size_t len);
+
 /**
  * \brief           Send an alert message
  *
@@ -0,0 +1,119 @@
+/**
+ * \file ssl_buffer_pool.h
+ *
+ * \brief SSL I/O buffer pool shared between connections
+ *
+ * By default, each SSL context allocates its input and output buffers in
+ * mbedtls_ssl_setup() and keeps them until mbedtls_ssl_free(). A buffer
+ * pool attached to the configuration with mbedtls_ssl_conf_buffer_pool()
+ * instead lends buffers to TLS connections only while they have data in
+ * flight: during the handshake, while a record is partially received or
+ * not yet fully sent, and while decrypted application data waits to be
+ * read. Idle connections return their buffers to the pool, which reduces
+ * the memory used by servers that hold many mostly idle connections.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_BUFFER_POOL_H
+#define MBEDTLS_SSL_BUFFER_POOL_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+
+#if defined(MBEDTLS_THREADING_C)
+#include "mbedtls/threading.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Buffer pool statistics
+ */
+typedef struct mbedtls_ssl_buffer_pool_stats {
+    size_t in_use;          /*!< buffers currently lent to connections      */
+    size_t idle;            /*!< buffers kept in the pool for reuse         */
+    size_t peak_in_use;     /*!< highest value of in_use so far             */
+    size_t buf_len;         /*!< size of one buffer, for the input and
+                                 output buffers of one connection           */
+    unsigned long acquired; /*!< buffers lent since the pool was set up     */
+    unsigned long allocated; /*!< buffers that had to be allocated because
+                                  the pool had none left for reuse          */
+    unsigned long failed;   /*!< requests refused because of the in-use
+                                 limit or an allocation failure             */
+} mbedtls_ssl_buffer_pool_stats;
+
+/**
+ * \brief   Buffer pool context
+ */
+struct mbedtls_ssl_buffer_pool {
+    unsigned char **MBEDTLS_PRIVATE(free_bufs);  /*!< buffers kept for reuse */
+    size_t MBEDTLS_PRIVATE(max_idle);            /*!< size of free_bufs      */
+    size_t MBEDTLS_PRIVATE(max_in_use);          /*!< in-use limit, 0 for none */
+    mbedtls_ssl_buffer_pool_stats MBEDTLS_PRIVATE(stats); /*!< statistics    */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);    /*!< mutex          */
+#endif
+};
+
+/**
+ * \brief          Initialize a buffer pool
+ *
+ * \param pool     Buffer pool context
+ */
+void mbedtls_ssl_buffer_pool_init(mbedtls_ssl_buffer_pool *pool);
+
+/**
+ * \brief          Set up a buffer pool
+ *
+ * \param pool     Buffer pool context, initialized with
+ *                 mbedtls_ssl_buffer_pool_init()
+ * \param max_idle Maximum number of buffers kept in the pool when they are
+ *                 returned by idle connections. Further buffers are freed.
+ *                 Each buffer holds the input and output buffers of one
+ *                 connection, see mbedtls_ssl_buffer_pool_stats::buf_len.
+ * \param max_in_use Maximum number of buffers lent at the same time, or 0
+ *                 for no limit. When the limit is reached, functions that
+ *                 need a buffer, such as mbedtls_ssl_read(), fail with
+ *                 #MBEDTLS_ERR_SSL_ALLOC_FAILED, and can be called again
+ *                 later.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_ALLOC_FAILED if memory allocation failed.
+ */
+int mbedtls_ssl_buffer_pool_setup(mbedtls_ssl_buffer_pool *pool,
+                                  size_t max_idle, size_t max_in_use);
+
+/**
+ * \brief          Get the statistics of a buffer pool
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ * \param pool     Buffer pool context
+ * \param stats    Structure to fill
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_THREADING_MUTEX_ERROR on a mutex failure.
+ */
+int mbedtls_ssl_buffer_pool_get_stats(mbedtls_ssl_buffer_pool *pool,
+                                      mbedtls_ssl_buffer_pool_stats *stats);
+
+/**
+ * \brief          Free the buffers kept in a buffer pool and clear memory
+ *
+ * \note           All SSL contexts using the pool must have been freed
+ *                 with mbedtls_ssl_free() before.
+ *
+ * \param pool     Buffer pool context
+ */
+void mbedtls_ssl_buffer_pool_free(mbedtls_ssl_buffer_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_buffer_pool.h */
@@ -0,0 +1,169 @@
+/**
+ * \file ssl_cache_hash.h
+ *
+ * \brief SSL session cache for large numbers of sessions
+ *
+ * This cache has the same callbacks as the one in ssl_cache.h, but indexes
+ * sessions with a hash table instead of a list, evicts the least recently
+ * used session in constant time, and splits the sessions between several
+ * independently locked stripes so that concurrent handshakes rarely wait
+ * for each other.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_CACHE_HASH_H
+#define MBEDTLS_SSL_CACHE_HASH_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+
+/**
+ * \name SECTION: Module settings
+ *
+ * The configuration options you can set for this module are in this section.
+ * Either change them in mbedtls_config.h or define them on the compiler command line.
+ * \{
+ */
+
+#if !defined(MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT)
+#define MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT       86400   /*!< 1 day  */
+#endif
+
+#if !defined(MBEDTLS_SSL_CACHE_HASH_DEFAULT_STRIPES)
+#define MBEDTLS_SSL_CACHE_HASH_DEFAULT_STRIPES     16   /*!< Number of lock stripes */
+#endif
+
+/** \} name SECTION: Module settings */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Defined in library/ssl_cache_hash.c */
+typedef struct mbedtls_ssl_cache_hash_stripe mbedtls_ssl_cache_hash_stripe;
+
+/**
+ * \brief Hash-indexed cache context
+ */
+typedef struct mbedtls_ssl_cache_hash_context {
+    mbedtls_ssl_cache_hash_stripe *MBEDTLS_PRIVATE(stripes); /*!< lock stripes */
+    size_t MBEDTLS_PRIVATE(stripe_count);        /*!< number of stripes      */
+    int MBEDTLS_PRIVATE(timeout);                /*!< cache entry timeout    */
+} mbedtls_ssl_cache_hash_context;
+
+/**
+ * \brief          Initialize a hash-indexed SSL cache context
+ *
+ * \param cache    SSL cache context
+ */
+void mbedtls_ssl_cache_hash_init(mbedtls_ssl_cache_hash_context *cache);
+
+/**
+ * \brief          Set up a hash-indexed SSL cache context
+ *
+ * \param cache    SSL cache context, initialized with
+ *                 mbedtls_ssl_cache_hash_init()
+ * \param max_entries Maximum number of cached sessions. The sessions are
+ *                 distributed between the stripes by session ID, and each
+ *                 stripe holds up to \p max_entries / \p stripes sessions,
+ *                 rounded up. When a stripe is full, its least recently used
+ *                 session is evicted.
+ * \param stripes  Number of independently locked parts of the cache, or 0
+ *                 for #MBEDTLS_SSL_CACHE_HASH_DEFAULT_STRIPES. Using more
+ *                 stripes reduces lock contention between threads. This is
+ *                 capped to \p max_entries.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p max_entries is 0.
+ * \return         #MBEDTLS_ERR_SSL_ALLOC_FAILED if memory allocation failed.
+ */
+int mbedtls_ssl_cache_hash_setup(mbedtls_ssl_cache_hash_context *cache,
+                                 size_t max_entries, size_t stripes);
+
+/**
+ * \brief          Cache get callback implementation
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ * \param data            The SSL cache context to use.
+ * \param session_id      The pointer to the buffer holding the session ID
+ *                        for the session to load.
+ * \param session_id_len  The length of \p session_id in bytes.
+ * \param session         The address at which to store the session
+ *                        associated with \p session_id, if present.
+ *
+ * \return                \c 0 on success.
+ * \return                #MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND if there is
+ *                        no cache entry with specified session ID found, or
+ *                        any other negative error code for other failures.
+ */
+int mbedtls_ssl_cache_hash_get(void *data,
+                               unsigned char const *session_id,
+                               size_t session_id_len,
+                               mbedtls_ssl_session *session);
+
+/**
+ * \brief          Cache set callback implementation
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ * \param data            The SSL cache context to use.
+ * \param session_id      The pointer to the buffer holding the session ID
+ *                        associated to \p session.
+ * \param session_id_len  The length of \p session_id in bytes.
+ * \param session         The session to store.
+ *
+ * \return                \c 0 on success.
+ * \return                A negative error code on failure.
+ */
+int mbedtls_ssl_cache_hash_set(void *data,
+                               unsigned char const *session_id,
+                               size_t session_id_len,
+                               const mbedtls_ssl_session *session);
+
+/**
+ * \brief          Remove the cache entry by the session ID
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ * \param data            The SSL cache context to use.
+ * \param session_id      The pointer to the buffer holding the session ID
+ *                        associated to session.
+ * \param session_id_len  The length of \p session_id in bytes.
+ *
+ * \return                \c 0 on success. This indicates the cache entry for
+ *                        the session with provided ID is removed or does not
+ *                        exist.
+ * \return                A negative error code on failure.
+ */
+int mbedtls_ssl_cache_hash_remove(void *data,
+                                  unsigned char const *session_id,
+                                  size_t session_id_len);
+
+#if defined(MBEDTLS_HAVE_TIME)
+/**
+ * \brief          Set the cache timeout
+ *                 (Default: MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT (1 day))
+ *
+ *                 A timeout of 0 indicates no timeout.
+ *
+ * \param cache    SSL cache context
+ * \param timeout  cache entry timeout in seconds
+ */
+void mbedtls_ssl_cache_hash_set_timeout(mbedtls_ssl_cache_hash_context *cache,
+                                        int timeout);
+#endif /* MBEDTLS_HAVE_TIME */
+
+/**
+ * \brief          Free referenced items in a cache context and clear memory
+ *
+ * \param cache    SSL cache context
+ */
+void mbedtls_ssl_cache_hash_free(mbedtls_ssl_cache_hash_context *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_cache_hash.h */
@@ -0,0 +1,201 @@
+/**
+ * \file ssl_cache_shm.h
+ *
+ * \brief SSL session cache shared between processes
+ *
+ * This cache has the same callbacks as the one in ssl_cache.h, but keeps
+ * the sessions in a memory region shared between processes, so that the
+ * worker processes of a pre-forking server can resume each other's
+ * sessions. The region holds a fixed number of fixed-size slots, protected
+ * by robust process-shared mutexes: if a process dies while holding one,
+ * the next process to take it discards the slot that may have been left
+ * half written and goes on.
+ *
+ * The region is either anonymous, in which case it must be set up before
+ * the worker processes are forked, or backed by a file, in which case
+ * unrelated processes can share it by setting it up with the same path.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_CACHE_SHM_H
+#define MBEDTLS_SSL_CACHE_SHM_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+
+/**
+ * \name SECTION: Module settings
+ *
+ * The configuration options you can set for this module are in this section.
+ * Either change them in mbedtls_config.h or define them on the compiler command line.
+ * \{
+ */
+
+#if !defined(MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT)
+#define MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT       86400   /*!< 1 day  */
+#endif
+
+#if !defined(MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE)
+#define MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE          1024   /*!< Maximum size of a serialized session */
+#endif
+
+/** \} name SECTION: Module settings */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Shared-memory cache context
+ *
+ * Each process has its own context, which refers to the shared region.
+ */
+typedef struct mbedtls_ssl_cache_shm_context {
+    unsigned char *MBEDTLS_PRIVATE(region);      /*!< shared region           */
+    size_t MBEDTLS_PRIVATE(region_len);          /*!< size of the region      */
+    int MBEDTLS_PRIVATE(timeout);                /*!< cache entry timeout     */
+} mbedtls_ssl_cache_shm_context;
+
+/**
+ * \brief          Initialize a shared-memory SSL cache context
+ *
+ * \param cache    SSL cache context
+ */
+void mbedtls_ssl_cache_shm_init(mbedtls_ssl_cache_shm_context *cache);
+
+/**
+ * \brief          Set up a shared-memory SSL cache context
+ *
+ * \param cache    SSL cache context, initialized with
+ *                 mbedtls_ssl_cache_shm_init()
+ * \param path     The file backing the shared region, or \c NULL for an
+ *                 anonymous region. An anonymous region is only shared with
+ *                 the processes forked after this call. A file-backed region
+ *                 is created if needed, and can be shared by any process
+ *                 that sets up a cache with the same path and the same
+ *                 \p max_entries. The file keeps the sessions until it is
+ *                 removed or the system reboots, so it must only be
+ *                 readable by the server. On systems that do not provide
+ *                 a boot identifier (Linux provides one in
+ *                 /proc/sys/kernel/random/boot_id), a file that survives a
+ *                 reboot may hold mutexes that are never unlocked: place it
+ *                 on a file system that is emptied at boot, such as tmpfs.
+ * \param max_entries Maximum number of cached sessions, rounded up to a
+ *                 multiple of a small internal bucket size. Sessions are
+ *                 distributed between buckets by session ID, and a session
+ *                 stored in a full bucket replaces the least recently used
+ *                 one of that bucket.
+ *
+ * \note           Sessions whose serialized form is larger than
+ *                 #MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE, for example sessions
+ *                 that keep a large client certificate, are not cached.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p max_entries is 0 or
+ *                 too large, or if the file holds a cache with a different
+ *                 layout.
+ * \return         #MBEDTLS_ERR_SSL_ALLOC_FAILED if the region could not be
+ *                 mapped.
+ * \return         #MBEDTLS_ERR_SSL_INTERNAL_ERROR if the file could not be
+ *                 opened, locked or resized.
+ * \return         #MBEDTLS_ERR_THREADING_MUTEX_ERROR if the process-shared
+ *                 mutexes could not be created.
+ */
+int mbedtls_ssl_cache_shm_setup(mbedtls_ssl_cache_shm_context *cache,
+                                const char *path, size_t max_entries);
+
+/**
+ * \brief          Cache get callback implementation
+ *                 (Thread-safe and process-safe)
+ *
+ * \param data            The SSL cache context to use.
+ * \param session_id      The pointer to the buffer holding the session ID
+ *                        for the session to load.
+ * \param session_id_len  The length of \p session_id in bytes.
+ * \param session         The address at which to store the session
+ *                        associated with \p session_id, if present.
+ *
+ * \return                \c 0 on success.
+ * \return                #MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND if there is
+ *                        no cache entry with specified session ID found, or
+ *                        any other negative error code for other failures.
+ */
+int mbedtls_ssl_cache_shm_get(void *data,
+                              unsigned char const *session_id,
+                              size_t session_id_len,
+                              mbedtls_ssl_session *session);
+
+/**
+ * \brief          Cache set callback implementation
+ *                 (Thread-safe and process-safe)
+ *
+ * \param data            The SSL cache context to use.
+ * \param session_id      The pointer to the buffer holding the session ID
+ *                        associated to \p session.
+ * \param session_id_len  The length of \p session_id in bytes.
+ * \param session         The session to store.
+ *
+ * \return                \c 0 on success.
+ * \return                #MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL if the session
+ *                        does not fit in a slot.
+ * \return                Another negative error code on other failures.
+ */
+int mbedtls_ssl_cache_shm_set(void *data,
+                              unsigned char const *session_id,
+                              size_t session_id_len,
+                              const mbedtls_ssl_session *session);
+
+/**
+ * \brief          Remove the cache entry by the session ID
+ *                 (Thread-safe and process-safe)
+ *
+ * \param data            The SSL cache context to use.
+ * \param session_id      The pointer to the buffer holding the session ID
+ *                        associated to session.
+ * \param session_id_len  The length of \p session_id in bytes.
+ *
+ * \return                \c 0 on success. This indicates the cache entry for
+ *                        the session with provided ID is removed or does not
+ *                        exist.
+ * \return                A negative error code on failure.
+ */
+int mbedtls_ssl_cache_shm_remove(void *data,
+                                 unsigned char const *session_id,
+                                 size_t session_id_len);
+
+#if defined(MBEDTLS_HAVE_TIME)
+/**
+ * \brief          Set the cache timeout
+ *                 (Default: MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT (1 day))
+ *
+ *                 A timeout of 0 indicates no timeout. The timeout applies
+ *                 to the lookups made through this context only, so all
+ *                 processes sharing the region should set the same one.
+ *
+ * \param cache    SSL cache context
+ * \param timeout  cache entry timeout in seconds
+ */
+void mbedtls_ssl_cache_shm_set_timeout(mbedtls_ssl_cache_shm_context *cache,
+                                       int timeout);
+#endif /* MBEDTLS_HAVE_TIME */
+
+/**
+ * \brief          Unmap the shared region from this process and clear
+ *                 memory
+ *
+ *                 The sessions stay available to the other processes that
+ *                 share the region, and in the file if there is one.
+ *
+ * \param cache    SSL cache context
+ */
+void mbedtls_ssl_cache_shm_free(mbedtls_ssl_cache_shm_context *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_cache_shm.h */
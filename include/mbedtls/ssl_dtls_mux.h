@@ -0,0 +1,286 @@
+/**
+ * \file ssl_dtls_mux.h
+ *
+ * \brief DTLS server multiplexer over a single datagram socket
+ *
+ * A DTLS server built with mbedtls_net_accept() connects a new UDP socket
+ * to each client, which costs a file descriptor per client and loses the
+ * client when a NAT changes its address. The multiplexer instead serves
+ * all clients over one unconnected socket: it reads the datagrams, answers
+ * ClientHellos without a valid cookie with a HelloVerifyRequest without
+ * allocating anything, creates a connection for each client that returns a
+ * valid cookie, and dispatches the other datagrams to their connection.
+ *
+ * Each connection is given a random connection ID (RFC 9146) of the length
+ * set with mbedtls_ssl_conf_cid(). Records that carry a connection ID are
+ * dispatched by connection ID, so a client that negotiated one keeps its
+ * connection when its address changes; the replies then go to the new
+ * address, once a record from it has been authenticated. The other records
+ * are dispatched by client address. Both lookups use hash tables, so the
+ * cost of dispatching a datagram does not depend on the number of
+ * connections.
+ *
+ * The multiplexer is driven by mbedtls_ssl_dtls_mux_read() from an event
+ * loop that waits until the socket is readable or until the delay returned
+ * by mbedtls_ssl_dtls_mux_next_timeout() has elapsed. It is not
+ * thread-safe.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_DTLS_MUX_H
+#define MBEDTLS_SSL_DTLS_MUX_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+
+/**
+ * \name SECTION: Module settings
+ *
+ * The configuration options you can set for this module are in this section.
+ * Either change them in mbedtls_config.h or define them on the compiler command line.
+ * \{
+ */
+
+#if !defined(MBEDTLS_SSL_DTLS_MUX_ADDR_MAX_LEN)
+#define MBEDTLS_SSL_DTLS_MUX_ADDR_MAX_LEN          32   /*!< Maximum client address length */
+#endif
+
+/** \} name SECTION: Module settings */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief          Callback type: send a datagram to a client
+ *
+ * \param ctx      Context for the send callback (typically a socket)
+ * \param buf      Buffer holding the datagram to send
+ * \param len      Length of the datagram
+ * \param addr     Address of the client, as returned by the receive
+ *                 callback
+ * \param addr_len Length of the address
+ *
+ * \return         The number of bytes sent if successful, or
+ *                 #MBEDTLS_ERR_SSL_WANT_WRITE if the datagram cannot be
+ *                 sent now, or another negative error code.
+ *
+ * \note           mbedtls_net_send_to() is a suitable implementation for a
+ *                 UDP socket.
+ */
+typedef int mbedtls_ssl_dtls_mux_send_to_t(void *ctx,
+                                           const unsigned char *buf,
+                                           size_t len,
+                                           const unsigned char *addr,
+                                           size_t addr_len);
+
+/**
+ * \brief          Callback type: receive a datagram from any client
+ *
+ * \param ctx      Context for the receive callback (typically a socket)
+ * \param buf      Buffer to write the datagram to
+ * \param len      Size of the buffer
+ * \param addr     Buffer to write the address of the client to. Any
+ *                 encoding may be used, as long as each client has a unique
+ *                 address and the send callback understands it.
+ * \param addr_size Size of the address buffer
+ * \param addr_len On success, the length of the address
+ *
+ * \return         The length of the datagram if successful, or
+ *                 #MBEDTLS_ERR_SSL_WANT_READ if no datagram is available,
+ *                 or another negative error code.
+ *
+ * \note           This callback must not block.
+ *
+ * \note           mbedtls_net_recv_from() is a suitable implementation for a
+ *                 non-blocking UDP socket.
+ */
+typedef int mbedtls_ssl_dtls_mux_recv_from_t(void *ctx,
+                                             unsigned char *buf,
+                                             size_t len,
+                                             unsigned char *addr,
+                                             size_t addr_size,
+                                             size_t *addr_len);
+
+/* Defined in library/ssl_dtls_mux.c */
+typedef struct mbedtls_ssl_dtls_mux_conn mbedtls_ssl_dtls_mux_conn;
+
+/**
+ * \brief DTLS multiplexer context
+ */
+typedef struct mbedtls_ssl_dtls_mux_context {
+    const mbedtls_ssl_config *MBEDTLS_PRIVATE(conf); /*!< server config   */
+
+    void *MBEDTLS_PRIVATE(p_bio);                     /*!< transport context */
+    mbedtls_ssl_dtls_mux_send_to_t *MBEDTLS_PRIVATE(f_send_to);
+    mbedtls_ssl_dtls_mux_recv_from_t *MBEDTLS_PRIVATE(f_recv_from);
+
+    unsigned char *MBEDTLS_PRIVATE(buf);              /*!< datagram buffer  */
+    size_t MBEDTLS_PRIVATE(buf_len);
+
+    mbedtls_ssl_dtls_mux_conn **MBEDTLS_PRIVATE(by_addr); /*!< address index */
+    mbedtls_ssl_dtls_mux_conn **MBEDTLS_PRIVATE(by_cid);  /*!< CID index     */
+    size_t MBEDTLS_PRIVATE(buckets);                  /*!< index size, a power of 2 */
+    uint32_t MBEDTLS_PRIVATE(seed);                   /*!< hash key         */
+
+    mbedtls_ssl_dtls_mux_conn *MBEDTLS_PRIVATE(timers); /*!< connections with
+                                                             a running timer */
+    mbedtls_ssl_dtls_mux_conn *MBEDTLS_PRIVATE(pending); /*!< connection with
+                                                              unread records */
+    size_t MBEDTLS_PRIVATE(count);                    /*!< open connections */
+    size_t MBEDTLS_PRIVATE(max_conns);                /*!< connection limit */
+
+    mbedtls_ssl_context MBEDTLS_PRIVATE(hello);       /*!< context for the
+                                                           cookie exchange  */
+} mbedtls_ssl_dtls_mux_context;
+
+/**
+ * \brief          Initialize a DTLS multiplexer context
+ *
+ * \param mux      DTLS multiplexer context
+ */
+void mbedtls_ssl_dtls_mux_init(mbedtls_ssl_dtls_mux_context *mux);
+
+/**
+ * \brief          Set up a DTLS multiplexer context
+ *
+ * \param mux      DTLS multiplexer context, initialized with
+ *                 mbedtls_ssl_dtls_mux_init()
+ * \param conf     The configuration of the connections. It must be a DTLS
+ *                 server configuration with a random generator and cookie
+ *                 callbacks (see mbedtls_ssl_conf_dtls_cookies()), and it
+ *                 must stay valid and unchanged while \p mux is in use.
+ *                 Replay detection must not be disabled with
+ *                 mbedtls_ssl_conf_dtls_anti_replay(): a connection only
+ *                 follows a client to a new address when it receives a
+ *                 record from it that is not a replay, so a replayed record
+ *                 would let an attacker redirect the replies.
+ * \param max_conns Maximum number of simultaneous connections. When it is
+ *                 reached, new clients are ignored until a connection is
+ *                 closed. The indexes are sized for this number.
+ *
+ * \note           Each connection holds an SSL context with its own record
+ *                 buffers. Servers with many clients should reduce
+ *                 #MBEDTLS_SSL_IN_CONTENT_LEN and
+ *                 #MBEDTLS_SSL_OUT_CONTENT_LEN to what the clients need.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p conf is not
+ *                 suitable or \p max_conns is 0.
+ * \return         #MBEDTLS_ERR_SSL_ALLOC_FAILED on allocation failure.
+ */
+int mbedtls_ssl_dtls_mux_setup(mbedtls_ssl_dtls_mux_context *mux,
+                               const mbedtls_ssl_config *conf,
+                               size_t max_conns);
+
+/**
+ * \brief          Set the transport callbacks of a DTLS multiplexer
+ *
+ * \param mux      DTLS multiplexer context
+ * \param p_bio    Parameter (context) shared by the callbacks, typically a
+ *                 bound UDP socket
+ * \param f_send_to Callback to send a datagram to a client
+ * \param f_recv_from Non-blocking callback to receive a datagram
+ */
+void mbedtls_ssl_dtls_mux_set_bio(mbedtls_ssl_dtls_mux_context *mux,
+                                  void *p_bio,
+                                  mbedtls_ssl_dtls_mux_send_to_t *f_send_to,
+                                  mbedtls_ssl_dtls_mux_recv_from_t *f_recv_from);
+
+/**
+ * \brief          Process the pending datagrams and timers until there is
+ *                 an event to report to the application.
+ *
+ *                 Handshakes progress inside this function, and the
+ *                 connections whose handshake fails are closed silently.
+ *
+ * \param mux      DTLS multiplexer context
+ * \param conn     On return, the connection concerned by the event, or
+ *                 \c NULL if there is none.
+ * \param buf      Buffer to write application data to
+ * \param len      Size of the buffer
+ *
+ * \return         The (positive) number of bytes of application data
+ *                 received from \p *conn.
+ * \return         \c 0 if the handshake of \p *conn has just completed.
+ *                 The application can now write to it with
+ *                 mbedtls_ssl_write() on mbedtls_ssl_dtls_mux_get_ssl().
+ * \return         #MBEDTLS_ERR_SSL_WANT_READ (with \p *conn set to
+ *                 \c NULL) if there is nothing left to do: the application
+ *                 should wait until the socket is readable or until the
+ *                 delay returned by mbedtls_ssl_dtls_mux_next_timeout() has
+ *                 elapsed, then call this function again.
+ * \return         Another negative error code with \p *conn not \c NULL
+ *                 if the established connection \p *conn failed or was
+ *                 closed by the client (#MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY).
+ *                 The application should then close it with
+ *                 mbedtls_ssl_dtls_mux_close().
+ * \return         Another negative error code with \p *conn set to
+ *                 \c NULL if the receive callback failed.
+ */
+int mbedtls_ssl_dtls_mux_read(mbedtls_ssl_dtls_mux_context *mux,
+                              mbedtls_ssl_dtls_mux_conn **conn,
+                              unsigned char *buf, size_t len);
+
+/**
+ * \brief          Return the delay until a retransmission timer of a
+ *                 connection expires.
+ *
+ * \param mux      DTLS multiplexer context
+ *
+ * \return         The delay in milliseconds, 0 if a timer has already
+ *                 expired, or -1 if no timer is running.
+ */
+int mbedtls_ssl_dtls_mux_next_timeout(const mbedtls_ssl_dtls_mux_context *mux);
+
+/**
+ * \brief          Get the SSL context of a connection, for example to write
+ *                 to it or to attach application data to it with
+ *                 mbedtls_ssl_set_user_data_p().
+ *
+ * \param conn     Connection returned by mbedtls_ssl_dtls_mux_read()
+ *
+ * \return         The SSL context of the connection.
+ */
+mbedtls_ssl_context *mbedtls_ssl_dtls_mux_get_ssl(mbedtls_ssl_dtls_mux_conn *conn);
+
+/**
+ * \brief          Get the current address of the client of a connection
+ *
+ * \param conn     Connection returned by mbedtls_ssl_dtls_mux_read()
+ * \param addr_len On return, the length of the address
+ *
+ * \return         The address, as returned by the receive callback.
+ */
+const unsigned char *mbedtls_ssl_dtls_mux_get_addr(const mbedtls_ssl_dtls_mux_conn *conn,
+                                                   size_t *addr_len);
+
+/**
+ * \brief          Close and free a connection
+ *
+ * \param mux      DTLS multiplexer context
+ * \param conn     Connection returned by mbedtls_ssl_dtls_mux_read(), which
+ *                 must not be used afterwards
+ *
+ * \note           This does not notify the client. Call
+ *                 mbedtls_ssl_close_notify() before if needed.
+ */
+void mbedtls_ssl_dtls_mux_close(mbedtls_ssl_dtls_mux_context *mux,
+                                mbedtls_ssl_dtls_mux_conn *conn);
+
+/**
+ * \brief          Close all connections and free a DTLS multiplexer context
+ *
+ * \param mux      DTLS multiplexer context
+ */
+void mbedtls_ssl_dtls_mux_free(mbedtls_ssl_dtls_mux_context *mux);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_dtls_mux.h */
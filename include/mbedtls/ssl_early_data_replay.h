@@ -0,0 +1,176 @@
+/**
+ * \file ssl_early_data_replay.h
+ *
+ * \brief TLS 1.3 server-side anti-replay store for early data
+ *
+ * A server that accepts early (0-RTT) data must make sure that the same
+ * ClientHello cannot be replayed to make it process the same early data
+ * twice, see RFC 8446 section 8. This store implements the combination of
+ * ClientHello recording and freshness checks recommended there: the server
+ * only accepts early data from a ClientHello whose expected arrival time,
+ * computed from the ticket creation time and the ticket age reported by the
+ * client, is within a tolerance of the current time, and records the PSK
+ * binder of every ClientHello it accepts early data from for as long as a
+ * replay of it could pass the freshness check.
+ *
+ * The store holds a bounded number of records in two generations which are
+ * discarded in turn. When it is full, or right after it has been created
+ * and could have missed ClientHellos processed before, it rejects early
+ * data, which the handshake then ignores: clients and applications see a
+ * plain 1-RTT handshake.
+ *
+ * The records can be kept in memory shared between processes, so that the
+ * worker processes of a multi-process server share a single store.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_EARLY_DATA_REPLAY_H
+#define MBEDTLS_SSL_EARLY_DATA_REPLAY_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/platform_time.h"
+
+#if defined(MBEDTLS_THREADING_C)
+#include "mbedtls/threading.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Early data anti-replay store context
+ */
+typedef struct mbedtls_ssl_early_data_replay_context {
+    unsigned char *MBEDTLS_PRIVATE(region);      /*!< records and state      */
+    size_t MBEDTLS_PRIVATE(region_len);          /*!< size of the region     */
+    int MBEDTLS_PRIVATE(shared);                 /*!< region is shared       */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex); /*!< lock of a region
+                                                           that isn't shared */
+#endif
+} mbedtls_ssl_early_data_replay_context;
+
+/**
+ * \brief          Initialize an anti-replay store context
+ *
+ * \param ctx      Context to be initialized
+ */
+void mbedtls_ssl_early_data_replay_init(mbedtls_ssl_early_data_replay_context *ctx);
+
+/**
+ * \brief          Set up an anti-replay store in the memory of this process
+ *
+ * \param ctx      Context to be set up, initialized with
+ *                 mbedtls_ssl_early_data_replay_init()
+ * \param max_entries Maximum number of ClientHellos recorded in each
+ *                 generation, that is in a period of
+ *                 2 * \p tolerance_ms milliseconds. This bounds the rate of
+ *                 handshakes with early data that the server can accept.
+ * \param tolerance_ms Largest difference, in milliseconds, between the time
+ *                 a ClientHello arrives and the time it was expected to
+ *                 arrive, for its early data to be accepted. This should
+ *                 cover the variations of the network delay and the clock
+ *                 drift between the client and the server, and should be at
+ *                 most #MBEDTLS_SSL_TLS1_3_TICKET_AGE_TOLERANCE, beyond
+ *                 which the ticket is not accepted at all.
+ *
+ * \note           A new store doesn't know about the ClientHellos accepted
+ *                 before it was set up, for example by a server process
+ *                 that has been restarted, so it rejects early data for
+ *                 the first 2 * \p tolerance_ms milliseconds.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p max_entries or
+ *                 \p tolerance_ms is 0 or too large.
+ * \return         #MBEDTLS_ERR_SSL_ALLOC_FAILED if memory allocation failed.
+ */
+int mbedtls_ssl_early_data_replay_setup(mbedtls_ssl_early_data_replay_context *ctx,
+                                        size_t max_entries,
+                                        uint32_t tolerance_ms);
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+/**
+ * \brief          Set up an anti-replay store in memory shared between
+ *                 processes
+ *
+ * \param ctx      Context to be set up, initialized with
+ *                 mbedtls_ssl_early_data_replay_init()
+ * \param path     The file backing the shared region, or \c NULL for an
+ *                 anonymous region. An anonymous region is only shared with
+ *                 the processes forked after this call. A file-backed region
+ *                 is created if needed, and can be shared by any process
+ *                 that sets up a store with the same path and parameters.
+ *                 The store is emptied when the system reboots. See
+ *                 mbedtls_ssl_cache_shm_setup() for the systems where the
+ *                 file must be on a file system that is emptied at boot.
+ * \param max_entries See mbedtls_ssl_early_data_replay_setup().
+ * \param tolerance_ms See mbedtls_ssl_early_data_replay_setup().
+ *
+ * \note           The store relies on mbedtls_ms_time() giving the same
+ *                 time in all the processes that share it, as it does on
+ *                 Linux and FreeBSD.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p max_entries or
+ *                 \p tolerance_ms is 0 or too large, or if the file holds a
+ *                 store with different parameters.
+ * \return         #MBEDTLS_ERR_SSL_ALLOC_FAILED if the region could not be
+ *                 mapped.
+ * \return         #MBEDTLS_ERR_SSL_INTERNAL_ERROR if the file could not be
+ *                 opened, locked or resized.
+ * \return         #MBEDTLS_ERR_THREADING_MUTEX_ERROR if the process-shared
+ *                 mutex could not be created.
+ */
+int mbedtls_ssl_early_data_replay_setup_shared(
+    mbedtls_ssl_early_data_replay_context *ctx, const char *path,
+    size_t max_entries, uint32_t tolerance_ms);
+#endif /* MBEDTLS_SSL_CACHE_SHM_C */
+
+/**
+ * \brief          Early data anti-replay callback implementation
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled, and
+ *                 process-safe if the store is shared)
+ *
+ *                 This is meant to be passed to
+ *                 mbedtls_ssl_conf_early_data_replay().
+ *
+ * \param p_replay The anti-replay store context.
+ * \param binder   The PSK binder of the ClientHello.
+ * \param binder_len The length of \p binder in bytes, at least 16.
+ * \param expected_arrival_time The time, in milliseconds on the
+ *                 mbedtls_ms_time() clock, at which the ClientHello was
+ *                 expected to arrive.
+ *
+ * \return         \c 0 if early data can be accepted. The ClientHello is
+ *                 then recorded.
+ * \return         #MBEDTLS_ERR_SSL_CANNOT_READ_EARLY_DATA if early data
+ *                 must be rejected: the ClientHello may be a replay, it
+ *                 arrived too early or too late, or the store is full.
+ * \return         Another negative error code on other failures.
+ */
+int mbedtls_ssl_early_data_replay_check(void *p_replay,
+                                        const unsigned char *binder,
+                                        size_t binder_len,
+                                        mbedtls_ms_time_t expected_arrival_time);
+
+/**
+ * \brief          Free an anti-replay store context
+ *
+ *                 A shared region is only unmapped from this process, and
+ *                 its records stay available to the other processes.
+ *
+ * \param ctx      Context to be cleaned up
+ */
+void mbedtls_ssl_early_data_replay_free(mbedtls_ssl_early_data_replay_context *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_early_data_replay.h */
@@ -0,0 +1,150 @@
+/**
+ * \file ssl_key_share_cache.h
+ *
+ * \brief TLS 1.3 client-side cache of the groups selected by servers
+ *
+ * A TLS 1.3 client sends a key share for a single group in its first
+ * ClientHello. When the server prefers another group, it answers with a
+ * HelloRetryRequest, which costs a round trip and a key generation. This
+ * cache remembers the group each server selected, indexed by the host name
+ * and the port of the server, so that the next handshakes with it offer a
+ * key share for that group first. Once it is registered with
+ * mbedtls_ssl_conf_key_share_cache(), the library updates and consults it
+ * without any involvement of the application.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_KEY_SHARE_CACHE_H
+#define MBEDTLS_SSL_KEY_SHARE_CACHE_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+
+#if defined(MBEDTLS_THREADING_C)
+#include "mbedtls/threading.h"
+#endif
+
+/**
+ * \name SECTION: Module settings
+ *
+ * The configuration options you can set for this module are in this section.
+ * Either change them in mbedtls_config.h or define them on the compiler command line.
+ * \{
+ */
+
+#if !defined(MBEDTLS_SSL_KEY_SHARE_CACHE_DEFAULT_MAX_ENTRIES)
+#define MBEDTLS_SSL_KEY_SHARE_CACHE_DEFAULT_MAX_ENTRIES    50   /*!< Maximum entries in cache */
+#endif
+
+/** \} name SECTION: Module settings */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mbedtls_ssl_key_share_cache_context mbedtls_ssl_key_share_cache_context;
+typedef struct mbedtls_ssl_key_share_cache_entry mbedtls_ssl_key_share_cache_entry;
+
+/**
+ * \brief   This structure is used for storing cache entries
+ */
+struct mbedtls_ssl_key_share_cache_entry {
+    char *MBEDTLS_PRIVATE(hostname);                     /*!< server host name   */
+    uint16_t MBEDTLS_PRIVATE(port);                      /*!< server port        */
+    uint16_t MBEDTLS_PRIVATE(group_id);                  /*!< selected group     */
+
+    mbedtls_ssl_key_share_cache_entry *MBEDTLS_PRIVATE(next); /*!< chain pointer */
+};
+
+/**
+ * \brief Key share cache context
+ */
+struct mbedtls_ssl_key_share_cache_context {
+    mbedtls_ssl_key_share_cache_entry *MBEDTLS_PRIVATE(chain); /*!< most recently
+                                                                    updated first */
+    int MBEDTLS_PRIVATE(max_entries);            /*!< maximum entries        */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);    /*!< mutex                  */
+#endif
+};
+
+/**
+ * \brief          Initialize a key share cache context
+ *
+ * \param cache    Key share cache context
+ */
+void mbedtls_ssl_key_share_cache_init(mbedtls_ssl_key_share_cache_context *cache);
+
+/**
+ * \brief          Key share cache get callback implementation
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ *                 This is meant to be passed to
+ *                 mbedtls_ssl_conf_key_share_cache().
+ *
+ * \param p_cache  The key share cache context to use.
+ * \param hostname The host name of the server.
+ * \param port     The port of the server.
+ * \param group_id On success, the IANA NamedGroup the server selected
+ *                 last time.
+ *
+ * \return         \c 0 on success.
+ * \return         #MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND if the cache
+ *                 doesn't know this server.
+ * \return         Another negative error code on other failures.
+ */
+int mbedtls_ssl_key_share_cache_get(void *p_cache,
+                                    const char *hostname,
+                                    uint16_t port,
+                                    uint16_t *group_id);
+
+/**
+ * \brief          Key share cache set callback implementation
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ *                 When the cache is full, the entry updated least recently
+ *                 is replaced.
+ *
+ *                 This is meant to be passed to
+ *                 mbedtls_ssl_conf_key_share_cache().
+ *
+ * \param p_cache  The key share cache context to use.
+ * \param hostname The host name of the server.
+ * \param port     The port of the server.
+ * \param group_id The IANA NamedGroup the server selected.
+ *
+ * \return         \c 0 on success.
+ * \return         A negative error code on failure.
+ */
+int mbedtls_ssl_key_share_cache_set(void *p_cache,
+                                    const char *hostname,
+                                    uint16_t port,
+                                    uint16_t group_id);
+
+/**
+ * \brief          Set the maximum number of cached servers
+ *                 (Default: MBEDTLS_SSL_KEY_SHARE_CACHE_DEFAULT_MAX_ENTRIES (50))
+ *
+ * \param cache    Key share cache context
+ * \param max      Maximum number of cached servers. 0 disables the cache.
+ */
+void mbedtls_ssl_key_share_cache_set_max_entries(mbedtls_ssl_key_share_cache_context *cache,
+                                                 int max);
+
+/**
+ * \brief          Free referenced items in a key share cache context and
+ *                 clear memory
+ *
+ * \param cache    Key share cache context
+ */
+void mbedtls_ssl_key_share_cache_free(mbedtls_ssl_key_share_cache_context *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_key_share_cache.h */
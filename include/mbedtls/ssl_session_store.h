@@ -0,0 +1,210 @@
+/**
+ * \file ssl_session_store.h
+ *
+ * \brief Client-side store of resumable sessions
+ *
+ * This store keeps the sessions a client can resume, indexed by the host
+ * name and the port of the server they were established with. Once it is
+ * registered with mbedtls_ssl_conf_session_store(), the library stores
+ * every TLS 1.3 ticket and every resumable TLS 1.2 session it receives,
+ * and each new handshake with a server resumes the most recent session
+ * stored for it, without any involvement of the application.
+ *
+ * TLS 1.3 tickets are used at most once, as recommended by RFC 8446
+ * section C.4: a ticket is removed from the store when it is handed out.
+ * A TLS 1.2 session stays in the store and replaces the older sessions
+ * with the same server. Expired sessions are removed from the store.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_SSL_SESSION_STORE_H
+#define MBEDTLS_SSL_SESSION_STORE_H
+#include "mbedtls/private_access.h"
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/platform_time.h"
+
+#if defined(MBEDTLS_THREADING_C)
+#include "mbedtls/threading.h"
+#endif
+
+/**
+ * \name SECTION: Module settings
+ *
+ * The configuration options you can set for this module are in this section.
+ * Either change them in mbedtls_config.h or define them on the compiler command line.
+ * \{
+ */
+
+#if !defined(MBEDTLS_SSL_SESSION_STORE_DEFAULT_TIMEOUT)
+#define MBEDTLS_SSL_SESSION_STORE_DEFAULT_TIMEOUT       86400   /*!< 1 day  */
+#endif
+
+#if !defined(MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_ENTRIES)
+#define MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_ENTRIES      50   /*!< Maximum entries in store */
+#endif
+
+#if !defined(MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_PER_PEER)
+#define MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_PER_PEER      4   /*!< Maximum entries per server */
+#endif
+
+/** \} name SECTION: Module settings */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mbedtls_ssl_session_store_context mbedtls_ssl_session_store_context;
+typedef struct mbedtls_ssl_session_store_entry mbedtls_ssl_session_store_entry;
+
+/**
+ * \brief   This structure is used for storing session store entries
+ */
+struct mbedtls_ssl_session_store_entry {
+    mbedtls_ms_time_t MBEDTLS_PRIVATE(expiry);           /*!< expiry time, or 0  */
+
+    char *MBEDTLS_PRIVATE(hostname);                     /*!< server host name   */
+    uint16_t MBEDTLS_PRIVATE(port);                      /*!< server port        */
+    mbedtls_ssl_protocol_version MBEDTLS_PRIVATE(tls_version); /*!< session version */
+
+    unsigned char *MBEDTLS_PRIVATE(session);             /*!< serialized session */
+    size_t MBEDTLS_PRIVATE(session_len);
+
+    mbedtls_ssl_session_store_entry *MBEDTLS_PRIVATE(next); /*!< chain pointer   */
+};
+
+/**
+ * \brief Session store context
+ */
+struct mbedtls_ssl_session_store_context {
+    mbedtls_ssl_session_store_entry *MBEDTLS_PRIVATE(chain); /*!< newest first   */
+    int MBEDTLS_PRIVATE(timeout);                /*!< TLS 1.2 session timeout */
+    int MBEDTLS_PRIVATE(max_entries);            /*!< maximum entries         */
+    int MBEDTLS_PRIVATE(max_per_peer);           /*!< maximum entries per peer */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);    /*!< mutex                   */
+#endif
+};
+
+/**
+ * \brief          Initialize a session store context
+ *
+ * \param store    Session store context
+ */
+void mbedtls_ssl_session_store_init(mbedtls_ssl_session_store_context *store);
+
+/**
+ * \brief          Session store put callback implementation
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ *                 This is meant to be passed to
+ *                 mbedtls_ssl_conf_session_store().
+ *
+ * \param p_store  The session store context to use.
+ * \param hostname The host name of the server, as set with
+ *                 mbedtls_ssl_set_hostname().
+ * \param port     The port of the server, as set with
+ *                 mbedtls_ssl_set_peer_port().
+ * \param session  The session to store. A TLS 1.3 session must hold a
+ *                 ticket, which expires after the lifetime given by the
+ *                 server. A TLS 1.2 session expires after the store timeout.
+ *
+ * \return         \c 0 on success, including when the session is not stored
+ *                 because it has already expired or the store is disabled.
+ * \return         #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if the session cannot be
+ *                 resumed.
+ * \return         Another negative error code on other failures.
+ */
+int mbedtls_ssl_session_store_put(void *p_store,
+                                  const char *hostname,
+                                  uint16_t port,
+                                  const mbedtls_ssl_session *session);
+
+/**
+ * \brief          Session store take callback implementation
+ *                 (Thread-safe if MBEDTLS_THREADING_C is enabled)
+ *
+ *                 This retrieves the most recently stored session of the
+ *                 server that hasn't expired. A TLS 1.3 session is removed
+ *                 from the store, so that its ticket is only used once.
+ *
+ *                 This is meant to be passed to
+ *                 mbedtls_ssl_conf_session_store().
+ *
+ * \param p_store  The session store context to use.
+ * \param hostname The host name of the server.
+ * \param port     The port of the server.
+ * \param session  The session to populate. It must have been initialized
+ *                 with mbedtls_ssl_session_init() but not populated yet.
+ *
+ * \return         \c 0 on success.
+ * \return         #MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND if there is no
+ *                 session for this server.
+ * \return         Another negative error code on other failures.
+ */
+int mbedtls_ssl_session_store_take(void *p_store,
+                                   const char *hostname,
+                                   uint16_t port,
+                                   mbedtls_ssl_session *session);
+
+/**
+ * \brief          Set the timeout of TLS 1.2 sessions
+ *                 (Default: MBEDTLS_SSL_SESSION_STORE_DEFAULT_TIMEOUT (1 day))
+ *
+ *                 A timeout of 0 indicates no timeout. It should not be
+ *                 longer than the time the servers keep sessions for.
+ *                 TLS 1.3 tickets expire after the lifetime given by the
+ *                 server instead.
+ *
+ * \param store    Session store context
+ * \param timeout  TLS 1.2 session timeout in seconds
+ */
+void mbedtls_ssl_session_store_set_timeout(mbedtls_ssl_session_store_context *store,
+                                           int timeout);
+
+/**
+ * \brief          Set the maximum number of stored sessions
+ *                 (Default: MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_ENTRIES (50))
+ *
+ *                 When the store is full, a new session replaces the oldest
+ *                 one. 0 disables the store.
+ *
+ * \param store    Session store context
+ * \param max      Maximum number of stored sessions
+ */
+void mbedtls_ssl_session_store_set_max_entries(mbedtls_ssl_session_store_context *store,
+                                               int max);
+
+/**
+ * \brief          Set the maximum number of sessions stored for each server
+ *                 (Default: MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_PER_PEER (4))
+ *
+ *                 This bounds the number of TLS 1.3 tickets kept from a
+ *                 server that sends many of them, and should be at least the
+ *                 number of connections a client opens in parallel with one
+ *                 server. When the limit is reached, a new ticket replaces
+ *                 the oldest one of the same server.
+ *
+ * \param store    Session store context
+ * \param max      Maximum number of sessions stored for each server
+ */
+void mbedtls_ssl_session_store_set_max_per_peer(mbedtls_ssl_session_store_context *store,
+                                                int max);
+
+/**
+ * \brief          Free referenced items in a session store context and
+ *                 clear memory
+ *
+ * \param store    Session store context
+ */
+void mbedtls_ssl_session_store_free(mbedtls_ssl_session_store_context *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ssl_session_store.h */
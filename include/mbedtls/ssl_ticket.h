@@ -41,8 +41,26 @@ extern "C" {
 #define MBEDTLS_SSL_TICKET_MAX_KEY_BYTES 32          /*!< Max supported key length in bytes */
 #define MBEDTLS_SSL_TICKET_KEY_NAME_BYTES 4          /*!< key name length in bytes */
 
+/**
+ * \name SECTION: Module settings
+ *
+ * The configuration options you can set for this module are in this section.
+ * Either change them in mbedtls_config.h or define them on the compiler command line.
+ * \{
+ */
+
+#if !defined(MBEDTLS_SSL_TICKET_MAX_KEYS)
+#define MBEDTLS_SSL_TICKET_MAX_KEYS 4                /*!< Max number of keys accepted at the same time */
+#endif
+
+/** \} name SECTION: Module settings */
+
 /**
  * \brief   Information for session ticket protection
+ *
+ * Keys are never modified once created. They are shared by the operations
+ * using them and freed after the last one, so that a key rotation does not
+ * have to wait for the operations in progress.
  */
 typedef struct mbedtls_ssl_ticket_key {
     unsigned char MBEDTLS_PRIVATE(name)[MBEDTLS_SSL_TICKET_KEY_NAME_BYTES];
@@ -54,8 +72,12 @@ typedef struct mbedtls_ssl_ticket_key {
      *  tickets created under that key.
      */
     uint32_t MBEDTLS_PRIVATE(lifetime);
+    size_t MBEDTLS_PRIVATE(refs);                    /*!< number of users of the key, which
+                                                          are the context while the key is
+                                                          accepted and operations using it */
 #if !defined(MBEDTLS_USE_PSA_CRYPTO)
-    mbedtls_cipher_context_t MBEDTLS_PRIVATE(ctx);   /*!< context for auth enc/decryption    */
+    unsigned char MBEDTLS_PRIVATE(key_bytes)[MBEDTLS_SSL_TICKET_MAX_KEY_BYTES];
+    /*!< key used for auth enc/decryption   */
 #else
     mbedtls_svc_key_id_t MBEDTLS_PRIVATE(key);       /*!< key used for auth enc/decryption   */
     psa_algorithm_t MBEDTLS_PRIVATE(alg);            /*!< algorithm of auth enc/decryption   */
@@ -69,16 +91,29 @@ mbedtls_ssl_ticket_key;
  * \brief   Context for session ticket handling functions
  */
 typedef struct mbedtls_ssl_ticket_context {
-    mbedtls_ssl_ticket_key MBEDTLS_PRIVATE(keys)[2]; /*!< ticket protection keys             */
-    unsigned char MBEDTLS_PRIVATE(active);           /*!< index of the currently active key  */
+    /** Accepted ticket protection keys, from the newest, which is the active
+     *  one used to protect new tickets, to the oldest                      */
+    mbedtls_ssl_ticket_key *MBEDTLS_PRIVATE(keys)[MBEDTLS_SSL_TICKET_MAX_KEYS];
+    size_t MBEDTLS_PRIVATE(key_count);               /*!< number of accepted keys            */
+    size_t MBEDTLS_PRIVATE(max_keys);                /*!< keys accepted after rotations      */
 
     uint32_t MBEDTLS_PRIVATE(ticket_lifetime);       /*!< lifetime of tickets in seconds     */
 
+#if !defined(MBEDTLS_USE_PSA_CRYPTO)
+    const mbedtls_cipher_info_t *MBEDTLS_PRIVATE(cipher_info); /*!< cipher of the keys      */
+#else
+    psa_algorithm_t MBEDTLS_PRIVATE(alg);            /*!< algorithm of the keys              */
+    psa_key_type_t MBEDTLS_PRIVATE(key_type);        /*!< type of the keys                   */
+    size_t MBEDTLS_PRIVATE(key_bits);                /*!< length of the keys in bits         */
+#endif
+
     /** Callback for getting (pseudo-)random numbers                        */
     int(*MBEDTLS_PRIVATE(f_rng))(void *, unsigned char *, size_t);
     void *MBEDTLS_PRIVATE(p_rng);                    /*!< context for the RNG function       */
 
 #if defined(MBEDTLS_THREADING_C)
+    /** Protects the key list and the reference counts of the keys. It is
+     *  not held while tickets are encrypted or decrypted.                  */
     mbedtls_threading_mutex_t MBEDTLS_PRIVATE(mutex);
 #endif
 }
@@ -126,6 +161,31 @@ int mbedtls_ssl_ticket_setup(mbedtls_ssl_ticket_context *ctx,
                              mbedtls_cipher_type_t cipher,
                              uint32_t lifetime);
 
+/**
+ * \brief           Set the number of keys accepted for parsing tickets.
+ *
+ *                  Each key rotation, whether automatic or done with
+ *                  mbedtls_ssl_ticket_rotate(), makes the new key active
+ *                  for protecting new tickets and keeps the previous keys
+ *                  for parsing the tickets they protected, up to this
+ *                  number of keys in total. Accepting more keys lets
+ *                  tickets stay valid across several rotations, so that
+ *                  the keys can be rotated more often than the tickets
+ *                  expire, for example by all the servers of a fleet with
+ *                  mbedtls_ssl_ticket_rotate().
+ *
+ * \param ctx       Context to configure
+ * \param max_keys  Number of accepted keys, including the active one,
+ *                  between 1 and #MBEDTLS_SSL_TICKET_MAX_KEYS.
+ *                  Default: 2.
+ *
+ * \return          0 if successful,
+ *                  or #MBEDTLS_ERR_SSL_BAD_INPUT_DATA if \p max_keys is
+ *                  out of range.
+ */
+int mbedtls_ssl_ticket_set_max_keys(mbedtls_ssl_ticket_context *ctx,
+                                    size_t max_keys);
+
 /**
  * \brief           Rotate session ticket encryption key to new specified key.
  *                  Provides for external control of session ticket encryption
@@ -146,6 +206,10 @@ int mbedtls_ssl_ticket_setup(mbedtls_ssl_ticket_context *ctx,
  * \note            \c name and \c k are recommended to be cryptographically
  *                  random data.
  *
+ * \note            The previous keys stay accepted for parsing tickets, see
+ *                  mbedtls_ssl_ticket_set_max_keys(). Tickets being written
+ *                  or parsed while the keys are rotated are not affected.
+ *
  * \note            \c nlength must match sizeof( ctx->name )
  *
  * \note            \c klength must be sufficient for use by cipher specified
@@ -171,15 +235,25 @@ int mbedtls_ssl_ticket_rotate(mbedtls_ssl_ticket_context *ctx,
 
 /**
  * \brief           Implementation of the ticket write callback
+ *                  (Thread-safe if MBEDTLS_THREADING_C is enabled)
  *
  * \note            See \c mbedtls_ssl_ticket_write_t for description
+ *
+ * \note            Tickets are encrypted without holding the mutex of the
+ *                  context, so that concurrent handshakes don't wait for
+ *                  each other or for a key rotation.
  */
 mbedtls_ssl_ticket_write_t mbedtls_ssl_ticket_write;
 
 /**
  * \brief           Implementation of the ticket parse callback
+ *                  (Thread-safe if MBEDTLS_THREADING_C is enabled)
  *
  * \note            See \c mbedtls_ssl_ticket_parse_t for description
+ *
+ * \note            Tickets are decrypted without holding the mutex of the
+ *                  context, so that concurrent handshakes don't wait for
+ *                  each other or for a key rotation.
  */
 mbedtls_ssl_ticket_parse_t mbedtls_ssl_ticket_parse;
 
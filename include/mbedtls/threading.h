@@ -128,6 +128,14 @@ extern mbedtls_threading_mutex_t mbedtls_threading_psa_globaldata_mutex;
 extern mbedtls_threading_mutex_t mbedtls_threading_psa_rngdata_mutex;
 #endif
 
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+/*
+ * A mutex used to build the shared fixed-base tables of the RFC 7919
+ * FFDHE groups on first use.
+ */
+extern mbedtls_threading_mutex_t mbedtls_threading_ffdhe_mutex;
+#endif
+
 #endif /* MBEDTLS_THREADING_C */
 
 #ifdef __cplusplus
@@ -799,8 +799,18 @@
  *   overapproximated as 9 half-size INTEGERS;
  * - 7 bytes for the public exponent.
  */
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/* A multi-prime key with u primes (RFC 8017 §3.2) has version 1 and replaces
+ * the 5 half-size INTEGERs by 3u - 1 INTEGERs of N/u bits, grouped in u - 1
+ * additional SEQUENCEs. For u <= 5, this is overapproximated as 10 half-size
+ * INTEGERs plus 48 bytes of INTEGER and SEQUENCE overhead.
+ */
+#define PSA_KEY_EXPORT_RSA_KEY_PAIR_MAX_SIZE(key_bits)   \
+    (10u * PSA_KEY_EXPORT_ASN1_INTEGER_MAX_SIZE((key_bits) / 2u + 1u) + 62u)
+#else
 #define PSA_KEY_EXPORT_RSA_KEY_PAIR_MAX_SIZE(key_bits)   \
     (9u * PSA_KEY_EXPORT_ASN1_INTEGER_MAX_SIZE((key_bits) / 2u + 1u) + 14u)
+#endif
 
 /* Maximum size of the export encoding of a DSA public key.
  *
@@ -174,6 +174,25 @@ cleanup:
 /* Implementation that should never be optimized out by the compiler */
 #define mbedtls_mpi_zeroize_and_free(v, n) mbedtls_zeroize_and_free(v, ciL * (n))
 
+#if defined(MBEDTLS_MPI_SMALL_BUFFER)
+#define MPI_IS_INLINE(X) ((X)->p == (X)->inline_limbs)
+#else
+#define MPI_IS_INLINE(X) 0
+#endif
+
+/*
+ * Wipe the current limbs of X and give them back, unless they are stored
+ * inside X. Leaves X->p dangling.
+ */
+static void mpi_release_limbs(mbedtls_mpi *X)
+{
+    if (MPI_IS_INLINE(X)) {
+        mbedtls_platform_zeroize(X->p, X->n * ciL);
+    } else {
+        mbedtls_mpi_zeroize_and_free(X->p, X->n);
+    }
+}
+
 /*
  * Initialize one MPI
  */
@@ -194,7 +213,7 @@ void mbedtls_mpi_free(mbedtls_mpi *X)
     }
 
     if (X->p != NULL) {
-        mbedtls_mpi_zeroize_and_free(X->p, X->n);
+        mpi_release_limbs(X);
     }
 
     X->s = 1;
@@ -214,13 +233,25 @@ int mbedtls_mpi_grow(mbedtls_mpi *X, size_t nblimbs)
     }
 
     if (X->n < nblimbs) {
+#if defined(MBEDTLS_MPI_SMALL_BUFFER)
+        if (nblimbs <= MBEDTLS_MPI_INLINE_LIMBS &&
+            (X->p == NULL || MPI_IS_INLINE(X))) {
+            /* Limbs past X->n in the inline buffer are never left
+             * with data in them, but may not have been written yet. */
+            memset(X->inline_limbs + X->n, 0, (nblimbs - X->n) * ciL);
+            X->n = (unsigned short) nblimbs;
+            X->p = X->inline_limbs;
+            return 0;
+        }
+#endif
+
         if ((p = (mbedtls_mpi_uint *) mbedtls_calloc(nblimbs, ciL)) == NULL) {
             return MBEDTLS_ERR_MPI_ALLOC_FAILED;
         }
 
         if (X->p != NULL) {
             memcpy(p, X->p, X->n * ciL);
-            mbedtls_mpi_zeroize_and_free(X->p, X->n);
+            mpi_release_limbs(X);
         }
 
         /* nblimbs fits in n because we ensure that MBEDTLS_MPI_MAX_LIMBS
@@ -262,13 +293,27 @@ int mbedtls_mpi_shrink(mbedtls_mpi *X, size_t nblimbs)
         i = nblimbs;
     }
 
+#if defined(MBEDTLS_MPI_SMALL_BUFFER)
+    if (i <= MBEDTLS_MPI_INLINE_LIMBS) {
+        if (MPI_IS_INLINE(X)) {
+            mbedtls_platform_zeroize(X->p + i, (X->n - i) * ciL);
+        } else {
+            memcpy(X->inline_limbs, X->p, i * ciL);
+            mpi_release_limbs(X);
+            X->p = X->inline_limbs;
+        }
+        X->n = (unsigned short) i;
+        return 0;
+    }
+#endif
+
     if ((p = (mbedtls_mpi_uint *) mbedtls_calloc(i, ciL)) == NULL) {
         return MBEDTLS_ERR_MPI_ALLOC_FAILED;
     }
 
     if (X->p != NULL) {
         memcpy(p, X->p, i * ciL);
-        mbedtls_mpi_zeroize_and_free(X->p, X->n);
+        mpi_release_limbs(X);
     }
 
     /* i fits in n because we ensure that MBEDTLS_MPI_MAX_LIMBS
@@ -352,6 +397,17 @@ void mbedtls_mpi_swap(mbedtls_mpi *X, mbedtls_mpi *Y)
     memcpy(&T,  X, sizeof(mbedtls_mpi));
     memcpy(X,  Y, sizeof(mbedtls_mpi));
     memcpy(Y, &T, sizeof(mbedtls_mpi));
+
+#if defined(MBEDTLS_MPI_SMALL_BUFFER)
+    /* Inline limbs moved with the structure: point at the new copy. */
+    if (X->p == Y->inline_limbs) {
+        X->p = X->inline_limbs;
+    }
+    if (Y->p == X->inline_limbs) {
+        Y->p = Y->inline_limbs;
+    }
+    mbedtls_platform_zeroize(&T, sizeof(T));
+#endif
 }
 
 static inline mbedtls_mpi_uint mpi_sint_abs(mbedtls_mpi_sint z)
@@ -1186,6 +1242,13 @@ int mbedtls_mpi_sub_int(mbedtls_mpi *X, const mbedtls_mpi *A, mbedtls_mpi_sint b
     return mbedtls_mpi_sub_mpi(X, A, &B);
 }
 
+/*
+ * Aliased operands of mbedtls_mpi_mul_mpi() with at most this many significant
+ * limbs are copied to the stack rather than to the heap. This covers all the
+ * field elements of the supported elliptic curves.
+ */
+#define MPI_MUL_STACK_LIMBS     (1024 / biL)
+
 /*
  * Baseline multiplication: X = A * B  (HAC 14.12)
  */
@@ -1194,18 +1257,13 @@ int mbedtls_mpi_mul_mpi(mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     size_t i, j;
     mbedtls_mpi TA, TB;
+    mbedtls_mpi_uint TA_stack[MPI_MUL_STACK_LIMBS];
+    mbedtls_mpi_uint TB_stack[MPI_MUL_STACK_LIMBS];
     int result_is_zero = 0;
 
     mbedtls_mpi_init(&TA);
     mbedtls_mpi_init(&TB);
 
-    if (X == A) {
-        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&TA, A)); A = &TA;
-    }
-    if (X == B) {
-        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&TB, B)); B = &TB;
-    }
-
     for (i = A->n; i > 0; i--) {
         if (A->p[i - 1] != 0) {
             break;
@@ -1224,6 +1282,32 @@ int mbedtls_mpi_mul_mpi(mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi
         result_is_zero = 1;
     }
 
+    if (X == A) {
+        if (i <= MPI_MUL_STACK_LIMBS) {
+            memcpy(TA_stack, A->p, i * ciL);
+            TA.s = A->s;
+            TA.n = (unsigned short) i;
+            TA.p = TA_stack;
+        } else {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&TA, A));
+        }
+        if (B == A) {
+            B = &TA;
+        }
+        A = &TA;
+    }
+    if (X == B) {
+        if (j <= MPI_MUL_STACK_LIMBS) {
+            memcpy(TB_stack, B->p, j * ciL);
+            TB.s = B->s;
+            TB.n = (unsigned short) j;
+            TB.p = TB_stack;
+        } else {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&TB, B));
+        }
+        B = &TB;
+    }
+
     MBEDTLS_MPI_CHK(mbedtls_mpi_grow(X, i + j));
     MBEDTLS_MPI_CHK(mbedtls_mpi_lset(X, 0));
 
@@ -1241,7 +1325,16 @@ int mbedtls_mpi_mul_mpi(mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi
 
 cleanup:
 
-    mbedtls_mpi_free(&TB); mbedtls_mpi_free(&TA);
+    if (TA.p == TA_stack) {
+        mbedtls_platform_zeroize(TA_stack, i * ciL);
+    } else {
+        mbedtls_mpi_free(&TA);
+    }
+    if (TB.p == TB_stack) {
+        mbedtls_platform_zeroize(TB_stack, j * ciL);
+    } else {
+        mbedtls_mpi_free(&TB);
+    }
 
     return ret;
 }
@@ -1656,7 +1749,10 @@ int mbedtls_mpi_exp_mod(mbedtls_mpi *X, const mbedtls_mpi *A,
         MBEDTLS_MPI_CHK(mbedtls_mpi_core_get_mont_r2_unsafe(&RR, N));
 
         if (prec_RR != NULL) {
-            *prec_RR = RR;
+            /* Hand the limbs over to prec_RR and keep a view of them:
+             * they may live inside the structure (MBEDTLS_MPI_SMALL_BUFFER). */
+            mbedtls_mpi_swap(prec_RR, &RR);
+            RR = *prec_RR;
         }
     } else {
         MBEDTLS_MPI_CHK(mbedtls_mpi_grow(prec_RR, N->n));
@@ -2149,6 +2245,100 @@ int mbedtls_mpi_is_prime_ext(const mbedtls_mpi *X, int rounds,
     return mpi_miller_rabin(&XX, rounds, f_rng, p_rng);
 }
 
+#if defined(MBEDTLS_GENPRIME_SIEVE)
+/* Number of odd candidates examined from each random starting point */
+#define GENPRIME_SIEVE_WINDOW   2048
+/* Odd primes below this bound are sieved out of each window */
+#define GENPRIME_SIEVE_BOUND    16384
+
+/*
+ * Sieve the window of candidates X + 2k, 0 <= k < GENPRIME_SIEVE_WINDOW:
+ * bit k of composite is set when X + 2k has an odd prime factor below
+ * GENPRIME_SIEVE_BOUND. X must be odd and larger than GENPRIME_SIEVE_BOUND.
+ *
+ * The small primes are found with a sieve of Eratosthenes as we go, and for
+ * each of them a single remainder of X is enough to strike out all of its
+ * multiples in the window.
+ */
+static int mpi_sieve_window(const mbedtls_mpi *X, unsigned char *composite)
+{
+    int ret = 0;
+    /* Bit i is set if 2i + 1 is known to be composite */
+    unsigned char small_composite[GENPRIME_SIEVE_BOUND / 16];
+    size_t i, j, k, p;
+    mbedtls_mpi_uint r;
+
+    memset(composite, 0, GENPRIME_SIEVE_WINDOW / 8);
+    memset(small_composite, 0, sizeof(small_composite));
+
+    for (i = 1; i < GENPRIME_SIEVE_BOUND / 2; i++) {
+        if ((small_composite[i / 8] >> (i % 8)) & 1) {
+            continue;
+        }
+        p = 2 * i + 1;
+
+        for (j = i + p; j < GENPRIME_SIEVE_BOUND / 2; j += p) {
+            small_composite[j / 8] |= (unsigned char) (1 << (j % 8));
+        }
+
+        /* X + 2k = 0 mod p  <=>  k = -X / 2 = (p - X mod p) * (p + 1) / 2 mod p */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_int(&r, X, (mbedtls_mpi_sint) p));
+        k = ((p - (size_t) r) % p) * ((p + 1) / 2) % p;
+
+        for (; k < GENPRIME_SIEVE_WINDOW; k += p) {
+            composite[k / 8] |= (unsigned char) (1 << (k % 8));
+        }
+    }
+
+cleanup:
+    return ret;
+}
+
+/*
+ * Look for a prime of exactly nbits bits among the odd numbers following
+ * the odd starting point X, which is replaced with the prime on success.
+ * Y is used as a temporary.
+ *
+ * Return MBEDTLS_ERR_MPI_NOT_ACCEPTABLE if the window contains no prime, in
+ * which case the caller should pick a new starting point.
+ */
+static int mpi_gen_prime_sieve(mbedtls_mpi *X, mbedtls_mpi *Y, size_t nbits,
+                               int rounds,
+                               int (*f_rng)(void *, unsigned char *, size_t),
+                               void *p_rng)
+{
+    int ret = MBEDTLS_ERR_MPI_NOT_ACCEPTABLE;
+    unsigned char composite[GENPRIME_SIEVE_WINDOW / 8];
+    size_t k;
+
+    MBEDTLS_MPI_CHK(mpi_sieve_window(X, composite));
+    ret = MBEDTLS_ERR_MPI_NOT_ACCEPTABLE;
+
+    for (k = 0; k < GENPRIME_SIEVE_WINDOW; k++) {
+        if ((composite[k / 8] >> (k % 8)) & 1) {
+            continue;
+        }
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_add_int(Y, X, (mbedtls_mpi_sint) (2 * k)));
+        if (mbedtls_mpi_bitlen(Y) > nbits) {
+            ret = MBEDTLS_ERR_MPI_NOT_ACCEPTABLE;
+            break;
+        }
+
+        ret = mpi_miller_rabin(Y, rounds, f_rng, p_rng);
+        if (ret != MBEDTLS_ERR_MPI_NOT_ACCEPTABLE) {
+            if (ret == 0) {
+                mbedtls_mpi_swap(X, Y);
+            }
+            break;
+        }
+    }
+
+cleanup:
+    return ret;
+}
+#endif /* MBEDTLS_GENPRIME_SIEVE */
+
 /*
  * Prime number generation
  *
@@ -2213,6 +2403,18 @@ int mbedtls_mpi_gen_prime(mbedtls_mpi *X, size_t nbits, int flags,
         X->p[0] |= 1;
 
         if ((flags & MBEDTLS_MPI_GEN_PRIME_FLAG_DH) == 0) {
+#if defined(MBEDTLS_GENPRIME_SIEVE)
+            /* X > 2^(nbits - 1) > GENPRIME_SIEVE_BOUND */
+            if (nbits > 15) {
+                ret = mpi_gen_prime_sieve(X, &Y, nbits, rounds, f_rng, p_rng);
+
+                if (ret != MBEDTLS_ERR_MPI_NOT_ACCEPTABLE) {
+                    goto cleanup;
+                }
+                continue;
+            }
+#endif /* MBEDTLS_GENPRIME_SIEVE */
+
             ret = mbedtls_mpi_is_prime_ext(X, rounds, f_rng, p_rng);
 
             if (ret != MBEDTLS_ERR_MPI_NOT_ACCEPTABLE) {
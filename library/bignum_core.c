@@ -593,7 +593,10 @@ cleanup:
     return ret;
 }
 
+/* Also used by the FFDHE fixed-base exponentiation in ffdhe.c */
+#if !defined(MBEDTLS_FFDHE_FIXED_BASE)
 MBEDTLS_STATIC_TESTABLE
+#endif
 void mbedtls_mpi_core_ct_uint_table_lookup(mbedtls_mpi_uint *dest,
                                            const mbedtls_mpi_uint *table,
                                            size_t limbs,
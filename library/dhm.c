@@ -20,6 +20,7 @@
 #include "mbedtls/dhm.h"
 #include "mbedtls/platform_util.h"
 #include "mbedtls/error.h"
+#include "ffdhe.h"
 
 #include <string.h>
 
@@ -206,8 +207,13 @@ static int dhm_make_common(mbedtls_dhm_context *ctx, int x_size,
     /*
      * Calculate GX = G^X mod P
      */
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+    MBEDTLS_MPI_CHK(mbedtls_ffdhe_exp_mod(&ctx->GX, &ctx->G, &ctx->X,
+                                          &ctx->P, &ctx->RP));
+#else
     MBEDTLS_MPI_CHK(mbedtls_mpi_exp_mod(&ctx->GX, &ctx->G, &ctx->X,
                                         &ctx->P, &ctx->RP));
+#endif
 
     if ((ret = dhm_check_range(&ctx->GX, &ctx->P)) != 0) {
         return ret;
@@ -27,6 +27,11 @@
  *     render ECC resistant against Side Channel Attacks. IACR Cryptology
  *     ePrint Archive, 2004, vol. 2004, p. 342.
  *     <http://eprint.iacr.org/2004/342.pdf>
+ *
+ * [4] GALLANT, Robert P., LAMBERT, Robert J., et VANSTONE, Scott A. Faster
+ *     point multiplication on elliptic curves with efficient endomorphisms.
+ *     In : Advances in Cryptology - CRYPTO 2001. Springer Berlin Heidelberg,
+ *     2001. p. 190-200.
  */
 
 #include "common.h"
@@ -68,7 +73,10 @@
 #include "mbedtls/error.h"
 
 #include "bn_mul.h"
+#include "bignum_core.h"
+#include "constant_time_internal.h"
 #include "ecp_invasive.h"
+#include "ecp_x448.h"
 
 #include <string.h>
 
@@ -327,6 +335,36 @@ static void mpi_free_many(mbedtls_mpi *arr, size_t size)
         mbedtls_mpi_free(arr++);
     }
 }
+
+/*
+ * Reserve room in field element temporaries for the product of two reduced
+ * elements, plus one limb for the fast reduction functions, so that the
+ * arithmetic of a scalar multiplication never has to reallocate them.
+ */
+static int mpi_reserve_many(const mbedtls_ecp_group *grp,
+                            mbedtls_mpi *arr, size_t size)
+{
+    int ret = 0;
+
+    while (size-- && ret == 0) {
+        ret = mbedtls_mpi_grow(arr++, 2 * grp->P.n + 1);
+    }
+
+    return ret;
+}
+
+static int ecp_point_reserve(const mbedtls_ecp_group *grp,
+                             mbedtls_ecp_point *pt)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, &pt->X, 1));
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, &pt->Y, 1));
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, &pt->Z, 1));
+
+cleanup:
+    return ret;
+}
 #endif /* MBEDTLS_ECP_C */
 
 /*
@@ -1330,6 +1368,8 @@ static int ecp_normalize_jac(const mbedtls_ecp_group *grp, mbedtls_ecp_point *pt
     mbedtls_mpi T;
     mbedtls_mpi_init(&T);
 
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, &T, 1));
+
     MPI_ECP_INV(&T,       &pt->Z);            /* T   <-          1 / Z   */
     MPI_ECP_MUL(&pt->Y,   &pt->Y,     &T);    /* Y'  <- Y*T    = Y / Z   */
     MPI_ECP_SQR(&T,       &T);                /* T   <- T^2    = 1 / Z^2 */
@@ -1384,6 +1424,9 @@ static int ecp_normalize_jac_many(const mbedtls_ecp_group *grp,
     mbedtls_mpi_init(&t);
 
     mpi_init_many(c, T_size);
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, &t, 1));
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, c, T_size));
+
     /*
      * c[i] = Z_0 * ... * Z_i,   i = 0,..,n := T_size-1
      */
@@ -1424,15 +1467,6 @@ static int ecp_normalize_jac_many(const mbedtls_ecp_group *grp,
         MPI_ECP_MUL(&T[i]->X, &T[i]->X, &t);
         MPI_ECP_MUL(&T[i]->Y, &T[i]->Y, &t);
 
-        /*
-         * Post-precessing: reclaim some memory by shrinking coordinates
-         * - not storing Z (always 1)
-         * - shrinking other coordinates, but still keeping the same number of
-         *   limbs as P, as otherwise it will too likely be regrown too fast.
-         */
-        MBEDTLS_MPI_CHK(mbedtls_mpi_shrink(&T[i]->X, grp->P.n));
-        MBEDTLS_MPI_CHK(mbedtls_mpi_shrink(&T[i]->Y, grp->P.n));
-
         MPI_ECP_LSET(&T[i]->Z, 1);
 
         if (i == 0) {
@@ -1456,16 +1490,16 @@ cleanup:
  */
 static int ecp_safe_invert_jac(const mbedtls_ecp_group *grp,
                                mbedtls_ecp_point *Q,
-                               unsigned char inv)
+                               unsigned char inv,
+                               mbedtls_mpi *tmp)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
-    mbedtls_mpi tmp;
-    mbedtls_mpi_init(&tmp);
+    unsigned char nonzero = mbedtls_mpi_cmp_int(&Q->Y, 0) != 0;
 
-    MPI_ECP_COND_NEG(&Q->Y, inv);
+    MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(tmp, &grp->P, &Q->Y));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_safe_cond_assign(&Q->Y, tmp, nonzero & inv));
 
 cleanup:
-    mbedtls_mpi_free(&tmp);
     return ret;
 }
 
@@ -1860,6 +1894,7 @@ static int ecp_precompute_comb(const mbedtls_ecp_group *grp,
     mbedtls_mpi tmp[4];
 
     mpi_init_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, tmp, sizeof(tmp) / sizeof(mbedtls_mpi)));
 
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if (rs_ctx != NULL && rs_ctx->rsm != NULL) {
@@ -2011,7 +2046,7 @@ cleanup:
  */
 static int ecp_select_comb(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
                            const mbedtls_ecp_point T[], unsigned char T_size,
-                           unsigned char i)
+                           unsigned char i, mbedtls_mpi *tmp)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     unsigned char ii, j;
@@ -2026,7 +2061,7 @@ static int ecp_select_comb(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     }
 
     /* Safely invert result if i is "negative" */
-    MBEDTLS_MPI_CHK(ecp_safe_invert_jac(grp, R, i >> 7));
+    MBEDTLS_MPI_CHK(ecp_safe_invert_jac(grp, R, i >> 7, tmp));
 
     MPI_ECP_LSET(&R->Z, 1);
 
@@ -2050,11 +2085,15 @@ static int ecp_mul_comb_core(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_ecp_point Txi;
     mbedtls_mpi tmp[4];
-    size_t i;
+    size_t i = 0;
 
     mbedtls_ecp_point_init(&Txi);
     mpi_init_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
 
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, tmp, sizeof(tmp) / sizeof(mbedtls_mpi)));
+    MBEDTLS_MPI_CHK(ecp_point_reserve(grp, &Txi));
+    MBEDTLS_MPI_CHK(ecp_point_reserve(grp, R));
+
 #if !defined(MBEDTLS_ECP_RESTARTABLE)
     (void) rs_ctx;
 #endif
@@ -2075,7 +2114,7 @@ static int ecp_mul_comb_core(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     {
         /* Start with a non-zero point and randomize its coordinates */
         i = d;
-        MBEDTLS_MPI_CHK(ecp_select_comb(grp, R, T, T_size, x[i]));
+        MBEDTLS_MPI_CHK(ecp_select_comb(grp, R, T, T_size, x[i], &tmp[0]));
         if (f_rng != 0) {
             MBEDTLS_MPI_CHK(ecp_randomize_jac(grp, R, f_rng, p_rng));
         }
@@ -2086,7 +2125,7 @@ static int ecp_mul_comb_core(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
         --i;
 
         MBEDTLS_MPI_CHK(ecp_double_jac(grp, R, R, tmp));
-        MBEDTLS_MPI_CHK(ecp_select_comb(grp, &Txi, T, T_size, x[i]));
+        MBEDTLS_MPI_CHK(ecp_select_comb(grp, &Txi, T, T_size, x[i], &tmp[0]));
         MBEDTLS_MPI_CHK(ecp_add_mixed(grp, R, R, &Txi, tmp));
     }
 
@@ -2176,6 +2215,9 @@ static int ecp_mul_comb_after_precomp(const mbedtls_ecp_group *grp,
     unsigned char parity_trick;
     unsigned char k[COMB_MAX_D + 1];
     mbedtls_ecp_point *RR = R;
+    mbedtls_mpi tmp;
+
+    mbedtls_mpi_init(&tmp);
 
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if (rs_ctx != NULL && rs_ctx->rsm != NULL) {
@@ -2191,7 +2233,7 @@ static int ecp_mul_comb_after_precomp(const mbedtls_ecp_group *grp,
                                            &parity_trick));
     MBEDTLS_MPI_CHK(ecp_mul_comb_core(grp, RR, T, T_size, k, d,
                                       f_rng, p_rng, rs_ctx));
-    MBEDTLS_MPI_CHK(ecp_safe_invert_jac(grp, RR, parity_trick));
+    MBEDTLS_MPI_CHK(ecp_safe_invert_jac(grp, RR, parity_trick, &tmp));
 
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if (rs_ctx != NULL && rs_ctx->rsm != NULL) {
@@ -2225,6 +2267,7 @@ final_norm:
 #endif
 
 cleanup:
+    mbedtls_mpi_free(&tmp);
     return ret;
 }
 
@@ -2273,6 +2316,323 @@ static unsigned char ecp_pick_window_size(const mbedtls_ecp_group *grp,
     return w;
 }
 
+#if defined(MBEDTLS_ECP_GLV_OPTIM) && defined(MBEDTLS_ECP_DP_SECP256K1_ENABLED)
+/*
+ * GLV method for secp256k1, see [4].
+ *
+ * phi(x, y) = (beta x, y) is an endomorphism of secp256k1 with
+ * phi(P) = lambda P for every point P. A scalar k is split as
+ * k = k1 + k2 lambda mod N with |k1|, |k2| < 2^128 using the short lattice
+ * basis (a1, b1), (a2, b2) of { (x, y) : x + y lambda = 0 mod N }, so that
+ * k P = k1 P + k2 phi(P) only needs half as many doublings.
+ *
+ * The values below are taken from the secp256k1 constants in SEC 2, and
+ * g1 = round(2^384 b2 / N), g2 = round(-2^384 b1 / N).
+ */
+#define GLV_BITS        129                     /* Bound on |k1| and |k2| */
+#define GLV_L           (256 / biL)             /* Limbs in N */
+#define GLV_W           (2 * GLV_L)             /* Limbs in k * g1 */
+#define GLV_C           (128 / biL)             /* Limbs in c1, c2 */
+
+static const mbedtls_mpi_uint secp256k1_glv_beta[] = {
+    MBEDTLS_BYTES_TO_T_UINT_8(0xEE, 0x01, 0x95, 0x71, 0x28, 0x6C, 0x39, 0xC1),
+    MBEDTLS_BYTES_TO_T_UINT_8(0x95, 0x89, 0xF5, 0x12, 0x75, 0x49, 0xF0, 0x9C),
+    MBEDTLS_BYTES_TO_T_UINT_8(0xE9, 0x34, 0x34, 0xAC, 0x9E, 0x47, 0x64, 0x6E),
+    MBEDTLS_BYTES_TO_T_UINT_8(0x10, 0x07, 0x7C, 0x65, 0x2B, 0x6A, 0xE9, 0x7A),
+};
+static const mbedtls_mpi_uint secp256k1_glv_g1[] = {
+    MBEDTLS_BYTES_TO_T_UINT_8(0x31, 0xB0, 0xDB, 0x45, 0x9A, 0x20, 0x93, 0xE8),
+    MBEDTLS_BYTES_TO_T_UINT_8(0x7F, 0xCA, 0xE8, 0x71, 0x14, 0x8A, 0xAA, 0x3D),
+    MBEDTLS_BYTES_TO_T_UINT_8(0x15, 0xEB, 0x84, 0x92, 0xE4, 0x90, 0x6C, 0xE8),
+    MBEDTLS_BYTES_TO_T_UINT_8(0xCD, 0x6B, 0xD4, 0xA7, 0x21, 0xD2, 0x86, 0x30),
+};
+static const mbedtls_mpi_uint secp256k1_glv_g2[] = {
+    MBEDTLS_BYTES_TO_T_UINT_8(0x71, 0x7F, 0xC4, 0x8A, 0xAE, 0xB4, 0x71, 0x15),
+    MBEDTLS_BYTES_TO_T_UINT_8(0xC6, 0x06, 0xF5, 0x9D, 0xAC, 0x08, 0x12, 0x22),
+    MBEDTLS_BYTES_TO_T_UINT_8(0xC4, 0xE4, 0xBF, 0x0A, 0xA9, 0x7F, 0x54, 0x6F),
+    MBEDTLS_BYTES_TO_T_UINT_8(0x28, 0x88, 0x0E, 0x01, 0xD6, 0x7E, 0x43, 0xE4),
+};
+/* a1 = b2 */
+static const mbedtls_mpi_uint secp256k1_glv_a1[] = {
+    MBEDTLS_BYTES_TO_T_UINT_8(0x15, 0xEB, 0x84, 0x92, 0xE4, 0x90, 0x6C, 0xE8),
+    MBEDTLS_BYTES_TO_T_UINT_8(0xCD, 0x6B, 0xD4, 0xA7, 0x21, 0xD2, 0x86, 0x30),
+};
+static const mbedtls_mpi_uint secp256k1_glv_a2[] = {
+    MBEDTLS_BYTES_TO_T_UINT_8(0xD8, 0xCF, 0x44, 0x9D, 0x8D, 0x10, 0xC1, 0x57),
+    MBEDTLS_BYTES_TO_T_UINT_8(0xF6, 0xF3, 0xE2, 0xA8, 0xF7, 0x50, 0xCA, 0x14),
+    MBEDTLS_BYTES_TO_T_UINT_8(0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00),
+};
+/* -b1 */
+static const mbedtls_mpi_uint secp256k1_glv_b1[] = {
+    MBEDTLS_BYTES_TO_T_UINT_8(0xC3, 0xE4, 0xBF, 0x0A, 0xA9, 0x7F, 0x54, 0x6F),
+    MBEDTLS_BYTES_TO_T_UINT_8(0x28, 0x88, 0x0E, 0x01, 0xD6, 0x7E, 0x43, 0xE4),
+};
+
+#define GLV_LIMBS(a)    (sizeof(a) / sizeof(mbedtls_mpi_uint))
+
+/*
+ * X += A * B, on GLV_W limbs
+ */
+static void ecp_glv_mla(mbedtls_mpi_uint X[GLV_W],
+                        const mbedtls_mpi_uint *A, size_t A_limbs,
+                        const mbedtls_mpi_uint *B, size_t B_limbs)
+{
+    size_t j;
+
+    for (j = 0; j < B_limbs; j++) {
+        (void) mbedtls_mpi_core_mla(X + j, GLV_W - j, A, A_limbs, B[j]);
+    }
+}
+
+/*
+ * c = round(k * g / 2^384)
+ */
+static void ecp_glv_round(mbedtls_mpi_uint c[GLV_C],
+                          const mbedtls_mpi_uint k[GLV_L],
+                          const mbedtls_mpi_uint g[GLV_L])
+{
+    mbedtls_mpi_uint kg[GLV_W] = { 0 };
+    mbedtls_mpi_uint half;
+
+    ecp_glv_mla(kg, k, GLV_L, g, GLV_L);
+
+    /* Bit 383 of k * g rounds to nearest, k * g < 2^510 so c < 2^126 */
+    half = kg[384 / biL - 1] >> (biL - 1);
+    memcpy(c, kg + 384 / biL, GLV_C * ciL);
+    (void) mbedtls_mpi_core_mla(c, GLV_C, &half, 1, 1);
+
+    mbedtls_platform_zeroize(kg, sizeof(kg));
+}
+
+/*
+ * X = |X| for X in two's complement on GLV_W limbs, return 1 if X was
+ * negative and 0 otherwise. Constant-time.
+ */
+static unsigned char ecp_glv_abs(mbedtls_mpi_uint X[GLV_W])
+{
+    mbedtls_mpi_uint neg[GLV_W] = { 0 };
+    mbedtls_mpi_uint sign = X[GLV_W - 1] >> (biL - 1);
+
+    (void) mbedtls_mpi_core_sub(neg, neg, X, GLV_W);
+    mbedtls_mpi_core_cond_assign(X, neg, GLV_W, mbedtls_ct_bool(sign));
+
+    mbedtls_platform_zeroize(neg, sizeof(neg));
+    return (unsigned char) sign;
+}
+
+/*
+ * Split 0 <= m < N into m = s1 k1 + s2 k2 lambda mod N, with s1, s2 = +-1,
+ * 0 <= k1, k2 < 2^GLV_BITS. Return k1, k2 as GLV_W limbs and the signs in
+ * neg1, neg2 (1 for -1). Constant-time in m.
+ */
+static int ecp_glv_split(const mbedtls_mpi *m,
+                         mbedtls_mpi_uint k1[GLV_W], unsigned char *neg1,
+                         mbedtls_mpi_uint k2[GLV_W], unsigned char *neg2)
+{
+    mbedtls_mpi_uint k[GLV_L] = { 0 };
+    mbedtls_mpi_uint c1[GLV_C], c2[GLV_C];
+    mbedtls_mpi_uint s[GLV_W] = { 0 };
+    mbedtls_mpi_uint over = 0;
+    size_t i;
+
+    if (m->s < 0 || mbedtls_mpi_bitlen(m) > 256) {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+    memcpy(k, m->p, (m->n < GLV_L ? m->n : GLV_L) * ciL);
+
+    ecp_glv_round(c1, k, secp256k1_glv_g1);
+    ecp_glv_round(c2, k, secp256k1_glv_g2);
+
+    /* k1 = k - c1 a1 - c2 a2 */
+    memset(k1, 0, GLV_W * ciL);
+    memcpy(k1, k, sizeof(k));
+    ecp_glv_mla(s, secp256k1_glv_a1, GLV_LIMBS(secp256k1_glv_a1), c1, GLV_C);
+    ecp_glv_mla(s, secp256k1_glv_a2, GLV_LIMBS(secp256k1_glv_a2), c2, GLV_C);
+    (void) mbedtls_mpi_core_sub(k1, k1, s, GLV_W);
+
+    /* k2 = -c1 b1 - c2 b2 */
+    memset(k2, 0, GLV_W * ciL);
+    memset(s, 0, sizeof(s));
+    ecp_glv_mla(k2, secp256k1_glv_b1, GLV_LIMBS(secp256k1_glv_b1), c1, GLV_C);
+    ecp_glv_mla(s, secp256k1_glv_a1, GLV_LIMBS(secp256k1_glv_a1), c2, GLV_C);
+    (void) mbedtls_mpi_core_sub(k2, k2, s, GLV_W);
+
+    *neg1 = ecp_glv_abs(k1);
+    *neg2 = ecp_glv_abs(k2);
+
+    /* The bound is a property of the basis, check it without branching
+     * on the value of m. */
+    for (i = GLV_BITS / biL; i < GLV_W; i++) {
+        if (i == GLV_BITS / biL) {
+            over |= (k1[i] | k2[i]) >> (GLV_BITS % biL);
+        } else {
+            over |= k1[i] | k2[i];
+        }
+    }
+
+    mbedtls_platform_zeroize(k, sizeof(k));
+    mbedtls_platform_zeroize(c1, sizeof(c1));
+    mbedtls_platform_zeroize(c2, sizeof(c2));
+    mbedtls_platform_zeroize(s, sizeof(s));
+
+    return over == 0 ? 0 : MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+}
+
+/*
+ * Recode k (GLV_W limbs, modified in place) for ecp_mul_comb_core() with
+ * sign s: make it odd, which is undone later by adding -s P if even is set,
+ * and negate all digits if s is -1.
+ */
+static void ecp_glv_recode(unsigned char x[], size_t d, unsigned char w,
+                           mbedtls_mpi_uint k[GLV_W], unsigned char neg,
+                           unsigned char *even)
+{
+    mbedtls_mpi K;
+    size_t i;
+
+    *even = (unsigned char) (1 - (k[0] & 1));
+    k[0] |= 1;
+
+    K.s = 1;
+    K.n = GLV_W;
+    K.p = k;
+    ecp_comb_recode_core(x, d, w, &K);
+
+    for (i = 0; i <= d; i++) {
+        x[i] ^= (unsigned char) (neg << 7);
+    }
+}
+
+/*
+ * R = R - s T[0] if even is set, in constant time.
+ */
+static int ecp_glv_fix_parity(const mbedtls_ecp_group *grp,
+                              mbedtls_ecp_point *R,
+                              const mbedtls_ecp_point T[], unsigned char T_size,
+                              unsigned char neg, unsigned char even,
+                              mbedtls_ecp_point *S, mbedtls_ecp_point *Txi,
+                              mbedtls_mpi tmp[4])
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    MBEDTLS_MPI_CHK(ecp_select_comb(grp, Txi, T, T_size,
+                                    (unsigned char) ((neg ^ 1) << 7), &tmp[0]));
+    MBEDTLS_MPI_CHK(ecp_add_mixed(grp, S, R, Txi, tmp));
+    MPI_ECP_COND_ASSIGN(&R->X, &S->X, even);
+    MPI_ECP_COND_ASSIGN(&R->Y, &S->Y, even);
+    MPI_ECP_COND_ASSIGN(&R->Z, &S->Z, even);
+
+cleanup:
+    return ret;
+}
+
+/*
+ * Multiplication R = m * P on secp256k1 with the GLV method.
+ *
+ * Two comb tables are used, T for P and T2 for phi(P), which is obtained
+ * from T by one field multiplication per point. The core loop is the one of
+ * ecp_mul_comb_core() on half-length scalars, doing one doubling and two
+ * additions per step. Constant-time in m.
+ *
+ * Cost: d(w-1) D + (2^{w-1} - 1) A + 2^{w-1} M + d D + 2d A,
+ *       with d = ceil(GLV_BITS / w)
+ */
+static int ecp_mul_glv(const mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
+                       const mbedtls_mpi *m, const mbedtls_ecp_point *P,
+                       int (*f_rng)(void *, unsigned char *, size_t),
+                       void *p_rng)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const unsigned char w = ecp_pick_window_size(grp, 0);
+    const unsigned char T_size = 1U << (w - 1);
+    const size_t d = (GLV_BITS + w - 1) / w;
+    unsigned char x1[(GLV_BITS + 1) / 2 + 1], x2[(GLV_BITS + 1) / 2 + 1];
+    unsigned char neg1, neg2, even1, even2;
+    mbedtls_mpi_uint k1[GLV_W], k2[GLV_W];
+    mbedtls_ecp_point T[COMB_MAX_PRE], T2[COMB_MAX_PRE];
+    mbedtls_ecp_point Txi, S;
+    mbedtls_mpi beta, tmp[4];
+    unsigned char i;
+    size_t j;
+
+    for (i = 0; i < T_size; i++) {
+        mbedtls_ecp_point_init(&T[i]);
+        mbedtls_ecp_point_init(&T2[i]);
+    }
+    mbedtls_ecp_point_init(&Txi);
+    mbedtls_ecp_point_init(&S);
+    mpi_init_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
+
+    MBEDTLS_MPI_CHK(ecp_glv_split(m, k1, &neg1, k2, &neg2));
+
+    for (i = 0; i < T_size; i++) {
+        MBEDTLS_MPI_CHK(ecp_point_reserve(grp, &T[i]));
+        MBEDTLS_MPI_CHK(ecp_point_reserve(grp, &T2[i]));
+    }
+    MBEDTLS_MPI_CHK(ecp_point_reserve(grp, &Txi));
+    MBEDTLS_MPI_CHK(ecp_point_reserve(grp, &S));
+    MBEDTLS_MPI_CHK(ecp_point_reserve(grp, R));
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, tmp, sizeof(tmp) / sizeof(mbedtls_mpi)));
+
+    /* T for P, then T2 = phi(T) for lambda P */
+    MBEDTLS_MPI_CHK(ecp_precompute_comb(grp, T, P, w, d, NULL));
+
+    beta.s = 1;
+    beta.n = GLV_LIMBS(secp256k1_glv_beta);
+    beta.p = (mbedtls_mpi_uint *) secp256k1_glv_beta; /* not modified */
+    for (i = 0; i < T_size; i++) {
+        MPI_ECP_MUL(&T2[i].X, &T[i].X, &beta);
+        MPI_ECP_MOV(&T2[i].Y, &T[i].Y);
+    }
+
+    ecp_glv_recode(x1, d, w, k1, neg1, &even1);
+    ecp_glv_recode(x2, d, w, k2, neg2, &even2);
+
+    /* Start with a non-zero point and randomize its coordinates */
+    MBEDTLS_MPI_CHK(ecp_select_comb(grp, R, T, T_size, x1[d], &tmp[0]));
+    MBEDTLS_MPI_CHK(ecp_select_comb(grp, &Txi, T2, T_size, x2[d], &tmp[0]));
+    MBEDTLS_MPI_CHK(ecp_add_mixed(grp, R, R, &Txi, tmp));
+    if (f_rng != 0) {
+        MBEDTLS_MPI_CHK(ecp_randomize_jac(grp, R, f_rng, p_rng));
+    }
+
+    for (j = d; j-- > 0;) {
+        MBEDTLS_MPI_CHK(ecp_double_jac(grp, R, R, tmp));
+        MBEDTLS_MPI_CHK(ecp_select_comb(grp, &Txi, T, T_size, x1[j], &tmp[0]));
+        MBEDTLS_MPI_CHK(ecp_add_mixed(grp, R, R, &Txi, tmp));
+        MBEDTLS_MPI_CHK(ecp_select_comb(grp, &Txi, T2, T_size, x2[j], &tmp[0]));
+        MBEDTLS_MPI_CHK(ecp_add_mixed(grp, R, R, &Txi, tmp));
+    }
+
+    MBEDTLS_MPI_CHK(ecp_glv_fix_parity(grp, R, T, T_size, neg1, even1,
+                                       &S, &Txi, tmp));
+    MBEDTLS_MPI_CHK(ecp_glv_fix_parity(grp, R, T2, T_size, neg2, even2,
+                                       &S, &Txi, tmp));
+
+    /* See ecp_mul_comb_after_precomp() */
+    if (f_rng != 0) {
+        MBEDTLS_MPI_CHK(ecp_randomize_jac(grp, R, f_rng, p_rng));
+    }
+
+    MBEDTLS_MPI_CHK(ecp_normalize_jac(grp, R));
+
+cleanup:
+    for (i = 0; i < T_size; i++) {
+        mbedtls_ecp_point_free(&T[i]);
+        mbedtls_ecp_point_free(&T2[i]);
+    }
+    mbedtls_ecp_point_free(&Txi);
+    mbedtls_ecp_point_free(&S);
+    mpi_free_many(tmp, sizeof(tmp) / sizeof(mbedtls_mpi));
+    mbedtls_platform_zeroize(k1, sizeof(k1));
+    mbedtls_platform_zeroize(k2, sizeof(k2));
+    mbedtls_platform_zeroize(x1, sizeof(x1));
+    mbedtls_platform_zeroize(x2, sizeof(x2));
+
+    return ret;
+}
+#endif /* MBEDTLS_ECP_GLV_OPTIM && MBEDTLS_ECP_DP_SECP256K1_ENABLED */
+
 /*
  * Multiplication using the comb method - for curves in short Weierstrass form
  *
@@ -2308,6 +2668,20 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
     p_eq_g = 0;
 #endif
 
+#if defined(MBEDTLS_ECP_GLV_OPTIM) && defined(MBEDTLS_ECP_DP_SECP256K1_ENABLED)
+    /* The base point keeps its static or cached comb table, which is
+     * faster; other points use the endomorphism. The GLV path is not
+     * restartable. */
+    if (grp->id == MBEDTLS_ECP_DP_SECP256K1 && !p_eq_g
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+        && (rs_ctx == NULL || rs_ctx->rsm == NULL)
+#endif
+        ) {
+        MBEDTLS_MPI_CHK(ecp_mul_glv(grp, R, m, P, f_rng, p_rng));
+        goto cleanup;
+    }
+#endif
+
     /* Pick window size and deduce related sizes */
     w = ecp_pick_window_size(grp, p_eq_g);
     T_size = 1U << (w - 1);
@@ -2342,6 +2716,9 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
         for (i = 0; i < T_size; i++) {
             mbedtls_ecp_point_init(&T[i]);
         }
+        for (i = 0; i < T_size; i++) {
+            MBEDTLS_MPI_CHK(ecp_point_reserve(grp, &T[i]));
+        }
 
         T_ok = 0;
     }
@@ -2351,6 +2728,15 @@ static int ecp_mul_comb(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
         MBEDTLS_MPI_CHK(ecp_precompute_comb(grp, T, P, w, d, rs_ctx));
 
         if (p_eq_g) {
+            /* The table is kept in the group: reclaim some memory by
+             * shrinking coordinates to the same number of limbs as P, and
+             * not storing Z (always 1). */
+            for (i = 0; i < T_size; i++) {
+                MBEDTLS_MPI_CHK(mbedtls_mpi_shrink(&T[i].X, grp->P.n));
+                MBEDTLS_MPI_CHK(mbedtls_mpi_shrink(&T[i].Y, grp->P.n));
+                MBEDTLS_MPI_CHK(mbedtls_mpi_shrink(&T[i].Z, 1));
+            }
+
             /* almost transfer ownership of T to the group, but keep a copy of
              * the pointer to use for calling the next function more easily */
             grp->T = T;
@@ -2561,6 +2947,17 @@ static int ecp_mul_mxz(mbedtls_ecp_group *grp, mbedtls_ecp_point *R,
         return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
     }
 
+#if defined(MBEDTLS_ECP_CURVE448_OPTIM) && defined(MBEDTLS_ECP_DP_CURVE448_ENABLED)
+    if (grp->id == MBEDTLS_ECP_DP_CURVE448) {
+        return mbedtls_ecp_x448_mul(R, m, P, f_rng, p_rng);
+    }
+#endif
+
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, tmp, sizeof(tmp) / sizeof(mbedtls_mpi)));
+    MBEDTLS_MPI_CHK(mpi_reserve_many(grp, &PX, 1));
+    MBEDTLS_MPI_CHK(ecp_point_reserve(grp, &RP));
+    MBEDTLS_MPI_CHK(ecp_point_reserve(grp, R));
+
     /* Save PX and read from P before writing to R, in case P == R */
     MPI_ECP_MOV(&PX, &P->X);
     MBEDTLS_MPI_CHK(mbedtls_ecp_copy(&RP, P));
@@ -5201,10 +5201,14 @@ static int ecp_mod_p255(mbedtls_mpi *N)
 
     /* Helper references for top part of N */
     mbedtls_mpi_uint * const NT_p = N->p + P255_WIDTH;
-    const size_t NT_n = N->n - P255_WIDTH;
+    size_t NT_n = N->n - P255_WIDTH;
     if (N->n <= P255_WIDTH) {
         return 0;
     }
+    /* Zero limbs above 2^512 are just room reserved by the caller */
+    while (NT_n > P255_WIDTH && NT_p[NT_n - 1] == 0) {
+        NT_n--;
+    }
     if (NT_n > P255_WIDTH) {
         return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
     }
@@ -5259,6 +5263,10 @@ static int ecp_mod_p448(mbedtls_mpi *N)
     /* M = A1 */
     M.s = 1;
     M.n = N->n - (P448_WIDTH);
+    /* Zero limbs above 2^896 are just room reserved by the caller */
+    while (M.n > P448_WIDTH && N->p[P448_WIDTH + M.n - 1] == 0) {
+        M.n--;
+    }
     if (M.n > P448_WIDTH) {
         /* Shouldn't be called with N larger than 2^896! */
         return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
@@ -5433,6 +5441,62 @@ static int ecp_mod_p224k1(mbedtls_mpi *N)
  * Fast quasi-reduction modulo p256k1 = 2^256 - R,
  * with R = 2^32 + 2^9 + 2^8 + 2^7 + 2^6 + 2^4 + 1 = 0x01000003D1
  */
+#if defined(MBEDTLS_ECP_GLV_OPTIM)
+/*
+ * Write N as A0 + 2^256 A1, return A0 + R * A1, twice. The result is less
+ * than 2^256 + 2^67, and this works on the limbs of N in place, without
+ * any allocation in the usual case where N holds a product.
+ */
+#define P256K1_LIMBS    (256 / 8 / sizeof(mbedtls_mpi_uint))
+static int ecp_mod_p256k1(mbedtls_mpi *N)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    static const mbedtls_mpi_uint Rp[] = {
+        MBEDTLS_BYTES_TO_T_UINT_8(0xD1, 0x03, 0x00, 0x00, 0x01, 0x00, 0x00,
+                                  0x00)
+    };
+    const size_t R_limbs = sizeof(Rp) / sizeof(mbedtls_mpi_uint);
+    mbedtls_mpi_uint A1[P256K1_LIMBS];
+    size_t i, n;
+
+    if (N->n <= P256K1_LIMBS) {
+        return 0;
+    }
+
+    /* Room for A0 + R * A1 < 2^290 */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_grow(N, P256K1_LIMBS + R_limbs));
+
+    /* A1 = N >> 256, N = A0. N < 2^512 is checked by the caller, so
+     * limbs past 2 * P256K1_LIMBS are zero. */
+    n = N->n - P256K1_LIMBS;
+    if (n > P256K1_LIMBS) {
+        n = P256K1_LIMBS;
+    }
+    memset(A1, 0, sizeof(A1));
+    memcpy(A1, N->p + P256K1_LIMBS, n * sizeof(mbedtls_mpi_uint));
+    memset(N->p + P256K1_LIMBS, 0,
+           (N->n - P256K1_LIMBS) * sizeof(mbedtls_mpi_uint));
+
+    /* N = A0 + R * A1 */
+    for (i = 0; i < R_limbs; i++) {
+        (void) mbedtls_mpi_core_mla(N->p + i, P256K1_LIMBS + R_limbs - i,
+                                    A1, P256K1_LIMBS, Rp[i]);
+    }
+
+    /* Second pass, A1 < 2^34 */
+    memcpy(A1, N->p + P256K1_LIMBS, R_limbs * sizeof(mbedtls_mpi_uint));
+    memset(N->p + P256K1_LIMBS, 0, R_limbs * sizeof(mbedtls_mpi_uint));
+
+    for (i = 0; i < R_limbs; i++) {
+        (void) mbedtls_mpi_core_mla(N->p + i, P256K1_LIMBS + R_limbs - i,
+                                    A1, R_limbs, Rp[i]);
+    }
+
+cleanup:
+    mbedtls_platform_zeroize(A1, sizeof(A1));
+    return ret;
+}
+#else /* MBEDTLS_ECP_GLV_OPTIM */
 static int ecp_mod_p256k1(mbedtls_mpi *N)
 {
     static const mbedtls_mpi_uint Rp[] = {
@@ -5442,6 +5506,7 @@ static int ecp_mod_p256k1(mbedtls_mpi *N)
     return ecp_mod_koblitz(N, Rp, 256 / 8 / sizeof(mbedtls_mpi_uint), 0, 0,
                            0);
 }
+#endif /* MBEDTLS_ECP_GLV_OPTIM */
 #endif /* MBEDTLS_ECP_DP_SECP256K1_ENABLED */
 
 #if defined(MBEDTLS_TEST_HOOKS)
@@ -0,0 +1,458 @@
+/*
+ *  Dedicated arithmetic for X448 (Curve448 in Montgomery form)
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+
+/*
+ * References:
+ *
+ * RFC 7748 for the X448 function and its Montgomery ladder
+ * - https://www.rfc-editor.org/rfc/rfc7748
+ *
+ * [1] HAMBURG, Mike. Ed448-Goldilocks, a new elliptic curve. IACR Cryptology
+ *     ePrint Archive, 2015, vol. 2015, p. 625.
+ *     <https://eprint.iacr.org/2015/625>
+ *
+ * Field elements modulo p = 2^448 - 2^224 - 1 are stored in X448_LIMBS limbs
+ * of X448_BITS bits: 8 limbs of 56 bits when a 128-bit type is available for
+ * products, 16 limbs of 28 bits otherwise. Limbs have a few bits of headroom
+ * so that sums do not need a full carry chain, and products of two elements
+ * are accumulated in double-width integers. Since 2^448 = 2^224 + 1 mod p
+ * and 224 is a whole number of limbs, the upper half of a product is folded
+ * onto the lower half with two limb additions per limb [1].
+ *
+ * Elements are kept "reduced": every limb is less than 2^X448_BITS + 2^7,
+ * but the value itself may be anywhere below 2^449. Only x448_to_bytes()
+ * computes the canonical representative.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_CURVE448_OPTIM) && \
+    defined(MBEDTLS_ECP_DP_CURVE448_ENABLED)
+
+#include "ecp_x448.h"
+#include "constant_time_internal.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include <string.h>
+
+#if defined(MBEDTLS_HAVE_INT64) && defined(MBEDTLS_HAVE_UDBL)
+typedef uint64_t x448_limb;
+typedef mbedtls_t_udbl x448_dlimb;
+#define X448_BITS       56
+#else
+typedef uint32_t x448_limb;
+typedef uint64_t x448_dlimb;
+#define X448_BITS       28
+#endif
+
+#define X448_LIMBS      (448 / X448_BITS)
+#define X448_HALF       (X448_LIMBS / 2)        /* The limb of 2^224 */
+#define X448_MASK       (((x448_limb) 1 << X448_BITS) - 1)
+#define X448_BYTES      56
+
+/* (A - 2) / 4 for Curve448 */
+#define X448_A24        39081
+
+typedef x448_limb x448_fe[X448_LIMBS];
+
+/*
+ * Bring a sum or difference of reduced elements back to a reduced element.
+ */
+static void x448_carry(x448_fe a)
+{
+    x448_limb top;
+    size_t i;
+
+    for (i = 0; i < X448_LIMBS - 1; i++) {
+        a[i + 1] += a[i] >> X448_BITS;
+        a[i] &= X448_MASK;
+    }
+
+    top = a[X448_LIMBS - 1] >> X448_BITS;
+    a[X448_LIMBS - 1] &= X448_MASK;
+    a[0] += top;
+    a[X448_HALF] += top;
+}
+
+/*
+ * r = c mod p, for c made of X448_LIMBS wide limbs of less than 2^126
+ * (resp. 2^62).
+ */
+static void x448_reduce_wide(x448_fe r, x448_dlimb c[X448_LIMBS])
+{
+    x448_dlimb top;
+    size_t i;
+
+    for (i = 0; i < X448_LIMBS - 1; i++) {
+        c[i + 1] += c[i] >> X448_BITS;
+        c[i] &= X448_MASK;
+    }
+
+    top = c[X448_LIMBS - 1] >> X448_BITS;
+    c[X448_LIMBS - 1] &= X448_MASK;
+    c[0] += top;
+    c[X448_HALF] += top;
+
+    /* top can be large, push it one limb further */
+    c[1] += c[0] >> X448_BITS;
+    c[0] &= X448_MASK;
+    c[X448_HALF + 1] += c[X448_HALF] >> X448_BITS;
+    c[X448_HALF] &= X448_MASK;
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        r[i] = (x448_limb) c[i];
+    }
+}
+
+/*
+ * Fold the upper half of a double-length product onto the lower half and
+ * reduce: limb i >= X448_LIMBS is worth 2^224 + 1 times limb i - X448_LIMBS.
+ * Going down from the top means that the limbs i - X448_HALF >= X448_LIMBS
+ * that receive a contribution are folded again afterwards.
+ */
+static void x448_fold(x448_fe r, x448_dlimb c[2 * X448_LIMBS - 1])
+{
+    size_t i;
+
+    for (i = 2 * X448_LIMBS - 2; i >= X448_LIMBS; i--) {
+        c[i - X448_LIMBS] += c[i];
+        c[i - X448_HALF] += c[i];
+    }
+
+    x448_reduce_wide(r, c);
+}
+
+static void x448_add(x448_fe r, const x448_fe a, const x448_fe b)
+{
+    size_t i;
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        r[i] = a[i] + b[i];
+    }
+    x448_carry(r);
+}
+
+/*
+ * r = a + 2p - b, which is positive in each limb for reduced b.
+ */
+static void x448_sub(x448_fe r, const x448_fe a, const x448_fe b)
+{
+    size_t i;
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        r[i] = a[i] + 2 * X448_MASK - b[i];
+    }
+    r[X448_HALF] -= 2;
+    x448_carry(r);
+}
+
+static void x448_mul(x448_fe r, const x448_fe a, const x448_fe b)
+{
+    x448_dlimb c[2 * X448_LIMBS - 1] = { 0 };
+    size_t i, j;
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        for (j = 0; j < X448_LIMBS; j++) {
+            c[i + j] += (x448_dlimb) a[i] * b[j];
+        }
+    }
+
+    x448_fold(r, c);
+}
+
+static void x448_sqr(x448_fe r, const x448_fe a)
+{
+    x448_dlimb c[2 * X448_LIMBS - 1] = { 0 };
+    size_t i, j;
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        const x448_limb a2 = 2 * a[i];
+
+        c[2 * i] += (x448_dlimb) a[i] * a[i];
+        for (j = i + 1; j < X448_LIMBS; j++) {
+            c[i + j] += (x448_dlimb) a2 * a[j];
+        }
+    }
+
+    x448_fold(r, c);
+}
+
+static void x448_mul_small(x448_fe r, const x448_fe a, x448_limb b)
+{
+    x448_dlimb c[X448_LIMBS];
+    size_t i;
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        c[i] = (x448_dlimb) a[i] * b;
+    }
+
+    x448_reduce_wide(r, c);
+}
+
+/*
+ * r = a^(2^n) * b
+ */
+static void x448_sqr_n_mul(x448_fe r, const x448_fe a, size_t n,
+                           const x448_fe b)
+{
+    x448_fe t;
+
+    memcpy(t, a, sizeof(t));
+    while (n-- > 0) {
+        x448_sqr(t, t);
+    }
+    x448_mul(r, t, b);
+}
+
+/*
+ * r = a^(p - 2), with p - 2 = 2^448 - 2^224 - 3. The sequence of operations
+ * only depends on p. The notation xN stands for a^(2^N - 1).
+ */
+static void x448_inv(x448_fe r, const x448_fe a)
+{
+    x448_fe x3, x6, x24, x30, t, u;
+
+    x448_sqr_n_mul(t, a, 1, a);             /* x2 */
+    x448_sqr_n_mul(x3, t, 1, a);
+    x448_sqr_n_mul(x6, x3, 3, x3);
+    x448_sqr_n_mul(t, x6, 6, x6);           /* x12 */
+    x448_sqr_n_mul(x24, t, 12, t);
+    x448_sqr_n_mul(x30, x24, 6, x6);
+    x448_sqr_n_mul(t, x24, 24, x24);        /* x48 */
+    x448_sqr_n_mul(u, t, 48, t);            /* x96 */
+    x448_sqr_n_mul(t, u, 96, u);            /* x192 */
+    x448_sqr_n_mul(u, t, 30, x30);          /* x222 */
+    x448_sqr_n_mul(t, u, 1, a);             /* x223 */
+    x448_sqr_n_mul(u, u, 2, a);             /* a^(2^224 - 3) */
+    x448_sqr_n_mul(r, t, 225, u);
+
+    mbedtls_platform_zeroize(x3, sizeof(x3));
+    mbedtls_platform_zeroize(x6, sizeof(x6));
+    mbedtls_platform_zeroize(x24, sizeof(x24));
+    mbedtls_platform_zeroize(x30, sizeof(x30));
+    mbedtls_platform_zeroize(t, sizeof(t));
+    mbedtls_platform_zeroize(u, sizeof(u));
+}
+
+/*
+ * Swap a and b if swap is 1, leave them alone if swap is 0, in constant time.
+ */
+static void x448_cswap(x448_fe a, x448_fe b, x448_limb swap)
+{
+    const x448_limb mask =
+        (x448_limb) 0 - (x448_limb) mbedtls_ct_compiler_opaque(swap);
+    x448_limb t;
+    size_t i;
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        t = mask & (a[i] ^ b[i]);
+        a[i] ^= t;
+        b[i] ^= t;
+    }
+}
+
+/*
+ * Load a little-endian number less than 2^448.
+ */
+static void x448_from_bytes(x448_fe r, const unsigned char in[X448_BYTES])
+{
+    uint64_t acc = 0;
+    unsigned bits = 0;
+    size_t i, j = 0;
+
+    for (i = 0; i < X448_BYTES; i++) {
+        acc |= (uint64_t) in[i] << bits;
+        bits += 8;
+        if (bits >= X448_BITS) {
+            r[j++] = (x448_limb) (acc & X448_MASK);
+            acc >>= X448_BITS;
+            bits -= X448_BITS;
+        }
+    }
+}
+
+/*
+ * Write the canonical representative of a as a little-endian number.
+ */
+static void x448_to_bytes(unsigned char out[X448_BYTES], const x448_fe a)
+{
+    x448_fe t, d;
+    x448_limb borrow = 0, mask;
+    uint64_t acc = 0;
+    unsigned bits = 0;
+    size_t i, j = 0;
+
+    /* Three passes leave every limb below 2^X448_BITS, so t < 2^448 < 2p */
+    memcpy(t, a, sizeof(t));
+    x448_carry(t);
+    x448_carry(t);
+    x448_carry(t);
+
+    /* d = t - p, keep it if there was no borrow */
+    for (i = 0; i < X448_LIMBS; i++) {
+        d[i] = t[i] - X448_MASK - borrow + (i == X448_HALF);
+        borrow = d[i] >> (sizeof(x448_limb) * 8 - 1);
+        d[i] &= X448_MASK;
+    }
+    mask = borrow - 1;
+    for (i = 0; i < X448_LIMBS; i++) {
+        t[i] = (d[i] & mask) | (t[i] & ~mask);
+    }
+
+    for (i = 0; i < X448_LIMBS; i++) {
+        acc |= (uint64_t) t[i] << bits;
+        bits += X448_BITS;
+        while (bits >= 8) {
+            out[j++] = (unsigned char) acc;
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+
+    mbedtls_platform_zeroize(t, sizeof(t));
+    mbedtls_platform_zeroize(d, sizeof(d));
+}
+
+/*
+ * Draw a random nonzero element, as ecp_randomize_mxz() does.
+ */
+static int x448_random(x448_fe r,
+                       int (*f_rng)(void *, unsigned char *, size_t),
+                       void *p_rng)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    unsigned char buf[X448_BYTES];
+    unsigned char nonzero;
+    int count = 30;
+    size_t i;
+
+    do {
+        MBEDTLS_MPI_CHK(f_rng(p_rng, buf, sizeof(buf)));
+        x448_from_bytes(r, buf);
+
+        x448_to_bytes(buf, r);
+        nonzero = 0;
+        for (i = 0; i < sizeof(buf); i++) {
+            nonzero |= buf[i];
+        }
+    } while (nonzero == 0 && --count > 0);
+
+    ret = nonzero != 0 ? 0 : MBEDTLS_ERR_ECP_RANDOM_FAILED;
+
+cleanup:
+    mbedtls_platform_zeroize(buf, sizeof(buf));
+    return ret;
+}
+
+int mbedtls_ecp_x448_mul(mbedtls_ecp_point *R, const mbedtls_mpi *m,
+                         const mbedtls_ecp_point *P,
+                         int (*f_rng)(void *, unsigned char *, size_t),
+                         void *p_rng)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    unsigned char k[X448_BYTES], u[X448_BYTES];
+    x448_fe x1, x2, z2, x3, z3;
+    x448_fe a, aa, b, bb, e, c, d, da, cb;
+    x448_limb swap = 0, bit;
+    unsigned char nonzero = 0;
+    size_t i;
+
+    if (f_rng == NULL) {
+        return MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+    }
+
+    /* Read P before writing to R, in case P == R */
+    if (mbedtls_mpi_write_binary_le(m, k, sizeof(k)) != 0 ||
+        mbedtls_mpi_write_binary_le(&P->X, u, sizeof(u)) != 0) {
+        ret = MBEDTLS_ERR_ECP_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+    x448_from_bytes(x1, u);
+
+    /* (x2 : z2) = (1 : 0), the point at infinity, and (x3 : z3) = P with
+     * randomized projective coordinates. */
+    memset(x2, 0, sizeof(x2));
+    memset(z2, 0, sizeof(z2));
+    x2[0] = 1;
+    MBEDTLS_MPI_CHK(x448_random(z3, f_rng, p_rng));
+    x448_mul(x3, x1, z3);
+
+    /* Loop invariant: (x3 : z3) - (x2 : z2) = P, see RFC 7748 section 5 */
+    for (i = 8 * X448_BYTES; i-- > 0;) {
+        bit = (k[i / 8] >> (i % 8)) & 1;
+        swap ^= bit;
+        x448_cswap(x2, x3, swap);
+        x448_cswap(z2, z3, swap);
+        swap = bit;
+
+        x448_add(a, x2, z2);
+        x448_sqr(aa, a);
+        x448_sub(b, x2, z2);
+        x448_sqr(bb, b);
+        x448_sub(e, aa, bb);
+        x448_add(c, x3, z3);
+        x448_sub(d, x3, z3);
+        x448_mul(da, d, a);
+        x448_mul(cb, c, b);
+        x448_add(x3, da, cb);
+        x448_sqr(x3, x3);
+        x448_sub(z3, da, cb);
+        x448_sqr(z3, z3);
+        x448_mul(z3, z3, x1);
+        x448_mul(x2, aa, bb);
+        x448_mul_small(z2, e, X448_A24);
+        x448_add(z2, z2, aa);
+        x448_mul(z2, z2, e);
+    }
+    x448_cswap(x2, x3, swap);
+    x448_cswap(z2, z3, swap);
+
+    /* The generic code fails to invert zero, do the same. Whether the
+     * result is zero only depends on the order of P since m is a multiple of
+     * the cofactor. */
+    x448_to_bytes(u, z2);
+    for (i = 0; i < sizeof(u); i++) {
+        nonzero |= u[i];
+    }
+    if (nonzero == 0) {
+        ret = MBEDTLS_ERR_MPI_NOT_ACCEPTABLE;
+        goto cleanup;
+    }
+
+    /* The inversion is constant-flow, so unlike in the generic code there
+     * is no need to randomize the coordinates again before it. */
+    x448_inv(z2, z2);
+    x448_mul(x2, x2, z2);
+    x448_to_bytes(u, x2);
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary_le(&R->X, u, sizeof(u)));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&R->Z, 1));
+    mbedtls_mpi_free(&R->Y);
+
+cleanup:
+    mbedtls_platform_zeroize(k, sizeof(k));
+    mbedtls_platform_zeroize(u, sizeof(u));
+    mbedtls_platform_zeroize(x2, sizeof(x2));
+    mbedtls_platform_zeroize(z2, sizeof(z2));
+    mbedtls_platform_zeroize(x3, sizeof(x3));
+    mbedtls_platform_zeroize(z3, sizeof(z3));
+    mbedtls_platform_zeroize(a, sizeof(a));
+    mbedtls_platform_zeroize(aa, sizeof(aa));
+    mbedtls_platform_zeroize(b, sizeof(b));
+    mbedtls_platform_zeroize(bb, sizeof(bb));
+    mbedtls_platform_zeroize(e, sizeof(e));
+    mbedtls_platform_zeroize(c, sizeof(c));
+    mbedtls_platform_zeroize(d, sizeof(d));
+    mbedtls_platform_zeroize(da, sizeof(da));
+    mbedtls_platform_zeroize(cb, sizeof(cb));
+
+    return ret;
+}
+
+#endif /* MBEDTLS_ECP_C && MBEDTLS_ECP_CURVE448_OPTIM &&
+          MBEDTLS_ECP_DP_CURVE448_ENABLED */
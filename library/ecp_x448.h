@@ -0,0 +1,60 @@
+/**
+ * \file ecp_x448.h
+ *
+ * \brief Dedicated arithmetic for X448 (Curve448 in Montgomery form)
+ *
+ *  This module implements the Montgomery ladder of RFC 7748 for Curve448 on
+ *  fixed-size field elements, with no heap allocation and no branch or
+ *  memory access depending on secret data. It is used by ecp_mul_mxz() in
+ *  place of the generic ladder on #mbedtls_mpi values, so that ECDH, PSA key
+ *  agreement and the TLS 1.3 key exchange benefit from it transparently.
+ *
+ *  This is an internal interface of the library.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_ECP_X448_H
+#define MBEDTLS_ECP_X448_H
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/ecp.h"
+
+#if defined(MBEDTLS_ECP_C) && defined(MBEDTLS_ECP_CURVE448_OPTIM) && \
+    defined(MBEDTLS_ECP_DP_CURVE448_ENABLED)
+
+/**
+ * \brief          Compute R = m * P on Curve448, in x/z coordinates.
+ *
+ * \param R        The destination point. This must be initialized. On
+ *                 success, its X coordinate is set to the normalized result,
+ *                 its Z coordinate to 1 and its Y coordinate is freed, as
+ *                 in the generic implementation.
+ * \param m        The scalar. This must be a valid Curve448 private key, see
+ *                 mbedtls_ecp_check_privkey().
+ * \param P        The point. Its X coordinate must be less than 2^448.
+ *                 This may alias \p R.
+ * \param f_rng    The RNG used to randomize the projective coordinates.
+ *                 This must not be \c NULL.
+ * \param p_rng    The RNG context to be passed to \p f_rng.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_ECP_BAD_INPUT_DATA if \p m or the X
+ *                 coordinate of \p P is too large.
+ * \return         #MBEDTLS_ERR_ECP_RANDOM_FAILED if the RNG failed to
+ *                 produce a suitable blinding value.
+ * \return         #MBEDTLS_ERR_MPI_NOT_ACCEPTABLE if the result is the
+ *                 point at infinity, as in the generic implementation.
+ * \return         Another negative error code on other kinds of failure.
+ */
+int mbedtls_ecp_x448_mul(mbedtls_ecp_point *R, const mbedtls_mpi *m,
+                         const mbedtls_ecp_point *P,
+                         int (*f_rng)(void *, unsigned char *, size_t),
+                         void *p_rng);
+
+#endif /* MBEDTLS_ECP_C && MBEDTLS_ECP_CURVE448_OPTIM &&
+          MBEDTLS_ECP_DP_CURVE448_ENABLED */
+
+#endif /* ecp_x448.h */
@@ -0,0 +1,301 @@
+/*
+ *  Fixed-base exponentiation for the RFC 7919 FFDHE groups
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+
+/*
+ * A public key in a named FFDHE group is 2^x mod p for a fixed p, so the
+ * work can be moved to a per-group precomputation with the comb method:
+ *
+ *  [1] C. H. Lim and P. J. Lee, "More flexible exponentiation with
+ *      precomputation", CRYPTO '94.
+ *
+ * Split the exponent into W rows of d = ceil(bits / W) bits each, so that
+ * column j of the comb is made of the bits j, d + j, ..., (W - 1) d + j.
+ * With T[v] = prod(2^(2^(i d)) for each bit i set in v), precomputed for
+ * the 2^W possible columns, 2^x is obtained with d squarings and d
+ * multiplications by table entries, instead of about 7/6 * bits
+ * operations for the generic sliding window method.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+
+#include "ffdhe.h"
+#include "bignum_core.h"
+#include "mbedtls/dhm.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include "mbedtls/platform.h"
+
+#if defined(MBEDTLS_THREADING_C)
+#include "mbedtls/threading.h"
+#endif
+
+#include <string.h>
+
+/* Number of rows of the comb. Each table has 2^FFDHE_COMB_WIDTH entries,
+ * which is 8KB for ffdhe2048 and 32KB for ffdhe8192. */
+#define FFDHE_COMB_WIDTH    5
+#define FFDHE_COMB_SIZE     (1 << FFDHE_COMB_WIDTH)
+
+#define FFDHE_LIMBS(bits)   ((bits) / biL)
+
+typedef struct {
+    const unsigned char *P;         /* The modulus, big-endian */
+    size_t bits;                    /* The size of the modulus in bits */
+    mbedtls_mpi_uint *N;            /* The modulus, FFDHE_LIMBS(bits) limbs */
+    mbedtls_mpi_uint *table;        /* The comb table, in Montgomery form */
+    mbedtls_mpi_uint mm;            /* The Montgomery constant for N */
+    int ready;                      /* Whether N, table and mm are set */
+} ffdhe_group;
+
+#define FFDHE_GROUP_STORAGE(bits)                                       \
+    static const unsigned char ffdhe ## bits ## _P[] =                  \
+        MBEDTLS_DHM_RFC7919_FFDHE ## bits ## _P_BIN;                    \
+    static mbedtls_mpi_uint ffdhe ## bits ## _N[FFDHE_LIMBS(bits)];     \
+    static mbedtls_mpi_uint ffdhe ## bits ## _T[FFDHE_COMB_SIZE *       \
+                                                FFDHE_LIMBS(bits)];
+
+FFDHE_GROUP_STORAGE(2048)
+FFDHE_GROUP_STORAGE(3072)
+FFDHE_GROUP_STORAGE(4096)
+FFDHE_GROUP_STORAGE(6144)
+FFDHE_GROUP_STORAGE(8192)
+
+#define FFDHE_GROUP(bits)                                               \
+    { ffdhe ## bits ## _P, bits, ffdhe ## bits ## _N, ffdhe ## bits ## _T, 0, 0 }
+
+/* The tables are protected by mbedtls_threading_ffdhe_mutex. */
+static ffdhe_group ffdhe_groups[] = {
+    FFDHE_GROUP(2048),
+    FFDHE_GROUP(3072),
+    FFDHE_GROUP(4096),
+    FFDHE_GROUP(6144),
+    FFDHE_GROUP(8192),
+};
+
+/*
+ * Return the named group whose modulus is P, or NULL if there is none.
+ * P is public, so this does not need to be constant-time.
+ */
+static ffdhe_group *ffdhe_find_group(const mbedtls_mpi *P)
+{
+    size_t bits = mbedtls_mpi_bitlen(P);
+    size_t i, k;
+
+    if (P->s < 0) {
+        return NULL;
+    }
+
+    for (i = 0; i < sizeof(ffdhe_groups) / sizeof(ffdhe_groups[0]); i++) {
+        ffdhe_group *grp = &ffdhe_groups[i];
+        size_t len = grp->bits / 8;
+
+        if (grp->bits != bits) {
+            continue;
+        }
+
+        /* Compare from the least significant byte: the RFC 7919 primes
+         * share their most significant bytes. */
+        for (k = 0; k < len; k++) {
+            unsigned char byte =
+                (unsigned char) (P->p[k / ciL] >> ((k % ciL) * 8));
+            if (byte != grp->P[len - 1 - k]) {
+                break;
+            }
+        }
+
+        return k == len ? grp : NULL;
+    }
+
+    return NULL;
+}
+
+/*
+ * Fill in the modulus, Montgomery constant and comb table of grp.
+ */
+static int ffdhe_build_table(ffdhe_group *grp)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const size_t limbs = FFDHE_LIMBS(grp->bits);
+    const size_t d = (grp->bits + FFDHE_COMB_WIDTH - 1) / FFDHE_COMB_WIDTH;
+    mbedtls_mpi_uint *table = grp->table;
+    mbedtls_mpi_uint *T = NULL;
+    mbedtls_mpi N, RR;
+    size_t i, j, v;
+
+    mbedtls_mpi_init(&RR);
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_core_read_be(grp->N, limbs,
+                                             grp->P, grp->bits / 8));
+    grp->mm = mbedtls_mpi_core_montmul_init(grp->N);
+
+    N.s = 1;
+    N.n = (unsigned short) limbs;
+    N.p = grp->N;
+    MBEDTLS_MPI_CHK(mbedtls_mpi_core_get_mont_r2_unsafe(&RR, &N));
+
+    T = mbedtls_calloc(mbedtls_mpi_core_montmul_working_limbs(limbs), ciL);
+    if (T == NULL) {
+        ret = MBEDTLS_ERR_MPI_ALLOC_FAILED;
+        goto cleanup;
+    }
+
+    /* T[0] = 1 and T[1] = 2, converted to Montgomery form in place. */
+    memset(table, 0, 2 * limbs * ciL);
+    table[0] = 1;
+    table[limbs] = 2;
+    mbedtls_mpi_core_to_mont_rep(table, table, grp->N, limbs,
+                                 grp->mm, RR.p, T);
+    mbedtls_mpi_core_to_mont_rep(table + limbs, table + limbs, grp->N, limbs,
+                                 grp->mm, RR.p, T);
+
+    /* T[2^i] = 2^(2^(i d)): square the previous row d times. */
+    for (i = 1; i < FFDHE_COMB_WIDTH; i++) {
+        mbedtls_mpi_uint *row = table + ((size_t) 1 << i) * limbs;
+
+        memcpy(row, table + ((size_t) 1 << (i - 1)) * limbs, limbs * ciL);
+        for (j = 0; j < d; j++) {
+            mbedtls_mpi_core_montmul(row, row, row, limbs, grp->N, limbs,
+                                     grp->mm, T);
+        }
+    }
+
+    /* T[v] = T[v - 2^i] * T[2^i] where 2^i is the highest bit of v. */
+    for (v = 3; v < FFDHE_COMB_SIZE; v++) {
+        size_t high = 1;
+
+        while (high * 2 <= v) {
+            high *= 2;
+        }
+        if (high == v) {
+            continue;
+        }
+
+        mbedtls_mpi_core_montmul(table + v * limbs, table + (v - high) * limbs,
+                                 table + high * limbs, limbs, grp->N, limbs,
+                                 grp->mm, T);
+    }
+
+cleanup:
+    if (T != NULL) {
+        mbedtls_zeroize_and_free(T, mbedtls_mpi_core_montmul_working_limbs(limbs) * ciL);
+    }
+    mbedtls_mpi_free(&RR);
+
+    return ret;
+}
+
+/*
+ * Return bit pos of E, which is 0 past the last limb of E.
+ * pos is public, the value of the bit is not.
+ */
+static size_t ffdhe_get_bit(const mbedtls_mpi *E, size_t pos)
+{
+    if (pos / biL >= E->n) {
+        return 0;
+    }
+
+    return (size_t) ((E->p[pos / biL] >> (pos % biL)) & 1);
+}
+
+/*
+ * X = 2^E mod p, for 0 <= E < 2^grp->bits. Constant-time in E.
+ */
+static int ffdhe_exp_comb(mbedtls_mpi *X, const ffdhe_group *grp,
+                          const mbedtls_mpi *E)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const size_t limbs = FFDHE_LIMBS(grp->bits);
+    const size_t d = (grp->bits + FFDHE_COMB_WIDTH - 1) / FFDHE_COMB_WIDTH;
+    const size_t work_limbs =
+        2 * limbs + mbedtls_mpi_core_montmul_working_limbs(limbs);
+    mbedtls_mpi_uint *work, *acc, *sel, *T;
+    size_t i, j;
+
+    work = mbedtls_calloc(work_limbs, ciL);
+    if (work == NULL) {
+        return MBEDTLS_ERR_MPI_ALLOC_FAILED;
+    }
+    acc = work;
+    sel = acc + limbs;
+    T = sel + limbs;
+
+    for (j = d; j-- > 0;) {
+        size_t column = 0;
+
+        for (i = 0; i < FFDHE_COMB_WIDTH; i++) {
+            column |= ffdhe_get_bit(E, i * d + j) << i;
+        }
+
+        if (j == d - 1) {
+            mbedtls_mpi_core_ct_uint_table_lookup(acc, grp->table, limbs,
+                                                  FFDHE_COMB_SIZE, column);
+            continue;
+        }
+
+        mbedtls_mpi_core_montmul(acc, acc, acc, limbs, grp->N, limbs,
+                                 grp->mm, T);
+        mbedtls_mpi_core_ct_uint_table_lookup(sel, grp->table, limbs,
+                                              FFDHE_COMB_SIZE, column);
+        mbedtls_mpi_core_montmul(acc, acc, sel, limbs, grp->N, limbs,
+                                 grp->mm, T);
+    }
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(X, 0));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_grow(X, limbs));
+    mbedtls_mpi_core_from_mont_rep(X->p, acc, grp->N, limbs, grp->mm, T);
+
+cleanup:
+    mbedtls_zeroize_and_free(work, work_limbs * ciL);
+
+    return ret;
+}
+
+int mbedtls_ffdhe_exp_mod(mbedtls_mpi *X, const mbedtls_mpi *G,
+                          const mbedtls_mpi *E, const mbedtls_mpi *P,
+                          mbedtls_mpi *prec_RR)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    ffdhe_group *grp;
+
+    if (mbedtls_mpi_cmp_int(G, 2) != 0 ||
+        mbedtls_mpi_cmp_int(E, 0) < 0 ||
+        (grp = ffdhe_find_group(P)) == NULL ||
+        mbedtls_mpi_bitlen(E) > grp->bits) {
+        return mbedtls_mpi_exp_mod(X, G, E, P, prec_RR);
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&mbedtls_threading_ffdhe_mutex) != 0) {
+        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    ret = 0;
+    if (!grp->ready) {
+        ret = ffdhe_build_table(grp);
+        grp->ready = (ret == 0);
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&mbedtls_threading_ffdhe_mutex) != 0) {
+        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* Once ready, the table is never written again, so it can be read
+     * without holding the lock. */
+    return ffdhe_exp_comb(X, grp, E);
+}
+
+#endif /* MBEDTLS_FFDHE_FIXED_BASE */
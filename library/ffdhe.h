@@ -0,0 +1,62 @@
+/**
+ * \file ffdhe.h
+ *
+ * \brief Fixed-base exponentiation for the RFC 7919 FFDHE groups
+ *
+ *  This module is used by the legacy DHM module and by the PSA FFDH driver
+ *  to compute public keys. When the generator is 2 and the modulus is one of
+ *  the named RFC 7919 primes, it uses a precomputed comb table for that
+ *  group instead of the generic sliding window exponentiation. The tables
+ *  are built on first use and shared by all contexts and threads.
+ *
+ *  This is an internal interface of the library.
+ */
+/*
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+#ifndef MBEDTLS_FFDHE_H
+#define MBEDTLS_FFDHE_H
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/bignum.h"
+
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+
+/**
+ * \brief          Compute X = G^E mod P, using the precomputed table of a
+ *                 named FFDHE group when possible.
+ *
+ *                 The fast path is taken when \p G is 2, \p P is one of the
+ *                 RFC 7919 primes ffdhe2048 to ffdhe8192 and \p E is
+ *                 nonnegative and no longer than \p P. In that case the
+ *                 computation takes about a third of the modular
+ *                 multiplications of mbedtls_mpi_exp_mod(), does not depend
+ *                 on the value of \p E other than through the bit-size of
+ *                 \p P, and \p prec_RR is not used. Otherwise this function calls
+ *                 mbedtls_mpi_exp_mod().
+ *
+ * \param X        The destination MPI. This must point to an initialized MPI.
+ *                 This must not alias \p E or \p P.
+ * \param G        The base of the exponentiation.
+ *                 This must point to an initialized MPI.
+ * \param E        The exponent. This must point to an initialized MPI.
+ * \param P        The modulus. This must point to an initialized MPI.
+ * \param prec_RR  A helper MPI passed to mbedtls_mpi_exp_mod() on the
+ *                 generic path. See there for its semantics.
+ *
+ * \return         \c 0 if successful.
+ * \return         #MBEDTLS_ERR_MPI_ALLOC_FAILED if a memory allocation failed.
+ * \return         #MBEDTLS_ERR_THREADING_MUTEX_ERROR if the lock protecting
+ *                 the tables could not be taken.
+ * \return         Another negative error code from mbedtls_mpi_exp_mod()
+ *                 on the generic path.
+ */
+int mbedtls_ffdhe_exp_mod(mbedtls_mpi *X, const mbedtls_mpi *G,
+                          const mbedtls_mpi *E, const mbedtls_mpi *P,
+                          mbedtls_mpi *prec_RR);
+
+#endif /* MBEDTLS_FFDHE_FIXED_BASE */
+
+#endif /* ffdhe.h */
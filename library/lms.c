@@ -408,6 +408,157 @@ int mbedtls_lms_verify(const mbedtls_lms_public_t *ctx,
     return 0;
 }
 
+#define HSS_SIG_NSPK_OFFSET         (0)
+#define HSS_SIG_LMS_SIGS_OFFSET     (HSS_SIG_NSPK_OFFSET + \
+                                     MBEDTLS_HSS_L_LEVELS_LEN)
+
+#define HSS_PUBLIC_KEY_L_OFFSET     (0)
+#define HSS_PUBLIC_KEY_LMS_OFFSET   (HSS_PUBLIC_KEY_L_OFFSET + \
+                                     MBEDTLS_HSS_L_LEVELS_LEN)
+
+void mbedtls_hss_public_init(mbedtls_hss_public_t *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_hss_public_free(mbedtls_hss_public_t *ctx)
+{
+    mbedtls_platform_zeroize(ctx, sizeof(*ctx));
+}
+
+int mbedtls_hss_import_public_key(mbedtls_hss_public_t *ctx,
+                                  const unsigned char *key, size_t key_size)
+{
+    uint32_t levels;
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (key_size < HSS_PUBLIC_KEY_LMS_OFFSET + MBEDTLS_LMS_TYPE_LEN) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    levels = MBEDTLS_GET_UINT32_BE(key, HSS_PUBLIC_KEY_L_OFFSET);
+    if (levels < 1 || levels > MBEDTLS_HSS_L_LEVELS_MAX) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    ret = mbedtls_lms_import_public_key(&ctx->root_pub_key,
+                                        key + HSS_PUBLIC_KEY_LMS_OFFSET,
+                                        key_size - HSS_PUBLIC_KEY_LMS_OFFSET);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ctx->levels = levels;
+
+    return 0;
+}
+
+int mbedtls_hss_export_public_key(const mbedtls_hss_public_t *ctx,
+                                  unsigned char *key, size_t key_size,
+                                  size_t *key_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (key_size < MBEDTLS_HSS_PUBLIC_KEY_LEN(ctx->root_pub_key.params.type)) {
+        return MBEDTLS_ERR_LMS_BUFFER_TOO_SMALL;
+    }
+
+    if (!ctx->root_pub_key.have_public_key) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    MBEDTLS_PUT_UINT32_BE(ctx->levels, key, HSS_PUBLIC_KEY_L_OFFSET);
+
+    ret = mbedtls_lms_export_public_key(&ctx->root_pub_key,
+                                        key + HSS_PUBLIC_KEY_LMS_OFFSET,
+                                        key_size - HSS_PUBLIC_KEY_LMS_OFFSET,
+                                        NULL);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (key_len != NULL) {
+        *key_len = MBEDTLS_HSS_PUBLIC_KEY_LEN(ctx->root_pub_key.params.type);
+    }
+
+    return 0;
+}
+
+/* Verify a HSS signature, as per RFC8554 section 6.3. Each signed public key
+ * is verified with the key of the level above it before being used to verify
+ * the next level, and the bottom-level key verifies the message itself. Since
+ * only one LMS parameter set is supported, every component has the same
+ * length as the ones of the top-level key.
+ */
+int mbedtls_hss_verify(const mbedtls_hss_public_t *ctx,
+                       const unsigned char *msg, size_t msg_size,
+                       const unsigned char *sig, size_t sig_size)
+{
+    mbedtls_lms_public_t child_pub_key;
+    const mbedtls_lms_public_t *curr_pub_key = &ctx->root_pub_key;
+    const unsigned char *curr_sig = sig + HSS_SIG_LMS_SIGS_OFFSET;
+    size_t lms_sig_len;
+    size_t lms_pub_key_len;
+    uint32_t idx;
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (!ctx->root_pub_key.have_public_key) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    if (ctx->root_pub_key.params.type != MBEDTLS_LMS_SHA256_M32_H10 ||
+        ctx->root_pub_key.params.otstype != MBEDTLS_LMOTS_SHA256_N32_W8) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    if (sig_size != MBEDTLS_HSS_SIG_LEN(ctx->levels,
+                                        ctx->root_pub_key.params.type,
+                                        ctx->root_pub_key.params.otstype)) {
+        return MBEDTLS_ERR_LMS_VERIFY_FAILED;
+    }
+
+    /* Nspk, the number of signed public keys, must be L - 1 */
+    if (MBEDTLS_GET_UINT32_BE(sig, HSS_SIG_NSPK_OFFSET) != ctx->levels - 1) {
+        return MBEDTLS_ERR_LMS_VERIFY_FAILED;
+    }
+
+    lms_sig_len = MBEDTLS_LMS_SIG_LEN(ctx->root_pub_key.params.type,
+                                      ctx->root_pub_key.params.otstype);
+    lms_pub_key_len = MBEDTLS_LMS_PUBLIC_KEY_LEN(ctx->root_pub_key.params.type);
+
+    mbedtls_lms_public_init(&child_pub_key);
+
+    for (idx = 0; idx + 1 < ctx->levels; idx++) {
+        ret = mbedtls_lms_verify(curr_pub_key, curr_sig + lms_sig_len,
+                                 lms_pub_key_len, curr_sig, lms_sig_len);
+        if (ret != 0) {
+            ret = MBEDTLS_ERR_LMS_VERIFY_FAILED;
+            goto exit;
+        }
+
+        ret = mbedtls_lms_import_public_key(&child_pub_key,
+                                            curr_sig + lms_sig_len,
+                                            lms_pub_key_len);
+        if (ret != 0) {
+            ret = MBEDTLS_ERR_LMS_VERIFY_FAILED;
+            goto exit;
+        }
+
+        curr_pub_key = &child_pub_key;
+        curr_sig += lms_sig_len + lms_pub_key_len;
+    }
+
+    ret = mbedtls_lms_verify(curr_pub_key, msg, msg_size, curr_sig, lms_sig_len);
+    if (ret != 0) {
+        ret = MBEDTLS_ERR_LMS_VERIFY_FAILED;
+    }
+
+exit:
+    mbedtls_lms_public_free(&child_pub_key);
+
+    return ret;
+}
+
 #if defined(MBEDTLS_LMS_PRIVATE)
 
 /* Calculate a full Merkle tree based on a private key. This function
@@ -468,57 +619,36 @@ static int calculate_merkle_tree(const mbedtls_lms_private_t *ctx,
     return 0;
 }
 
-/* Calculate a path from a leaf node of the Merkle tree to the root of the tree,
- * and return the full path. This function implements RFC8554 section 5.4.1, as
- * the Merkle path is the main component of an LMS signature.
+/* Read a path from a leaf node of the Merkle tree to the root of the tree
+ * out of the tree cached in the private context. This function implements
+ * RFC8554 section 5.4.1, as the Merkle path is the main component of an LMS
+ * signature.
  *
  *  ctx                 The LMS private context, containing a parameter
- *                      set and private key material consisting of both
- *                      public and private OTS.
+ *                      set and the cached Merkle tree.
  *
  *  leaf_node_id        Which leaf node to calculate the path from.
  *
  *  path                The output path, which is H hash outputs.
  */
-static int get_merkle_path(mbedtls_lms_private_t *ctx,
-                           unsigned int leaf_node_id,
-                           unsigned char *path)
+static void get_merkle_path(const mbedtls_lms_private_t *ctx,
+                            unsigned int leaf_node_id,
+                            unsigned char *path)
 {
     const size_t node_bytes = MBEDTLS_LMS_M_NODE_BYTES(ctx->params.type);
     unsigned int curr_node_id = leaf_node_id;
     unsigned int adjacent_node_id;
-    unsigned char *tree = NULL;
     unsigned int height;
-    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
-
-    tree = mbedtls_calloc((size_t) MERKLE_TREE_NODE_AM(ctx->params.type),
-                          node_bytes);
-    if (tree == NULL) {
-        return MBEDTLS_ERR_LMS_ALLOC_FAILED;
-    }
-
-    ret = calculate_merkle_tree(ctx, tree);
-    if (ret != 0) {
-        goto exit;
-    }
 
     for (height = 0; height < MBEDTLS_LMS_H_TREE_HEIGHT(ctx->params.type);
          height++) {
         adjacent_node_id = curr_node_id ^ 1;
 
         memcpy(&path[height * node_bytes],
-               &tree[adjacent_node_id * node_bytes], node_bytes);
+               &ctx->tree[adjacent_node_id * node_bytes], node_bytes);
 
         curr_node_id >>= 1;
     }
-
-    ret = 0;
-
-exit:
-    mbedtls_zeroize_and_free(tree, node_bytes *
-                             (size_t) MERKLE_TREE_NODE_AM(ctx->params.type));
-
-    return ret;
 }
 
 void mbedtls_lms_private_init(mbedtls_lms_private_t *ctx)
@@ -545,6 +675,9 @@ void mbedtls_lms_private_free(mbedtls_lms_private_t *ctx)
 
         mbedtls_free(ctx->ots_private_keys);
         mbedtls_free(ctx->ots_public_keys);
+        mbedtls_zeroize_and_free(ctx->tree,
+                                 MBEDTLS_LMS_M_NODE_BYTES(ctx->params.type) *
+                                 (size_t) MERKLE_TREE_NODE_AM(ctx->params.type));
     }
 
     mbedtls_platform_zeroize(ctx, sizeof(*ctx));
@@ -602,6 +735,13 @@ int mbedtls_lms_generate_private_key(mbedtls_lms_private_t *ctx,
         goto exit;
     }
 
+    ctx->tree = mbedtls_calloc((size_t) MERKLE_TREE_NODE_AM(ctx->params.type),
+                               MBEDTLS_LMS_M_NODE_BYTES(ctx->params.type));
+    if (ctx->tree == NULL) {
+        ret = MBEDTLS_ERR_LMS_ALLOC_FAILED;
+        goto exit;
+    }
+
     for (idx = 0; idx < MERKLE_TREE_LEAF_NODE_AM(ctx->params.type); idx++) {
         mbedtls_lmots_private_init(&ctx->ots_private_keys[idx]);
         mbedtls_lmots_public_init(&ctx->ots_public_keys[idx]);
@@ -624,6 +764,13 @@ int mbedtls_lms_generate_private_key(mbedtls_lms_private_t *ctx,
         }
     }
 
+    /* The tree only depends on the OTS public keys, so build it once here
+     * rather than on every signature. */
+    ret = calculate_merkle_tree(ctx, ctx->tree);
+    if (ret != 0) {
+        goto exit;
+    }
+
     ctx->q_next_usable_key = 0;
 
 exit:
@@ -638,8 +785,6 @@ int mbedtls_lms_calculate_public_key(mbedtls_lms_public_t *ctx,
                                      const mbedtls_lms_private_t *priv_ctx)
 {
     const size_t node_bytes = MBEDTLS_LMS_M_NODE_BYTES(priv_ctx->params.type);
-    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
-    unsigned char *tree = NULL;
 
     if (!priv_ctx->have_private_key) {
         return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
@@ -655,32 +800,15 @@ int mbedtls_lms_calculate_public_key(mbedtls_lms_public_t *ctx,
         return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
     }
 
-    tree = mbedtls_calloc((size_t) MERKLE_TREE_NODE_AM(priv_ctx->params.type),
-                          node_bytes);
-    if (tree == NULL) {
-        return MBEDTLS_ERR_LMS_ALLOC_FAILED;
-    }
-
     memcpy(&ctx->params, &priv_ctx->params,
            sizeof(mbedtls_lmots_parameters_t));
 
-    ret = calculate_merkle_tree(priv_ctx, tree);
-    if (ret != 0) {
-        goto exit;
-    }
-
     /* Root node is always at position 1, due to 1-based indexing */
-    memcpy(ctx->T_1_pub_key, &tree[node_bytes], node_bytes);
+    memcpy(ctx->T_1_pub_key, &priv_ctx->tree[node_bytes], node_bytes);
 
     ctx->have_public_key = 1;
 
-    ret = 0;
-
-exit:
-    mbedtls_zeroize_and_free(tree, node_bytes *
-                             (size_t) MERKLE_TREE_NODE_AM(priv_ctx->params.type));
-
-    return ret;
+    return 0;
 }
 
 
@@ -742,18 +870,224 @@ int mbedtls_lms_sign(mbedtls_lms_private_t *ctx,
     MBEDTLS_PUT_UINT32_BE(ctx->params.type, sig, SIG_TYPE_OFFSET(ctx->params.otstype));
     MBEDTLS_PUT_UINT32_BE(q_leaf_identifier, sig, SIG_Q_LEAF_ID_OFFSET);
 
-    ret = get_merkle_path(ctx,
-                          MERKLE_TREE_INTERNAL_NODE_AM(ctx->params.type) + q_leaf_identifier,
-                          sig + SIG_PATH_OFFSET(ctx->params.otstype));
+    get_merkle_path(ctx,
+                    MERKLE_TREE_INTERNAL_NODE_AM(ctx->params.type) + q_leaf_identifier,
+                    sig + SIG_PATH_OFFSET(ctx->params.otstype));
+
+    if (sig_len != NULL) {
+        *sig_len = MBEDTLS_LMS_SIG_LEN(ctx->params.type, ctx->params.otstype);
+    }
+
+
+    return 0;
+}
+
+void mbedtls_hss_private_init(mbedtls_hss_private_t *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_hss_private_free(mbedtls_hss_private_t *ctx)
+{
+    unsigned int idx;
+
+    for (idx = 0; idx < MBEDTLS_HSS_L_LEVELS_MAX; idx++) {
+        mbedtls_lms_private_free(&ctx->priv_keys[idx]);
+        mbedtls_lms_public_free(&ctx->pub_keys[idx]);
+    }
+
+    mbedtls_platform_zeroize(ctx, sizeof(*ctx));
+}
+
+/* Replace the LMS key at the given level (which must not be the top level) by
+ * a new one with a seed drawn from the RNG, and sign its public key with the
+ * level above, as per RFC8554 section 6.2.
+ */
+static int hss_regenerate_level(mbedtls_hss_private_t *ctx, unsigned int level,
+                                int (*f_rng)(void *, unsigned char *, size_t),
+                                void *p_rng)
+{
+    mbedtls_lms_private_t *parent = &ctx->priv_keys[level - 1];
+    unsigned char seed[MBEDTLS_LMOTS_N_HASH_LEN_MAX];
+    unsigned char pub_key[MBEDTLS_LMS_PUBLIC_KEY_LEN(MBEDTLS_LMS_SHA256_M32_H10)];
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    mbedtls_lms_private_free(&ctx->priv_keys[level]);
+    mbedtls_lms_public_free(&ctx->pub_keys[level]);
+    mbedtls_lms_private_init(&ctx->priv_keys[level]);
+    mbedtls_lms_public_init(&ctx->pub_keys[level]);
+
+    ret = f_rng(p_rng, seed, sizeof(seed));
+    if (ret != 0) {
+        goto exit;
+    }
+
+    ret = mbedtls_lms_generate_private_key(&ctx->priv_keys[level],
+                                           parent->params.type,
+                                           parent->params.otstype,
+                                           f_rng, p_rng, seed, sizeof(seed));
+    if (ret != 0) {
+        goto exit;
+    }
+
+    ret = mbedtls_lms_calculate_public_key(&ctx->pub_keys[level],
+                                           &ctx->priv_keys[level]);
+    if (ret != 0) {
+        goto exit;
+    }
+
+    ret = mbedtls_lms_export_public_key(&ctx->pub_keys[level], pub_key,
+                                        sizeof(pub_key), NULL);
+    if (ret != 0) {
+        goto exit;
+    }
+
+    ret = mbedtls_lms_sign(parent, f_rng, p_rng, pub_key, sizeof(pub_key),
+                           ctx->pub_key_sigs[level - 1],
+                           sizeof(ctx->pub_key_sigs[level - 1]), NULL);
+
+exit:
+    mbedtls_platform_zeroize(seed, sizeof(seed));
+
+    return ret;
+}
+
+int mbedtls_hss_generate_private_key(mbedtls_hss_private_t *ctx,
+                                     unsigned int levels,
+                                     mbedtls_lms_algorithm_type_t type,
+                                     mbedtls_lmots_algorithm_type_t otstype,
+                                     int (*f_rng)(void *, unsigned char *, size_t),
+                                     void *p_rng, const unsigned char *seed,
+                                     size_t seed_size)
+{
+    unsigned int idx;
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (levels < 1 || levels > MBEDTLS_HSS_L_LEVELS_MAX) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    if (ctx->have_private_key) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    ret = mbedtls_lms_generate_private_key(&ctx->priv_keys[0], type, otstype,
+                                           f_rng, p_rng, seed, seed_size);
+    if (ret != 0) {
+        goto exit;
+    }
+
+    ret = mbedtls_lms_calculate_public_key(&ctx->pub_keys[0],
+                                           &ctx->priv_keys[0]);
+    if (ret != 0) {
+        goto exit;
+    }
+
+    for (idx = 1; idx < levels; idx++) {
+        ret = hss_regenerate_level(ctx, idx, f_rng, p_rng);
+        if (ret != 0) {
+            goto exit;
+        }
+    }
+
+    ctx->levels = levels;
+    ctx->have_private_key = 1;
+
+exit:
+    if (ret != 0) {
+        mbedtls_hss_private_free(ctx);
+    }
+
+    return ret;
+}
+
+int mbedtls_hss_calculate_public_key(mbedtls_hss_public_t *ctx,
+                                     const mbedtls_hss_private_t *priv_ctx)
+{
+    if (!priv_ctx->have_private_key) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    ctx->levels = priv_ctx->levels;
+    memcpy(&ctx->root_pub_key, &priv_ctx->pub_keys[0],
+           sizeof(ctx->root_pub_key));
+
+    return 0;
+}
+
+int mbedtls_hss_sign(mbedtls_hss_private_t *ctx,
+                     int (*f_rng)(void *, unsigned char *, size_t),
+                     void *p_rng, const unsigned char *msg,
+                     unsigned int msg_size, unsigned char *sig, size_t sig_size,
+                     size_t *sig_len)
+{
+    const mbedtls_lms_parameters_t *params = &ctx->priv_keys[0].params;
+    size_t lms_sig_len;
+    size_t lms_pub_key_len;
+    unsigned char *p;
+    unsigned int level;
+    unsigned int idx;
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (!ctx->have_private_key) {
+        return MBEDTLS_ERR_LMS_BAD_INPUT_DATA;
+    }
+
+    if (sig_size < MBEDTLS_HSS_SIG_LEN(ctx->levels, params->type, params->otstype)) {
+        return MBEDTLS_ERR_LMS_BUFFER_TOO_SMALL;
+    }
+
+    lms_sig_len = MBEDTLS_LMS_SIG_LEN(params->type, params->otstype);
+    lms_pub_key_len = MBEDTLS_LMS_PUBLIC_KEY_LEN(params->type);
+
+    /* Find the lowest level that still has keys left. Every level below it
+     * is exhausted and must be replaced before the message can be signed. */
+    for (level = ctx->levels; level > 0; level--) {
+        if (ctx->priv_keys[level - 1].q_next_usable_key <
+            MERKLE_TREE_LEAF_NODE_AM(params->type)) {
+            break;
+        }
+    }
+
+    if (level == 0) {
+        return MBEDTLS_ERR_LMS_OUT_OF_PRIVATE_KEYS;
+    }
+
+    /* A failure while replacing a level leaves the hierarchy half updated,
+     * so drop the key rather than risk signing with inconsistent state. */
+    for (; level < ctx->levels; level++) {
+        ret = hss_regenerate_level(ctx, level, f_rng, p_rng);
+        if (ret != 0) {
+            mbedtls_hss_private_free(ctx);
+            return ret;
+        }
+    }
+
+    MBEDTLS_PUT_UINT32_BE(ctx->levels - 1, sig, HSS_SIG_NSPK_OFFSET);
+    p = sig + HSS_SIG_LMS_SIGS_OFFSET;
+
+    for (idx = 0; idx + 1 < ctx->levels; idx++) {
+        memcpy(p, ctx->pub_key_sigs[idx], lms_sig_len);
+        p += lms_sig_len;
+
+        ret = mbedtls_lms_export_public_key(&ctx->pub_keys[idx + 1], p,
+                                            lms_pub_key_len, NULL);
+        if (ret != 0) {
+            return ret;
+        }
+        p += lms_pub_key_len;
+    }
+
+    ret = mbedtls_lms_sign(&ctx->priv_keys[ctx->levels - 1], f_rng, p_rng,
+                           msg, msg_size, p, lms_sig_len, NULL);
     if (ret != 0) {
         return ret;
     }
 
     if (sig_len != NULL) {
-        *sig_len = MBEDTLS_LMS_SIG_LEN(ctx->params.type, ctx->params.otstype);
+        *sig_len = MBEDTLS_HSS_SIG_LEN(ctx->levels, params->type, params->otstype);
     }
 
-
     return 0;
 }
 
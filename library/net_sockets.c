@@ -71,6 +71,14 @@ static int wsa_init_done = 0;
 #include <fcntl.h>
 #include <netdb.h>
 #include <errno.h>
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+#include <sys/uio.h>
+#endif
+#if defined(MBEDTLS_SSL_KTLS) && defined(__linux__)
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+#define MBEDTLS_NET_HAVE_KTLS
+#endif
 
 #define IS_EINTR(ret) ((ret) == EINTR)
 #define SOCKET int
@@ -664,6 +672,513 @@ int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len)
     return ret;
 }
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+/*
+ * Write several buffers at once
+ */
+int mbedtls_net_send_vec(void *ctx, const mbedtls_ssl_iovec *iov, size_t iovcnt)
+{
+#if (defined(_WIN32) || defined(_WIN32_WCE)) && !defined(EFIX64) && \
+    !defined(EFI32)
+    /* Partial writes are allowed, so this is correct if not optimal */
+    if (iovcnt == 0) {
+        return 0;
+    }
+
+    return mbedtls_net_send(ctx, iov[0].base, iov[0].len);
+#else
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int fd = ((mbedtls_net_context *) ctx)->fd;
+    struct iovec vec[16];
+    size_t i;
+
+    ret = check_fd(fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    /* Partial writes are allowed, so extra buffers can be left out */
+    if (iovcnt > sizeof(vec) / sizeof(vec[0])) {
+        iovcnt = sizeof(vec) / sizeof(vec[0]);
+    }
+
+    for (i = 0; i < iovcnt; i++) {
+        vec[i].iov_base = (void *) iov[i].base;
+        vec[i].iov_len = iov[i].len;
+    }
+
+    ret = (int) writev(fd, vec, (int) iovcnt);
+
+    if (ret < 0) {
+        if (net_would_block(ctx) != 0) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+
+        if (errno == EINTR) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    return ret;
+#endif
+}
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
+#if defined(MBEDTLS_SSL_DTLS_MUX_C)
+/*
+ * Receive a datagram and encode the address of its sender as the IP
+ * address (4 or 16 bytes) followed by the port (2 bytes, big endian)
+ */
+int mbedtls_net_recv_from(void *ctx, unsigned char *buf, size_t len,
+                          unsigned char *addr, size_t addr_size,
+                          size_t *addr_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int fd = ((mbedtls_net_context *) ctx)->fd;
+    struct sockaddr_storage peer;
+
+#if defined(__socklen_t_defined) || defined(_SOCKLEN_T) ||  \
+    defined(_SOCKLEN_T_DECLARED) || defined(__DEFINED_socklen_t) || \
+    defined(socklen_t) || (defined(_POSIX_VERSION) && _POSIX_VERSION >= 200112L)
+    socklen_t n = (socklen_t) sizeof(peer);
+#else
+    int n = (int) sizeof(peer);
+#endif
+
+    ret = check_fd(fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    ret = (int) recvfrom(fd, (void *) buf, MSVC_INT_CAST len, 0,
+                         (struct sockaddr *) &peer, &n);
+
+    if (ret < 0) {
+        if (net_would_block(ctx) != 0) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+
+#if (defined(_WIN32) || defined(_WIN32_WCE)) && !defined(EFIX64) && \
+        !defined(EFI32)
+        if (WSAGetLastError() == WSAECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+#else
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+
+        if (errno == EINTR) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+#endif
+
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+
+    if (peer.ss_family == AF_INET) {
+        struct sockaddr_in *addr4 = (struct sockaddr_in *) &peer;
+        *addr_len = sizeof(addr4->sin_addr.s_addr) + 2;
+
+        if (addr_size < *addr_len) {
+            return MBEDTLS_ERR_NET_BUFFER_TOO_SMALL;
+        }
+
+        memcpy(addr, &addr4->sin_addr.s_addr, *addr_len - 2);
+        memcpy(addr + *addr_len - 2, &addr4->sin_port, 2);
+    } else if (peer.ss_family == AF_INET6) {
+        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *) &peer;
+        *addr_len = sizeof(addr6->sin6_addr.s6_addr) + 2;
+
+        if (addr_size < *addr_len) {
+            return MBEDTLS_ERR_NET_BUFFER_TOO_SMALL;
+        }
+
+        memcpy(addr, &addr6->sin6_addr.s6_addr, *addr_len - 2);
+        memcpy(addr + *addr_len - 2, &addr6->sin6_port, 2);
+    } else {
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+
+    return ret;
+}
+
+/*
+ * Send a datagram to an address encoded as by mbedtls_net_recv_from()
+ */
+int mbedtls_net_send_to(void *ctx, const unsigned char *buf, size_t len,
+                        const unsigned char *addr, size_t addr_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int fd = ((mbedtls_net_context *) ctx)->fd;
+    struct sockaddr_storage peer;
+    size_t n;
+
+    ret = check_fd(fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    memset(&peer, 0, sizeof(peer));
+
+    if (addr_len == 4 + 2) {
+        struct sockaddr_in *addr4 = (struct sockaddr_in *) &peer;
+        addr4->sin_family = AF_INET;
+        memcpy(&addr4->sin_addr.s_addr, addr, 4);
+        memcpy(&addr4->sin_port, addr + 4, 2);
+        n = sizeof(struct sockaddr_in);
+    } else if (addr_len == 16 + 2) {
+        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *) &peer;
+        addr6->sin6_family = AF_INET6;
+        memcpy(&addr6->sin6_addr.s6_addr, addr, 16);
+        memcpy(&addr6->sin6_port, addr + 16, 2);
+        n = sizeof(struct sockaddr_in6);
+    } else {
+        return MBEDTLS_ERR_NET_BAD_INPUT_DATA;
+    }
+
+    ret = (int) sendto(fd, (const void *) buf, MSVC_INT_CAST len, 0,
+                       (struct sockaddr *) &peer, MSVC_INT_CAST n);
+
+    if (ret < 0) {
+        if (net_would_block(ctx) != 0) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+
+#if (defined(_WIN32) || defined(_WIN32_WCE)) && !defined(EFIX64) && \
+        !defined(EFI32)
+        if (WSAGetLastError() == WSAECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+#else
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+
+        if (errno == EINTR) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+#endif
+
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    return ret;
+}
+#endif /* MBEDTLS_SSL_DTLS_MUX_C */
+
+#if defined(MBEDTLS_SSL_KTLS)
+#if defined(MBEDTLS_NET_HAVE_KTLS)
+
+#if !defined(SOL_TLS)
+#define SOL_TLS 282
+#endif
+#if !defined(TCP_ULP)
+#define TCP_ULP 31
+#endif
+
+/*
+ * Send a record through the kernel: application data is written as usual,
+ * other record types are given as a control message.
+ */
+static int net_ktls_send(void *ctx, int record_type,
+                         const unsigned char *buf, size_t len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int fd = ((mbedtls_net_context *) ctx)->fd;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr align;
+        unsigned char buf[CMSG_SPACE(sizeof(unsigned char))];
+    } control;
+
+    if (record_type == MBEDTLS_SSL_MSG_APPLICATION_DATA) {
+        return mbedtls_net_send(ctx, buf, len);
+    }
+
+    ret = check_fd(fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+    iov.iov_base = (void *) buf;
+    iov.iov_len = len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+    *CMSG_DATA(cmsg) = (unsigned char) record_type;
+
+    ret = (int) sendmsg(fd, &msg, 0);
+
+    if (ret < 0) {
+        if (net_would_block(ctx) != 0) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+
+        if (errno == EINTR) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    return ret;
+}
+
+/*
+ * Receive the content of a record decrypted by the kernel, and its type
+ */
+static int net_ktls_recv(void *ctx, int *record_type,
+                         unsigned char *buf, size_t len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int fd = ((mbedtls_net_context *) ctx)->fd;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    union {
+        struct cmsghdr align;
+        unsigned char buf[CMSG_SPACE(sizeof(unsigned char))];
+    } control;
+
+    ret = check_fd(fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ret = (int) recvmsg(fd, &msg, 0);
+
+    if (ret < 0) {
+        if (net_would_block(ctx) != 0) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+
+        if (errno == EINTR) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+
+    *record_type = MBEDTLS_SSL_MSG_APPLICATION_DATA;
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_TLS &&
+            cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+            *record_type = *CMSG_DATA(cmsg);
+        }
+    }
+
+    return ret;
+}
+
+typedef union {
+    struct tls_crypto_info base;
+    struct tls12_crypto_info_aes_gcm_128 aes_gcm_128;
+#if defined(TLS_CIPHER_AES_GCM_256)
+    struct tls12_crypto_info_aes_gcm_256 aes_gcm_256;
+#endif
+#if defined(TLS_CIPHER_CHACHA20_POLY1305)
+    struct tls12_crypto_info_chacha20_poly1305 chacha20_poly1305;
+#endif
+} net_ktls_crypto_info;
+
+/*
+ * Convert the state exported by the SSL module to the kernel structure.
+ * For AES-GCM the kernel splits the nonce into a salt and an IV: with
+ * TLS 1.2 the IV is the explicit nonce of the next record, which is the
+ * sequence number in this library.
+ */
+static int net_ktls_fill_crypto_info(const mbedtls_ssl_ktls_info *info,
+                                     net_ktls_crypto_info *crypto,
+                                     socklen_t *crypto_len)
+{
+    const unsigned char *gcm_iv = info->rec_seq;
+
+    memset(crypto, 0, sizeof(*crypto));
+
+    if (info->tls_version == MBEDTLS_SSL_VERSION_TLS1_2) {
+        crypto->base.version = TLS_1_2_VERSION;
+    }
+#if defined(TLS_1_3_VERSION)
+    else if (info->tls_version == MBEDTLS_SSL_VERSION_TLS1_3) {
+        crypto->base.version = TLS_1_3_VERSION;
+        gcm_iv = info->iv + TLS_CIPHER_AES_GCM_128_SALT_SIZE;
+    }
+#endif
+    else {
+        return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+    }
+
+    switch (info->cipher) {
+        case MBEDTLS_CIPHER_AES_128_GCM:
+            crypto->base.cipher_type = TLS_CIPHER_AES_GCM_128;
+            memcpy(crypto->aes_gcm_128.key, info->key,
+                   TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+            memcpy(crypto->aes_gcm_128.salt, info->iv,
+                   TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+            memcpy(crypto->aes_gcm_128.iv, gcm_iv,
+                   TLS_CIPHER_AES_GCM_128_IV_SIZE);
+            memcpy(crypto->aes_gcm_128.rec_seq, info->rec_seq,
+                   TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+            *crypto_len = sizeof(crypto->aes_gcm_128);
+            return 0;
+#if defined(TLS_CIPHER_AES_GCM_256)
+        case MBEDTLS_CIPHER_AES_256_GCM:
+            crypto->base.cipher_type = TLS_CIPHER_AES_GCM_256;
+            memcpy(crypto->aes_gcm_256.key, info->key,
+                   TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+            memcpy(crypto->aes_gcm_256.salt, info->iv,
+                   TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+            memcpy(crypto->aes_gcm_256.iv, gcm_iv,
+                   TLS_CIPHER_AES_GCM_256_IV_SIZE);
+            memcpy(crypto->aes_gcm_256.rec_seq, info->rec_seq,
+                   TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+            *crypto_len = sizeof(crypto->aes_gcm_256);
+            return 0;
+#endif
+#if defined(TLS_CIPHER_CHACHA20_POLY1305)
+        case MBEDTLS_CIPHER_CHACHA20_POLY1305:
+            crypto->base.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+            memcpy(crypto->chacha20_poly1305.key, info->key,
+                   TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE);
+            memcpy(crypto->chacha20_poly1305.iv, info->iv,
+                   TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE);
+            memcpy(crypto->chacha20_poly1305.rec_seq, info->rec_seq,
+                   TLS_CIPHER_CHACHA20_POLY1305_REC_SEQ_SIZE);
+            *crypto_len = sizeof(crypto->chacha20_poly1305);
+            return 0;
+#endif
+        default:
+            return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+    }
+}
+#endif /* MBEDTLS_NET_HAVE_KTLS */
+
+/*
+ * Hand record protection over to the kernel
+ */
+int mbedtls_net_ktls_enable(mbedtls_net_context *ctx,
+                            mbedtls_ssl_context *ssl,
+                            int directions)
+{
+#if defined(MBEDTLS_NET_HAVE_KTLS)
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int fd = ctx->fd;
+    static const int dirs[2] = { MBEDTLS_SSL_KTLS_RX, MBEDTLS_SSL_KTLS_TX };
+    mbedtls_ssl_ktls_info info;
+    net_ktls_crypto_info crypto;
+    socklen_t crypto_len = 0;
+    int enabled = 0;
+    size_t i;
+
+    ret = check_fd(fd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+
+    if (directions == 0 ||
+        (directions & ~(MBEDTLS_SSL_KTLS_TX | MBEDTLS_SSL_KTLS_RX)) != 0) {
+        return MBEDTLS_ERR_NET_BAD_INPUT_DATA;
+    }
+
+    /* Check everything that can be checked before touching the socket,
+     * as the TLS layer cannot be removed from it afterwards. */
+    for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        if ((directions & dirs[i]) == 0) {
+            continue;
+        }
+
+        ret = mbedtls_ssl_get_ktls_info(ssl, dirs[i], &info);
+        if (ret == 0) {
+            ret = net_ktls_fill_crypto_info(&info, &crypto, &crypto_len);
+        }
+        if (ret != 0) {
+            goto exit;
+        }
+    }
+
+    /* Fails if the tls module is not available; EEXIST means that it is
+     * already attached to this socket. */
+    if (setsockopt(fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls")) != 0 &&
+        errno != EEXIST) {
+        ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+        goto exit;
+    }
+
+    /* Receive first: older kernels only support transmit, and a failure
+     * here leaves the socket unchanged. */
+    for (i = 0; i < sizeof(dirs) / sizeof(dirs[0]); i++) {
+        if ((directions & dirs[i]) == 0) {
+            continue;
+        }
+
+        if (mbedtls_ssl_get_ktls_info(ssl, dirs[i], &info) != 0 ||
+            net_ktls_fill_crypto_info(&info, &crypto, &crypto_len) != 0) {
+            continue;
+        }
+
+        if (setsockopt(fd, SOL_TLS,
+                       dirs[i] == MBEDTLS_SSL_KTLS_TX ? TLS_TX : TLS_RX,
+                       &crypto, crypto_len) == 0) {
+            enabled |= dirs[i];
+        }
+    }
+
+    if (enabled == 0) {
+        ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+        goto exit;
+    }
+
+    ret = mbedtls_ssl_set_ktls(ssl, enabled, net_ktls_send, net_ktls_recv);
+    if (ret == 0) {
+        ret = enabled;
+    }
+
+exit:
+    mbedtls_platform_zeroize(&info, sizeof(info));
+    mbedtls_platform_zeroize(&crypto, sizeof(crypto));
+    return ret;
+#else
+    (void) ctx;
+    (void) ssl;
+    (void) directions;
+    return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+#endif /* MBEDTLS_NET_HAVE_KTLS */
+}
+#endif /* MBEDTLS_SSL_KTLS */
+
 /*
  * Close the connection
  */
@@ -20,6 +20,7 @@
 #include "psa_crypto_core.h"
 #include "psa_crypto_ffdh.h"
 #include "psa_crypto_random_impl.h"
+#include "ffdhe.h"
 #include "mbedtls/platform.h"
 #include "mbedtls/error.h"
 
@@ -178,7 +179,11 @@ psa_status_t mbedtls_psa_ffdh_export_public_key(
     MBEDTLS_MPI_CHK(mbedtls_mpi_read_binary(&X, key_buffer,
                                             key_buffer_size));
 
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+    MBEDTLS_MPI_CHK(mbedtls_ffdhe_exp_mod(&GX, &G, &X, &P, NULL));
+#else
     MBEDTLS_MPI_CHK(mbedtls_mpi_exp_mod(&GX, &G, &X, &P, NULL));
+#endif
     MBEDTLS_MPI_CHK(mbedtls_mpi_write_binary(&GX, data, key_len));
 
     *data_length = key_len;
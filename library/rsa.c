@@ -75,6 +75,69 @@ static int asn1_get_nonzero_mpi(unsigned char **p,
     return 0;
 }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/*
+ * Parse the additional primes of a multi-prime key into rsa->other.
+ *
+ *  OtherPrimeInfos ::= SEQUENCE SIZE(1..MAX) OF OtherPrimeInfo
+ *
+ *  OtherPrimeInfo ::= SEQUENCE {
+ *      prime             INTEGER,  -- ri
+ *      exponent          INTEGER,  -- di
+ *      coefficient       INTEGER   -- ti
+ *  }
+ */
+static int rsa_parse_other_prime_infos(unsigned char **p,
+                                       const unsigned char *end,
+                                       mbedtls_rsa_context *rsa)
+{
+    int ret;
+    size_t len;
+    const unsigned char *seq_end, *info_end;
+    mbedtls_rsa_prime_info *info;
+
+    if ((ret = mbedtls_asn1_get_tag(p, end, &len,
+                                    MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)) != 0) {
+        return ret;
+    }
+
+    if (len == 0) {
+        return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+    }
+
+    seq_end = *p + len;
+
+    while (*p < seq_end) {
+        if (rsa->other_count == MBEDTLS_RSA_MAX_PRIMES - 2) {
+            return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+        }
+
+        if ((ret = mbedtls_asn1_get_tag(p, seq_end, &len,
+                                        MBEDTLS_ASN1_CONSTRUCTED |
+                                        MBEDTLS_ASN1_SEQUENCE)) != 0) {
+            return ret;
+        }
+
+        info_end = *p + len;
+        info = &rsa->other[rsa->other_count];
+
+        if ((ret = asn1_get_nonzero_mpi(p, info_end, &info->R)) != 0 ||
+            (ret = asn1_get_nonzero_mpi(p, info_end, &info->D)) != 0 ||
+            (ret = asn1_get_nonzero_mpi(p, info_end, &info->T)) != 0) {
+            return ret;
+        }
+
+        if (*p != info_end) {
+            return MBEDTLS_ERR_ASN1_LENGTH_MISMATCH;
+        }
+
+        rsa->other_count++;
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
 int mbedtls_rsa_parse_key(mbedtls_rsa_context *rsa, const unsigned char *key, size_t keylen)
 {
     int ret, version;
@@ -116,9 +179,16 @@ int mbedtls_rsa_parse_key(mbedtls_rsa_context *rsa, const unsigned char *key, si
         return ret;
     }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    /* Version 1 announces a multi-prime key, with otherPrimeInfos present */
+    if (version != 0 && version != 1) {
+        return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+    }
+#else
     if (version != 0) {
         return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
     }
+#endif
 
     /* Import N */
     if ((ret = asn1_get_nonzero_mpi(&p, end, &T)) != 0 ||
@@ -185,6 +255,14 @@ int mbedtls_rsa_parse_key(mbedtls_rsa_context *rsa, const unsigned char *key, si
         goto cleanup;
     }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    /* Import otherPrimeInfos */
+    if (version == 1 &&
+        (ret = rsa_parse_other_prime_infos(&p, end, rsa)) != 0) {
+        goto cleanup;
+    }
+#endif
+
 #else
     /* Verify existence of the CRT params */
     if ((ret = asn1_get_nonzero_mpi(&p, end, &T)) != 0 ||
@@ -282,11 +360,49 @@ int mbedtls_rsa_parse_pubkey(mbedtls_rsa_context *rsa, const unsigned char *key,
     return 0;
 }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/*
+ * Write the additional primes of a multi-prime key, see
+ * rsa_parse_other_prime_infos() for the format.
+ */
+static int rsa_write_other_prime_infos(const mbedtls_rsa_context *rsa,
+                                       unsigned char *start,
+                                       unsigned char **p)
+{
+    int ret;
+    size_t len = 0, info_len;
+    size_t i;
+    const mbedtls_rsa_prime_info *info;
+
+    for (i = rsa->other_count; i > 0; i--) {
+        info = &rsa->other[i - 1];
+        info_len = 0;
+
+        MBEDTLS_ASN1_CHK_ADD(info_len, mbedtls_asn1_write_mpi(p, start, &info->T));
+        MBEDTLS_ASN1_CHK_ADD(info_len, mbedtls_asn1_write_mpi(p, start, &info->D));
+        MBEDTLS_ASN1_CHK_ADD(info_len, mbedtls_asn1_write_mpi(p, start, &info->R));
+        MBEDTLS_ASN1_CHK_ADD(info_len, mbedtls_asn1_write_len(p, start, info_len));
+        MBEDTLS_ASN1_CHK_ADD(info_len, mbedtls_asn1_write_tag(p, start,
+                                                              MBEDTLS_ASN1_CONSTRUCTED |
+                                                              MBEDTLS_ASN1_SEQUENCE));
+        len += info_len;
+    }
+
+    MBEDTLS_ASN1_CHK_ADD(len, mbedtls_asn1_write_len(p, start, len));
+    MBEDTLS_ASN1_CHK_ADD(len, mbedtls_asn1_write_tag(p, start,
+                                                     MBEDTLS_ASN1_CONSTRUCTED |
+                                                     MBEDTLS_ASN1_SEQUENCE));
+
+    return (int) len;
+}
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
 int mbedtls_rsa_write_key(const mbedtls_rsa_context *rsa, unsigned char *start,
                           unsigned char **p)
 {
     size_t len = 0;
     int ret;
+    int version = 0;
 
     mbedtls_mpi T; /* Temporary holding the exported parameters */
 
@@ -296,6 +412,17 @@ int mbedtls_rsa_write_key(const mbedtls_rsa_context *rsa, unsigned char *start,
 
     mbedtls_mpi_init(&T);
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    /* Export otherPrimeInfos */
+    if (rsa->other_count != 0) {
+        if ((ret = rsa_write_other_prime_infos(rsa, start, p)) < 0) {
+            goto end_of_export;
+        }
+        len += ret;
+        version = 1;
+    }
+#endif
+
     /* Export QP */
     if ((ret = mbedtls_rsa_export_crt(rsa, NULL, NULL, &T)) != 0 ||
         (ret = mbedtls_asn1_write_mpi(p, start, &T)) < 0) {
@@ -359,7 +486,7 @@ end_of_export:
         return ret;
     }
 
-    MBEDTLS_ASN1_CHK_ADD(len, mbedtls_asn1_write_int(p, start, 0));
+    MBEDTLS_ASN1_CHK_ADD(len, mbedtls_asn1_write_int(p, start, version));
     MBEDTLS_ASN1_CHK_ADD(len, mbedtls_asn1_write_len(p, start, len));
     MBEDTLS_ASN1_CHK_ADD(len, mbedtls_asn1_write_tag(p, start,
                                                      MBEDTLS_ASN1_CONSTRUCTED |
@@ -715,9 +842,185 @@ static int rsa_check_context(mbedtls_rsa_context const *ctx, int is_priv,
     }
 #endif
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    /* The additional primes of a multi-prime key need the
+     * same properties as P and Q, DP and DQ, and QP. */
+    if (is_priv) {
+        size_t i;
+        for (i = 0; i < ctx->other_count; i++) {
+            if (mbedtls_mpi_cmp_int(&ctx->other[i].R, 0) <= 0 ||
+                mbedtls_mpi_get_bit(&ctx->other[i].R, 0) == 0 ||
+                mbedtls_mpi_cmp_int(&ctx->other[i].D, 0) <= 0 ||
+                mbedtls_mpi_cmp_int(&ctx->other[i].T, 0) <= 0) {
+                return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+            }
+        }
+    }
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
     return 0;
 }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/*
+ * Compute the CRT parameters of the additional primes of a multi-prime key:
+ *
+ * d_i = D mod (r_i - 1)
+ * t_i = (P * Q * r_3 * ... * r_(i-1))^-1 mod r_i
+ *
+ * Parameters which are already present are kept as is.
+ */
+static int rsa_deduce_other_primes_crt(mbedtls_rsa_context *ctx)
+{
+    int ret = 0;
+    size_t i;
+    mbedtls_mpi M, K;
+    mbedtls_rsa_prime_info *info;
+
+    mbedtls_mpi_init(&M);
+    mbedtls_mpi_init(&K);
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&M, &ctx->P, &ctx->Q));
+
+    for (i = 0; i < ctx->other_count; i++) {
+        info = &ctx->other[i];
+
+        if (mbedtls_mpi_cmp_int(&info->D, 0) == 0) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&K, &info->R, 1));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&info->D, &ctx->D, &K));
+        }
+
+        if (mbedtls_mpi_cmp_int(&info->T, 0) == 0) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&info->T, &M, &info->R));
+        }
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&M, &M, &info->R));
+    }
+
+cleanup:
+
+    mbedtls_mpi_free(&M);
+    mbedtls_mpi_free(&K);
+
+    return ret;
+}
+
+/*
+ * Check that the additional primes of a multi-prime key are consistent
+ * with the rest of the key: N is the product of all primes, D is an
+ * inverse of E modulo r_i - 1, and d_i, t_i are the CRT parameters
+ * computed by rsa_deduce_other_primes_crt().
+ */
+static int rsa_validate_other_primes(const mbedtls_rsa_context *ctx)
+{
+    int ret = 0;
+    size_t i;
+    mbedtls_mpi M, K, L;
+    const mbedtls_rsa_prime_info *info;
+
+    mbedtls_mpi_init(&M);
+    mbedtls_mpi_init(&K);
+    mbedtls_mpi_init(&L);
+
+    if (mbedtls_mpi_cmp_int(&ctx->D, 1) <= 0 ||
+        mbedtls_mpi_cmp_mpi(&ctx->D, &ctx->N) >= 0) {
+        ret = MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+        goto cleanup;
+    }
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&M, &ctx->P, &ctx->Q));
+
+    for (i = 0; i < ctx->other_count; i++) {
+        info = &ctx->other[i];
+
+        if (mbedtls_mpi_cmp_int(&info->R, 1) <= 0) {
+            ret = MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+            goto cleanup;
+        }
+
+        /* Check that D * E - 1 = 0 mod r_i - 1 */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&K, &ctx->D, &ctx->E));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&K, &K, 1));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&L, &info->R, 1));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&K, &K, &L));
+        if (mbedtls_mpi_cmp_int(&K, 0) != 0) {
+            ret = MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+            goto cleanup;
+        }
+
+        /* Check that d_i = D mod r_i - 1 */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&K, &ctx->D, &L));
+        if (mbedtls_mpi_cmp_mpi(&K, &info->D) != 0) {
+            ret = MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+            goto cleanup;
+        }
+
+        /* Check that t_i * M = 1 mod r_i */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&K, &info->T, &M));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&K, &K, &info->R));
+        if (mbedtls_mpi_cmp_int(&K, 1) != 0) {
+            ret = MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+            goto cleanup;
+        }
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&M, &M, &info->R));
+    }
+
+    /* Check that N = P * Q * r_3 * ... * r_u */
+    if (mbedtls_mpi_cmp_mpi(&M, &ctx->N) != 0) {
+        ret = MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+        goto cleanup;
+    }
+
+cleanup:
+
+    mbedtls_mpi_free(&M);
+    mbedtls_mpi_free(&K);
+    mbedtls_mpi_free(&L);
+
+    /* Wrap MPI error codes by RSA check failure error code */
+    if (ret != 0 && ret != MBEDTLS_ERR_RSA_KEY_CHECK_FAILED) {
+        ret += MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+    }
+
+    return ret;
+}
+
+/*
+ * Complete a multi-prime key. Unlike for two-prime keys, the primes
+ * can't be deduced from N, E and D, so all core parameters must
+ * have been provided: only the CRT parameters are computed if missing.
+ */
+static int rsa_complete_multi(mbedtls_rsa_context *ctx)
+{
+    int ret;
+
+    if (mbedtls_mpi_cmp_int(&ctx->N, 0) == 0 ||
+        mbedtls_mpi_cmp_int(&ctx->P, 0) == 0 ||
+        mbedtls_mpi_cmp_int(&ctx->Q, 0) == 0 ||
+        mbedtls_mpi_cmp_int(&ctx->D, 0) == 0 ||
+        mbedtls_mpi_cmp_int(&ctx->E, 0) == 0) {
+        return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+    }
+
+    if (mbedtls_mpi_cmp_int(&ctx->DP, 0) == 0 ||
+        mbedtls_mpi_cmp_int(&ctx->DQ, 0) == 0 ||
+        mbedtls_mpi_cmp_int(&ctx->QP, 0) == 0) {
+        ret = mbedtls_rsa_deduce_crt(&ctx->P,  &ctx->Q,  &ctx->D,
+                                     &ctx->DP, &ctx->DQ, &ctx->QP);
+        if (ret != 0) {
+            return MBEDTLS_ERROR_ADD(MBEDTLS_ERR_RSA_BAD_INPUT_DATA, ret);
+        }
+    }
+
+    if ((ret = rsa_deduce_other_primes_crt(ctx)) != 0) {
+        return MBEDTLS_ERROR_ADD(MBEDTLS_ERR_RSA_BAD_INPUT_DATA, ret);
+    }
+
+    return rsa_check_context(ctx, 1, 1);
+}
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
 int mbedtls_rsa_complete(mbedtls_rsa_context *ctx)
 {
     int ret = 0;
@@ -727,6 +1030,12 @@ int mbedtls_rsa_complete(mbedtls_rsa_context *ctx)
 #endif
     int n_missing, pq_missing, d_missing, is_pub, is_priv;
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    if (ctx->other_count != 0) {
+        return rsa_complete_multi(ctx);
+    }
+#endif
+
     have_N = (mbedtls_mpi_cmp_int(&ctx->N, 0) != 0);
     have_P = (mbedtls_mpi_cmp_int(&ctx->P, 0) != 0);
     have_Q = (mbedtls_mpi_cmp_int(&ctx->Q, 0) != 0);
@@ -1032,6 +1341,21 @@ size_t mbedtls_rsa_get_len(const mbedtls_rsa_context *ctx)
     return ctx->len;
 }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/*
+ * Get number of prime factors of the RSA modulus
+ */
+size_t mbedtls_rsa_get_prime_count(const mbedtls_rsa_context *ctx)
+{
+    if (mbedtls_mpi_cmp_int(&ctx->P, 0) == 0 ||
+        mbedtls_mpi_cmp_int(&ctx->Q, 0) == 0) {
+        return 0;
+    }
+
+    return 2 + ctx->other_count;
+}
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
 #if defined(MBEDTLS_GENPRIME)
 
 /*
@@ -1160,6 +1484,165 @@ cleanup:
     return 0;
 }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+/*
+ * Generate a multi-prime RSA keypair
+ *
+ * This follows the same criteria as mbedtls_rsa_gen_key(), applied to
+ * every prime, with D = E^-1 mod LCM(r_1 - 1, ..., r_u - 1).
+ */
+int mbedtls_rsa_gen_key_multi(mbedtls_rsa_context *ctx,
+                              int (*f_rng)(void *, unsigned char *, size_t),
+                              void *p_rng,
+                              unsigned int nbits, int exponent,
+                              unsigned int nprimes)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_mpi H, G, L;
+    mbedtls_mpi *primes[MBEDTLS_RSA_MAX_PRIMES];
+    unsigned int pbits, i, j;
+    int prime_quality = 0;
+
+    if (nprimes == 2) {
+        return mbedtls_rsa_gen_key(ctx, f_rng, p_rng, nbits, exponent);
+    }
+
+    if (nprimes < 2 || nprimes > MBEDTLS_RSA_MAX_PRIMES) {
+        return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+    }
+
+    if (nbits > 1024) {
+        prime_quality = MBEDTLS_MPI_GEN_PRIME_FLAG_LOW_ERR;
+    }
+
+    mbedtls_mpi_init(&H);
+    mbedtls_mpi_init(&G);
+    mbedtls_mpi_init(&L);
+
+    if (exponent < 3 || nbits % 2 != 0) {
+        ret = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
+    if (nbits < MBEDTLS_RSA_GEN_KEY_MIN_BITS || nbits / nprimes < 128) {
+        ret = MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+        goto cleanup;
+    }
+
+    primes[0] = &ctx->P;
+    primes[1] = &ctx->Q;
+    for (i = 2; i < nprimes; i++) {
+        primes[i] = &ctx->other[i - 2].R;
+    }
+    ctx->other_count = nprimes - 2;
+
+    MBEDTLS_MPI_CHK(mbedtls_mpi_lset(&ctx->E, exponent));
+
+    /* All primes have nbits / nprimes bits, except for the last one
+     * which gets the remaining bits. */
+    pbits = nbits / nprimes;
+
+    do {
+        for (i = 0; i < nprimes;) {
+            unsigned int bits = (i + 1 < nprimes) ? pbits : nbits - i * pbits;
+
+            MBEDTLS_MPI_CHK(mbedtls_mpi_gen_prime(primes[i], bits,
+                                                  prime_quality, f_rng, p_rng));
+
+            /* check GCD( E, r_i - 1 ) == 1 (FIPS 186-4 §B.3.1 criterion 2(a)) */
+            MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&H, primes[i], 1));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_gcd(&G, &ctx->E, &H));
+            if (mbedtls_mpi_cmp_int(&G, 1) != 0) {
+                continue;
+            }
+
+            /* make sure the difference between any two primes is not too small
+             * (FIPS 186-4 §B.3.3 step 5.4) */
+            for (j = 0; j < i; j++) {
+                MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(&H, primes[i], primes[j]));
+                if (mbedtls_mpi_bitlen(&H) <= ((pbits >= 100) ? (pbits - 99) : 0)) {
+                    break;
+                }
+            }
+            if (j < i) {
+                continue;
+            }
+
+            /* The product of the primes may be a few bits short, in which
+             * case no choice of the last prime can fix it: start over. */
+            if (i + 1 == nprimes) {
+                MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&ctx->N, primes[0]));
+                for (j = 1; j < nprimes; j++) {
+                    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&ctx->N, &ctx->N, primes[j]));
+                }
+                if (mbedtls_mpi_bitlen(&ctx->N) != nbits) {
+                    i = 0;
+                    continue;
+                }
+            }
+
+            i++;
+        }
+
+        /* not required by any standards, but some users rely on the fact that P > Q */
+        if (mbedtls_mpi_cmp_mpi(&ctx->P, &ctx->Q) < 0) {
+            mbedtls_mpi_swap(&ctx->P, &ctx->Q);
+        }
+
+        /* compute L = LCM(r_1 - 1, ..., r_u - 1) */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&L, primes[0], 1));
+        for (i = 1; i < nprimes; i++) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&H, primes[i], 1));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_gcd(&G, &L, &H));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&L, &L, &H));
+            MBEDTLS_MPI_CHK(mbedtls_mpi_div_mpi(&L, NULL, &L, &G));
+        }
+
+        /* compute smallest possible D = E^-1 mod L (FIPS 186-4 §B.3.1 criterion 3(b)) */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_inv_mod(&ctx->D, &ctx->E, &L));
+
+        if (mbedtls_mpi_bitlen(&ctx->D) <= ((nbits + 1) / 2)) {      // (FIPS 186-4 §B.3.1 criterion 3(a))
+            continue;
+        }
+
+        break;
+    } while (1);
+
+    ctx->len = mbedtls_mpi_size(&ctx->N);
+
+    /*
+     * DP = D mod (P - 1)
+     * DQ = D mod (Q - 1)
+     * QP = Q^-1 mod P
+     * d_i = D mod (r_i - 1)
+     * t_i = (P * Q * ... * r_(i-1))^-1 mod r_i
+     */
+    MBEDTLS_MPI_CHK(mbedtls_rsa_deduce_crt(&ctx->P, &ctx->Q, &ctx->D,
+                                           &ctx->DP, &ctx->DQ, &ctx->QP));
+    MBEDTLS_MPI_CHK(rsa_deduce_other_primes_crt(ctx));
+
+    /* Double-check */
+    MBEDTLS_MPI_CHK(mbedtls_rsa_check_privkey(ctx));
+
+cleanup:
+
+    mbedtls_mpi_free(&H);
+    mbedtls_mpi_free(&G);
+    mbedtls_mpi_free(&L);
+
+    if (ret != 0) {
+        mbedtls_rsa_free(ctx);
+
+        if ((-ret & ~0x7f) == 0) {
+            ret = MBEDTLS_ERROR_ADD(MBEDTLS_ERR_RSA_KEY_GEN_FAILED, ret);
+        }
+        return ret;
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
+
 #endif /* MBEDTLS_GENPRIME */
 
 /*
@@ -1194,14 +1677,25 @@ int mbedtls_rsa_check_privkey(const mbedtls_rsa_context *ctx)
         return MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
     }
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    if (ctx->other_count != 0) {
+        /* N isn't P * Q for a multi-prime key: it is checked
+         * together with the additional primes instead. */
+        if (mbedtls_rsa_validate_params(NULL, &ctx->P, &ctx->Q,
+                                        &ctx->D, &ctx->E, NULL, NULL) != 0 ||
+            rsa_validate_other_primes(ctx) != 0) {
+            return MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
+        }
+    } else
+#endif
     if (mbedtls_rsa_validate_params(&ctx->N, &ctx->P, &ctx->Q,
                                     &ctx->D, &ctx->E, NULL, NULL) != 0) {
         return MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
     }
 
 #if !defined(MBEDTLS_RSA_NO_CRT)
-    else if (mbedtls_rsa_validate_crt(&ctx->P, &ctx->Q, &ctx->D,
-                                      &ctx->DP, &ctx->DQ, &ctx->QP) != 0) {
+    if (mbedtls_rsa_validate_crt(&ctx->P, &ctx->Q, &ctx->D,
+                                 &ctx->DP, &ctx->DQ, &ctx->QP) != 0) {
         return MBEDTLS_ERR_RSA_KEY_CHECK_FAILED;
     }
 #endif
@@ -1279,29 +1773,20 @@ cleanup:
 }
 
 /*
- * Generate or update blinding values, see section 10 of:
+ * Generate a fresh pair of blinding values, see section 10 of:
  *  KOCHER, Paul C. Timing attacks on implementations of Diffie-Hellman, RSA,
  *  DSS, and other systems. In : Advances in Cryptology-CRYPTO'96. Springer
  *  Berlin Heidelberg, 1996. p. 104-113.
  */
-static int rsa_prepare_blinding(mbedtls_rsa_context *ctx,
-                                int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+static int rsa_generate_blinding(mbedtls_rsa_context *ctx,
+                                 mbedtls_mpi *Vi, mbedtls_mpi *Vf,
+                                 int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
 {
     int ret, count = 0;
     mbedtls_mpi R;
 
     mbedtls_mpi_init(&R);
 
-    if (ctx->Vf.p != NULL) {
-        /* We already have blinding values, just update them by squaring */
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&ctx->Vi, &ctx->Vi, &ctx->Vi));
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&ctx->Vi, &ctx->Vi, &ctx->N));
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&ctx->Vf, &ctx->Vf, &ctx->Vf));
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&ctx->Vf, &ctx->Vf, &ctx->N));
-
-        goto cleanup;
-    }
-
     /* Unblinding value: Vf = random number, invertible mod N */
     do {
         if (count++ > 10) {
@@ -1309,18 +1794,18 @@ static int rsa_prepare_blinding(mbedtls_rsa_context *ctx,
             goto cleanup;
         }
 
-        MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(&ctx->Vf, ctx->len - 1, f_rng, p_rng));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(Vf, ctx->len - 1, f_rng, p_rng));
 
         /* Compute Vf^-1 as R * (R Vf)^-1 to avoid leaks from inv_mod. */
         MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(&R, ctx->len - 1, f_rng, p_rng));
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&ctx->Vi, &ctx->Vf, &R));
-        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&ctx->Vi, &ctx->Vi, &ctx->N));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(Vi, Vf, &R));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(Vi, Vi, &ctx->N));
 
         /* At this point, Vi is invertible mod N if and only if both Vf and R
          * are invertible mod N. If one of them isn't, we don't need to know
          * which one, we just loop and choose new values for both of them.
          * (Each iteration succeeds with overwhelming probability.) */
-        ret = mbedtls_mpi_inv_mod(&ctx->Vi, &ctx->Vi, &ctx->N);
+        ret = mbedtls_mpi_inv_mod(Vi, Vi, &ctx->N);
         if (ret != 0 && ret != MBEDTLS_ERR_MPI_NOT_ACCEPTABLE) {
             goto cleanup;
         }
@@ -1328,12 +1813,12 @@ static int rsa_prepare_blinding(mbedtls_rsa_context *ctx,
     } while (ret == MBEDTLS_ERR_MPI_NOT_ACCEPTABLE);
 
     /* Finish the computation of Vf^-1 = R * (R Vf)^-1 */
-    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&ctx->Vi, &ctx->Vi, &R));
-    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&ctx->Vi, &ctx->Vi, &ctx->N));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(Vi, Vi, &R));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(Vi, Vi, &ctx->N));
 
     /* Blinding value: Vi = Vf^(-e) mod N
      * (Vi already contains Vf^-1 at this point) */
-    MBEDTLS_MPI_CHK(mbedtls_mpi_exp_mod(&ctx->Vi, &ctx->Vi, &ctx->E, &ctx->N, &ctx->RN));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_exp_mod(Vi, Vi, &ctx->E, &ctx->N, &ctx->RN));
 
 
 cleanup:
@@ -1342,6 +1827,89 @@ cleanup:
     return ret;
 }
 
+/*
+ * Generate or update blinding values
+ */
+static int rsa_prepare_blinding(mbedtls_rsa_context *ctx,
+                                int (*f_rng)(void *, unsigned char *, size_t), void *p_rng)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+#if defined(MBEDTLS_RSA_BLINDING_POOL)
+    if (ctx->pool_count != 0) {
+        /* Take a precomputed pair from the pool. The previous pair ends up
+         * in the vacated slot, to be overwritten when the pool is refilled. */
+        ctx->pool_count--;
+        mbedtls_mpi_swap(&ctx->Vi, &ctx->pool_Vi[ctx->pool_count]);
+        mbedtls_mpi_swap(&ctx->Vf, &ctx->pool_Vf[ctx->pool_count]);
+
+        return 0;
+    }
+#endif /* MBEDTLS_RSA_BLINDING_POOL */
+
+    if (ctx->Vf.p == NULL) {
+        return rsa_generate_blinding(ctx, &ctx->Vi, &ctx->Vf, f_rng, p_rng);
+    }
+
+    /* We already have blinding values, just update them by squaring */
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&ctx->Vi, &ctx->Vi, &ctx->Vi));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&ctx->Vi, &ctx->Vi, &ctx->N));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&ctx->Vf, &ctx->Vf, &ctx->Vf));
+    MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&ctx->Vf, &ctx->Vf, &ctx->N));
+
+cleanup:
+    return ret;
+}
+
+#if defined(MBEDTLS_RSA_BLINDING_POOL)
+/*
+ * Fill the pool of precomputed blinding values, one pair at a time so that
+ * private key operations on the same context are not held up for long.
+ */
+int mbedtls_rsa_blinding_precompute(mbedtls_rsa_context *ctx,
+                                    int (*f_rng)(void *, unsigned char *, size_t),
+                                    void *p_rng)
+{
+    int ret = 0;
+    int full = 0;
+
+    if (f_rng == NULL) {
+        return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+    }
+
+    if (rsa_check_context(ctx, 0 /* public key checks */,
+                          0 /* no blinding checks */) != 0) {
+        return MBEDTLS_ERR_RSA_BAD_INPUT_DATA;
+    }
+
+    while (ret == 0 && !full) {
+#if defined(MBEDTLS_THREADING_C)
+        if ((ret = mbedtls_mutex_lock(&ctx->mutex)) != 0) {
+            return ret;
+        }
+#endif
+
+        if (ctx->pool_count < MBEDTLS_RSA_BLINDING_POOL_SIZE) {
+            ret = rsa_generate_blinding(ctx, &ctx->pool_Vi[ctx->pool_count],
+                                        &ctx->pool_Vf[ctx->pool_count],
+                                        f_rng, p_rng);
+            if (ret == 0) {
+                ctx->pool_count++;
+            }
+        }
+        full = (ctx->pool_count == MBEDTLS_RSA_BLINDING_POOL_SIZE);
+
+#if defined(MBEDTLS_THREADING_C)
+        if (mbedtls_mutex_unlock(&ctx->mutex) != 0) {
+            return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+        }
+#endif
+    }
+
+    return ret;
+}
+#endif /* MBEDTLS_RSA_BLINDING_POOL */
+
 /*
  * Unblind
  * T = T * Vf mod N
@@ -1433,6 +2001,13 @@ int mbedtls_rsa_private(mbedtls_rsa_context *ctx,
     mbedtls_mpi D_blind;
 #endif /* MBEDTLS_RSA_NO_CRT */
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    /* Temporary holding the product of the primes
+     * already recombined, for multi-prime keys. */
+    mbedtls_mpi M;
+    size_t i;
+#endif
+
     /* Temporaries holding the initial input and the double
      * checked result; should be the same in the end. */
     mbedtls_mpi input_blinded, check_result_blinded;
@@ -1470,6 +2045,10 @@ int mbedtls_rsa_private(mbedtls_rsa_context *ctx,
     mbedtls_mpi_init(&TP); mbedtls_mpi_init(&TQ);
 #endif
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    mbedtls_mpi_init(&M);
+#endif
+
     mbedtls_mpi_init(&input_blinded);
     mbedtls_mpi_init(&check_result_blinded);
 
@@ -1551,6 +2130,46 @@ int mbedtls_rsa_private(mbedtls_rsa_context *ctx,
      */
     MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&TP, &T, &ctx->Q));
     MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&T, &TQ, &TP));
+
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    /*
+     * Fold in the additional primes of a multi-prime key (RFC 8017 §5.1.2),
+     * with M = P * Q * r_3 * ... * r_(i-1):
+     *
+     * TQ = input ^ d_i mod r_i
+     * T = T + M * ((TQ - T) * t_i mod r_i)
+     */
+    if (ctx->other_count != 0) {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&M, &ctx->P, &ctx->Q));
+    }
+
+    for (i = 0; i < ctx->other_count; i++) {
+        mbedtls_rsa_prime_info *info = &ctx->other[i];
+
+        /*
+         * DP_blind = ( r_i - 1 ) * R + d_i
+         */
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_int(&P1, &info->R, 1));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_fill_random(&R, RSA_EXPONENT_BLINDING,
+                                                f_rng, p_rng));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&DP_blind, &P1, &R));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&DP_blind, &DP_blind, &info->D));
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_exp_mod(&TQ, &input_blinded, &DP_blind,
+                                            &info->R, &info->RR));
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_sub_mpi(&TQ, &TQ, &T));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&TP, &TQ, &info->T));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mod_mpi(&TQ, &TP, &info->R));
+
+        MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&TP, &TQ, &M));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_add_mpi(&T, &T, &TP));
+
+        if (i + 1 < ctx->other_count) {
+            MBEDTLS_MPI_CHK(mbedtls_mpi_mul_mpi(&M, &M, &info->R));
+        }
+    }
+#endif /* MBEDTLS_RSA_MULTI_PRIME */
 #endif /* MBEDTLS_RSA_NO_CRT */
 
     /* Verify the result to prevent glitching attacks. */
@@ -1594,6 +2213,10 @@ cleanup:
     mbedtls_mpi_free(&TP); mbedtls_mpi_free(&TQ);
 #endif
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    mbedtls_mpi_free(&M);
+#endif
+
     mbedtls_mpi_free(&check_result_blinded);
     mbedtls_mpi_free(&input_blinded);
 
@@ -2772,6 +3395,9 @@ int mbedtls_rsa_pkcs1_verify(mbedtls_rsa_context *ctx,
 int mbedtls_rsa_copy(mbedtls_rsa_context *dst, const mbedtls_rsa_context *src)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    size_t i;
+#endif
 
     dst->len = src->len;
 
@@ -2795,6 +3421,21 @@ int mbedtls_rsa_copy(mbedtls_rsa_context *dst, const mbedtls_rsa_context *src)
     MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&dst->Vi, &src->Vi));
     MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&dst->Vf, &src->Vf));
 
+#if defined(MBEDTLS_RSA_BLINDING_POOL)
+    /* Precomputed blinding values are single-use: don't share them. */
+    dst->pool_count = 0;
+#endif
+
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    for (i = 0; i < MBEDTLS_RSA_MAX_PRIMES - 2; i++) {
+        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&dst->other[i].R, &src->other[i].R));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&dst->other[i].D, &src->other[i].D));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&dst->other[i].T, &src->other[i].T));
+        MBEDTLS_MPI_CHK(mbedtls_mpi_copy(&dst->other[i].RR, &src->other[i].RR));
+    }
+    dst->other_count = src->other_count;
+#endif
+
     dst->padding = src->padding;
     dst->hash_id = src->hash_id;
 
@@ -2811,6 +3452,10 @@ cleanup:
  */
 void mbedtls_rsa_free(mbedtls_rsa_context *ctx)
 {
+#if defined(MBEDTLS_RSA_MULTI_PRIME) || defined(MBEDTLS_RSA_BLINDING_POOL)
+    size_t i;
+#endif
+
     if (ctx == NULL) {
         return;
     }
@@ -2832,6 +3477,24 @@ void mbedtls_rsa_free(mbedtls_rsa_context *ctx)
     mbedtls_mpi_free(&ctx->DP);
 #endif /* MBEDTLS_RSA_NO_CRT */
 
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+    for (i = 0; i < MBEDTLS_RSA_MAX_PRIMES - 2; i++) {
+        mbedtls_mpi_free(&ctx->other[i].RR);
+        mbedtls_mpi_free(&ctx->other[i].T);
+        mbedtls_mpi_free(&ctx->other[i].D);
+        mbedtls_mpi_free(&ctx->other[i].R);
+    }
+    ctx->other_count = 0;
+#endif
+
+#if defined(MBEDTLS_RSA_BLINDING_POOL)
+    for (i = 0; i < MBEDTLS_RSA_BLINDING_POOL_SIZE; i++) {
+        mbedtls_mpi_free(&ctx->pool_Vf[i]);
+        mbedtls_mpi_free(&ctx->pool_Vi[i]);
+    }
+    ctx->pool_count = 0;
+#endif
+
 #if defined(MBEDTLS_THREADING_C)
     /* Free the mutex, but only if it hasn't been freed already. */
     if (ctx->ver != 0) {
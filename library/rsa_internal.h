@@ -20,6 +20,9 @@
 /**
  * \brief           Parse a PKCS#1 (ASN.1) encoded private RSA key.
  *
+ * \note            Multi-prime keys (version 1, with otherPrimeInfos) are
+ *                  only supported if #MBEDTLS_RSA_MULTI_PRIME is enabled.
+ *
  * \param rsa       The RSA context where parsed data will be stored.
  * \param key       The buffer that contains the key.
  * \param keylen    The length of the key buffer in bytes.
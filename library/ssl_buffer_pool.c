@@ -0,0 +1,171 @@
+/*
+ *  SSL I/O buffer pool shared between connections
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * Buffers returned by idle connections are kept in a stack, so that the
+ * most recently used (and most likely cached) buffer is lent first.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+
+#include "mbedtls/platform.h"
+
+#include "mbedtls/ssl_buffer_pool.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include <string.h>
+
+void mbedtls_ssl_buffer_pool_init(mbedtls_ssl_buffer_pool *pool)
+{
+    memset(pool, 0, sizeof(mbedtls_ssl_buffer_pool));
+
+    pool->stats.buf_len = MBEDTLS_SSL_BUFFER_POOL_BUF_LEN;
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init(&pool->mutex);
+#endif
+}
+
+int mbedtls_ssl_buffer_pool_setup(mbedtls_ssl_buffer_pool *pool,
+                                  size_t max_idle, size_t max_in_use)
+{
+    if (max_idle != 0) {
+        pool->free_bufs = mbedtls_calloc(max_idle, sizeof(unsigned char *));
+        if (pool->free_bufs == NULL) {
+            return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        }
+    }
+
+    pool->max_idle = max_idle;
+    pool->max_in_use = max_in_use;
+
+    return 0;
+}
+
+int mbedtls_ssl_buffer_pool_get(mbedtls_ssl_buffer_pool *pool,
+                                unsigned char **buf)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&pool->mutex)) != 0) {
+        return ret;
+    }
+#endif
+
+    if (pool->max_in_use != 0 && pool->stats.in_use >= pool->max_in_use) {
+        pool->stats.failed++;
+        ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        goto exit;
+    }
+
+    if (pool->stats.idle > 0) {
+        *buf = pool->free_bufs[--pool->stats.idle];
+        pool->free_bufs[pool->stats.idle] = NULL;
+    } else {
+        /* Allocate with the lock held, so that the in-use limit holds */
+        *buf = mbedtls_calloc(1, MBEDTLS_SSL_BUFFER_POOL_BUF_LEN);
+        if (*buf == NULL) {
+            pool->stats.failed++;
+            ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+            goto exit;
+        }
+        pool->stats.allocated++;
+    }
+
+    pool->stats.acquired++;
+    if (++pool->stats.in_use > pool->stats.peak_in_use) {
+        pool->stats.peak_in_use = pool->stats.in_use;
+    }
+
+    ret = 0;
+
+exit:
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&pool->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    return ret;
+}
+
+void mbedtls_ssl_buffer_pool_put(mbedtls_ssl_buffer_pool *pool,
+                                 unsigned char *buf)
+{
+    /* Buffers hold plaintext and must be clean before being lent again */
+    mbedtls_platform_zeroize(buf, MBEDTLS_SSL_BUFFER_POOL_BUF_LEN);
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_lock(&pool->mutex) != 0) {
+        /* Can't update the pool, so don't reuse the buffer. The in-use
+         * count stays too high, which is safe. */
+        mbedtls_free(buf);
+        return;
+    }
+#endif
+
+    pool->stats.in_use--;
+
+    if (pool->stats.idle < pool->max_idle) {
+        pool->free_bufs[pool->stats.idle++] = buf;
+        buf = NULL;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    (void) mbedtls_mutex_unlock(&pool->mutex);
+#endif
+
+    mbedtls_free(buf);
+}
+
+int mbedtls_ssl_buffer_pool_get_stats(mbedtls_ssl_buffer_pool *pool,
+                                      mbedtls_ssl_buffer_pool_stats *stats)
+{
+#if defined(MBEDTLS_THREADING_C)
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if ((ret = mbedtls_mutex_lock(&pool->mutex)) != 0) {
+        return ret;
+    }
+#endif
+
+    *stats = pool->stats;
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&pool->mutex) != 0) {
+        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    return 0;
+}
+
+void mbedtls_ssl_buffer_pool_free(mbedtls_ssl_buffer_pool *pool)
+{
+    size_t i;
+
+    if (pool == NULL) {
+        return;
+    }
+
+    for (i = 0; i < pool->stats.idle; i++) {
+        mbedtls_free(pool->free_bufs[i]);
+    }
+    mbedtls_free(pool->free_bufs);
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free(&pool->mutex);
+#endif
+
+    mbedtls_platform_zeroize(pool, sizeof(mbedtls_ssl_buffer_pool));
+}
+
+#endif /* MBEDTLS_SSL_BUFFER_POOL_C */
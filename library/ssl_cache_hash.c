@@ -0,0 +1,531 @@
+/*
+ *  SSL session cache for large numbers of sessions
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * Sessions are distributed between stripes by a hash of their ID. Each
+ * stripe has its own mutex, a hash table of entries, a list of entries by
+ * recent use for eviction, and a list of entries by age for expiry. Since
+ * every entry is appended to the age list when it is stored, that list is
+ * ordered by timestamp and expired entries are always at its head.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_CACHE_HASH_C)
+
+#include "mbedtls/platform.h"
+
+#include "mbedtls/ssl_cache_hash.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#if defined(MBEDTLS_THREADING_C)
+#include "mbedtls/threading.h"
+#endif
+
+#include <string.h>
+
+typedef struct ssl_cache_hash_entry ssl_cache_hash_entry;
+
+struct ssl_cache_hash_entry {
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_time_t timestamp;           /*!< time the session was stored   */
+#endif
+
+    unsigned char session_id[32];       /*!< session ID                     */
+    size_t session_id_len;
+
+    unsigned char *session;             /*!< serialized session             */
+    size_t session_len;
+
+    ssl_cache_hash_entry *hash_next;    /*!< next entry in the same bucket  */
+    ssl_cache_hash_entry *lru_prev;     /*!< more recently used entry       */
+    ssl_cache_hash_entry *lru_next;     /*!< less recently used entry       */
+    ssl_cache_hash_entry *age_prev;     /*!< older entry                    */
+    ssl_cache_hash_entry *age_next;     /*!< newer entry                    */
+};
+
+struct mbedtls_ssl_cache_hash_stripe {
+    ssl_cache_hash_entry **buckets;     /*!< hash table                     */
+    size_t bucket_mask;                 /*!< number of buckets - 1          */
+    size_t entries;                     /*!< number of stored sessions      */
+    size_t max_entries;                 /*!< maximum number of sessions     */
+    ssl_cache_hash_entry *lru_head;     /*!< most recently used entry       */
+    ssl_cache_hash_entry *lru_tail;     /*!< least recently used entry      */
+    ssl_cache_hash_entry *age_head;     /*!< oldest entry                   */
+    ssl_cache_hash_entry *age_tail;     /*!< newest entry                   */
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_threading_mutex_t mutex;
+#endif
+};
+
+/* Session IDs are chosen by the server at random, so the hash needs no
+ * secret seed to resist collisions. */
+static uint32_t ssl_cache_hash_id(unsigned char const *session_id,
+                                  size_t session_id_len)
+{
+    return mbedtls_ssl_fnv1a(0, session_id, session_id_len);
+}
+
+void mbedtls_ssl_cache_hash_init(mbedtls_ssl_cache_hash_context *cache)
+{
+    memset(cache, 0, sizeof(mbedtls_ssl_cache_hash_context));
+
+    cache->timeout = MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT;
+}
+
+int mbedtls_ssl_cache_hash_setup(mbedtls_ssl_cache_hash_context *cache,
+                                 size_t max_entries, size_t stripes)
+{
+    size_t i, per_stripe, buckets;
+
+    if (max_entries == 0) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (stripes == 0) {
+        stripes = MBEDTLS_SSL_CACHE_HASH_DEFAULT_STRIPES;
+    }
+    if (stripes > max_entries) {
+        stripes = max_entries;
+    }
+
+    per_stripe = (max_entries + stripes - 1) / stripes;
+
+    /* Power of two, so that the load factor stays at most 1 */
+    for (buckets = 1; buckets < per_stripe; buckets <<= 1) {
+        ;
+    }
+
+    cache->stripes = mbedtls_calloc(stripes,
+                                    sizeof(mbedtls_ssl_cache_hash_stripe));
+    if (cache->stripes == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    for (i = 0; i < stripes; i++) {
+        mbedtls_ssl_cache_hash_stripe *stripe = &cache->stripes[i];
+
+        stripe->buckets = mbedtls_calloc(buckets,
+                                         sizeof(ssl_cache_hash_entry *));
+        if (stripe->buckets == NULL) {
+            /* Free the stripes set up so far */
+            cache->stripe_count = i;
+            mbedtls_ssl_cache_hash_free(cache);
+            return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        }
+
+        stripe->bucket_mask = buckets - 1;
+        stripe->max_entries = per_stripe;
+#if defined(MBEDTLS_THREADING_C)
+        mbedtls_mutex_init(&stripe->mutex);
+#endif
+    }
+
+    cache->stripe_count = stripes;
+
+    return 0;
+}
+
+static ssl_cache_hash_entry **ssl_cache_hash_bucket(
+    mbedtls_ssl_cache_hash_stripe *stripe, uint32_t h,
+    size_t stripe_count)
+{
+    return &stripe->buckets[(h / stripe_count) & stripe->bucket_mask];
+}
+
+static mbedtls_ssl_cache_hash_stripe *ssl_cache_hash_stripe(
+    mbedtls_ssl_cache_hash_context *cache, uint32_t h)
+{
+    return &cache->stripes[h % cache->stripe_count];
+}
+
+static ssl_cache_hash_entry *ssl_cache_hash_find(
+    ssl_cache_hash_entry *bucket,
+    unsigned char const *session_id, size_t session_id_len)
+{
+    ssl_cache_hash_entry *cur;
+
+    for (cur = bucket; cur != NULL; cur = cur->hash_next) {
+        if (session_id_len == cur->session_id_len &&
+            memcmp(session_id, cur->session_id, session_id_len) == 0) {
+            return cur;
+        }
+    }
+
+    return NULL;
+}
+
+static void ssl_cache_hash_lru_unlink(mbedtls_ssl_cache_hash_stripe *stripe,
+                                      ssl_cache_hash_entry *entry)
+{
+    if (entry->lru_prev != NULL) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        stripe->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next != NULL) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        stripe->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+static void ssl_cache_hash_lru_push(mbedtls_ssl_cache_hash_stripe *stripe,
+                                    ssl_cache_hash_entry *entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = stripe->lru_head;
+    if (stripe->lru_head != NULL) {
+        stripe->lru_head->lru_prev = entry;
+    } else {
+        stripe->lru_tail = entry;
+    }
+    stripe->lru_head = entry;
+}
+
+static void ssl_cache_hash_age_unlink(mbedtls_ssl_cache_hash_stripe *stripe,
+                                      ssl_cache_hash_entry *entry)
+{
+    if (entry->age_prev != NULL) {
+        entry->age_prev->age_next = entry->age_next;
+    } else {
+        stripe->age_head = entry->age_next;
+    }
+    if (entry->age_next != NULL) {
+        entry->age_next->age_prev = entry->age_prev;
+    } else {
+        stripe->age_tail = entry->age_prev;
+    }
+    entry->age_prev = NULL;
+    entry->age_next = NULL;
+}
+
+static void ssl_cache_hash_age_append(mbedtls_ssl_cache_hash_stripe *stripe,
+                                      ssl_cache_hash_entry *entry)
+{
+    entry->age_next = NULL;
+    entry->age_prev = stripe->age_tail;
+    if (stripe->age_tail != NULL) {
+        stripe->age_tail->age_next = entry;
+    } else {
+        stripe->age_head = entry;
+    }
+    stripe->age_tail = entry;
+}
+
+/* Take an entry out of all the structures of its stripe and wipe it */
+static void ssl_cache_hash_detach(mbedtls_ssl_cache_hash_context *cache,
+                                  mbedtls_ssl_cache_hash_stripe *stripe,
+                                  ssl_cache_hash_entry *entry)
+{
+    ssl_cache_hash_entry **link;
+
+    link = ssl_cache_hash_bucket(stripe,
+                                 ssl_cache_hash_id(entry->session_id,
+                                                   entry->session_id_len),
+                                 cache->stripe_count);
+    while (*link != entry) {
+        link = &(*link)->hash_next;
+    }
+    *link = entry->hash_next;
+
+    ssl_cache_hash_lru_unlink(stripe, entry);
+    ssl_cache_hash_age_unlink(stripe, entry);
+    stripe->entries--;
+
+    if (entry->session != NULL) {
+        mbedtls_zeroize_and_free(entry->session, entry->session_len);
+    }
+    mbedtls_platform_zeroize(entry, sizeof(ssl_cache_hash_entry));
+}
+
+#if defined(MBEDTLS_HAVE_TIME)
+static int ssl_cache_hash_expired(const mbedtls_ssl_cache_hash_context *cache,
+                                  const ssl_cache_hash_entry *entry,
+                                  mbedtls_time_t t)
+{
+    return cache->timeout != 0 &&
+           (int) (t - entry->timestamp) > cache->timeout;
+}
+
+/* Drop expired entries, which are all at the head of the age list */
+static void ssl_cache_hash_expire(mbedtls_ssl_cache_hash_context *cache,
+                                  mbedtls_ssl_cache_hash_stripe *stripe,
+                                  mbedtls_time_t t)
+{
+    ssl_cache_hash_entry *entry;
+
+    while ((entry = stripe->age_head) != NULL &&
+           ssl_cache_hash_expired(cache, entry, t)) {
+        ssl_cache_hash_detach(cache, stripe, entry);
+        mbedtls_free(entry);
+    }
+}
+#endif /* MBEDTLS_HAVE_TIME */
+
+int mbedtls_ssl_cache_hash_get(void *data,
+                               unsigned char const *session_id,
+                               size_t session_id_len,
+                               mbedtls_ssl_session *session)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_cache_hash_context *cache = (mbedtls_ssl_cache_hash_context *) data;
+    mbedtls_ssl_cache_hash_stripe *stripe;
+    ssl_cache_hash_entry *entry;
+    uint32_t h;
+
+    if (cache->stripes == NULL) {
+        return MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+    }
+
+    h = ssl_cache_hash_id(session_id, session_id_len);
+    stripe = ssl_cache_hash_stripe(cache, h);
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&stripe->mutex)) != 0) {
+        return ret;
+    }
+#endif
+
+    entry = ssl_cache_hash_find(*ssl_cache_hash_bucket(stripe, h,
+                                                       cache->stripe_count),
+                                session_id, session_id_len);
+    if (entry == NULL) {
+        ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+        goto exit;
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    if (ssl_cache_hash_expired(cache, entry, mbedtls_time(NULL))) {
+        ssl_cache_hash_detach(cache, stripe, entry);
+        mbedtls_free(entry);
+        ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+        goto exit;
+    }
+#endif
+
+    ret = mbedtls_ssl_session_load(session, entry->session, entry->session_len);
+    if (ret != 0) {
+        goto exit;
+    }
+
+    ssl_cache_hash_lru_unlink(stripe, entry);
+    ssl_cache_hash_lru_push(stripe, entry);
+
+    ret = 0;
+
+exit:
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&stripe->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    return ret;
+}
+
+int mbedtls_ssl_cache_hash_set(void *data,
+                               unsigned char const *session_id,
+                               size_t session_id_len,
+                               const mbedtls_ssl_session *session)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_cache_hash_context *cache = (mbedtls_ssl_cache_hash_context *) data;
+    mbedtls_ssl_cache_hash_stripe *stripe;
+    ssl_cache_hash_entry **bucket;
+    ssl_cache_hash_entry *entry;
+    uint32_t h;
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_time_t t = mbedtls_time(NULL);
+#endif
+
+    size_t session_serialized_len = 0;
+    unsigned char *session_serialized = NULL;
+
+    if (cache->stripes == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (session_id_len > sizeof(entry->session_id)) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    /* Serialize the session before taking the lock, since this is the
+     * slowest part of storing it. */
+    ret = mbedtls_ssl_session_save(session, NULL, 0, &session_serialized_len);
+    if (ret != MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        return ret;
+    }
+
+    session_serialized = mbedtls_calloc(1, session_serialized_len);
+    if (session_serialized == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    ret = mbedtls_ssl_session_save(session,
+                                   session_serialized,
+                                   session_serialized_len,
+                                   &session_serialized_len);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    h = ssl_cache_hash_id(session_id, session_id_len);
+    stripe = ssl_cache_hash_stripe(cache, h);
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&stripe->mutex)) != 0) {
+        goto cleanup;
+    }
+#endif
+
+#if defined(MBEDTLS_HAVE_TIME)
+    ssl_cache_hash_expire(cache, stripe, t);
+#endif
+
+    bucket = ssl_cache_hash_bucket(stripe, h, cache->stripe_count);
+    entry = ssl_cache_hash_find(*bucket, session_id, session_id_len);
+
+    if (entry != NULL) {
+        /* Overwrite the session, which is now the newest one */
+        ssl_cache_hash_detach(cache, stripe, entry);
+    } else if (stripe->entries >= stripe->max_entries) {
+        /* Reuse the least recently used entry */
+        entry = stripe->lru_tail;
+        ssl_cache_hash_detach(cache, stripe, entry);
+    } else {
+        entry = mbedtls_calloc(1, sizeof(ssl_cache_hash_entry));
+        if (entry == NULL) {
+            ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+            goto exit;
+        }
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    entry->timestamp = t;
+#endif
+    memcpy(entry->session_id, session_id, session_id_len);
+    entry->session_id_len = session_id_len;
+    entry->session = session_serialized;
+    entry->session_len = session_serialized_len;
+    session_serialized = NULL;
+
+    entry->hash_next = *bucket;
+    *bucket = entry;
+    ssl_cache_hash_lru_push(stripe, entry);
+    ssl_cache_hash_age_append(stripe, entry);
+    stripe->entries++;
+
+    ret = 0;
+
+exit:
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&stripe->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+cleanup:
+    if (session_serialized != NULL) {
+        mbedtls_zeroize_and_free(session_serialized, session_serialized_len);
+    }
+
+    return ret;
+}
+
+int mbedtls_ssl_cache_hash_remove(void *data,
+                                  unsigned char const *session_id,
+                                  size_t session_id_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_cache_hash_context *cache = (mbedtls_ssl_cache_hash_context *) data;
+    mbedtls_ssl_cache_hash_stripe *stripe;
+    ssl_cache_hash_entry *entry;
+    uint32_t h;
+
+    if (cache->stripes == NULL) {
+        return 0;
+    }
+
+    h = ssl_cache_hash_id(session_id, session_id_len);
+    stripe = ssl_cache_hash_stripe(cache, h);
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&stripe->mutex)) != 0) {
+        return ret;
+    }
+#endif
+
+    entry = ssl_cache_hash_find(*ssl_cache_hash_bucket(stripe, h,
+                                                       cache->stripe_count),
+                                session_id, session_id_len);
+    /* No entry found, exit with success */
+    if (entry != NULL) {
+        ssl_cache_hash_detach(cache, stripe, entry);
+        mbedtls_free(entry);
+    }
+
+    ret = 0;
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&stripe->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    return ret;
+}
+
+#if defined(MBEDTLS_HAVE_TIME)
+void mbedtls_ssl_cache_hash_set_timeout(mbedtls_ssl_cache_hash_context *cache,
+                                        int timeout)
+{
+    if (timeout < 0) {
+        timeout = 0;
+    }
+
+    cache->timeout = timeout;
+}
+#endif /* MBEDTLS_HAVE_TIME */
+
+void mbedtls_ssl_cache_hash_free(mbedtls_ssl_cache_hash_context *cache)
+{
+    ssl_cache_hash_entry *cur, *next;
+    size_t i;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    for (i = 0; i < cache->stripe_count; i++) {
+        mbedtls_ssl_cache_hash_stripe *stripe = &cache->stripes[i];
+
+        for (cur = stripe->age_head; cur != NULL; cur = next) {
+            next = cur->age_next;
+
+            if (cur->session != NULL) {
+                mbedtls_zeroize_and_free(cur->session, cur->session_len);
+            }
+            mbedtls_platform_zeroize(cur, sizeof(ssl_cache_hash_entry));
+            mbedtls_free(cur);
+        }
+
+        mbedtls_free(stripe->buckets);
+#if defined(MBEDTLS_THREADING_C)
+        mbedtls_mutex_free(&stripe->mutex);
+#endif
+    }
+
+    mbedtls_free(cache->stripes);
+
+    mbedtls_platform_zeroize(cache, sizeof(mbedtls_ssl_cache_hash_context));
+}
+
+#endif /* MBEDTLS_SSL_CACHE_HASH_C */
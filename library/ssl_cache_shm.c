@@ -0,0 +1,668 @@
+/*
+ *  SSL session cache shared between processes
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * The shared region starts with a header describing its layout, followed
+ * by the lock stripes and by the slots. Slots are grouped in buckets of
+ * SSL_CACHE_SHM_WAYS, and a session can only be stored in the bucket
+ * selected by the hash of its ID. Each bucket belongs to one stripe, whose
+ * robust mutex protects its slots.
+ *
+ * A stripe records which slot is being written while its mutex is held.
+ * If the process writing it dies, the next process to take the mutex is
+ * told so by EOWNERDEAD and empties that slot, since it may be torn. Reads
+ * copy the slot while holding the mutex, so they can't see a torn slot.
+ *
+ * Mapping the region and handling the robust mutexes is done by the
+ * mbedtls_ssl_shm_xxx() functions, which other modules use for their own
+ * shared regions.
+ */
+
+/*
+ * Ensure robust mutexes and MAP_ANONYMOUS are available even with -std=c99;
+ * must be defined before mbedtls_config.h, which pulls in glibc's features.h.
+ */
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+
+#if !defined(__linux__) && !defined(__FreeBSD__)
+#error "This module requires robust process-shared mutexes, see MBEDTLS_SSL_CACHE_SHM_C in mbedtls_config.h"
+#endif
+
+#include "mbedtls/platform.h"
+
+#include "mbedtls/ssl_cache_shm.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/threading.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SSL_CACHE_SHM_MAGIC         0x4D435348  /* "MCSH" */
+#define SSL_CACHE_SHM_WAYS          4           /* slots per bucket */
+#define SSL_CACHE_SHM_MAX_STRIPES   16
+#define SSL_CACHE_SHM_ALIGN         64          /* cache line */
+
+#define SSL_CACHE_SHM_ROUND(x) \
+    (((x) + SSL_CACHE_SHM_ALIGN - 1) & ~((size_t) SSL_CACHE_SHM_ALIGN - 1))
+
+typedef struct {
+    uint32_t magic;             /*!< written last when formatting         */
+    unsigned char boot_id[MBEDTLS_SSL_SHM_BOOT_ID_LEN]; /*!< written by
+                                                             mbedtls_ssl_shm_map() */
+    uint32_t slot_size;         /*!< size of a slot, to detect builds with
+                                     a different slot layout              */
+    uint32_t bucket_count;
+    uint32_t stripe_count;
+} ssl_cache_shm_header;
+
+typedef struct {
+    pthread_mutex_t mutex;      /*!< robust process-shared mutex          */
+    uint64_t clock;             /*!< use counter, for LRU eviction        */
+    uint32_t dirty;             /*!< 1 + index of the slot being written,
+                                     or 0                                 */
+} ssl_cache_shm_stripe;
+
+typedef struct {
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_time_t timestamp;   /*!< time the session was stored          */
+#endif
+    uint64_t last_used;         /*!< stripe clock at the last use         */
+    uint32_t session_len;       /*!< 0 for an empty slot                  */
+    uint32_t session_id_len;
+    unsigned char session_id[32];
+    unsigned char session[MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE];
+} ssl_cache_shm_slot;
+
+#if defined(MBEDTLS_TEST_HOOKS)
+void (*mbedtls_ssl_cache_shm_test_hook_write)(void) = NULL;
+void (*mbedtls_ssl_shm_test_hook_boot_id)(unsigned char *boot_id) = NULL;
+#endif
+
+static ssl_cache_shm_header *ssl_cache_shm_get_header(
+    const mbedtls_ssl_cache_shm_context *cache)
+{
+    return (ssl_cache_shm_header *) cache->region;
+}
+
+static size_t ssl_cache_shm_stripes_offset(void)
+{
+    return SSL_CACHE_SHM_ROUND(sizeof(ssl_cache_shm_header));
+}
+
+static size_t ssl_cache_shm_slots_offset(size_t stripe_count)
+{
+    return SSL_CACHE_SHM_ROUND(ssl_cache_shm_stripes_offset() +
+                               stripe_count * sizeof(ssl_cache_shm_stripe));
+}
+
+static ssl_cache_shm_stripe *ssl_cache_shm_get_stripes(
+    const mbedtls_ssl_cache_shm_context *cache)
+{
+    return (ssl_cache_shm_stripe *) (cache->region +
+                                     ssl_cache_shm_stripes_offset());
+}
+
+static ssl_cache_shm_slot *ssl_cache_shm_get_slots(
+    const mbedtls_ssl_cache_shm_context *cache)
+{
+    return (ssl_cache_shm_slot *) (cache->region +
+                                   ssl_cache_shm_slots_offset(
+                                       ssl_cache_shm_get_header(cache)->stripe_count));
+}
+
+void mbedtls_ssl_cache_shm_init(mbedtls_ssl_cache_shm_context *cache)
+{
+    memset(cache, 0, sizeof(mbedtls_ssl_cache_shm_context));
+
+    cache->timeout = MBEDTLS_SSL_CACHE_DEFAULT_TIMEOUT;
+}
+
+int mbedtls_ssl_shm_mutex_init(pthread_mutex_t *mutex)
+{
+    pthread_mutexattr_t attr;
+    int ret = 0;
+
+    if (pthread_mutexattr_init(&attr) != 0) {
+        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+
+    if (pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) != 0 ||
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) != 0 ||
+        pthread_mutex_init(mutex, &attr) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+
+    (void) pthread_mutexattr_destroy(&attr);
+
+    return ret;
+}
+
+int mbedtls_ssl_shm_mutex_lock(pthread_mutex_t *mutex, int *owner_died)
+{
+    int ret = pthread_mutex_lock(mutex);
+
+    *owner_died = 0;
+    if (ret == EOWNERDEAD) {
+        *owner_died = 1;
+        ret = pthread_mutex_consistent(mutex);
+    }
+
+    return ret == 0 ? 0 : MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+}
+
+int mbedtls_ssl_shm_mutex_unlock(pthread_mutex_t *mutex)
+{
+    return pthread_mutex_unlock(mutex) == 0 ?
+           0 : MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+}
+
+/* Identify the current boot of the system. The identifier is all zeros if
+ * the system does not provide one. */
+static void ssl_shm_get_boot_id(unsigned char boot_id[MBEDTLS_SSL_SHM_BOOT_ID_LEN])
+{
+    ssize_t len;
+    int fd;
+
+    memset(boot_id, 0, MBEDTLS_SSL_SHM_BOOT_ID_LEN);
+
+#if defined(MBEDTLS_TEST_HOOKS)
+    if (mbedtls_ssl_shm_test_hook_boot_id != NULL) {
+        mbedtls_ssl_shm_test_hook_boot_id(boot_id);
+        return;
+    }
+#endif
+
+    fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    len = read(fd, boot_id, MBEDTLS_SSL_SHM_BOOT_ID_LEN);
+    if (len != MBEDTLS_SSL_SHM_BOOT_ID_LEN) {
+        memset(boot_id, 0, MBEDTLS_SSL_SHM_BOOT_ID_LEN);
+    }
+
+    (void) close(fd);
+}
+
+int mbedtls_ssl_shm_map(const char *path, size_t len, uint32_t magic,
+                        int (*f_setup)(void *, unsigned char *, int),
+                        void *p_setup,
+                        unsigned char **region, size_t *region_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    void *map = MAP_FAILED;
+    unsigned char boot_id[MBEDTLS_SSL_SHM_BOOT_ID_LEN];
+    struct stat st;
+    uint32_t found;
+    int format;
+    int fd = -1;
+
+    if (path == NULL) {
+        map = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        }
+
+        ret = f_setup(p_setup, map, 1);
+        goto exit;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+    }
+
+    /* Keep other processes from formatting the file at the same time */
+    if (flock(fd, LOCK_EX) != 0 || fstat(fd, &st) != 0) {
+        ret = MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+        goto exit;
+    }
+
+    if (st.st_size == 0) {
+        if (ftruncate(fd, (off_t) len) != 0) {
+            ret = MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+            goto exit;
+        }
+    } else if ((size_t) st.st_size != len) {
+        ret = MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        goto exit;
+    }
+
+    map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        goto exit;
+    }
+
+    /* The magic number is written last, so a file whose creator died
+     * before formatting it completely is formatted again. So is a file
+     * that survived a reboot: its robust mutexes may be locked by processes
+     * of the previous boot, which will never release them. */
+    ssl_shm_get_boot_id(boot_id);
+    memcpy(&found, map, sizeof(found));
+    format = found != magic ||
+             memcmp((unsigned char *) map + sizeof(found), boot_id,
+                    sizeof(boot_id)) != 0;
+    if (format) {
+        memset(map, 0, len);
+        memcpy((unsigned char *) map + sizeof(found), boot_id,
+               sizeof(boot_id));
+    }
+
+    ret = f_setup(p_setup, map, format);
+
+exit:
+    if (fd >= 0) {
+        /* The mapping stays valid after the file is closed */
+        (void) flock(fd, LOCK_UN);
+        (void) close(fd);
+    }
+
+    if (ret != 0 && map != MAP_FAILED) {
+        (void) munmap(map, len);
+    }
+
+    if (ret == 0) {
+        *region = map;
+        *region_len = len;
+    }
+
+    return ret;
+}
+
+/* Initialize the header and the mutexes of a region full of zeros */
+static int ssl_cache_shm_format(mbedtls_ssl_cache_shm_context *cache,
+                                uint32_t bucket_count, uint32_t stripe_count)
+{
+    ssl_cache_shm_header *header = ssl_cache_shm_get_header(cache);
+    ssl_cache_shm_stripe *stripes = ssl_cache_shm_get_stripes(cache);
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < stripe_count; i++) {
+        if ((ret = mbedtls_ssl_shm_mutex_init(&stripes[i].mutex)) != 0) {
+            return ret;
+        }
+    }
+
+    header->slot_size = (uint32_t) sizeof(ssl_cache_shm_slot);
+    header->bucket_count = bucket_count;
+    header->stripe_count = stripe_count;
+    header->magic = SSL_CACHE_SHM_MAGIC;
+
+    return 0;
+}
+
+static int ssl_cache_shm_check(const mbedtls_ssl_cache_shm_context *cache,
+                               uint32_t bucket_count, uint32_t stripe_count)
+{
+    const ssl_cache_shm_header *header = ssl_cache_shm_get_header(cache);
+
+    if (header->slot_size != sizeof(ssl_cache_shm_slot) ||
+        header->bucket_count != bucket_count ||
+        header->stripe_count != stripe_count) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    return 0;
+}
+
+typedef struct {
+    mbedtls_ssl_cache_shm_context *cache;
+    uint32_t bucket_count;
+    uint32_t stripe_count;
+} ssl_cache_shm_geometry;
+
+static int ssl_cache_shm_setup_region(void *p, unsigned char *region,
+                                      int format)
+{
+    ssl_cache_shm_geometry *geometry = (ssl_cache_shm_geometry *) p;
+
+    geometry->cache->region = region;
+
+    return format ?
+           ssl_cache_shm_format(geometry->cache, geometry->bucket_count,
+                                geometry->stripe_count) :
+           ssl_cache_shm_check(geometry->cache, geometry->bucket_count,
+                               geometry->stripe_count);
+}
+
+int mbedtls_ssl_cache_shm_setup(mbedtls_ssl_cache_shm_context *cache,
+                                const char *path, size_t max_entries)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    ssl_cache_shm_geometry geometry;
+    size_t buckets, stripes, slots_offset, len;
+
+    if (max_entries == 0) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    buckets = max_entries / SSL_CACHE_SHM_WAYS +
+              (max_entries % SSL_CACHE_SHM_WAYS != 0);
+    stripes = buckets < SSL_CACHE_SHM_MAX_STRIPES ?
+              buckets : SSL_CACHE_SHM_MAX_STRIPES;
+    slots_offset = ssl_cache_shm_slots_offset(stripes);
+
+    if ((uint64_t) buckets > 0xFFFFFFFF ||
+        buckets > (SIZE_MAX - slots_offset) /
+        (SSL_CACHE_SHM_WAYS * sizeof(ssl_cache_shm_slot))) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    len = slots_offset + buckets * SSL_CACHE_SHM_WAYS * sizeof(ssl_cache_shm_slot);
+
+    geometry.cache = cache;
+    geometry.bucket_count = (uint32_t) buckets;
+    geometry.stripe_count = (uint32_t) stripes;
+
+    ret = mbedtls_ssl_shm_map(path, len, SSL_CACHE_SHM_MAGIC,
+                              ssl_cache_shm_setup_region, &geometry,
+                              &cache->region, &cache->region_len);
+    if (ret != 0) {
+        cache->region = NULL;
+        cache->region_len = 0;
+    }
+
+    return ret;
+}
+
+static void ssl_cache_shm_wipe(ssl_cache_shm_slot *slot)
+{
+    mbedtls_platform_zeroize(slot, sizeof(ssl_cache_shm_slot));
+}
+
+static int ssl_cache_shm_lock(mbedtls_ssl_cache_shm_context *cache,
+                              ssl_cache_shm_stripe *stripe)
+{
+    int owner_died;
+    int ret = mbedtls_ssl_shm_mutex_lock(&stripe->mutex, &owner_died);
+
+    /* If the previous owner died with the mutex held, only the slot it
+     * was writing, if any, can be inconsistent. */
+    if (ret == 0 && owner_died && stripe->dirty != 0) {
+        ssl_cache_shm_wipe(&ssl_cache_shm_get_slots(cache)[stripe->dirty - 1]);
+        stripe->dirty = 0;
+    }
+
+    return ret;
+}
+
+static int ssl_cache_shm_unlock(ssl_cache_shm_stripe *stripe)
+{
+    return mbedtls_ssl_shm_mutex_unlock(&stripe->mutex);
+}
+
+/* Find the bucket and the stripe of a session ID */
+static ssl_cache_shm_slot *ssl_cache_shm_bucket(
+    mbedtls_ssl_cache_shm_context *cache,
+    unsigned char const *session_id, size_t session_id_len,
+    ssl_cache_shm_stripe **stripe)
+{
+    const ssl_cache_shm_header *header = ssl_cache_shm_get_header(cache);
+    uint32_t bucket = mbedtls_ssl_fnv1a(0, session_id, session_id_len) %
+                      header->bucket_count;
+
+    *stripe = &ssl_cache_shm_get_stripes(cache)[bucket % header->stripe_count];
+
+    return &ssl_cache_shm_get_slots(cache)[(size_t) bucket * SSL_CACHE_SHM_WAYS];
+}
+
+static ssl_cache_shm_slot *ssl_cache_shm_find(
+    ssl_cache_shm_slot *bucket,
+    unsigned char const *session_id, size_t session_id_len)
+{
+    size_t i;
+
+    for (i = 0; i < SSL_CACHE_SHM_WAYS; i++) {
+        if (bucket[i].session_len != 0 &&
+            bucket[i].session_id_len == session_id_len &&
+            memcmp(bucket[i].session_id, session_id, session_id_len) == 0) {
+            return &bucket[i];
+        }
+    }
+
+    return NULL;
+}
+
+#if defined(MBEDTLS_HAVE_TIME)
+static int ssl_cache_shm_expired(const mbedtls_ssl_cache_shm_context *cache,
+                                 const ssl_cache_shm_slot *slot,
+                                 mbedtls_time_t t)
+{
+    return cache->timeout != 0 &&
+           (int) (t - slot->timestamp) > cache->timeout;
+}
+#endif /* MBEDTLS_HAVE_TIME */
+
+int mbedtls_ssl_cache_shm_get(void *data,
+                              unsigned char const *session_id,
+                              size_t session_id_len,
+                              mbedtls_ssl_session *session)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_cache_shm_context *cache = (mbedtls_ssl_cache_shm_context *) data;
+    ssl_cache_shm_stripe *stripe;
+    ssl_cache_shm_slot *slot;
+    unsigned char *buf;
+    size_t len = 0;
+
+    if (cache->region == NULL) {
+        return MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+    }
+
+    /* Copy the session out of the shared region, so that the mutex isn't
+     * held while it is parsed. */
+    buf = mbedtls_calloc(1, MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE);
+    if (buf == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    slot = ssl_cache_shm_bucket(cache, session_id, session_id_len, &stripe);
+
+    if ((ret = ssl_cache_shm_lock(cache, stripe)) != 0) {
+        goto cleanup;
+    }
+
+    slot = ssl_cache_shm_find(slot, session_id, session_id_len);
+    if (slot == NULL) {
+        ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+        goto exit;
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    if (ssl_cache_shm_expired(cache, slot, mbedtls_time(NULL))) {
+        ssl_cache_shm_wipe(slot);
+        ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+        goto exit;
+    }
+#endif
+
+    len = slot->session_len;
+    memcpy(buf, slot->session, len);
+    slot->last_used = ++stripe->clock;
+
+    ret = 0;
+
+exit:
+    if (ssl_cache_shm_unlock(stripe) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+
+    if (ret == 0) {
+        ret = mbedtls_ssl_session_load(session, buf, len);
+    }
+
+cleanup:
+    mbedtls_zeroize_and_free(buf, MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE);
+
+    return ret;
+}
+
+int mbedtls_ssl_cache_shm_set(void *data,
+                              unsigned char const *session_id,
+                              size_t session_id_len,
+                              const mbedtls_ssl_session *session)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_cache_shm_context *cache = (mbedtls_ssl_cache_shm_context *) data;
+    ssl_cache_shm_stripe *stripe;
+    ssl_cache_shm_slot *bucket, *slot;
+    unsigned char *buf;
+    size_t i, len = 0;
+#if defined(MBEDTLS_HAVE_TIME)
+    mbedtls_time_t t = mbedtls_time(NULL);
+#endif
+
+    if (cache->region == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (session_id_len > sizeof(slot->session_id)) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    /* Serialize the session before taking the mutex */
+    buf = mbedtls_calloc(1, MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE);
+    if (buf == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    ret = mbedtls_ssl_session_save(session, buf,
+                                   MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE, &len);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    bucket = ssl_cache_shm_bucket(cache, session_id, session_id_len, &stripe);
+
+    if ((ret = ssl_cache_shm_lock(cache, stripe)) != 0) {
+        goto cleanup;
+    }
+
+    /* Overwrite the same session, or else take an empty slot, an expired
+     * one or the least recently used one, in this order. */
+    slot = ssl_cache_shm_find(bucket, session_id, session_id_len);
+    for (i = 0; slot == NULL && i < SSL_CACHE_SHM_WAYS; i++) {
+        if (bucket[i].session_len == 0) {
+            slot = &bucket[i];
+        }
+    }
+#if defined(MBEDTLS_HAVE_TIME)
+    for (i = 0; slot == NULL && i < SSL_CACHE_SHM_WAYS; i++) {
+        if (ssl_cache_shm_expired(cache, &bucket[i], t)) {
+            slot = &bucket[i];
+        }
+    }
+#endif
+    if (slot == NULL) {
+        slot = &bucket[0];
+        for (i = 1; i < SSL_CACHE_SHM_WAYS; i++) {
+            if (bucket[i].last_used < slot->last_used) {
+                slot = &bucket[i];
+            }
+        }
+    }
+
+    stripe->dirty = (uint32_t) (slot - ssl_cache_shm_get_slots(cache)) + 1;
+
+    ssl_cache_shm_wipe(slot);
+#if defined(MBEDTLS_HAVE_TIME)
+    slot->timestamp = t;
+#endif
+    slot->last_used = ++stripe->clock;
+    slot->session_id_len = (uint32_t) session_id_len;
+    memcpy(slot->session_id, session_id, session_id_len);
+#if defined(MBEDTLS_TEST_HOOKS)
+    if (mbedtls_ssl_cache_shm_test_hook_write != NULL) {
+        mbedtls_ssl_cache_shm_test_hook_write();
+    }
+#endif
+    memcpy(slot->session, buf, len);
+    slot->session_len = (uint32_t) len;
+
+    stripe->dirty = 0;
+
+    ret = ssl_cache_shm_unlock(stripe);
+
+cleanup:
+    mbedtls_zeroize_and_free(buf, MBEDTLS_SSL_CACHE_SHM_SLOT_SIZE);
+
+    return ret;
+}
+
+int mbedtls_ssl_cache_shm_remove(void *data,
+                                 unsigned char const *session_id,
+                                 size_t session_id_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_cache_shm_context *cache = (mbedtls_ssl_cache_shm_context *) data;
+    ssl_cache_shm_stripe *stripe;
+    ssl_cache_shm_slot *slot;
+
+    if (cache->region == NULL) {
+        return 0;
+    }
+
+    slot = ssl_cache_shm_bucket(cache, session_id, session_id_len, &stripe);
+
+    if ((ret = ssl_cache_shm_lock(cache, stripe)) != 0) {
+        return ret;
+    }
+
+    /* No entry found, exit with success */
+    slot = ssl_cache_shm_find(slot, session_id, session_id_len);
+    if (slot != NULL) {
+        ssl_cache_shm_wipe(slot);
+    }
+
+    return ssl_cache_shm_unlock(stripe);
+}
+
+#if defined(MBEDTLS_HAVE_TIME)
+void mbedtls_ssl_cache_shm_set_timeout(mbedtls_ssl_cache_shm_context *cache,
+                                       int timeout)
+{
+    if (timeout < 0) {
+        timeout = 0;
+    }
+
+    cache->timeout = timeout;
+}
+#endif /* MBEDTLS_HAVE_TIME */
+
+void mbedtls_ssl_cache_shm_free(mbedtls_ssl_cache_shm_context *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    /* Other processes may still use the mutexes, so they are not
+     * destroyed. */
+    if (cache->region != NULL) {
+        (void) munmap(cache->region, cache->region_len);
+    }
+
+    mbedtls_platform_zeroize(cache, sizeof(mbedtls_ssl_cache_shm_context));
+}
+
+#endif /* MBEDTLS_SSL_CACHE_SHM_C */
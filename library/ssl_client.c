@@ -732,6 +732,56 @@ static int ssl_generate_random(mbedtls_ssl_context *ssl)
     return ret;
 }
 
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+/*
+ * Load a session from the session store, unless the application has set
+ * one. Only for the first ClientHello of an initial handshake: the
+ * ClientHello sent again after a HelloVerifyRequest or a HelloRetryRequest
+ * offers the same session, if any.
+ */
+static void ssl_take_stored_session(mbedtls_ssl_context *ssl)
+{
+    int ret;
+    mbedtls_ssl_session session;
+
+    if (ssl->conf->f_session_store_take == NULL || ssl->hostname == NULL ||
+        ssl->handshake->resume != 0) {
+        return;
+    }
+#if defined(MBEDTLS_SSL_RENEGOTIATION)
+    if (ssl->renego_status != MBEDTLS_SSL_INITIAL_HANDSHAKE) {
+        return;
+    }
+#endif
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+    if (ssl->handshake->cookie != NULL) {
+        return;
+    }
+#endif
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+    if (ssl->handshake->hello_retry_request_flag) {
+        return;
+    }
+#endif
+
+    mbedtls_ssl_session_init(&session);
+
+    ret = ssl->conf->f_session_store_take(ssl->conf->p_session_store,
+                                          ssl->hostname, ssl->peer_port,
+                                          &session);
+    if (ret == 0) {
+        ret = mbedtls_ssl_set_session(ssl, &session);
+    }
+    if (ret != 0) {
+        MBEDTLS_SSL_DEBUG_RET(3, "no stored session to resume", ret);
+    } else {
+        MBEDTLS_SSL_DEBUG_MSG(3, ("resume a stored session"));
+    }
+
+    mbedtls_ssl_session_free(&session);
+}
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
 MBEDTLS_CHECK_RETURN_CRITICAL
 static int ssl_prepare_client_hello(mbedtls_ssl_context *ssl)
 {
@@ -743,6 +793,10 @@ static int ssl_prepare_client_hello(mbedtls_ssl_context *ssl)
         return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
     }
 
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    ssl_take_stored_session(ssl);
+#endif
+
 #if defined(MBEDTLS_SSL_PROTO_TLS1_3) && \
     defined(MBEDTLS_SSL_SESSION_TICKETS) && \
     defined(MBEDTLS_HAVE_TIME)
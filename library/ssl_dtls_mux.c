@@ -0,0 +1,666 @@
+/*
+ *  DTLS server multiplexer over a single datagram socket
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * Every connection is in the address index, and in the CID index if CIDs
+ * are enabled. Both indexes are hash tables with chained buckets, sized to
+ * the maximum number of connections so that the chains stay short. The
+ * connections with a running retransmission timer are also kept in a
+ * doubly linked list, which is the only place where timers are looked for:
+ * established connections normally have no timer.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_DTLS_MUX_C)
+
+#include "mbedtls/platform.h"
+
+#include "mbedtls/ssl_dtls_mux.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+
+#include <string.h>
+
+/* Offset of the CID in a DTLS 1.2 record with a CID */
+#define SSL_DTLS_MUX_CID_OFFSET     11
+
+/* Room for a HelloVerifyRequest with the longest possible cookie */
+#define SSL_DTLS_MUX_HVR_LEN        (28 + 255)
+
+/* Number of attempts to draw a CID that is not in use */
+#define SSL_DTLS_MUX_CID_ATTEMPTS   8
+
+struct mbedtls_ssl_dtls_mux_conn {
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_dtls_mux_context *mux;
+
+    unsigned char addr[MBEDTLS_SSL_DTLS_MUX_ADDR_MAX_LEN]; /* client address */
+    size_t addr_len;
+    unsigned char cid[MBEDTLS_SSL_CID_IN_LEN_MAX];       /* own CID        */
+    size_t cid_len;
+
+    const unsigned char *in;    /* datagram not yet passed to the context */
+    size_t in_len;
+
+    mbedtls_ms_time_t timer_start;
+    uint32_t int_ms;
+    uint32_t fin_ms;            /* 0 if the timer is cancelled */
+
+    mbedtls_ssl_dtls_mux_conn *next_addr;  /* address index chain */
+    mbedtls_ssl_dtls_mux_conn *next_cid;   /* CID index chain     */
+    mbedtls_ssl_dtls_mux_conn *timer_prev; /* timer list          */
+    mbedtls_ssl_dtls_mux_conn *timer_next;
+};
+
+/* Keyed with a random seed so that clients cannot choose addresses that
+ * collide. */
+static size_t ssl_dtls_mux_bucket(const mbedtls_ssl_dtls_mux_context *mux,
+                                  const unsigned char *buf, size_t len)
+{
+    return (size_t) mbedtls_ssl_fnv1a(mux->seed, buf, len) & (mux->buckets - 1);
+}
+
+static mbedtls_ssl_dtls_mux_conn *ssl_dtls_mux_find_addr(
+    const mbedtls_ssl_dtls_mux_context *mux,
+    const unsigned char *addr, size_t addr_len)
+{
+    mbedtls_ssl_dtls_mux_conn *conn;
+
+    conn = mux->by_addr[ssl_dtls_mux_bucket(mux, addr, addr_len)];
+    for (; conn != NULL; conn = conn->next_addr) {
+        if (conn->addr_len == addr_len &&
+            memcmp(conn->addr, addr, addr_len) == 0) {
+            break;
+        }
+    }
+
+    return conn;
+}
+
+static mbedtls_ssl_dtls_mux_conn *ssl_dtls_mux_find_cid(
+    const mbedtls_ssl_dtls_mux_context *mux,
+    const unsigned char *cid, size_t cid_len)
+{
+    mbedtls_ssl_dtls_mux_conn *conn;
+
+    conn = mux->by_cid[ssl_dtls_mux_bucket(mux, cid, cid_len)];
+    for (; conn != NULL; conn = conn->next_cid) {
+        if (conn->cid_len == cid_len &&
+            memcmp(conn->cid, cid, cid_len) == 0) {
+            break;
+        }
+    }
+
+    return conn;
+}
+
+static void ssl_dtls_mux_link_addr(mbedtls_ssl_dtls_mux_context *mux,
+                                   mbedtls_ssl_dtls_mux_conn *conn)
+{
+    mbedtls_ssl_dtls_mux_conn **p =
+        &mux->by_addr[ssl_dtls_mux_bucket(mux, conn->addr, conn->addr_len)];
+
+    conn->next_addr = *p;
+    *p = conn;
+}
+
+static void ssl_dtls_mux_unlink_addr(mbedtls_ssl_dtls_mux_context *mux,
+                                     mbedtls_ssl_dtls_mux_conn *conn)
+{
+    mbedtls_ssl_dtls_mux_conn **p =
+        &mux->by_addr[ssl_dtls_mux_bucket(mux, conn->addr, conn->addr_len)];
+
+    for (; *p != NULL; p = &(*p)->next_addr) {
+        if (*p == conn) {
+            *p = conn->next_addr;
+            break;
+        }
+    }
+}
+
+static void ssl_dtls_mux_unlink_cid(mbedtls_ssl_dtls_mux_context *mux,
+                                    mbedtls_ssl_dtls_mux_conn *conn)
+{
+    mbedtls_ssl_dtls_mux_conn **p;
+
+    if (conn->cid_len == 0) {
+        return;
+    }
+
+    p = &mux->by_cid[ssl_dtls_mux_bucket(mux, conn->cid, conn->cid_len)];
+    for (; *p != NULL; p = &(*p)->next_cid) {
+        if (*p == conn) {
+            *p = conn->next_cid;
+            break;
+        }
+    }
+}
+
+static void ssl_dtls_mux_unlink_timer(mbedtls_ssl_dtls_mux_context *mux,
+                                      mbedtls_ssl_dtls_mux_conn *conn)
+{
+    if (conn->timer_prev != NULL) {
+        conn->timer_prev->timer_next = conn->timer_next;
+    } else if (mux->timers == conn) {
+        mux->timers = conn->timer_next;
+    } else {
+        return;
+    }
+
+    if (conn->timer_next != NULL) {
+        conn->timer_next->timer_prev = conn->timer_prev;
+    }
+
+    conn->timer_prev = NULL;
+    conn->timer_next = NULL;
+}
+
+/*
+ * Callbacks of the SSL context of a connection
+ */
+static int ssl_dtls_mux_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    mbedtls_ssl_dtls_mux_conn *conn = (mbedtls_ssl_dtls_mux_conn *) ctx;
+    mbedtls_ssl_dtls_mux_context *mux = conn->mux;
+
+    return mux->f_send_to(mux->p_bio, buf, len, conn->addr, conn->addr_len);
+}
+
+static int ssl_dtls_mux_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    mbedtls_ssl_dtls_mux_conn *conn = (mbedtls_ssl_dtls_mux_conn *) ctx;
+
+    if (conn->in == NULL) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    if (len > conn->in_len) {
+        len = conn->in_len;
+    }
+
+    memcpy(buf, conn->in, len);
+    conn->in = NULL;
+
+    return (int) len;
+}
+
+static void ssl_dtls_mux_set_timer(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+    mbedtls_ssl_dtls_mux_conn *conn = (mbedtls_ssl_dtls_mux_conn *) ctx;
+    mbedtls_ssl_dtls_mux_context *mux = conn->mux;
+
+    conn->int_ms = int_ms;
+    conn->fin_ms = fin_ms;
+
+    if (fin_ms == 0) {
+        ssl_dtls_mux_unlink_timer(mux, conn);
+        return;
+    }
+
+    conn->timer_start = mbedtls_ms_time();
+
+    if (conn->timer_prev == NULL && mux->timers != conn) {
+        conn->timer_next = mux->timers;
+        if (mux->timers != NULL) {
+            mux->timers->timer_prev = conn;
+        }
+        mux->timers = conn;
+    }
+}
+
+/* Same semantics as mbedtls_timing_get_delay() */
+static int ssl_dtls_mux_get_timer(void *ctx)
+{
+    mbedtls_ssl_dtls_mux_conn *conn = (mbedtls_ssl_dtls_mux_conn *) ctx;
+    mbedtls_ms_time_t elapsed;
+
+    if (conn->fin_ms == 0) {
+        return -1;
+    }
+
+    elapsed = mbedtls_ms_time() - conn->timer_start;
+
+    if (elapsed >= conn->fin_ms) {
+        return 2;
+    }
+
+    if (elapsed >= conn->int_ms) {
+        return 1;
+    }
+
+    return 0;
+}
+
+void mbedtls_ssl_dtls_mux_init(mbedtls_ssl_dtls_mux_context *mux)
+{
+    memset(mux, 0, sizeof(mbedtls_ssl_dtls_mux_context));
+
+    mbedtls_ssl_init(&mux->hello);
+}
+
+int mbedtls_ssl_dtls_mux_setup(mbedtls_ssl_dtls_mux_context *mux,
+                               const mbedtls_ssl_config *conf,
+                               size_t max_conns)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    size_t buckets = 1;
+
+    if (conf->endpoint != MBEDTLS_SSL_IS_SERVER ||
+        conf->transport != MBEDTLS_SSL_TRANSPORT_DATAGRAM ||
+        conf->f_rng == NULL ||
+        conf->f_cookie_write == NULL || conf->f_cookie_check == NULL ||
+        conf->anti_replay == MBEDTLS_SSL_ANTI_REPLAY_DISABLED ||
+        max_conns == 0 ||
+        max_conns > SIZE_MAX / 2 / sizeof(mbedtls_ssl_dtls_mux_conn *)) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    while (buckets < max_conns) {
+        buckets <<= 1;
+    }
+
+    mux->by_addr = mbedtls_calloc(buckets, sizeof(mbedtls_ssl_dtls_mux_conn *));
+    mux->by_cid = mbedtls_calloc(buckets, sizeof(mbedtls_ssl_dtls_mux_conn *));
+    mux->buf = mbedtls_calloc(1, MBEDTLS_SSL_IN_BUFFER_LEN);
+    if (mux->by_addr == NULL || mux->by_cid == NULL || mux->buf == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    ret = conf->f_rng(conf->p_rng, (unsigned char *) &mux->seed,
+                      sizeof(mux->seed));
+    if (ret != 0) {
+        return ret;
+    }
+
+    mux->conf = conf;
+    mux->buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
+    mux->buckets = buckets;
+    mux->max_conns = max_conns;
+
+    /* The cookie exchange only uses the configuration of this context */
+    mux->hello.conf = conf;
+
+    return 0;
+}
+
+void mbedtls_ssl_dtls_mux_set_bio(mbedtls_ssl_dtls_mux_context *mux,
+                                  void *p_bio,
+                                  mbedtls_ssl_dtls_mux_send_to_t *f_send_to,
+                                  mbedtls_ssl_dtls_mux_recv_from_t *f_recv_from)
+{
+    mux->p_bio = p_bio;
+    mux->f_send_to = f_send_to;
+    mux->f_recv_from = f_recv_from;
+}
+
+/*
+ * Create a connection for a client that returned a valid cookie
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_dtls_mux_new_conn(mbedtls_ssl_dtls_mux_context *mux,
+                                 const unsigned char *addr, size_t addr_len,
+                                 mbedtls_ssl_dtls_mux_conn **p_conn)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const mbedtls_ssl_config *conf = mux->conf;
+    mbedtls_ssl_dtls_mux_conn *conn;
+    int attempts;
+
+    conn = mbedtls_calloc(1, sizeof(mbedtls_ssl_dtls_mux_conn));
+    if (conn == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    mbedtls_ssl_init(&conn->ssl);
+    conn->mux = mux;
+    memcpy(conn->addr, addr, addr_len);
+    conn->addr_len = addr_len;
+
+    if ((ret = mbedtls_ssl_setup(&conn->ssl, conf)) != 0) {
+        goto error;
+    }
+
+    if (conf->cid_len != 0) {
+        for (attempts = 0;; attempts++) {
+            if (attempts == SSL_DTLS_MUX_CID_ATTEMPTS) {
+                ret = MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+                goto error;
+            }
+
+            if ((ret = conf->f_rng(conf->p_rng, conn->cid, conf->cid_len)) != 0) {
+                goto error;
+            }
+
+            if (ssl_dtls_mux_find_cid(mux, conn->cid, conf->cid_len) == NULL) {
+                break;
+            }
+        }
+
+        ret = mbedtls_ssl_set_cid(&conn->ssl, MBEDTLS_SSL_CID_ENABLED,
+                                  conn->cid, conf->cid_len);
+        if (ret != 0) {
+            goto error;
+        }
+        conn->cid_len = conf->cid_len;
+    }
+
+    ret = mbedtls_ssl_set_client_transport_id(&conn->ssl, addr, addr_len);
+    if (ret != 0) {
+        goto error;
+    }
+
+    mbedtls_ssl_set_bio(&conn->ssl, conn, ssl_dtls_mux_send,
+                        ssl_dtls_mux_recv, NULL);
+    mbedtls_ssl_set_timer_cb(&conn->ssl, conn, ssl_dtls_mux_set_timer,
+                             ssl_dtls_mux_get_timer);
+
+    ssl_dtls_mux_link_addr(mux, conn);
+    if (conn->cid_len != 0) {
+        mbedtls_ssl_dtls_mux_conn **p =
+            &mux->by_cid[ssl_dtls_mux_bucket(mux, conn->cid, conn->cid_len)];
+        conn->next_cid = *p;
+        *p = conn;
+    }
+    mux->count++;
+
+    *p_conn = conn;
+    return 0;
+
+error:
+    mbedtls_ssl_free(&conn->ssl);
+    mbedtls_free(conn);
+    return ret;
+}
+
+/*
+ * Move a connection to the address a newer record came from (RFC 9146
+ * section 6). Another connection may still be indexed under this address
+ * if its client has moved away; the lookup then finds either of them, which
+ * only matters for clients that do not use a CID.
+ */
+static void ssl_dtls_mux_rebind(mbedtls_ssl_dtls_mux_context *mux,
+                                mbedtls_ssl_dtls_mux_conn *conn,
+                                const unsigned char *addr, size_t addr_len)
+{
+    ssl_dtls_mux_unlink_addr(mux, conn);
+    memcpy(conn->addr, addr, addr_len);
+    conn->addr_len = addr_len;
+    ssl_dtls_mux_link_addr(mux, conn);
+
+    /* Only used to check the cookie of a client reconnecting from the same
+     * address: keep the old one if this fails. */
+    (void) mbedtls_ssl_set_client_transport_id(&conn->ssl, addr, addr_len);
+}
+
+/*
+ * Let a connection process the datagram it was given, if any, and its
+ * expired timer. Return MBEDTLS_ERR_SSL_WANT_READ if there is nothing to
+ * report to the application.
+ */
+static int ssl_dtls_mux_process(mbedtls_ssl_dtls_mux_context *mux,
+                                mbedtls_ssl_dtls_mux_conn *conn,
+                                unsigned char *buf, size_t len,
+                                const unsigned char *addr, size_t addr_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    uint64_t top = conn->ssl.in_window_top;
+
+    if (!mbedtls_ssl_is_handshake_over(&conn->ssl)) {
+        ret = mbedtls_ssl_handshake(&conn->ssl);
+        conn->in = NULL;
+
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ ||
+            ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+
+        if (ret != 0) {
+            /* The application doesn't know about this connection yet */
+            mbedtls_ssl_dtls_mux_close(mux, conn);
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+    } else {
+        ret = mbedtls_ssl_read(&conn->ssl, buf, len);
+        conn->in = NULL;
+
+        /* The record window only moves forward when a newer record has
+         * been authenticated, so a replayed or forged datagram cannot
+         * redirect the connection. */
+        if (addr != NULL && conn->ssl.in_window_top > top &&
+            (addr_len != conn->addr_len ||
+             memcmp(addr, conn->addr, addr_len) != 0)) {
+            ssl_dtls_mux_rebind(mux, conn, addr, addr_len);
+        }
+
+        if (ret == 0 || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            ret = MBEDTLS_ERR_SSL_WANT_READ;
+        }
+    }
+
+    /* Another record of the same datagram is waiting */
+    if (mbedtls_ssl_check_pending(&conn->ssl)) {
+        mux->pending = conn;
+    }
+
+    return ret;
+}
+
+/*
+ * Answer a datagram from an unknown address: it must be a ClientHello,
+ * and a connection is only created once the client has proven that it
+ * can receive at its address by returning a valid cookie.
+ */
+static int ssl_dtls_mux_hello(mbedtls_ssl_dtls_mux_context *mux,
+                              mbedtls_ssl_dtls_mux_conn **p_conn,
+                              size_t datagram_len,
+                              unsigned char *buf, size_t len,
+                              const unsigned char *addr, size_t addr_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    unsigned char hvr[SSL_DTLS_MUX_HVR_LEN];
+    size_t hvr_len = 0;
+    mbedtls_ssl_dtls_mux_conn *conn;
+
+    ret = mbedtls_ssl_check_dtls_clihlo_cookie(&mux->hello, addr, addr_len,
+                                               mux->buf, datagram_len,
+                                               hvr, sizeof(hvr), &hvr_len);
+    if (ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
+        /* Losing the HelloVerifyRequest is harmless: the client will send
+         * its ClientHello again. */
+        (void) mux->f_send_to(mux->p_bio, hvr, hvr_len, addr, addr_len);
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    if (ret != 0 || mux->count >= mux->max_conns) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    if (ssl_dtls_mux_new_conn(mux, addr, addr_len, &conn) != 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+
+    conn->in = mux->buf;
+    conn->in_len = datagram_len;
+    *p_conn = conn;
+
+    return ssl_dtls_mux_process(mux, conn, buf, len, addr, addr_len);
+}
+
+/*
+ * Find the connection a datagram belongs to and pass it the datagram
+ */
+static int ssl_dtls_mux_dispatch(mbedtls_ssl_dtls_mux_context *mux,
+                                 mbedtls_ssl_dtls_mux_conn **p_conn,
+                                 size_t datagram_len,
+                                 unsigned char *buf, size_t len,
+                                 const unsigned char *addr, size_t addr_len)
+{
+    mbedtls_ssl_dtls_mux_conn *conn;
+    size_t cid_len = mux->conf->cid_len;
+
+    if (cid_len != 0 && mux->buf[0] == MBEDTLS_SSL_MSG_CID) {
+        if (datagram_len < SSL_DTLS_MUX_CID_OFFSET + cid_len + 2) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+
+        conn = ssl_dtls_mux_find_cid(mux, mux->buf + SSL_DTLS_MUX_CID_OFFSET,
+                                     cid_len);
+        if (conn == NULL) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+    } else {
+        conn = ssl_dtls_mux_find_addr(mux, addr, addr_len);
+        if (conn == NULL) {
+            return ssl_dtls_mux_hello(mux, p_conn, datagram_len, buf, len,
+                                      addr, addr_len);
+        }
+    }
+
+    conn->in = mux->buf;
+    conn->in_len = datagram_len;
+    *p_conn = conn;
+
+    return ssl_dtls_mux_process(mux, conn, buf, len, addr, addr_len);
+}
+
+int mbedtls_ssl_dtls_mux_read(mbedtls_ssl_dtls_mux_context *mux,
+                              mbedtls_ssl_dtls_mux_conn **conn,
+                              unsigned char *buf, size_t len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    unsigned char addr[MBEDTLS_SSL_DTLS_MUX_ADDR_MAX_LEN];
+    size_t addr_len = 0;
+    mbedtls_ssl_dtls_mux_conn *cur, *next;
+
+    *conn = NULL;
+
+    if (mux->conf == NULL || mux->f_recv_from == NULL || mux->f_send_to == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    /* Retransmit the flights whose timer has expired. The list is only
+     * modified for the connection being processed. */
+    for (cur = mux->timers; cur != NULL; cur = next) {
+        next = cur->timer_next;
+
+        if (ssl_dtls_mux_get_timer(cur) != 2) {
+            continue;
+        }
+
+        ret = ssl_dtls_mux_process(mux, cur, buf, len, NULL, 0);
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ) {
+            *conn = cur;
+            return ret;
+        }
+    }
+
+    for (;;) {
+        cur = NULL;
+
+        if (mux->pending != NULL) {
+            cur = mux->pending;
+            mux->pending = NULL;
+            ret = ssl_dtls_mux_process(mux, cur, buf, len, NULL, 0);
+        } else {
+            ret = mux->f_recv_from(mux->p_bio, mux->buf, mux->buf_len,
+                                   addr, sizeof(addr), &addr_len);
+            if (ret < 0) {
+                return ret;
+            }
+
+            if (ret == 0 || addr_len > sizeof(addr)) {
+                continue;
+            }
+
+            ret = ssl_dtls_mux_dispatch(mux, &cur, (size_t) ret, buf, len,
+                                        addr, addr_len);
+        }
+
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ) {
+            *conn = cur;
+            return ret;
+        }
+    }
+}
+
+int mbedtls_ssl_dtls_mux_next_timeout(const mbedtls_ssl_dtls_mux_context *mux)
+{
+    mbedtls_ssl_dtls_mux_conn *conn;
+    mbedtls_ms_time_t now = mbedtls_ms_time();
+    mbedtls_ms_time_t left, min = -1;
+
+    for (conn = mux->timers; conn != NULL; conn = conn->timer_next) {
+        left = conn->timer_start + conn->fin_ms - now;
+        if (left < 0) {
+            left = 0;
+        }
+        if (min < 0 || left < min) {
+            min = left;
+        }
+    }
+
+    return (int) min;
+}
+
+mbedtls_ssl_context *mbedtls_ssl_dtls_mux_get_ssl(mbedtls_ssl_dtls_mux_conn *conn)
+{
+    return &conn->ssl;
+}
+
+const unsigned char *mbedtls_ssl_dtls_mux_get_addr(const mbedtls_ssl_dtls_mux_conn *conn,
+                                                   size_t *addr_len)
+{
+    *addr_len = conn->addr_len;
+    return conn->addr;
+}
+
+void mbedtls_ssl_dtls_mux_close(mbedtls_ssl_dtls_mux_context *mux,
+                                mbedtls_ssl_dtls_mux_conn *conn)
+{
+    if (conn == NULL) {
+        return;
+    }
+
+    if (mux->pending == conn) {
+        mux->pending = NULL;
+    }
+
+    ssl_dtls_mux_unlink_timer(mux, conn);
+    ssl_dtls_mux_unlink_addr(mux, conn);
+    ssl_dtls_mux_unlink_cid(mux, conn);
+    mux->count--;
+
+    mbedtls_ssl_free(&conn->ssl);
+    mbedtls_free(conn);
+}
+
+void mbedtls_ssl_dtls_mux_free(mbedtls_ssl_dtls_mux_context *mux)
+{
+    size_t i;
+
+    if (mux == NULL) {
+        return;
+    }
+
+    if (mux->by_addr != NULL) {
+        for (i = 0; i < mux->buckets; i++) {
+            while (mux->by_addr[i] != NULL) {
+                mbedtls_ssl_dtls_mux_close(mux, mux->by_addr[i]);
+            }
+        }
+    }
+
+    mbedtls_free(mux->by_addr);
+    mbedtls_free(mux->by_cid);
+    mbedtls_free(mux->buf);
+    mbedtls_ssl_free(&mux->hello);
+
+    mbedtls_platform_zeroize(mux, sizeof(mbedtls_ssl_dtls_mux_context));
+}
+
+#endif /* MBEDTLS_SSL_DTLS_MUX_C */
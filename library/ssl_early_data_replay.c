@@ -0,0 +1,465 @@
+/*
+ *  TLS 1.3 server-side anti-replay store for early data
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * The region starts with a header holding the parameters and the state of
+ * the store, followed by two hash tables of records, one per generation.
+ * A record is the beginning of the PSK binder of a ClientHello, which is
+ * the output of a MAC and is thus unique with overwhelming probability.
+ * Records are only ever removed by emptying a whole table, so the tables
+ * use linear probing without tombstones, and are kept at most half full.
+ *
+ * New records go to the current generation. Once it is 2 * tolerance old,
+ * it becomes the previous generation, whose records are discarded. A record
+ * thus lives at least 2 * tolerance, which is the longest time between two
+ * arrivals of the same ClientHello that both pass the freshness check.
+ *
+ * Whenever records may have been lost, because the store is new, because
+ * the clock went backwards or because a process died while updating a
+ * shared store, early data is rejected for 2 * tolerance.
+ */
+
+/*
+ * Ensure the robust mutexes of shared stores are available even with
+ * -std=c99, see ssl_cache_shm.c.
+ */
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_EARLY_DATA_REPLAY_C)
+
+#include "mbedtls/platform.h"
+
+#include "mbedtls/ssl_early_data_replay.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/threading.h"
+
+#include <string.h>
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+#include <sys/mman.h>
+#endif
+
+#define SSL_EARLY_DATA_REPLAY_MAGIC         0x4D455252  /* "MERR" */
+#define SSL_EARLY_DATA_REPLAY_RECORD_LEN    16
+#define SSL_EARLY_DATA_REPLAY_MAX_ENTRIES   (1u << 24)
+#define SSL_EARLY_DATA_REPLAY_ALIGN         64          /* cache line */
+
+#define SSL_EARLY_DATA_REPLAY_ROUND(x) \
+    (((x) + SSL_EARLY_DATA_REPLAY_ALIGN - 1) & \
+     ~((size_t) SSL_EARLY_DATA_REPLAY_ALIGN - 1))
+
+/* Content of the empty slots */
+static const unsigned char ssl_early_data_replay_empty[
+    SSL_EARLY_DATA_REPLAY_RECORD_LEN] = { 0 };
+
+typedef struct {
+    uint32_t magic;             /*!< written last when formatting         */
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    unsigned char boot_id[MBEDTLS_SSL_SHM_BOOT_ID_LEN]; /*!< written by
+                                                             mbedtls_ssl_shm_map() */
+#endif
+    uint32_t max_entries;       /*!< records per generation               */
+    uint32_t table_size;        /*!< slots per generation, power of 2     */
+    uint32_t tolerance;         /*!< freshness tolerance in ms            */
+    mbedtls_ms_time_t generation_start; /*!< creation of the current
+                                             generation                   */
+    mbedtls_ms_time_t accept_after;     /*!< end of the period during
+                                             which early data is rejected */
+    uint32_t current;           /*!< index of the current generation      */
+    uint32_t count[2];          /*!< records in each generation           */
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    pthread_mutex_t mutex;      /*!< lock of a shared region              */
+#endif
+} ssl_early_data_replay_header;
+
+#if defined(MBEDTLS_TEST_HOOKS)
+mbedtls_ms_time_t (*mbedtls_ssl_early_data_replay_test_hook_time)(void) = NULL;
+#endif
+
+static mbedtls_ms_time_t ssl_early_data_replay_time(void)
+{
+#if defined(MBEDTLS_TEST_HOOKS)
+    if (mbedtls_ssl_early_data_replay_test_hook_time != NULL) {
+        return mbedtls_ssl_early_data_replay_test_hook_time();
+    }
+#endif
+
+    return mbedtls_ms_time();
+}
+
+static ssl_early_data_replay_header *ssl_early_data_replay_get_header(
+    const mbedtls_ssl_early_data_replay_context *ctx)
+{
+    return (ssl_early_data_replay_header *) ctx->region;
+}
+
+static size_t ssl_early_data_replay_tables_offset(void)
+{
+    return SSL_EARLY_DATA_REPLAY_ROUND(sizeof(ssl_early_data_replay_header));
+}
+
+static unsigned char *ssl_early_data_replay_get_table(
+    const mbedtls_ssl_early_data_replay_context *ctx, uint32_t generation)
+{
+    const ssl_early_data_replay_header *header =
+        ssl_early_data_replay_get_header(ctx);
+
+    return ctx->region + ssl_early_data_replay_tables_offset() +
+           (size_t) generation * header->table_size *
+           SSL_EARLY_DATA_REPLAY_RECORD_LEN;
+}
+
+void mbedtls_ssl_early_data_replay_init(mbedtls_ssl_early_data_replay_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_ssl_early_data_replay_context));
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init(&ctx->mutex);
+#endif
+}
+
+/* Compute the size of the tables, and of the region holding them */
+static int ssl_early_data_replay_geometry(size_t max_entries,
+                                          uint32_t tolerance_ms,
+                                          uint32_t *table_size,
+                                          size_t *len)
+{
+    uint32_t size = 1;
+
+    if (max_entries == 0 || max_entries > SSL_EARLY_DATA_REPLAY_MAX_ENTRIES ||
+        tolerance_ms == 0 ||
+        tolerance_ms > MBEDTLS_SSL_TLS1_3_MAX_ALLOWED_TICKET_LIFETIME * 1000u) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    while (size < 2 * max_entries) {
+        size <<= 1;
+    }
+
+    *table_size = size;
+    *len = ssl_early_data_replay_tables_offset() +
+           2 * (size_t) size * SSL_EARLY_DATA_REPLAY_RECORD_LEN;
+
+    return 0;
+}
+
+/* Forget all records, and reject early data until a replay of any
+ * ClientHello processed before can no longer be fresh. */
+static void ssl_early_data_replay_reset(mbedtls_ssl_early_data_replay_context *ctx,
+                                        mbedtls_ms_time_t now)
+{
+    ssl_early_data_replay_header *header = ssl_early_data_replay_get_header(ctx);
+
+    memset(ssl_early_data_replay_get_table(ctx, 0), 0,
+           2 * (size_t) header->table_size * SSL_EARLY_DATA_REPLAY_RECORD_LEN);
+    header->count[0] = 0;
+    header->count[1] = 0;
+    header->current = 0;
+    header->generation_start = now;
+    header->accept_after = now + 2 * (mbedtls_ms_time_t) header->tolerance;
+}
+
+typedef struct {
+    mbedtls_ssl_early_data_replay_context *ctx;
+    uint32_t max_entries;
+    uint32_t table_size;
+    uint32_t tolerance;
+} ssl_early_data_replay_params;
+
+static int ssl_early_data_replay_setup_region(void *p, unsigned char *region,
+                                              int format)
+{
+    ssl_early_data_replay_params *params = (ssl_early_data_replay_params *) p;
+    ssl_early_data_replay_header *header;
+
+    params->ctx->region = region;
+    header = ssl_early_data_replay_get_header(params->ctx);
+
+    if (!format) {
+        if (header->max_entries != params->max_entries ||
+            header->table_size != params->table_size ||
+            header->tolerance != params->tolerance) {
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+
+        return 0;
+    }
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    if (params->ctx->shared) {
+        int ret = mbedtls_ssl_shm_mutex_init(&header->mutex);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+#endif
+
+    header->max_entries = params->max_entries;
+    header->table_size = params->table_size;
+    header->tolerance = params->tolerance;
+    ssl_early_data_replay_reset(params->ctx, ssl_early_data_replay_time());
+    header->magic = SSL_EARLY_DATA_REPLAY_MAGIC;
+
+    return 0;
+}
+
+int mbedtls_ssl_early_data_replay_setup(mbedtls_ssl_early_data_replay_context *ctx,
+                                        size_t max_entries,
+                                        uint32_t tolerance_ms)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    ssl_early_data_replay_params params;
+    unsigned char *region;
+    size_t len;
+
+    ret = ssl_early_data_replay_geometry(max_entries, tolerance_ms,
+                                         &params.table_size, &len);
+    if (ret != 0) {
+        return ret;
+    }
+
+    region = mbedtls_calloc(1, len);
+    if (region == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    params.ctx = ctx;
+    params.max_entries = (uint32_t) max_entries;
+    params.tolerance = tolerance_ms;
+
+    ctx->shared = 0;
+    ctx->region_len = len;
+
+    return ssl_early_data_replay_setup_region(&params, region, 1);
+}
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+int mbedtls_ssl_early_data_replay_setup_shared(
+    mbedtls_ssl_early_data_replay_context *ctx, const char *path,
+    size_t max_entries, uint32_t tolerance_ms)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    ssl_early_data_replay_params params;
+    size_t len;
+
+    ret = ssl_early_data_replay_geometry(max_entries, tolerance_ms,
+                                         &params.table_size, &len);
+    if (ret != 0) {
+        return ret;
+    }
+
+    params.ctx = ctx;
+    params.max_entries = (uint32_t) max_entries;
+    params.tolerance = tolerance_ms;
+
+    ctx->shared = 1;
+
+    ret = mbedtls_ssl_shm_map(path, len, SSL_EARLY_DATA_REPLAY_MAGIC,
+                              ssl_early_data_replay_setup_region, &params,
+                              &ctx->region, &ctx->region_len);
+    if (ret != 0) {
+        ctx->region = NULL;
+        ctx->region_len = 0;
+        ctx->shared = 0;
+    }
+
+    return ret;
+}
+#endif /* MBEDTLS_SSL_CACHE_SHM_C */
+
+static int ssl_early_data_replay_lock(mbedtls_ssl_early_data_replay_context *ctx,
+                                      int *owner_died)
+{
+    *owner_died = 0;
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    if (ctx->shared) {
+        return mbedtls_ssl_shm_mutex_lock(
+            &ssl_early_data_replay_get_header(ctx)->mutex, owner_died);
+    }
+#endif
+
+#if defined(MBEDTLS_THREADING_C)
+    return mbedtls_mutex_lock(&ctx->mutex);
+#else
+    ((void) ctx);
+    return 0;
+#endif
+}
+
+static int ssl_early_data_replay_unlock(mbedtls_ssl_early_data_replay_context *ctx)
+{
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    if (ctx->shared) {
+        return mbedtls_ssl_shm_mutex_unlock(
+            &ssl_early_data_replay_get_header(ctx)->mutex);
+    }
+#endif
+
+#if defined(MBEDTLS_THREADING_C)
+    return mbedtls_mutex_unlock(&ctx->mutex);
+#else
+    ((void) ctx);
+    return 0;
+#endif
+}
+
+/* Discard the generations that are too old to hold records that matter */
+static void ssl_early_data_replay_rotate(mbedtls_ssl_early_data_replay_context *ctx,
+                                         mbedtls_ms_time_t now)
+{
+    ssl_early_data_replay_header *header = ssl_early_data_replay_get_header(ctx);
+    mbedtls_ms_time_t period = 2 * (mbedtls_ms_time_t) header->tolerance;
+    uint32_t previous;
+
+    if (now - header->generation_start >= 2 * period) {
+        memset(ssl_early_data_replay_get_table(ctx, 0), 0,
+               2 * (size_t) header->table_size * SSL_EARLY_DATA_REPLAY_RECORD_LEN);
+        header->count[0] = 0;
+        header->count[1] = 0;
+        header->generation_start = now;
+    } else if (now - header->generation_start >= period) {
+        previous = 1 - header->current;
+        memset(ssl_early_data_replay_get_table(ctx, previous), 0,
+               (size_t) header->table_size * SSL_EARLY_DATA_REPLAY_RECORD_LEN);
+        header->count[previous] = 0;
+        header->current = previous;
+        header->generation_start = now;
+    }
+}
+
+/* Return the slot holding a record in a table, or the empty slot where it
+ * would be inserted. There is always one since tables are at most half
+ * full. */
+static unsigned char *ssl_early_data_replay_find(
+    const mbedtls_ssl_early_data_replay_context *ctx, uint32_t generation,
+    const unsigned char *record)
+{
+    uint32_t mask = ssl_early_data_replay_get_header(ctx)->table_size - 1;
+    unsigned char *table = ssl_early_data_replay_get_table(ctx, generation);
+    uint32_t i = MBEDTLS_GET_UINT32_LE(record, 0) & mask;
+    unsigned char *slot;
+
+    for (;;) {
+        slot = table + (size_t) i * SSL_EARLY_DATA_REPLAY_RECORD_LEN;
+        if (memcmp(slot, record, SSL_EARLY_DATA_REPLAY_RECORD_LEN) == 0 ||
+            memcmp(slot, ssl_early_data_replay_empty,
+                   SSL_EARLY_DATA_REPLAY_RECORD_LEN) == 0) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+int mbedtls_ssl_early_data_replay_check(void *p_replay,
+                                        const unsigned char *binder,
+                                        size_t binder_len,
+                                        mbedtls_ms_time_t expected_arrival_time)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_early_data_replay_context *ctx =
+        (mbedtls_ssl_early_data_replay_context *) p_replay;
+    ssl_early_data_replay_header *header;
+    mbedtls_ms_time_t now;
+    unsigned char *slot;
+    int owner_died;
+
+    if (ctx->region == NULL || binder_len < SSL_EARLY_DATA_REPLAY_RECORD_LEN) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    /* An all-zero record would be taken for an empty slot */
+    if (memcmp(binder, ssl_early_data_replay_empty,
+               SSL_EARLY_DATA_REPLAY_RECORD_LEN) == 0) {
+        return MBEDTLS_ERR_SSL_CANNOT_READ_EARLY_DATA;
+    }
+
+    header = ssl_early_data_replay_get_header(ctx);
+
+    if ((ret = ssl_early_data_replay_lock(ctx, &owner_died)) != 0) {
+        return ret;
+    }
+
+    now = ssl_early_data_replay_time();
+
+    /* A process that died while updating the store may have left it
+     * inconsistent, and the clock going backwards means the records can't
+     * be trusted. */
+    if (owner_died || now < header->generation_start) {
+        ssl_early_data_replay_reset(ctx, now);
+    }
+
+    ssl_early_data_replay_rotate(ctx, now);
+
+    ret = MBEDTLS_ERR_SSL_CANNOT_READ_EARLY_DATA;
+
+    if (now < header->accept_after) {
+        goto exit;
+    }
+
+    /* RFC 8446 section 8.3 */
+    if (expected_arrival_time < now - (mbedtls_ms_time_t) header->tolerance ||
+        expected_arrival_time > now + (mbedtls_ms_time_t) header->tolerance) {
+        goto exit;
+    }
+
+    /* RFC 8446 section 8.2 */
+    slot = ssl_early_data_replay_find(ctx, 1 - header->current, binder);
+    if (memcmp(slot, binder, SSL_EARLY_DATA_REPLAY_RECORD_LEN) == 0) {
+        goto exit;
+    }
+
+    slot = ssl_early_data_replay_find(ctx, header->current, binder);
+    if (memcmp(slot, binder, SSL_EARLY_DATA_REPLAY_RECORD_LEN) == 0 ||
+        header->count[header->current] >= header->max_entries) {
+        goto exit;
+    }
+
+    memcpy(slot, binder, SSL_EARLY_DATA_REPLAY_RECORD_LEN);
+    header->count[header->current]++;
+
+    ret = 0;
+
+exit:
+    if (ssl_early_data_replay_unlock(ctx) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+
+    return ret;
+}
+
+void mbedtls_ssl_early_data_replay_free(mbedtls_ssl_early_data_replay_context *ctx)
+{
+    if (ctx == NULL) {
+        return;
+    }
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    /* Other processes may still use the mutex, so it is not destroyed */
+    if (ctx->shared) {
+        (void) munmap(ctx->region, ctx->region_len);
+        ctx->region = NULL;
+    }
+#endif
+
+    if (ctx->region != NULL) {
+        mbedtls_zeroize_and_free(ctx->region, ctx->region_len);
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free(&ctx->mutex);
+#endif
+
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_ssl_early_data_replay_context));
+}
+
+#endif /* MBEDTLS_SSL_EARLY_DATA_REPLAY_C */
@@ -0,0 +1,210 @@
+/*
+ *  TLS 1.3 client-side cache of the groups selected by servers
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * The entries are kept in a chained list, most recently updated first,
+ * which is short enough on a client to be searched linearly.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_KEY_SHARE_CACHE_C)
+
+#include "mbedtls/platform.h"
+
+#include "mbedtls/ssl_key_share_cache.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+
+#include <string.h>
+
+void mbedtls_ssl_key_share_cache_init(mbedtls_ssl_key_share_cache_context *cache)
+{
+    memset(cache, 0, sizeof(mbedtls_ssl_key_share_cache_context));
+
+    cache->max_entries = MBEDTLS_SSL_KEY_SHARE_CACHE_DEFAULT_MAX_ENTRIES;
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init(&cache->mutex);
+#endif
+}
+
+/* Find the entry of a server, and count the entries before it. On return,
+ * `*p_entry` is the link to the entry, or the NULL link at the end of the
+ * chain if there is none. */
+static int ssl_key_share_cache_find(mbedtls_ssl_key_share_cache_context *cache,
+                                    const char *hostname, uint16_t port,
+                                    mbedtls_ssl_key_share_cache_entry ***p_entry)
+{
+    mbedtls_ssl_key_share_cache_entry **p;
+    int count = 0;
+
+    for (p = &cache->chain; *p != NULL; p = &(*p)->next) {
+        if ((*p)->port == port && strcmp((*p)->hostname, hostname) == 0) {
+            break;
+        }
+        count++;
+    }
+
+    *p_entry = p;
+    return count;
+}
+
+static void ssl_key_share_cache_entry_free(mbedtls_ssl_key_share_cache_entry *entry)
+{
+    mbedtls_free(entry->hostname);
+    mbedtls_free(entry);
+}
+
+int mbedtls_ssl_key_share_cache_get(void *p_cache,
+                                    const char *hostname,
+                                    uint16_t port,
+                                    uint16_t *group_id)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_key_share_cache_context *cache =
+        (mbedtls_ssl_key_share_cache_context *) p_cache;
+    mbedtls_ssl_key_share_cache_entry **p;
+
+    if (hostname == NULL || group_id == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&cache->mutex)) != 0) {
+        return ret;
+    }
+#endif
+
+    (void) ssl_key_share_cache_find(cache, hostname, port, &p);
+    if (*p == NULL) {
+        ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+    } else {
+        *group_id = (*p)->group_id;
+        ret = 0;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&cache->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    return ret;
+}
+
+int mbedtls_ssl_key_share_cache_set(void *p_cache,
+                                    const char *hostname,
+                                    uint16_t port,
+                                    uint16_t group_id)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_key_share_cache_context *cache =
+        (mbedtls_ssl_key_share_cache_context *) p_cache;
+    mbedtls_ssl_key_share_cache_entry *entry = NULL, **p;
+    size_t hostname_len;
+    int count;
+
+    if (hostname == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&cache->mutex)) != 0) {
+        return ret;
+    }
+#endif
+
+    count = ssl_key_share_cache_find(cache, hostname, port, &p);
+    if (*p != NULL) {
+        /* Move the entry to the front */
+        entry = *p;
+        *p = entry->next;
+    } else {
+        if (cache->max_entries == 0) {
+            ret = 0;
+            goto exit;
+        }
+
+        entry = mbedtls_calloc(1, sizeof(mbedtls_ssl_key_share_cache_entry));
+        if (entry == NULL) {
+            ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+            goto exit;
+        }
+
+        hostname_len = strlen(hostname) + 1;
+        entry->hostname = mbedtls_calloc(1, hostname_len);
+        if (entry->hostname == NULL) {
+            mbedtls_free(entry);
+            ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+            goto exit;
+        }
+        memcpy(entry->hostname, hostname, hostname_len);
+        entry->port = port;
+
+        /* Evict the entries updated least recently, at the end of the
+         * chain, to make room for the new one. */
+        if (count >= cache->max_entries) {
+            p = &cache->chain;
+            for (count = 1; count < cache->max_entries; count++) {
+                p = &(*p)->next;
+            }
+            while (*p != NULL) {
+                mbedtls_ssl_key_share_cache_entry *old = *p;
+                *p = old->next;
+                ssl_key_share_cache_entry_free(old);
+            }
+        }
+    }
+
+    entry->group_id = group_id;
+    entry->next = cache->chain;
+    cache->chain = entry;
+
+    ret = 0;
+
+exit:
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&cache->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    return ret;
+}
+
+void mbedtls_ssl_key_share_cache_set_max_entries(mbedtls_ssl_key_share_cache_context *cache,
+                                                 int max)
+{
+    if (max < 0) {
+        max = 0;
+    }
+
+    cache->max_entries = max;
+}
+
+void mbedtls_ssl_key_share_cache_free(mbedtls_ssl_key_share_cache_context *cache)
+{
+    mbedtls_ssl_key_share_cache_entry *cur, *prv;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    cur = cache->chain;
+    while (cur != NULL) {
+        prv = cur;
+        cur = cur->next;
+        ssl_key_share_cache_entry_free(prv);
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free(&cache->mutex);
+#endif
+    cache->chain = NULL;
+}
+
+#endif /* MBEDTLS_SSL_KEY_SHARE_CACHE_C */
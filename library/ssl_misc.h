@@ -13,6 +13,8 @@
 #include "mbedtls/build_info.h"
 
 #include "mbedtls/error.h"
+#include "mbedtls/platform.h"
+#include "mbedtls/platform_util.h"
 
 #include "mbedtls/ssl.h"
 #include "mbedtls/cipher.h"
@@ -49,6 +51,10 @@
 #include "pk_internal.h"
 #include "common.h"
 
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+#include "mbedtls/threading.h"
+#endif
+
 /* Shorthand for restartable ECC */
 #if defined(MBEDTLS_ECP_RESTARTABLE) && \
     defined(MBEDTLS_SSL_CLI_C) && \
@@ -655,6 +661,13 @@ struct mbedtls_ssl_handshake_params {
 #if defined(MBEDTLS_SSL_EARLY_DATA)
     /* Flag indicating if the server has accepted early data or not. */
     uint8_t early_data_accepted;
+#if defined(MBEDTLS_HAVE_TIME)
+    /* Binder of the ticket offered first by the client, and time at which
+     * its ClientHello was expected to arrive, for the anti-replay check. */
+    unsigned char early_data_binder[MBEDTLS_MD_MAX_SIZE];
+    uint8_t early_data_binder_len;
+    mbedtls_ms_time_t early_data_expected_arrival;
+#endif
 #endif
 #endif /* MBEDTLS_SSL_SRV_C */
 
@@ -945,6 +958,13 @@ struct mbedtls_ssl_handshake_params {
                                 * On the client: Defaults to the first
                                 * entry in the client's group list,
                                 * but can be overwritten by the HRR. */
+#if defined(MBEDTLS_SSL_CLI_C) && \
+    defined(MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED)
+    uint16_t extra_group_id;   /* On the client: the group of the second
+                                * key share of the first ClientHello, or 0
+                                * if only one key share was offered. */
+    mbedtls_svc_key_id_t extra_xxdh_psa_privkey; /* Its private key */
+#endif
 #endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
 
 #if defined(MBEDTLS_SSL_CLI_C)
@@ -1024,6 +1044,13 @@ struct mbedtls_ssl_handshake_params {
     void *user_async_ctx;
 #endif /* MBEDTLS_SSL_ASYNC_PRIVATE */
 
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+    unsigned char *arena;               /*!< memory for allocations made by
+                                             mbedtls_ssl_hs_calloc(), or NULL */
+    size_t arena_size;                  /*!< size of arena                  */
+    size_t arena_used;                  /*!< bytes of arena handed out      */
+#endif /* MBEDTLS_SSL_HANDSHAKE_ARENA */
+
 #if defined(MBEDTLS_SSL_SERVER_NAME_INDICATION)
     const unsigned char *sni_name;      /*!< raw SNI                        */
     size_t sni_name_len;                /*!< raw SNI len                    */
@@ -1162,6 +1189,15 @@ struct mbedtls_ssl_transform {
     unsigned char out_cid[MBEDTLS_SSL_CID_OUT_LEN_MAX];
 #endif /* MBEDTLS_SSL_DTLS_CONNECTION_ID */
 
+#if defined(MBEDTLS_SSL_KTLS)
+    /* Copy of the traffic keys, to hand record protection over to the
+     * kernel, see mbedtls_ssl_get_ktls_info() */
+    mbedtls_cipher_type_t cipher_type;
+    size_t keylen;
+    unsigned char key_enc[32];
+    unsigned char key_dec[32];
+#endif /* MBEDTLS_SSL_KTLS */
+
 #if defined(MBEDTLS_SSL_CONTEXT_SERIALIZATION)
     /* We need the Hello random bytes in order to re-derive keys from the
      * Master Secret and other session info,
@@ -1263,6 +1299,31 @@ struct mbedtls_ssl_flight_item {
 };
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+/*
+ * Complete outgoing records waiting to be sent with the next vectored send.
+ *
+ * Records are queued by swapping the output buffer with a spare one, so that
+ * the next record can be written as usual. Entries [0, count) hold queued
+ * records in sending order, the remaining ones hold spare buffers (or NULL)
+ * for later use.
+ */
+typedef struct {
+    unsigned char *buf;     /*!< buffer, of the size of the output buffer   */
+    size_t buf_len;         /*!< length of buf                              */
+    size_t off;             /*!< offset of the first byte not yet sent      */
+    size_t left;            /*!< number of bytes not yet sent               */
+} mbedtls_ssl_out_queue_item;
+
+struct mbedtls_ssl_out_queue {
+    mbedtls_ssl_out_queue_item item[MBEDTLS_SSL_OUT_QUEUE_LEN];
+    size_t count;           /*!< number of queued records                   */
+    size_t app_len;         /*!< application data accepted by the last
+                                 mbedtls_ssl_write() that could not send all
+                                 of its records yet, or 0                   */
+};
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
 #if defined(MBEDTLS_SSL_PROTO_TLS1_2)
 /**
  * \brief Given an SSL context and its associated configuration, write the TLS
@@ -1332,6 +1393,10 @@ int mbedtls_ssl_handshake_client_step(mbedtls_ssl_context *ssl);
 MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_handshake_server_step(mbedtls_ssl_context *ssl);
 void mbedtls_ssl_handshake_wrapup(mbedtls_ssl_context *ssl);
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+/* Give the current session to the session store, if there is one. */
+void mbedtls_ssl_store_session(mbedtls_ssl_context *ssl);
+#endif
 static inline void mbedtls_ssl_handshake_set_state(mbedtls_ssl_context *ssl,
                                                    mbedtls_ssl_states state)
 {
@@ -1466,6 +1531,138 @@ int mbedtls_ssl_write_record(mbedtls_ssl_context *ssl, int force_flush);
 MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_flush_output(mbedtls_ssl_context *ssl);
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+/*
+ * Return 1 if complete records are waiting in the output queue, 0 otherwise.
+ */
+static inline int mbedtls_ssl_out_queue_pending(const mbedtls_ssl_context *ssl)
+{
+    return ssl->out_queue != NULL && ssl->out_queue->count != 0;
+}
+
+/*
+ * Drop all queued records and free the output queue.
+ */
+void mbedtls_ssl_out_queue_free(mbedtls_ssl_context *ssl);
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+/* Size of a pool buffer: the input buffer followed by the output buffer */
+#define MBEDTLS_SSL_BUFFER_POOL_BUF_LEN \
+    ((MBEDTLS_SSL_IN_BUFFER_LEN) + (MBEDTLS_SSL_OUT_BUFFER_LEN))
+
+/*
+ * Borrow a buffer of MBEDTLS_SSL_BUFFER_POOL_BUF_LEN bytes from the pool.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+int mbedtls_ssl_buffer_pool_get(mbedtls_ssl_buffer_pool *pool,
+                                unsigned char **buf);
+
+/*
+ * Wipe a buffer obtained from mbedtls_ssl_buffer_pool_get() and return it.
+ */
+void mbedtls_ssl_buffer_pool_put(mbedtls_ssl_buffer_pool *pool,
+                                 unsigned char *buf);
+
+/*
+ * Make sure that a context using a buffer pool holds its I/O buffers.
+ * Must be called before accessing the record layer from a public function.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+int mbedtls_ssl_buffers_acquire(mbedtls_ssl_context *ssl);
+
+/*
+ * Return the I/O buffers of a context using a buffer pool if no data is in
+ * flight in either direction.
+ */
+void mbedtls_ssl_buffers_release_idle(mbedtls_ssl_context *ssl);
+#else
+static inline int mbedtls_ssl_buffers_acquire(mbedtls_ssl_context *ssl)
+{
+    (void) ssl;
+    return 0;
+}
+
+static inline void mbedtls_ssl_buffers_release_idle(mbedtls_ssl_context *ssl)
+{
+    (void) ssl;
+}
+#endif /* MBEDTLS_SSL_BUFFER_POOL_C */
+
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+/*
+ * Allocate zeroed memory that is only used until the current handshake
+ * completes, from the handshake arena if it has room left.
+ */
+void *mbedtls_ssl_hs_calloc(mbedtls_ssl_context *ssl, size_t n, size_t size);
+
+/*
+ * Free memory from mbedtls_ssl_hs_calloc(). Memory from the arena is only
+ * reclaimed when the handshake is freed.
+ */
+void mbedtls_ssl_hs_free(mbedtls_ssl_context *ssl, void *ptr);
+
+/*
+ * Wipe and free memory from mbedtls_ssl_hs_calloc().
+ */
+void mbedtls_ssl_hs_zeroize_and_free(mbedtls_ssl_context *ssl,
+                                     void *ptr, size_t len);
+
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+/*
+ * Free the handshake arena and everything allocated from it, for TLS 1.3
+ * which keeps the handshake parameters after the handshake.
+ */
+void mbedtls_ssl_handshake_arena_release(mbedtls_ssl_context *ssl);
+#endif
+#else
+static inline void mbedtls_ssl_handshake_arena_release(mbedtls_ssl_context *ssl)
+{
+    (void) ssl;
+}
+
+static inline void *mbedtls_ssl_hs_calloc(mbedtls_ssl_context *ssl,
+                                          size_t n, size_t size)
+{
+    (void) ssl;
+    return mbedtls_calloc(n, size);
+}
+
+static inline void mbedtls_ssl_hs_free(mbedtls_ssl_context *ssl, void *ptr)
+{
+    (void) ssl;
+    mbedtls_free(ptr);
+}
+
+static inline void mbedtls_ssl_hs_zeroize_and_free(mbedtls_ssl_context *ssl,
+                                                   void *ptr, size_t len)
+{
+    (void) ssl;
+    mbedtls_zeroize_and_free(ptr, len);
+}
+#endif /* MBEDTLS_SSL_HANDSHAKE_ARENA */
+
+/*
+ * FNV-1a hash, for the hash tables of the session caches and of the DTLS
+ * multiplexer. The seed is mixed into the offset basis: use a random seed
+ * when the peer chooses the hashed data, so that it cannot predict
+ * collisions, and 0 for data chosen at random by the library, such as
+ * session IDs.
+ */
+static inline uint32_t mbedtls_ssl_fnv1a(uint32_t seed,
+                                         const unsigned char *buf, size_t len)
+{
+    uint32_t h = 0x811C9DC5 ^ seed;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h ^= buf[i];
+        h *= 0x01000193;
+    }
+
+    return h;
+}
+
 MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_parse_certificate(mbedtls_ssl_context *ssl);
 MBEDTLS_CHECK_RETURN_CRITICAL
@@ -1823,6 +2020,20 @@ void mbedtls_ssl_pend_fatal_alert(mbedtls_ssl_context *ssl,
 
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
 void mbedtls_ssl_dtls_replay_reset(mbedtls_ssl_context *ssl);
+
+/*
+ * Number of 64-bit words of the anti-replay window in a serialized context.
+ * Word k holds the records in_window_top - 64 * k - n for n from 0 (lsb)
+ * to 63 (msb), so a window of 64 records keeps the format of a single
+ * bitmask.
+ */
+#define MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS \
+    ((MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX + 63) / 64)
+
+void mbedtls_ssl_dtls_replay_save(const mbedtls_ssl_context *ssl,
+                                  unsigned char *buf);
+void mbedtls_ssl_dtls_replay_load(mbedtls_ssl_context *ssl,
+                                  const unsigned char *buf);
 #endif
 
 void mbedtls_ssl_handshake_wrapup_free_hs_transform(mbedtls_ssl_context *ssl);
@@ -1835,7 +2046,8 @@ int mbedtls_ssl_start_renegotiation(mbedtls_ssl_context *ssl);
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
 size_t mbedtls_ssl_get_current_mtu(const mbedtls_ssl_context *ssl);
 void mbedtls_ssl_buffering_free(mbedtls_ssl_context *ssl);
-void mbedtls_ssl_flight_free(mbedtls_ssl_flight_item *flight);
+void mbedtls_ssl_flight_free(mbedtls_ssl_context *ssl,
+                             mbedtls_ssl_flight_item *flight);
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
 
 /**
@@ -2800,13 +3012,25 @@ int mbedtls_ssl_write_alpn_ext(mbedtls_ssl_context *ssl,
                                size_t *out_len);
 #endif /* MBEDTLS_SSL_ALPN */
 
-#if defined(MBEDTLS_TEST_HOOKS)
+#if (defined(MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE) || defined(MBEDTLS_SSL_DTLS_MUX_C)) && \
+    defined(MBEDTLS_SSL_SRV_C)
+/*
+ * Check if a datagram looks like a ClientHello with a valid cookie for the
+ * client identified by cli_id, and if it doesn't, write a HelloVerifyRequest
+ * to obuf. Only the cookie callbacks of ssl->conf are used.
+ *
+ * Return 0 if the cookie is valid, MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED if
+ * a HelloVerifyRequest was written, or another error code if the datagram
+ * is not a ClientHello.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
 int mbedtls_ssl_check_dtls_clihlo_cookie(
     mbedtls_ssl_context *ssl,
     const unsigned char *cli_id, size_t cli_id_len,
     const unsigned char *in, size_t in_len,
     unsigned char *obuf, size_t buf_len, size_t *olen);
-#endif
+#endif /* (MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE || MBEDTLS_SSL_DTLS_MUX_C) &&
+          MBEDTLS_SSL_SRV_C */
 
 #if defined(MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_PSK_ENABLED)
 /**
@@ -2980,4 +3204,57 @@ int mbedtls_ct_hmac(mbedtls_md_context_t *ctx,
 #endif /* defined(MBEDTLS_USE_PSA_CRYPTO) */
 #endif /* MBEDTLS_TEST_HOOKS && defined(MBEDTLS_SSL_SOME_SUITES_USE_MAC) */
 
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+/*
+ * Memory regions shared between processes, implemented in ssl_cache_shm.c.
+ *
+ * mbedtls_ssl_shm_map() maps \p len bytes of an anonymous region if \p path
+ * is NULL, or of the file \p path otherwise, creating it if needed. It then
+ * calls \p f_setup with a non-zero \c format argument if the region is new
+ * or if its first four bytes are not \p magic, in which case \p f_setup
+ * must initialize the region and write \p magic last, and with \c format
+ * set to 0 otherwise, in which case \p f_setup must check that the region
+ * has the expected layout. For a file, this happens while holding an
+ * exclusive lock on it.
+ *
+ * The magic is followed by #MBEDTLS_SSL_SHM_BOOT_ID_LEN bytes that
+ * mbedtls_ssl_shm_map() fills with an identifier of the current boot of the
+ * system. A file formatted before the system rebooted may hold mutexes
+ * locked by processes that no longer exist, so it is formatted again. A
+ * region to format is always full of zeros, except for the boot identifier.
+ *
+ * The mutexes are robust and process-shared. mbedtls_ssl_shm_mutex_lock()
+ * sets \p owner_died if the previous owner died while holding the mutex,
+ * in which case the caller must repair the state that the mutex protects.
+ */
+#define MBEDTLS_SSL_SHM_BOOT_ID_LEN 36   /* a UUID in text form */
+
+MBEDTLS_CHECK_RETURN_CRITICAL
+int mbedtls_ssl_shm_map(const char *path, size_t len, uint32_t magic,
+                        int (*f_setup)(void *, unsigned char *, int),
+                        void *p_setup,
+                        unsigned char **region, size_t *region_len);
+MBEDTLS_CHECK_RETURN_CRITICAL
+int mbedtls_ssl_shm_mutex_init(pthread_mutex_t *mutex);
+MBEDTLS_CHECK_RETURN_CRITICAL
+int mbedtls_ssl_shm_mutex_lock(pthread_mutex_t *mutex, int *owner_died);
+int mbedtls_ssl_shm_mutex_unlock(pthread_mutex_t *mutex);
+#endif /* MBEDTLS_SSL_CACHE_SHM_C */
+
+#if defined(MBEDTLS_SSL_CACHE_SHM_C) && defined(MBEDTLS_TEST_HOOKS)
+/* Called by mbedtls_ssl_cache_shm_set() halfway through writing a slot, so
+ * that tests can make a process die with a stripe locked. */
+extern void (*mbedtls_ssl_cache_shm_test_hook_write)(void);
+
+/* Called by mbedtls_ssl_shm_map() instead of reading the boot identifier of
+ * the system, so that tests can simulate a reboot. */
+extern void (*mbedtls_ssl_shm_test_hook_boot_id)(unsigned char *boot_id);
+#endif
+
+#if defined(MBEDTLS_SSL_EARLY_DATA_REPLAY_C) && defined(MBEDTLS_TEST_HOOKS)
+/* Called by the early data anti-replay store instead of mbedtls_ms_time(),
+ * so that tests can control its clock. */
+extern mbedtls_ms_time_t (*mbedtls_ssl_early_data_replay_test_hook_time)(void);
+#endif
+
 #endif /* ssl_misc.h */
@@ -2137,10 +2137,11 @@ hmac_failed_etm_disabled:
  *
  * With stream transport (TLS) on success ssl->in_left == nb_want, but
  * with datagram transport (DTLS) on success ssl->in_left >= nb_want,
- * since we always read a whole datagram at once.
+ * since we always read a whole datagram at once. The same holds for TLS
+ * with read-ahead, where we read as much as fits in the buffer.
  *
- * For DTLS, it is up to the caller to set ssl->next_record_offset when
- * they're done reading a record.
+ * For DTLS and TLS with read-ahead, it is up to the caller to set
+ * ssl->next_record_offset when they're done reading a record.
  */
 int mbedtls_ssl_fetch_input(mbedtls_ssl_context *ssl, size_t nb_want)
 {
@@ -2292,6 +2293,29 @@ int mbedtls_ssl_fetch_input(mbedtls_ssl_context *ssl, size_t nb_want)
     } else
 #endif
     {
+        /*
+         * Move to the next record in the data read ahead if applicable
+         */
+        if (ssl->next_record_offset != 0) {
+            if (ssl->in_left < ssl->next_record_offset) {
+                MBEDTLS_SSL_DEBUG_MSG(1, ("should never happen"));
+                return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+            }
+
+            ssl->in_left -= ssl->next_record_offset;
+
+            if (ssl->in_left != 0) {
+                MBEDTLS_SSL_DEBUG_MSG(2, ("next record read ahead, offset: %"
+                                          MBEDTLS_PRINTF_SIZET,
+                                          ssl->next_record_offset));
+                memmove(ssl->in_hdr,
+                        ssl->in_hdr + ssl->next_record_offset,
+                        ssl->in_left);
+            }
+
+            ssl->next_record_offset = 0;
+        }
+
         MBEDTLS_SSL_DEBUG_MSG(2, ("in_left: %" MBEDTLS_PRINTF_SIZET
                                   ", nb_want: %" MBEDTLS_PRINTF_SIZET,
                                   ssl->in_left, nb_want));
@@ -2299,6 +2323,21 @@ int mbedtls_ssl_fetch_input(mbedtls_ssl_context *ssl, size_t nb_want)
         while (ssl->in_left < nb_want) {
             len = nb_want - ssl->in_left;
 
+            /* With read-ahead, fill the buffer to serve further records */
+            if (ssl->conf->read_ahead == MBEDTLS_SSL_READ_AHEAD_ENABLED) {
+                len = in_buf_len - (size_t) (ssl->in_hdr - ssl->in_buf) -
+                      ssl->in_left;
+            }
+
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+            /* Records held back must leave before waiting for the peer */
+            if (mbedtls_ssl_out_queue_pending(ssl) &&
+                (ret = mbedtls_ssl_flush_output(ssl)) != 0) {
+                MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_flush_output", ret);
+                return ret;
+            }
+#endif
+
             if (mbedtls_ssl_check_timer(ssl) != 0) {
                 ret = MBEDTLS_ERR_SSL_TIMEOUT;
             } else {
@@ -2342,6 +2381,261 @@ int mbedtls_ssl_fetch_input(mbedtls_ssl_context *ssl, size_t nb_want)
     return 0;
 }
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+void mbedtls_ssl_out_queue_free(mbedtls_ssl_context *ssl)
+{
+    size_t i;
+
+    if (ssl->out_queue == NULL) {
+        return;
+    }
+
+    for (i = 0; i < MBEDTLS_SSL_OUT_QUEUE_LEN; i++) {
+        mbedtls_zeroize_and_free(ssl->out_queue->item[i].buf,
+                                 ssl->out_queue->item[i].buf_len);
+    }
+
+    mbedtls_free(ssl->out_queue);
+    ssl->out_queue = NULL;
+}
+
+/*
+ * Make sure that at least n spare buffers are available after the queued
+ * records. Return the number of spare buffers that are available, which may
+ * be less than n if the queue is too short or on allocation failure.
+ */
+static size_t ssl_out_queue_reserve(mbedtls_ssl_context *ssl, size_t n)
+{
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t out_buf_len = ssl->out_buf_len;
+#else
+    size_t out_buf_len = MBEDTLS_SSL_OUT_BUFFER_LEN;
+#endif
+    mbedtls_ssl_out_queue *queue;
+    size_t i;
+
+    if (ssl->out_queue == NULL) {
+        ssl->out_queue = mbedtls_calloc(1, sizeof(mbedtls_ssl_out_queue));
+        if (ssl->out_queue == NULL) {
+            return 0;
+        }
+    }
+    queue = ssl->out_queue;
+
+    if (n > MBEDTLS_SSL_OUT_QUEUE_LEN - queue->count) {
+        n = MBEDTLS_SSL_OUT_QUEUE_LEN - queue->count;
+    }
+
+    for (i = queue->count; i < queue->count + n; i++) {
+        mbedtls_ssl_out_queue_item *item = &queue->item[i];
+
+        /* The output buffer may have been resized since */
+        if (item->buf != NULL && item->buf_len != out_buf_len) {
+            mbedtls_zeroize_and_free(item->buf, item->buf_len);
+            item->buf = NULL;
+        }
+
+        if (item->buf == NULL) {
+            item->buf = mbedtls_calloc(1, out_buf_len);
+            if (item->buf == NULL) {
+                MBEDTLS_SSL_DEBUG_MSG(1, ("alloc(%" MBEDTLS_PRINTF_SIZET
+                                          " bytes) failed", out_buf_len));
+                break;
+            }
+            item->buf_len = out_buf_len;
+        }
+    }
+
+    return i - queue->count;
+}
+
+/*
+ * Move the records waiting in the output buffer to the end of the queue, and
+ * continue with an empty spare buffer as output buffer.
+ *
+ * Return 0 on success, or MBEDTLS_ERR_SSL_ALLOC_FAILED if the queue is full
+ * or no spare buffer could be allocated, in which case the records are still
+ * in the output buffer.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_out_queue_push(mbedtls_ssl_context *ssl)
+{
+    mbedtls_ssl_out_queue_item *item;
+    unsigned char *buf;
+
+    if (ssl->out_left == 0) {
+        return 0;
+    }
+
+    if (ssl_out_queue_reserve(ssl, 1) == 0) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    item = &ssl->out_queue->item[ssl->out_queue->count++];
+    buf = ssl->out_buf;
+    ssl->out_buf = item->buf;
+    item->buf = buf;
+    item->off = (size_t) (ssl->out_hdr - ssl->out_left - buf);
+    item->left = ssl->out_left;
+
+    /* Only used with TLS, where the record counter precedes the header */
+    ssl->out_left = 0;
+    ssl->out_ctr = ssl->out_buf;
+    ssl->out_hdr = ssl->out_buf + 8;
+    mbedtls_ssl_update_out_pointers(ssl, ssl->transform_out);
+
+    MBEDTLS_SSL_DEBUG_MSG(3, ("queued %" MBEDTLS_PRINTF_SIZET " bytes of records, "
+                              "%" MBEDTLS_PRINTF_SIZET " queued buffer(s)",
+                              item->left, ssl->out_queue->count));
+
+    return 0;
+}
+
+/*
+ * Send the queued records, followed by the content of the output buffer,
+ * with as few calls to the send callbacks as possible. Return 0 once the
+ * queue is empty; the output buffer may still hold data to send then.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_out_queue_send(mbedtls_ssl_context *ssl)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_out_queue *queue = ssl->out_queue;
+    mbedtls_ssl_out_queue_item sent[MBEDTLS_SSL_OUT_QUEUE_LEN];
+    mbedtls_ssl_iovec iov[MBEDTLS_SSL_OUT_QUEUE_LEN + 1];
+    size_t i, iovcnt, total, done;
+
+    while (queue->count > 0) {
+        total = 0;
+        for (i = 0; i < queue->count; i++) {
+            iov[i].base = queue->item[i].buf + queue->item[i].off;
+            iov[i].len = queue->item[i].left;
+            total += iov[i].len;
+        }
+        iovcnt = queue->count;
+
+        if (ssl->out_left != 0) {
+            iov[iovcnt].base = ssl->out_hdr - ssl->out_left;
+            iov[iovcnt].len = ssl->out_left;
+            total += ssl->out_left;
+            iovcnt++;
+        }
+
+        MBEDTLS_SSL_DEBUG_MSG(2, ("queued records: %" MBEDTLS_PRINTF_SIZET
+                                  ", bytes: %" MBEDTLS_PRINTF_SIZET,
+                                  iovcnt, total));
+
+        if (ssl->f_send_vec != NULL) {
+            ret = ssl->f_send_vec(ssl->p_bio, iov, iovcnt);
+            MBEDTLS_SSL_DEBUG_RET(2, "ssl->f_send_vec", ret);
+        } else {
+            ret = ssl->f_send(ssl->p_bio, iov[0].base, iov[0].len);
+            MBEDTLS_SSL_DEBUG_RET(2, "ssl->f_send", ret);
+        }
+
+        if (ret <= 0) {
+            return ret;
+        }
+
+        if ((size_t) ret > total) {
+            MBEDTLS_SSL_DEBUG_MSG(1,
+                                  ("f_send returned %d bytes but only %" MBEDTLS_PRINTF_SIZET
+                                   " bytes were sent",
+                                   ret, total));
+            return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+        }
+
+        /* Consume what was sent, and recycle the buffers that are done */
+        total = (size_t) ret;
+        for (done = 0; done < queue->count; done++) {
+            if (total < queue->item[done].left) {
+                queue->item[done].off += total;
+                queue->item[done].left -= total;
+                total = 0;
+                break;
+            }
+            total -= queue->item[done].left;
+            queue->item[done].off = 0;
+            queue->item[done].left = 0;
+        }
+        ssl->out_left -= total;
+
+        if (done > 0) {
+            memcpy(sent, queue->item, done * sizeof(sent[0]));
+            memmove(queue->item, queue->item + done,
+                    (queue->count - done) * sizeof(sent[0]));
+            memcpy(queue->item + queue->count - done, sent,
+                   done * sizeof(sent[0]));
+            queue->count -= done;
+        }
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
+#if defined(MBEDTLS_SSL_KTLS)
+/*
+ * Flush output when record protection is done by the kernel: the output
+ * buffer holds plaintext records, whose content is passed to f_ktls_send
+ * along with their type. Record headers are not sent.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_ktls_flush_output(mbedtls_ssl_context *ssl)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const size_t hdr_len = mbedtls_ssl_out_hdr_len(ssl);
+    unsigned char *buf, *rec;
+    size_t content_len, len;
+
+    while (ssl->out_left > 0) {
+        buf = ssl->out_hdr - ssl->out_left;
+
+        /* Find the record buf points into: records are laid out
+         * back-to-back from the start of the output buffer. */
+        rec = ssl->out_buf + 8;
+        for (;;) {
+            content_len = MBEDTLS_GET_UINT16_BE(rec, 3);
+            if (buf < rec + hdr_len + content_len) {
+                break;
+            }
+            rec += hdr_len + content_len;
+        }
+
+        if (buf < rec + hdr_len) {
+            ssl->out_left -= (size_t) (rec + hdr_len - buf);
+            continue;
+        }
+
+        len = (size_t) (rec + hdr_len + content_len - buf);
+        ret = ssl->f_ktls_send(ssl->p_bio, rec[0], buf, len);
+
+        MBEDTLS_SSL_DEBUG_RET(2, "ssl->f_ktls_send", ret);
+
+        if (ret <= 0) {
+            return ret;
+        }
+
+        if ((size_t) ret > len) {
+            MBEDTLS_SSL_DEBUG_MSG(1,
+                                  ("f_ktls_send returned %d bytes but only %" MBEDTLS_PRINTF_SIZET
+                                   " bytes were sent",
+                                   ret, len));
+            return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+        }
+
+        ssl->out_left -= ret;
+    }
+
+    ssl->out_hdr = ssl->out_buf + 8;
+    mbedtls_ssl_update_out_pointers(ssl, ssl->transform_out);
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("<= flush output"));
+
+    return 0;
+}
+#endif /* MBEDTLS_SSL_KTLS */
+
 /*
  * Flush any data not yet written
  */
@@ -2352,11 +2646,24 @@ int mbedtls_ssl_flush_output(mbedtls_ssl_context *ssl)
 
     MBEDTLS_SSL_DEBUG_MSG(2, ("=> flush output"));
 
+#if defined(MBEDTLS_SSL_KTLS)
+    if (ssl->ktls & MBEDTLS_SSL_KTLS_TX) {
+        return ssl_ktls_flush_output(ssl);
+    }
+#endif
+
     if (ssl->f_send == NULL) {
         MBEDTLS_SSL_DEBUG_MSG(1, ("Bad usage of mbedtls_ssl_set_bio() "));
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    if (mbedtls_ssl_out_queue_pending(ssl)) {
+        if ((ret = ssl_out_queue_send(ssl)) != 0) {
+            return ret;
+        }
+    } else
+#endif
     /* Avoid incrementing counter if data is flushed */
     if (ssl->out_left == 0) {
         MBEDTLS_SSL_DEBUG_MSG(2, ("<= flush output"));
@@ -2419,16 +2726,17 @@ static int ssl_flight_append(mbedtls_ssl_context *ssl)
                           ssl->out_msg, ssl->out_msglen);
 
     /* Allocate space for current message */
-    if ((msg = mbedtls_calloc(1, sizeof(mbedtls_ssl_flight_item))) == NULL) {
+    if ((msg = mbedtls_ssl_hs_calloc(ssl, 1,
+                                     sizeof(mbedtls_ssl_flight_item))) == NULL) {
         MBEDTLS_SSL_DEBUG_MSG(1, ("alloc %" MBEDTLS_PRINTF_SIZET " bytes failed",
                                   sizeof(mbedtls_ssl_flight_item)));
         return MBEDTLS_ERR_SSL_ALLOC_FAILED;
     }
 
-    if ((msg->p = mbedtls_calloc(1, ssl->out_msglen)) == NULL) {
+    if ((msg->p = mbedtls_ssl_hs_calloc(ssl, 1, ssl->out_msglen)) == NULL) {
         MBEDTLS_SSL_DEBUG_MSG(1, ("alloc %" MBEDTLS_PRINTF_SIZET " bytes failed",
                                   ssl->out_msglen));
-        mbedtls_free(msg);
+        mbedtls_ssl_hs_free(ssl, msg);
         return MBEDTLS_ERR_SSL_ALLOC_FAILED;
     }
 
@@ -2456,7 +2764,8 @@ static int ssl_flight_append(mbedtls_ssl_context *ssl)
 /*
  * Free the current flight of handshake messages
  */
-void mbedtls_ssl_flight_free(mbedtls_ssl_flight_item *flight)
+void mbedtls_ssl_flight_free(mbedtls_ssl_context *ssl,
+                             mbedtls_ssl_flight_item *flight)
 {
     mbedtls_ssl_flight_item *cur = flight;
     mbedtls_ssl_flight_item *next;
@@ -2464,8 +2773,8 @@ void mbedtls_ssl_flight_free(mbedtls_ssl_flight_item *flight)
     while (cur != NULL) {
         next = cur->next;
 
-        mbedtls_free(cur->p);
-        mbedtls_free(cur);
+        mbedtls_ssl_hs_free(ssl, cur->p);
+        mbedtls_ssl_hs_free(ssl, cur);
 
         cur = next;
     }
@@ -2687,7 +2996,7 @@ int mbedtls_ssl_flight_transmit(mbedtls_ssl_context *ssl)
 void mbedtls_ssl_recv_flight_completed(mbedtls_ssl_context *ssl)
 {
     /* We won't need to resend that one any more */
-    mbedtls_ssl_flight_free(ssl->handshake->flight);
+    mbedtls_ssl_flight_free(ssl, ssl->handshake->flight);
     ssl->handshake->flight = NULL;
     ssl->handshake->cur_msg = NULL;
 
@@ -2939,9 +3248,22 @@ int mbedtls_ssl_write_record(mbedtls_ssl_context *ssl, int force_flush)
     int ret, done = 0;
     size_t len = ssl->out_msglen;
     int flush = force_flush;
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    /* Hold handshake records back, to send the whole flight at once */
+    const int hold = ssl->f_send_vec != NULL &&
+                     ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM &&
+                     ssl->handshake != NULL &&
+                     ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER &&
+                     (ssl->out_msgtype == MBEDTLS_SSL_MSG_HANDSHAKE ||
+                      ssl->out_msgtype == MBEDTLS_SSL_MSG_CHANGE_CIPHER_SPEC);
+#endif
 
     MBEDTLS_SSL_DEBUG_MSG(2, ("=> write record"));
 
+    /* Any record written reuses out_msg, ending a zero-copy reservation */
+    ssl->out_reserved = 0;
+    ssl->out_commit_pending = 0;
+
     if (!done) {
         unsigned i;
         size_t protected_record_size;
@@ -3071,6 +3393,14 @@ int mbedtls_ssl_write_record(mbedtls_ssl_context *ssl, int force_flush)
     }
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    if (hold) {
+        /* If the queue is full, send it along with this record */
+        flush = ssl_out_queue_push(ssl) == 0 ?
+                SSL_DONT_FORCE_FLUSH : SSL_FORCE_FLUSH;
+    }
+#endif
+
     if ((flush == SSL_FORCE_FLUSH) &&
         (ret = mbedtls_ssl_flush_output(ssl)) != 0) {
         MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_flush_output", ret);
@@ -3348,18 +3678,26 @@ int mbedtls_ssl_update_handshake_status(mbedtls_ssl_context *ssl)
 /*
  * DTLS anti-replay: RFC 6347 4.1.2.6
  *
- * in_window is a field of bits numbered from 0 (lsb) to 63 (msb).
- * Bit n is set iff record number in_window_top - n has been seen.
+ * in_window is a circular bitmap of 64-bit words, as in RFC 6479: record
+ * number n is tracked by bit n % 64 of word (n / 64) % WORDS. The words
+ * hold the records of the word of in_window_top and of the WORDS - 1 words
+ * before it, which is enough for a window of MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX
+ * records whatever its alignment. Sliding the window only clears the words
+ * it moves over, each at most once per 64 records, so checks and updates
+ * take constant time on average, independently of the size of the window.
  *
- * Usually, in_window_top is the last record number seen and the lsb of
- * in_window is set. The only exception is the initial state (record number 0
- * not seen yet).
+ * Usually, in_window_top is the last record number seen and its bit is set.
+ * The only exception is the initial state (record number 0 not seen yet).
  */
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
+#define SSL_DTLS_REPLAY_WORD(n) \
+    (((n) / 64) % MBEDTLS_SSL_DTLS_REPLAY_WINDOW_WORDS)
+#define SSL_DTLS_REPLAY_BIT(n)  ((uint64_t) 1 << ((n) % 64))
+
 void mbedtls_ssl_dtls_replay_reset(mbedtls_ssl_context *ssl)
 {
     ssl->in_window_top = 0;
-    ssl->in_window = 0;
+    memset(ssl->in_window, 0, sizeof(ssl->in_window));
 }
 
 static inline uint64_t ssl_load_six_bytes(unsigned char *buf)
@@ -3398,7 +3736,6 @@ static int mbedtls_ssl_dtls_record_replay_check(mbedtls_ssl_context *ssl, uint8_
 int mbedtls_ssl_dtls_replay_check(mbedtls_ssl_context const *ssl)
 {
     uint64_t rec_seqnum = ssl_load_six_bytes(ssl->in_ctr + 2);
-    uint64_t bit;
 
     if (ssl->conf->anti_replay == MBEDTLS_SSL_ANTI_REPLAY_DISABLED) {
         return 0;
@@ -3408,13 +3745,12 @@ int mbedtls_ssl_dtls_replay_check(mbedtls_ssl_context const *ssl)
         return 0;
     }
 
-    bit = ssl->in_window_top - rec_seqnum;
-
-    if (bit >= 64) {
+    if (ssl->in_window_top - rec_seqnum >= ssl->conf->replay_window) {
         return -1;
     }
 
-    if ((ssl->in_window & ((uint64_t) 1 << bit)) != 0) {
+    if ((ssl->in_window[SSL_DTLS_REPLAY_WORD(rec_seqnum)] &
+         SSL_DTLS_REPLAY_BIT(rec_seqnum)) != 0) {
         return -1;
     }
 
@@ -3433,29 +3769,85 @@ void mbedtls_ssl_dtls_replay_update(mbedtls_ssl_context *ssl)
     }
 
     if (rec_seqnum > ssl->in_window_top) {
-        /* Update window_top and the contents of the window */
-        uint64_t shift = rec_seqnum - ssl->in_window_top;
+        /* Clear the words the window slides over, then update window_top */
+        uint64_t word = ssl->in_window_top / 64;
+        uint64_t shift = rec_seqnum / 64 - word;
 
-        if (shift >= 64) {
-            ssl->in_window = 1;
-        } else {
-            ssl->in_window <<= shift;
-            ssl->in_window |= 1;
+        if (shift > MBEDTLS_SSL_DTLS_REPLAY_WINDOW_WORDS) {
+            shift = MBEDTLS_SSL_DTLS_REPLAY_WINDOW_WORDS;
+        }
+        while (shift-- > 0) {
+            word++;
+            ssl->in_window[word % MBEDTLS_SSL_DTLS_REPLAY_WINDOW_WORDS] = 0;
         }
 
         ssl->in_window_top = rec_seqnum;
-    } else {
-        /* Mark that number as seen in the current window */
-        uint64_t bit = ssl->in_window_top - rec_seqnum;
+    } else if (ssl->in_window_top - rec_seqnum >= ssl->conf->replay_window) {
+        /* Never true after a successful check, but be extra sure */
+        return;
+    }
+
+    /* Mark that number as seen in the current window */
+    ssl->in_window[SSL_DTLS_REPLAY_WORD(rec_seqnum)] |=
+        SSL_DTLS_REPLAY_BIT(rec_seqnum);
+}
+
+/*
+ * Serialize the window as MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS words relative
+ * to in_window_top, so that the format doesn't depend on its alignment.
+ */
+void mbedtls_ssl_dtls_replay_save(const mbedtls_ssl_context *ssl,
+                                  unsigned char *buf)
+{
+    uint64_t word = 0;
+    uint64_t n;
+    size_t i;
 
-        if (bit < 64) { /* Always true, but be extra sure */
-            ssl->in_window |= (uint64_t) 1 << bit;
+    for (i = 0; i < MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS * 64; i++) {
+        if (i <= ssl->in_window_top) {
+            n = ssl->in_window_top - i;
+            if ((ssl->in_window[SSL_DTLS_REPLAY_WORD(n)] &
+                 SSL_DTLS_REPLAY_BIT(n)) != 0) {
+                word |= (uint64_t) 1 << (i % 64);
+            }
+        }
+
+        if (i % 64 == 63) {
+            MBEDTLS_PUT_UINT64_BE(word, buf, 8 * (i / 64));
+            word = 0;
+        }
+    }
+}
+
+/*
+ * Restore a window serialized by mbedtls_ssl_dtls_replay_save(), once
+ * in_window_top has been restored.
+ */
+void mbedtls_ssl_dtls_replay_load(mbedtls_ssl_context *ssl,
+                                  const unsigned char *buf)
+{
+    uint64_t word = 0;
+    uint64_t n;
+    size_t i;
+
+    memset(ssl->in_window, 0, sizeof(ssl->in_window));
+
+    for (i = 0; i < MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS * 64 &&
+         i <= ssl->in_window_top; i++) {
+        if (i % 64 == 0) {
+            word = MBEDTLS_GET_UINT64_BE(buf, 8 * (i / 64));
+        }
+
+        if ((word & ((uint64_t) 1 << (i % 64))) != 0) {
+            n = ssl->in_window_top - i;
+            ssl->in_window[SSL_DTLS_REPLAY_WORD(n)] |= SSL_DTLS_REPLAY_BIT(n);
         }
     }
 }
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
-#if defined(MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE) && defined(MBEDTLS_SSL_SRV_C)
+#if (defined(MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE) || defined(MBEDTLS_SSL_DTLS_MUX_C)) && \
+    defined(MBEDTLS_SSL_SRV_C)
 /*
  * Check if a datagram looks like a ClientHello with a valid cookie,
  * and if it doesn't, generate a HelloVerifyRequest message.
@@ -3467,8 +3859,6 @@ void mbedtls_ssl_dtls_replay_update(mbedtls_ssl_context *ssl)
  *   return MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED
  * - otherwise return a specific error code
  */
-MBEDTLS_CHECK_RETURN_CRITICAL
-MBEDTLS_STATIC_TESTABLE
 int mbedtls_ssl_check_dtls_clihlo_cookie(
     mbedtls_ssl_context *ssl,
     const unsigned char *cli_id, size_t cli_id_len,
@@ -3602,7 +3992,10 @@ int mbedtls_ssl_check_dtls_clihlo_cookie(
 
     return MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED;
 }
+#endif /* (MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE || MBEDTLS_SSL_DTLS_MUX_C) &&
+          MBEDTLS_SSL_SRV_C */
 
+#if defined(MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE) && defined(MBEDTLS_SSL_SRV_C)
 /*
  * Handle possible client reconnect with the same UDP quadruplet
  * (RFC 6347 Section 4.2.8).
@@ -4534,7 +4927,7 @@ static int ssl_buffer_message(mbedtls_ssl_context *ssl)
                                        MBEDTLS_PRINTF_SIZET,
                                        msg_len));
 
-                hs_buf->data = mbedtls_calloc(1, reassembly_buf_sz);
+                hs_buf->data = mbedtls_ssl_hs_calloc(ssl, 1, reassembly_buf_sz);
                 if (hs_buf->data == NULL) {
                     ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
                     goto exit;
@@ -4709,7 +5102,7 @@ static void ssl_free_buffered_record(mbedtls_ssl_context *ssl)
         hs->buffering.total_bytes_buffered -=
             hs->buffering.future_record.len;
 
-        mbedtls_free(hs->buffering.future_record.data);
+        mbedtls_ssl_hs_free(ssl, hs->buffering.future_record.data);
         hs->buffering.future_record.data = NULL;
     }
 }
@@ -4819,7 +5212,7 @@ static int ssl_buffer_future_record(mbedtls_ssl_context *ssl,
     hs->buffering.future_record.len   = rec->buf_len;
 
     hs->buffering.future_record.data =
-        mbedtls_calloc(1, hs->buffering.future_record.len);
+        mbedtls_ssl_hs_calloc(ssl, 1, hs->buffering.future_record.len);
     if (hs->buffering.future_record.data == NULL) {
         /* If we run out of RAM trying to buffer a
          * record from the next epoch, just ignore. */
@@ -4834,12 +5227,81 @@ static int ssl_buffer_future_record(mbedtls_ssl_context *ssl,
 
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
 
+#if defined(MBEDTLS_SSL_KTLS)
+/*
+ * Read the next record when record protection is done by the kernel:
+ * f_ktls_recv returns the plaintext content and type of the record.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_ktls_get_next_record(mbedtls_ssl_context *ssl)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    int type = 0;
+    size_t len;
+#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
+    size_t in_buf_len = ssl->in_buf_len;
+#else
+    size_t in_buf_len = MBEDTLS_SSL_IN_BUFFER_LEN;
+#endif
+
+    mbedtls_ssl_update_in_pointers(ssl);
+
+    len = in_buf_len - (size_t) (ssl->in_msg - ssl->in_buf);
+    if (len > MBEDTLS_SSL_IN_CONTENT_LEN) {
+        len = MBEDTLS_SSL_IN_CONTENT_LEN;
+    }
+
+    ret = ssl->f_ktls_recv(ssl->p_bio, &type, ssl->in_msg, len);
+
+    MBEDTLS_SSL_DEBUG_RET(2, "ssl->f_ktls_recv", ret);
+
+    if (ret == 0) {
+        return MBEDTLS_ERR_SSL_CONN_EOF;
+    }
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    if ((size_t) ret > len) {
+        MBEDTLS_SSL_DEBUG_MSG(1,
+                              ("f_ktls_recv returned %d bytes but only %" MBEDTLS_PRINTF_SIZET
+                               " were requested",
+                               ret, len));
+        return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+    }
+
+    if (type != MBEDTLS_SSL_MSG_HANDSHAKE &&
+        type != MBEDTLS_SSL_MSG_ALERT &&
+        type != MBEDTLS_SSL_MSG_CHANGE_CIPHER_SPEC &&
+        type != MBEDTLS_SSL_MSG_APPLICATION_DATA) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("unknown record type %d", type));
+        return MBEDTLS_ERR_SSL_INVALID_RECORD;
+    }
+
+    MBEDTLS_SSL_DEBUG_BUF(4, "input record from kernel", ssl->in_msg, (size_t) ret);
+
+    ssl->in_msgtype = type;
+    ssl->in_hdr[0] = (unsigned char) type;
+    ssl->in_msglen = (size_t) ret;
+    MBEDTLS_PUT_UINT16_BE(ret, ssl->in_len, 0);
+
+    return 0;
+}
+#endif /* MBEDTLS_SSL_KTLS */
+
 MBEDTLS_CHECK_RETURN_CRITICAL
 static int ssl_get_next_record(mbedtls_ssl_context *ssl)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_record rec;
 
+#if defined(MBEDTLS_SSL_KTLS)
+    if (ssl->ktls & MBEDTLS_SSL_KTLS_RX) {
+        return ssl_ktls_get_next_record(ssl);
+    }
+#endif
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     /* We might have buffered a future record; if so,
      * and if the epoch matches now, load it.
@@ -4940,7 +5402,12 @@ static int ssl_get_next_record(mbedtls_ssl_context *ssl)
             return ret;
         }
 
-        ssl->in_left = 0;
+        if (ssl->conf->read_ahead == MBEDTLS_SSL_READ_AHEAD_ENABLED) {
+            /* Remember offset of next record within data read ahead. */
+            ssl->next_record_offset = rec.buf_len;
+        } else {
+            ssl->in_left = 0;
+        }
     }
 
     /*
@@ -5161,6 +5628,10 @@ int mbedtls_ssl_send_alert_message(mbedtls_ssl_context *ssl,
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
+    if ((ret = mbedtls_ssl_buffers_acquire(ssl)) != 0) {
+        return ret;
+    }
+
     if (ssl->out_left != 0) {
         return mbedtls_ssl_flush_output(ssl);
     }
@@ -5413,6 +5884,19 @@ int mbedtls_ssl_check_pending(const mbedtls_ssl_context *ssl)
     }
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
 
+    /*
+     * Case B': Further data was read ahead after the current record.
+     * Data read ahead before a record is complete doesn't count, as it
+     * can't be processed before more data arrives.
+     */
+
+    if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM &&
+        ssl->next_record_offset != 0 &&
+        ssl->in_left > ssl->next_record_offset) {
+        MBEDTLS_SSL_DEBUG_MSG(3, ("ssl_check_pending: more data read ahead"));
+        return 1;
+    }
+
     /*
      * Case C: A handshake message is being processed.
      */
@@ -5730,30 +6214,21 @@ static int ssl_handle_hs_message_post_handshake(mbedtls_ssl_context *ssl)
 }
 
 /*
- * brief          Read at most 'len' application data bytes from the input
- *                buffer.
+ * brief          Mark 'n' application data bytes of the input buffer as
+ *                consumed.
  *
  * param ssl      SSL context:
  *                - First byte of application data not read yet in the input
  *                  buffer located at address `in_offt`.
  *                - The number of bytes of data not read yet is `in_msglen`.
- * param buf      buffer that will hold the data
- * param len      maximum number of bytes to read
+ * param n        number of bytes consumed, at most `in_msglen`
  *
  * note           The function updates the fields `in_offt` and `in_msglen`
- *                according to the number of bytes read.
- *
- * return         The number of bytes read.
+ *                according to the number of bytes consumed.
  */
-static int ssl_read_application_data(
-    mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+static void ssl_consume_application_data(mbedtls_ssl_context *ssl, size_t n)
 {
-    size_t n = (len < ssl->in_msglen) ? len : ssl->in_msglen;
-
-    if (len != 0) {
-        memcpy(buf, ssl->in_offt, n);
-        ssl->in_msglen -= n;
-    }
+    ssl->in_msglen -= n;
 
     /* Zeroising the plaintext buffer to erase unused application data
        from the memory. */
@@ -5767,23 +6242,51 @@ static int ssl_read_application_data(
         /* more data available */
         ssl->in_offt += n;
     }
+}
+
+/*
+ * brief          Read at most 'len' application data bytes from the input
+ *                buffer.
+ *
+ * param ssl      SSL context:
+ *                - First byte of application data not read yet in the input
+ *                  buffer located at address `in_offt`.
+ *                - The number of bytes of data not read yet is `in_msglen`.
+ * param buf      buffer that will hold the data
+ * param len      maximum number of bytes to read
+ *
+ * note           The function updates the fields `in_offt` and `in_msglen`
+ *                according to the number of bytes read.
+ *
+ * return         The number of bytes read.
+ */
+static int ssl_read_application_data(
+    mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+{
+    size_t n = (len < ssl->in_msglen) ? len : ssl->in_msglen;
+
+    if (n != 0) {
+        memcpy(buf, ssl->in_offt, n);
+    }
+
+    ssl_consume_application_data(ssl, n);
 
     return (int) n;
 }
 
 /*
- * Receive application data decrypted from the SSL layer
+ * Process incoming records until decrypted application data is available at
+ * in_offt. Returns MBEDTLS_ERR_SSL_CONN_EOF if the transport was closed.
  */
-int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_wait_application_data(mbedtls_ssl_context *ssl)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
 
-    if (ssl == NULL || ssl->conf == NULL) {
-        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    if ((ret = mbedtls_ssl_buffers_acquire(ssl)) != 0) {
+        return ret;
     }
 
-    MBEDTLS_SSL_DEBUG_MSG(2, ("=> read"));
-
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
         if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
@@ -5839,7 +6342,7 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
 
         if ((ret = mbedtls_ssl_read_record(ssl, 1)) != 0) {
             if (ret == MBEDTLS_ERR_SSL_CONN_EOF) {
-                return 0;
+                return ret;
             }
 
             MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_read_record", ret);
@@ -5853,7 +6356,7 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
              */
             if ((ret = mbedtls_ssl_read_record(ssl, 1)) != 0) {
                 if (ret == MBEDTLS_ERR_SSL_CONN_EOF) {
-                    return 0;
+                    return ret;
                 }
 
                 MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_read_record", ret);
@@ -5940,13 +6443,97 @@ int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
     }
 
-    ret = ssl_read_application_data(ssl, buf, len);
+    return 0;
+}
+
+/*
+ * Receive application data decrypted from the SSL layer
+ */
+int mbedtls_ssl_read(mbedtls_ssl_context *ssl, unsigned char *buf, size_t len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (ssl == NULL || ssl->conf == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("=> read"));
+
+    ret = ssl_wait_application_data(ssl);
+    if (ret == 0) {
+        ret = ssl_read_application_data(ssl, buf, len);
+    } else if (ret == MBEDTLS_ERR_SSL_CONN_EOF) {
+        ret = 0;
+    }
+
+    mbedtls_ssl_buffers_release_idle(ssl);
 
     MBEDTLS_SSL_DEBUG_MSG(2, ("<= read"));
 
     return ret;
 }
 
+/*
+ * Zero-copy read: expose the decrypted application data in place
+ */
+int mbedtls_ssl_read_peek(mbedtls_ssl_context *ssl,
+                          const unsigned char **buf, size_t *len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (ssl == NULL || ssl->conf == NULL || buf == NULL || len == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("=> read peek"));
+
+    *buf = NULL;
+    *len = 0;
+
+    /* Skip empty records, so that a zero length always means end of file */
+    while (1) {
+        ret = ssl_wait_application_data(ssl);
+        if (ret != 0) {
+            mbedtls_ssl_buffers_release_idle(ssl);
+            return ret == MBEDTLS_ERR_SSL_CONN_EOF ? 0 : ret;
+        }
+
+        if (ssl->in_msglen != 0) {
+            break;
+        }
+
+        ssl_consume_application_data(ssl, 0);
+    }
+
+    *buf = ssl->in_offt;
+    *len = ssl->in_msglen;
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("<= read peek"));
+
+    return 0;
+}
+
+int mbedtls_ssl_read_consume(mbedtls_ssl_context *ssl, size_t len)
+{
+    if (ssl == NULL || ssl->conf == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (ssl->in_offt == NULL) {
+        return len == 0 ? 0 : MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (len > ssl->in_msglen) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    ssl_consume_application_data(ssl, len);
+
+    mbedtls_ssl_buffers_release_idle(ssl);
+
+    return 0;
+}
+
 #if defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_SSL_EARLY_DATA)
 int mbedtls_ssl_read_early_data(mbedtls_ssl_context *ssl,
                                 unsigned char *buf, size_t len)
@@ -5968,6 +6555,152 @@ int mbedtls_ssl_read_early_data(mbedtls_ssl_context *ssl,
 }
 #endif /* MBEDTLS_SSL_SRV_C && MBEDTLS_SSL_EARLY_DATA */
 
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+/*
+ * Maximum payload of the next application data record, given the maximum
+ * payload max_len: small records while the connection is new or after it
+ * has been idle, so that the peer can process the first bytes of a response
+ * before the rest arrives.
+ *
+ * The limit only changes when a new write starts, so that a write repeated
+ * after MBEDTLS_ERR_SSL_WANT_WRITE sees the same limit.
+ */
+static size_t ssl_dynamic_record_limit(mbedtls_ssl_context *ssl,
+                                       size_t max_len)
+{
+    const mbedtls_ssl_config *conf = ssl->conf;
+
+    if (conf->drs_initial_len == 0 ||
+        conf->transport != MBEDTLS_SSL_TRANSPORT_STREAM) {
+        return max_len;
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    /* TCP restarts from a small congestion window after an idle period
+     * (RFC 5681, section 4.1), so start over with small records. */
+    if (conf->drs_idle_timeout != 0 && ssl->out_left == 0 &&
+        ssl->drs_bytes_sent != 0 &&
+        mbedtls_ms_time() - ssl->drs_last_write >
+        (mbedtls_ms_time_t) conf->drs_idle_timeout) {
+        MBEDTLS_SSL_DEBUG_MSG(3, ("connection was idle, use small records"));
+        ssl->drs_bytes_sent = 0;
+    }
+#endif
+
+    if (ssl->drs_bytes_sent < conf->drs_boost_threshold &&
+        conf->drs_initial_len < max_len) {
+        return conf->drs_initial_len;
+    }
+
+    return max_len;
+}
+
+/*
+ * Account for len bytes of application data written
+ */
+static void ssl_dynamic_record_update(mbedtls_ssl_context *ssl, size_t len)
+{
+    const mbedtls_ssl_config *conf = ssl->conf;
+
+    if (conf->drs_initial_len == 0) {
+        return;
+    }
+
+    if (ssl->drs_bytes_sent >= conf->drs_boost_threshold ||
+        len >= conf->drs_boost_threshold - ssl->drs_bytes_sent) {
+        ssl->drs_bytes_sent = conf->drs_boost_threshold;
+    } else {
+        ssl->drs_bytes_sent += (uint32_t) len;
+    }
+
+#if defined(MBEDTLS_HAVE_TIME)
+    if (conf->drs_idle_timeout != 0) {
+        ssl->drs_last_write = mbedtls_ms_time();
+    }
+#endif
+}
+#endif /* MBEDTLS_SSL_DYNAMIC_RECORD_SIZING */
+
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+/*
+ * Send application data spanning several records, with the records queued
+ * and sent at once with the vectored send callback.
+ *
+ * The amount of data accepted is remembered, so that it can be returned
+ * once the records are sent if this needs further calls after
+ * MBEDTLS_ERR_SSL_WANT_WRITE.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_write_real_vec(mbedtls_ssl_context *ssl,
+                              const unsigned char *buf, size_t len,
+                              size_t max_len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    size_t records, written, chunk;
+
+    if (ssl->out_left != 0) {
+        /* Same as in ssl_write_real() */
+        if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
+            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_flush_output", ret);
+            return ret;
+        }
+
+        written = max_len;
+        if (ssl->out_queue != NULL && ssl->out_queue->app_len != 0) {
+            written = ssl->out_queue->app_len;
+            ssl->out_queue->app_len = 0;
+        }
+
+        return (int) written;
+    }
+
+    /* One record in the output buffer, the others in spare buffers */
+    records = (len + max_len - 1) / max_len;
+    records = 1 + ssl_out_queue_reserve(ssl, records - 1);
+
+    written = 0;
+    while (records-- > 0) {
+        chunk = len - written > max_len ? max_len : len - written;
+
+        ssl->out_msglen  = chunk;
+        ssl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
+        memcpy(ssl->out_msg, buf + written, chunk);
+        written += chunk;
+
+        if (records == 0) {
+            break;
+        }
+
+        if ((ret = mbedtls_ssl_write_record(ssl, SSL_DONT_FORCE_FLUSH)) != 0) {
+            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_write_record", ret);
+            return ret;
+        }
+
+        if ((ret = ssl_out_queue_push(ssl)) != 0) {
+            MBEDTLS_SSL_DEBUG_RET(1, "ssl_out_queue_push", ret);
+            return ret;
+        }
+    }
+
+    /* Needed if the records cannot all be sent immediately. The queue
+     * only fails to exist if a single record is sent, see above. */
+    if (ssl->out_queue != NULL) {
+        ssl->out_queue->app_len = written;
+    }
+
+    if ((ret = mbedtls_ssl_write_record(ssl, SSL_FORCE_FLUSH)) != 0) {
+        MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_write_record", ret);
+        return ret;
+    }
+
+    if (ssl->out_queue != NULL) {
+        ssl->out_queue->app_len = 0;
+    }
+
+    return (int) written;
+}
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
 /*
  * Send application data to be encrypted by the SSL layer, taking care of max
  * fragment length and buffer size.
@@ -5985,13 +6718,17 @@ static int ssl_write_real(mbedtls_ssl_context *ssl,
                           const unsigned char *buf, size_t len)
 {
     int ret = mbedtls_ssl_get_max_out_record_payload(ssl);
-    const size_t max_len = (size_t) ret;
+    size_t max_len = (size_t) ret;
 
     if (ret < 0) {
         MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_get_max_out_record_payload", ret);
         return ret;
     }
 
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+    max_len = ssl_dynamic_record_limit(ssl, max_len);
+#endif
+
     if (len > max_len) {
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
         if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
@@ -6001,6 +6738,17 @@ static int ssl_write_real(mbedtls_ssl_context *ssl,
                                       len, max_len));
             return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
         } else
+#endif
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+        if (ssl->f_send_vec != NULL) {
+            ret = ssl_write_real_vec(ssl, buf, len, max_len);
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+            if (ret > 0) {
+                ssl_dynamic_record_update(ssl, (size_t) ret);
+            }
+#endif
+            return ret;
+        } else
 #endif
         len = max_len;
     }
@@ -6034,6 +6782,10 @@ static int ssl_write_real(mbedtls_ssl_context *ssl,
         }
     }
 
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+    ssl_dynamic_record_update(ssl, len);
+#endif
+
     return (int) len;
 }
 
@@ -6050,6 +6802,10 @@ int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
+    if ((ret = mbedtls_ssl_buffers_acquire(ssl)) != 0) {
+        return ret;
+    }
+
 #if defined(MBEDTLS_SSL_RENEGOTIATION)
     if ((ret = ssl_check_ctr_renegotiate(ssl)) != 0) {
         MBEDTLS_SSL_DEBUG_RET(1, "ssl_check_ctr_renegotiate", ret);
@@ -6066,11 +6822,125 @@ int mbedtls_ssl_write(mbedtls_ssl_context *ssl, const unsigned char *buf, size_t
 
     ret = ssl_write_real(ssl, buf, len);
 
+    mbedtls_ssl_buffers_release_idle(ssl);
+
     MBEDTLS_SSL_DEBUG_MSG(2, ("<= write"));
 
     return ret;
 }
 
+/*
+ * Zero-copy write: hand out the plaintext area of the output buffer
+ */
+int mbedtls_ssl_write_reserve(mbedtls_ssl_context *ssl,
+                              unsigned char **buf, size_t *len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("=> write reserve"));
+
+    if (ssl == NULL || ssl->conf == NULL || buf == NULL || len == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if ((ret = mbedtls_ssl_buffers_acquire(ssl)) != 0) {
+        return ret;
+    }
+
+#if defined(MBEDTLS_SSL_RENEGOTIATION)
+    if ((ret = ssl_check_ctr_renegotiate(ssl)) != 0) {
+        MBEDTLS_SSL_DEBUG_RET(1, "ssl_check_ctr_renegotiate", ret);
+        return ret;
+    }
+#endif
+
+    if (ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        if ((ret = mbedtls_ssl_handshake(ssl)) != 0) {
+            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_handshake", ret);
+            return ret;
+        }
+    }
+
+    /* out_msg may only be handed out once previous records have left */
+    if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
+        MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_flush_output", ret);
+        return ret;
+    }
+    ssl->out_commit_pending = 0;
+
+    ret = mbedtls_ssl_get_max_out_record_payload(ssl);
+    if (ret < 0) {
+        MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_get_max_out_record_payload", ret);
+        return ret;
+    }
+
+    ssl->out_reserved = (size_t) ret;
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+    ssl->out_reserved = ssl_dynamic_record_limit(ssl, ssl->out_reserved);
+#endif
+    *buf = ssl->out_msg;
+    *len = ssl->out_reserved;
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("<= write reserve"));
+
+    return 0;
+}
+
+/*
+ * Zero-copy write: encrypt and send the reserved area in place
+ */
+int mbedtls_ssl_write_commit(mbedtls_ssl_context *ssl, size_t len)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("=> write commit"));
+
+    if (ssl == NULL || ssl->conf == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (ssl->out_commit_pending) {
+        /* A previous call encrypted the record and returned
+         * MBEDTLS_ERR_SSL_WANT_WRITE: finish sending it. */
+        if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
+            MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_flush_output", ret);
+            return ret;
+        }
+        ssl->out_commit_pending = 0;
+
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+        ssl_dynamic_record_update(ssl, len);
+#endif
+        mbedtls_ssl_buffers_release_idle(ssl);
+        return (int) len;
+    }
+
+    if (ssl->out_reserved == 0 || len > ssl->out_reserved) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    ssl->out_msglen  = len;
+    ssl->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
+
+    if ((ret = mbedtls_ssl_write_record(ssl, SSL_FORCE_FLUSH)) != 0) {
+        MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_write_record", ret);
+        if (ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            ssl->out_commit_pending = 1;
+        }
+        return ret;
+    }
+
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+    ssl_dynamic_record_update(ssl, len);
+#endif
+
+    mbedtls_ssl_buffers_release_idle(ssl);
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("<= write commit"));
+
+    return (int) len;
+}
+
 #if defined(MBEDTLS_SSL_EARLY_DATA) && defined(MBEDTLS_SSL_CLI_C)
 int mbedtls_ssl_write_early_data(mbedtls_ssl_context *ssl,
                                  const unsigned char *buf, size_t len)
@@ -6198,6 +7068,8 @@ int mbedtls_ssl_close_notify(mbedtls_ssl_context *ssl)
         }
     }
 
+    mbedtls_ssl_buffers_release_idle(ssl);
+
     MBEDTLS_SSL_DEBUG_MSG(2, ("<= write close notify"));
 
     return 0;
@@ -6274,7 +7146,7 @@ static void ssl_buffering_free_slot(mbedtls_ssl_context *ssl,
 
     if (hs_buf->is_valid == 1) {
         hs->buffering.total_bytes_buffered -= hs_buf->data_len;
-        mbedtls_zeroize_and_free(hs_buf->data, hs_buf->data_len);
+        mbedtls_ssl_hs_zeroize_and_free(ssl, hs_buf->data, hs_buf->data_len);
         memset(hs_buf, 0, sizeof(mbedtls_ssl_hs_buffer));
     }
 }
@@ -0,0 +1,362 @@
+/*
+ *  Client-side store of resumable sessions
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+/*
+ * The sessions are kept in a chained list, newest first, which is short
+ * enough on a client to be searched linearly.
+ */
+
+#include "common.h"
+
+#if defined(MBEDTLS_SSL_SESSION_STORE_C)
+
+#include "mbedtls/platform.h"
+
+#include "mbedtls/ssl_session_store.h"
+#include "ssl_misc.h"
+#include "mbedtls/error.h"
+
+#include <string.h>
+
+void mbedtls_ssl_session_store_init(mbedtls_ssl_session_store_context *store)
+{
+    memset(store, 0, sizeof(mbedtls_ssl_session_store_context));
+
+    store->timeout = MBEDTLS_SSL_SESSION_STORE_DEFAULT_TIMEOUT;
+    store->max_entries = MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_ENTRIES;
+    store->max_per_peer = MBEDTLS_SSL_SESSION_STORE_DEFAULT_MAX_PER_PEER;
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_init(&store->mutex);
+#endif
+}
+
+static int ssl_session_store_entry_is_peer(const mbedtls_ssl_session_store_entry *entry,
+                                           const char *hostname, uint16_t port)
+{
+    return entry->port == port && strcmp(entry->hostname, hostname) == 0;
+}
+
+static int ssl_session_store_entry_expired(const mbedtls_ssl_session_store_entry *entry,
+                                           mbedtls_ms_time_t now)
+{
+    return entry->expiry != 0 && entry->expiry <= now;
+}
+
+/* Unlink the entry `*p_entry` from the chain and free it */
+static void ssl_session_store_remove(mbedtls_ssl_session_store_entry **p_entry)
+{
+    mbedtls_ssl_session_store_entry *entry = *p_entry;
+
+    *p_entry = entry->next;
+
+    if (entry->session != NULL) {
+        mbedtls_zeroize_and_free(entry->session, entry->session_len);
+    }
+    mbedtls_free(entry->hostname);
+    mbedtls_free(entry);
+}
+
+/* Remove the expired entries and return the number of remaining ones */
+static int ssl_session_store_purge(mbedtls_ssl_session_store_context *store,
+                                   mbedtls_ms_time_t now)
+{
+    mbedtls_ssl_session_store_entry **p;
+    int count = 0;
+
+    for (p = &store->chain; *p != NULL;) {
+        if (ssl_session_store_entry_expired(*p, now)) {
+            ssl_session_store_remove(p);
+        } else {
+            count++;
+            p = &(*p)->next;
+        }
+    }
+
+    return count;
+}
+
+/* Remove the oldest entry of a server, or of the whole store if hostname
+ * is NULL. */
+static void ssl_session_store_remove_oldest(mbedtls_ssl_session_store_context *store,
+                                            const char *hostname, uint16_t port)
+{
+    mbedtls_ssl_session_store_entry **p, **oldest = NULL;
+
+    for (p = &store->chain; *p != NULL; p = &(*p)->next) {
+        if (hostname == NULL || ssl_session_store_entry_is_peer(*p, hostname, port)) {
+            oldest = p;
+        }
+    }
+
+    if (oldest != NULL) {
+        ssl_session_store_remove(oldest);
+    }
+}
+
+/*
+ * Compute when a session stops being resumable: at the end of the ticket
+ * lifetime for TLS 1.3, after the store timeout for TLS 1.2, or earlier if
+ * the lifetime hint of a TLS 1.2 ticket is shorter. 0 means never.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_session_store_expiry(const mbedtls_ssl_session_store_context *store,
+                                    const mbedtls_ssl_session *session,
+                                    mbedtls_ms_time_t now,
+                                    mbedtls_ms_time_t *expiry)
+{
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+    if (session->tls_version == MBEDTLS_SSL_VERSION_TLS1_3) {
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        if (session->ticket == NULL) {
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+
+        *expiry = session->ticket_reception_time +
+                  (mbedtls_ms_time_t) session->ticket_lifetime * 1000;
+        return 0;
+#else
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+#endif /* MBEDTLS_SSL_SESSION_TICKETS */
+    }
+#endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
+
+    *expiry = 0;
+    if (store->timeout != 0) {
+        *expiry = now + (mbedtls_ms_time_t) store->timeout * 1000;
+    }
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    if (session->ticket != NULL) {
+        if (session->ticket_lifetime != 0) {
+            mbedtls_ms_time_t hint =
+                now + (mbedtls_ms_time_t) session->ticket_lifetime * 1000;
+            if (*expiry == 0 || hint < *expiry) {
+                *expiry = hint;
+            }
+        }
+        return 0;
+    }
+#endif /* MBEDTLS_SSL_SESSION_TICKETS */
+
+    return session->id_len != 0 ? 0 : MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+}
+
+int mbedtls_ssl_session_store_put(void *p_store,
+                                  const char *hostname,
+                                  uint16_t port,
+                                  const mbedtls_ssl_session *session)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_session_store_context *store =
+        (mbedtls_ssl_session_store_context *) p_store;
+    mbedtls_ssl_session_store_entry *entry = NULL, **p;
+    mbedtls_ms_time_t now = mbedtls_ms_time();
+    mbedtls_ms_time_t expiry;
+    size_t hostname_len;
+    int count, peer_count;
+
+    if (hostname == NULL || session == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    ret = ssl_session_store_expiry(store, session, now, &expiry);
+    if (ret != 0) {
+        return ret;
+    }
+    if (expiry != 0 && expiry <= now) {
+        return 0;
+    }
+
+    entry = mbedtls_calloc(1, sizeof(mbedtls_ssl_session_store_entry));
+    if (entry == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    hostname_len = strlen(hostname) + 1;
+    entry->hostname = mbedtls_calloc(1, hostname_len);
+    if (entry->hostname == NULL) {
+        ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        goto free;
+    }
+    memcpy(entry->hostname, hostname, hostname_len);
+    entry->port = port;
+    entry->tls_version = session->tls_version;
+    entry->expiry = expiry;
+
+    /* Serialize the session outside of the lock. */
+    ret = mbedtls_ssl_session_save(session, NULL, 0, &entry->session_len);
+    if (ret != MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL) {
+        goto free;
+    }
+
+    entry->session = mbedtls_calloc(1, entry->session_len);
+    if (entry->session == NULL) {
+        ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        goto free;
+    }
+
+    ret = mbedtls_ssl_session_save(session, entry->session, entry->session_len,
+                                   &entry->session_len);
+    if (ret != 0) {
+        goto free;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&store->mutex)) != 0) {
+        goto free;
+    }
+#endif
+
+    if (store->max_entries == 0 || store->max_per_peer == 0) {
+        ret = 0;
+        goto exit;
+    }
+
+    count = ssl_session_store_purge(store, now);
+
+    /* A TLS 1.2 session replaces the older sessions of the server, which
+     * it would be pointless to resume after it. Count the others. */
+    peer_count = 0;
+    for (p = &store->chain; *p != NULL;) {
+        if (ssl_session_store_entry_is_peer(*p, hostname, port)) {
+            if (entry->tls_version != MBEDTLS_SSL_VERSION_TLS1_3) {
+                ssl_session_store_remove(p);
+                count--;
+                continue;
+            }
+            peer_count++;
+        }
+        p = &(*p)->next;
+    }
+
+    for (; peer_count >= store->max_per_peer; peer_count--, count--) {
+        ssl_session_store_remove_oldest(store, hostname, port);
+    }
+    for (; count >= store->max_entries; count--) {
+        ssl_session_store_remove_oldest(store, NULL, 0);
+    }
+
+    entry->next = store->chain;
+    store->chain = entry;
+    entry = NULL;
+
+    ret = 0;
+
+exit:
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&store->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+free:
+    if (entry != NULL) {
+        entry->next = NULL;
+        ssl_session_store_remove(&entry);
+    }
+
+    return ret;
+}
+
+int mbedtls_ssl_session_store_take(void *p_store,
+                                   const char *hostname,
+                                   uint16_t port,
+                                   mbedtls_ssl_session *session)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_session_store_context *store =
+        (mbedtls_ssl_session_store_context *) p_store;
+    mbedtls_ssl_session_store_entry **p;
+
+    if (hostname == NULL || session == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    if ((ret = mbedtls_mutex_lock(&store->mutex)) != 0) {
+        return ret;
+    }
+#endif
+
+    (void) ssl_session_store_purge(store, mbedtls_ms_time());
+
+    for (p = &store->chain; *p != NULL; p = &(*p)->next) {
+        if (ssl_session_store_entry_is_peer(*p, hostname, port)) {
+            break;
+        }
+    }
+
+    if (*p == NULL) {
+        ret = MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND;
+        goto exit;
+    }
+
+    ret = mbedtls_ssl_session_load(session, (*p)->session, (*p)->session_len);
+
+    /* A TLS 1.3 ticket is handed out only once, even if it could not be
+     * loaded. */
+    if ((*p)->tls_version == MBEDTLS_SSL_VERSION_TLS1_3) {
+        ssl_session_store_remove(p);
+    }
+
+exit:
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&store->mutex) != 0) {
+        ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#endif
+
+    return ret;
+}
+
+void mbedtls_ssl_session_store_set_timeout(mbedtls_ssl_session_store_context *store,
+                                           int timeout)
+{
+    if (timeout < 0) {
+        timeout = 0;
+    }
+
+    store->timeout = timeout;
+}
+
+void mbedtls_ssl_session_store_set_max_entries(mbedtls_ssl_session_store_context *store,
+                                               int max)
+{
+    if (max < 0) {
+        max = 0;
+    }
+
+    store->max_entries = max;
+}
+
+void mbedtls_ssl_session_store_set_max_per_peer(mbedtls_ssl_session_store_context *store,
+                                                int max)
+{
+    if (max < 0) {
+        max = 0;
+    }
+
+    store->max_per_peer = max;
+}
+
+void mbedtls_ssl_session_store_free(mbedtls_ssl_session_store_context *store)
+{
+    if (store == NULL) {
+        return;
+    }
+
+    while (store->chain != NULL) {
+        ssl_session_store_remove(&store->chain);
+    }
+
+#if defined(MBEDTLS_THREADING_C)
+    mbedtls_mutex_free(&store->mutex);
+#endif
+    store->chain = NULL;
+}
+
+#endif /* MBEDTLS_SSL_SESSION_STORE_C */
@@ -37,6 +37,8 @@ void mbedtls_ssl_ticket_init(mbedtls_ssl_ticket_context *ctx)
 {
     memset(ctx, 0, sizeof(mbedtls_ssl_ticket_context));
 
+    ctx->max_keys = 2;
+
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_mutex_init(&ctx->mutex);
 #endif
@@ -58,37 +60,99 @@ void mbedtls_ssl_ticket_init(mbedtls_ssl_ticket_context *ctx)
                              TICKET_CRYPT_LEN_BYTES)
 
 /*
- * Generate/update a key
+ * The mutex only protects the key list and the reference counts, and is
+ * never held during a cryptographic operation or a call to the RNG.
+ */
+static int ssl_ticket_lock(mbedtls_ssl_ticket_context *ctx)
+{
+#if defined(MBEDTLS_THREADING_C)
+    return mbedtls_mutex_lock(&ctx->mutex);
+#else
+    ((void) ctx);
+    return 0;
+#endif
+}
+
+static int ssl_ticket_unlock(mbedtls_ssl_ticket_context *ctx)
+{
+#if defined(MBEDTLS_THREADING_C)
+    if (mbedtls_mutex_unlock(&ctx->mutex) != 0) {
+        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+    }
+#else
+    ((void) ctx);
+#endif
+    return 0;
+}
+
+static void ssl_ticket_key_free(mbedtls_ssl_ticket_key *key)
+{
+    if (key == NULL) {
+        return;
+    }
+
+#if defined(MBEDTLS_USE_PSA_CRYPTO)
+    psa_destroy_key(key->key);
+#endif
+
+    mbedtls_platform_zeroize(key, sizeof(mbedtls_ssl_ticket_key));
+    mbedtls_free(key);
+}
+
+/*
+ * Drop a reference to a key, and free it if it was the last one
+ */
+static void ssl_ticket_key_release(mbedtls_ssl_ticket_context *ctx,
+                                   mbedtls_ssl_ticket_key *key)
+{
+    size_t refs;
+
+    if (ssl_ticket_lock(ctx) != 0) {
+        /* Leak the key rather than free it while it may be in use */
+        return;
+    }
+
+    refs = --key->refs;
+
+    if (ssl_ticket_unlock(ctx) == 0 && refs == 0) {
+        ssl_ticket_key_free(key);
+    }
+}
+
+/*
+ * Create a key from the given name and key material
  */
 MBEDTLS_CHECK_RETURN_CRITICAL
-static int ssl_ticket_gen_key(mbedtls_ssl_ticket_context *ctx,
-                              unsigned char index)
+static int ssl_ticket_key_new(mbedtls_ssl_ticket_context *ctx,
+                              const unsigned char name[TICKET_KEY_NAME_BYTES],
+                              const unsigned char *k,
+                              uint32_t lifetime,
+                              mbedtls_ssl_ticket_key **out)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
-    unsigned char buf[MAX_KEY_BYTES] = { 0 };
-    mbedtls_ssl_ticket_key *key = ctx->keys + index;
+    mbedtls_ssl_ticket_key *key;
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
     psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
 #endif
 
+    key = mbedtls_calloc(1, sizeof(mbedtls_ssl_ticket_key));
+    if (key == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+
+    memcpy(key->name, name, TICKET_KEY_NAME_BYTES);
 #if defined(MBEDTLS_HAVE_TIME)
     key->generation_time = mbedtls_time(NULL);
 #endif
-    /* The lifetime of a key is the configured lifetime of the tickets when
-     * the key is created.
-     */
-    key->lifetime = ctx->ticket_lifetime;
-
-    if ((ret = ctx->f_rng(ctx->p_rng, key->name, sizeof(key->name))) != 0) {
-        return ret;
-    }
-
-    if ((ret = ctx->f_rng(ctx->p_rng, buf, sizeof(buf))) != 0) {
-        return ret;
-    }
+    key->lifetime = lifetime;
+    key->refs = 1;
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
+    key->alg = ctx->alg;
+    key->key_type = ctx->key_type;
+    key->key_bits = ctx->key_bits;
+
     psa_set_key_usage_flags(&attributes,
                             PSA_KEY_USAGE_ENCRYPT | PSA_KEY_USAGE_DECRYPT);
     psa_set_key_algorithm(&attributes, key->alg);
@@ -96,21 +160,96 @@ static int ssl_ticket_gen_key(mbedtls_ssl_ticket_context *ctx,
     psa_set_key_bits(&attributes, key->key_bits);
 
     ret = PSA_TO_MBEDTLS_ERR(
-        psa_import_key(&attributes, buf,
+        psa_import_key(&attributes, k,
                        PSA_BITS_TO_BYTES(key->key_bits),
                        &key->key));
 #else
-    /* With GCM and CCM, same context can encrypt & decrypt */
-    ret = mbedtls_cipher_setkey(&key->ctx, buf,
-                                mbedtls_cipher_get_key_bitlen(&key->ctx),
-                                MBEDTLS_ENCRYPT);
+    memcpy(key->key_bytes, k,
+           (size_t) mbedtls_cipher_info_get_key_bitlen(ctx->cipher_info) / 8);
+    ret = 0;
 #endif /* MBEDTLS_USE_PSA_CRYPTO */
 
+    if (ret != 0) {
+        ssl_ticket_key_free(key);
+        return ret;
+    }
+
+    *out = key;
+
+    return 0;
+}
+
+/*
+ * Generate a random key
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_ticket_gen_key(mbedtls_ssl_ticket_context *ctx,
+                              uint32_t lifetime,
+                              mbedtls_ssl_ticket_key **key)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    unsigned char name[TICKET_KEY_NAME_BYTES];
+    unsigned char buf[MAX_KEY_BYTES] = { 0 };
+
+    if ((ret = ctx->f_rng(ctx->p_rng, name, sizeof(name))) != 0) {
+        return ret;
+    }
+
+    if ((ret = ctx->f_rng(ctx->p_rng, buf, sizeof(buf))) != 0) {
+        return ret;
+    }
+
+    ret = ssl_ticket_key_new(ctx, name, buf, lifetime, key);
+
     mbedtls_platform_zeroize(buf, sizeof(buf));
 
     return ret;
 }
 
+/*
+ * Make a key the active one, and return the key that is no longer
+ * accepted, if any. Must be called with the mutex held.
+ */
+static mbedtls_ssl_ticket_key *ssl_ticket_push_key(
+    mbedtls_ssl_ticket_context *ctx,
+    mbedtls_ssl_ticket_key *key)
+{
+    mbedtls_ssl_ticket_key *dropped = NULL;
+    size_t i;
+
+    if (ctx->key_count == ctx->max_keys) {
+        dropped = ctx->keys[--ctx->key_count];
+    }
+
+    for (i = ctx->key_count; i > 0; i--) {
+        ctx->keys[i] = ctx->keys[i - 1];
+    }
+    ctx->keys[0] = key;
+    ctx->key_count++;
+
+    if (dropped != NULL && --dropped->refs != 0) {
+        /* Still used by an operation, which will free it */
+        dropped = NULL;
+    }
+
+    return dropped;
+}
+
+#if defined(MBEDTLS_HAVE_TIME)
+static int ssl_ticket_key_expired(const mbedtls_ssl_ticket_key *key,
+                                  mbedtls_time_t current_time)
+{
+    mbedtls_time_t key_time = key->generation_time;
+
+    if (key->lifetime == 0) {
+        return 0;
+    }
+
+    return current_time < key_time ||
+           (uint64_t) (current_time - key_time) >= key->lifetime;
+}
+#endif /* MBEDTLS_HAVE_TIME */
+
 /*
  * Rotate/generate keys if necessary
  */
@@ -119,35 +258,146 @@ static int ssl_ticket_update_keys(mbedtls_ssl_ticket_context *ctx)
 {
 #if !defined(MBEDTLS_HAVE_TIME)
     ((void) ctx);
+    return 0;
 #else
-    mbedtls_ssl_ticket_key * const key = ctx->keys + ctx->active;
-    if (key->lifetime != 0) {
-        mbedtls_time_t current_time = mbedtls_time(NULL);
-        mbedtls_time_t key_time = key->generation_time;
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_time_t current_time = mbedtls_time(NULL);
+    mbedtls_ssl_ticket_key *key = NULL, *dropped = NULL;
+    uint32_t lifetime;
+    int expired;
 
-#if defined(MBEDTLS_USE_PSA_CRYPTO)
-        psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
-#endif
+    if ((ret = ssl_ticket_lock(ctx)) != 0) {
+        return ret;
+    }
+    expired = ssl_ticket_key_expired(ctx->keys[0], current_time);
+    lifetime = ctx->ticket_lifetime;
+    if ((ret = ssl_ticket_unlock(ctx)) != 0 || !expired) {
+        return ret;
+    }
 
-        if (current_time >= key_time &&
-            (uint64_t) (current_time - key_time) < key->lifetime) {
-            return 0;
-        }
+    /* Generate the new key without holding the mutex. Threads that find
+     * the key expired at the same time all do so, and only the first one
+     * to get back installs its key. */
+    if ((ret = ssl_ticket_gen_key(ctx, lifetime, &key)) != 0) {
+        return ret;
+    }
 
-        ctx->active = 1 - ctx->active;
+    if ((ret = ssl_ticket_lock(ctx)) != 0) {
+        ssl_ticket_key_free(key);
+        return ret;
+    }
+    if (ssl_ticket_key_expired(ctx->keys[0], current_time)) {
+        dropped = ssl_ticket_push_key(ctx, key);
+        key = NULL;
+    }
+    ret = ssl_ticket_unlock(ctx);
 
-#if defined(MBEDTLS_USE_PSA_CRYPTO)
-        if ((status = psa_destroy_key(ctx->keys[ctx->active].key)) != PSA_SUCCESS) {
-            return PSA_TO_MBEDTLS_ERR(status);
-        }
-#endif /* MBEDTLS_USE_PSA_CRYPTO */
+    ssl_ticket_key_free(key);
+    ssl_ticket_key_free(dropped);
 
-        return ssl_ticket_gen_key(ctx, ctx->active);
-    } else
+    return ret;
 #endif /* MBEDTLS_HAVE_TIME */
+}
+
+/*
+ * Take a reference to the active key, or to the key with the given name
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_ticket_acquire_key(mbedtls_ssl_ticket_context *ctx,
+                                  const unsigned char *name,
+                                  mbedtls_ssl_ticket_key **key)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    size_t i;
+
+    *key = NULL;
+
+    if ((ret = ssl_ticket_lock(ctx)) != 0) {
+        return ret;
+    }
+
+    for (i = 0; i < ctx->key_count; i++) {
+        if (name == NULL ||
+            memcmp(name, ctx->keys[i]->name, TICKET_KEY_NAME_BYTES) == 0) {
+            *key = ctx->keys[i];
+            (*key)->refs++;
+            break;
+        }
+    }
+
+    if ((ret = ssl_ticket_unlock(ctx)) != 0) {
+        /* The reference count is protected by the mutex, so it can't be
+         * dropped safely now. */
+        *key = NULL;
+        return ret;
+    }
+
+    if (*key == NULL) {
+        /* We can't know for sure but this is a likely option unless we're
+         * under attack - this is only informative anyway */
+        return MBEDTLS_ERR_SSL_SESSION_TICKET_EXPIRED;
+    }
+
     return 0;
 }
 
+#if !defined(MBEDTLS_USE_PSA_CRYPTO)
+/*
+ * A cipher context can't be used by several threads at once, so each
+ * operation sets up its own one from the key.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_ticket_cipher_setup(mbedtls_ssl_ticket_context *ctx,
+                                   const mbedtls_ssl_ticket_key *key,
+                                   mbedtls_cipher_context_t *cipher)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if ((ret = mbedtls_cipher_setup(cipher, ctx->cipher_info)) != 0) {
+        return ret;
+    }
+
+    /* With GCM and CCM, same context can encrypt & decrypt */
+    return mbedtls_cipher_setkey(cipher, key->key_bytes,
+                                 mbedtls_cipher_info_get_key_bitlen(ctx->cipher_info),
+                                 MBEDTLS_ENCRYPT);
+}
+#endif /* !MBEDTLS_USE_PSA_CRYPTO */
+
+int mbedtls_ssl_ticket_set_max_keys(mbedtls_ssl_ticket_context *ctx,
+                                    size_t max_keys)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_ticket_key *dropped[MBEDTLS_SSL_TICKET_MAX_KEYS];
+    size_t i, count = 0;
+
+    if (max_keys < 1 || max_keys > MBEDTLS_SSL_TICKET_MAX_KEYS) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if ((ret = ssl_ticket_lock(ctx)) != 0) {
+        return ret;
+    }
+
+    ctx->max_keys = max_keys;
+    while (ctx->key_count > max_keys) {
+        mbedtls_ssl_ticket_key *key = ctx->keys[--ctx->key_count];
+
+        ctx->keys[ctx->key_count] = NULL;
+        if (--key->refs == 0) {
+            dropped[count++] = key;
+        }
+    }
+
+    ret = ssl_ticket_unlock(ctx);
+
+    for (i = 0; i < count; i++) {
+        ssl_ticket_key_free(dropped[i]);
+    }
+
+    return ret;
+}
+
 /*
  * Rotate active session ticket encryption key
  */
@@ -156,56 +406,41 @@ int mbedtls_ssl_ticket_rotate(mbedtls_ssl_ticket_context *ctx,
                               const unsigned char *k, size_t klength,
                               uint32_t lifetime)
 {
-    const unsigned char idx = 1 - ctx->active;
-    mbedtls_ssl_ticket_key * const key = ctx->keys + idx;
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_ticket_key *key, *dropped;
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
-    psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
-    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
-    const size_t bitlen = key->key_bits;
+    const size_t bitlen = ctx->key_bits;
 #else
-    const int bitlen = mbedtls_cipher_get_key_bitlen(&key->ctx);
+    const int bitlen = ctx->cipher_info == NULL ? 0 :
+                       mbedtls_cipher_info_get_key_bitlen(ctx->cipher_info);
 #endif
 
+    if (ctx->f_rng == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
     if (nlength < TICKET_KEY_NAME_BYTES || klength * 8 < (size_t) bitlen) {
         return MBEDTLS_ERR_CIPHER_BAD_INPUT_DATA;
     }
 
-#if defined(MBEDTLS_USE_PSA_CRYPTO)
-    if ((status = psa_destroy_key(key->key)) != PSA_SUCCESS) {
-        ret = PSA_TO_MBEDTLS_ERR(status);
+    if ((ret = ssl_ticket_key_new(ctx, name, k, lifetime, &key)) != 0) {
         return ret;
     }
 
-    psa_set_key_usage_flags(&attributes,
-                            PSA_KEY_USAGE_ENCRYPT | PSA_KEY_USAGE_DECRYPT);
-    psa_set_key_algorithm(&attributes, key->alg);
-    psa_set_key_type(&attributes, key->key_type);
-    psa_set_key_bits(&attributes, key->key_bits);
-
-    if ((status = psa_import_key(&attributes, k,
-                                 PSA_BITS_TO_BYTES(key->key_bits),
-                                 &key->key)) != PSA_SUCCESS) {
-        ret = PSA_TO_MBEDTLS_ERR(status);
-        return ret;
-    }
-#else
-    ret = mbedtls_cipher_setkey(&key->ctx, k, bitlen, MBEDTLS_ENCRYPT);
-    if (ret != 0) {
+    if ((ret = ssl_ticket_lock(ctx)) != 0) {
+        ssl_ticket_key_free(key);
         return ret;
     }
-#endif /* MBEDTLS_USE_PSA_CRYPTO */
 
-    ctx->active = idx;
+    dropped = ssl_ticket_push_key(ctx, key);
     ctx->ticket_lifetime = lifetime;
-    memcpy(key->name, name, TICKET_KEY_NAME_BYTES);
-#if defined(MBEDTLS_HAVE_TIME)
-    key->generation_time = mbedtls_time(NULL);
-#endif
-    key->lifetime = lifetime;
 
-    return 0;
+    ret = ssl_ticket_unlock(ctx);
+
+    ssl_ticket_key_free(dropped);
+
+    return ret;
 }
 
 /*
@@ -217,6 +452,7 @@ int mbedtls_ssl_ticket_setup(mbedtls_ssl_ticket_context *ctx,
                              uint32_t lifetime)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    mbedtls_ssl_ticket_key *key;
     size_t key_bits;
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
@@ -257,28 +493,23 @@ int mbedtls_ssl_ticket_setup(mbedtls_ssl_ticket_context *ctx,
     ctx->ticket_lifetime = lifetime;
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
-    ctx->keys[0].alg = alg;
-    ctx->keys[0].key_type = key_type;
-    ctx->keys[0].key_bits = key_bits;
-
-    ctx->keys[1].alg = alg;
-    ctx->keys[1].key_type = key_type;
-    ctx->keys[1].key_bits = key_bits;
+    ctx->alg = alg;
+    ctx->key_type = key_type;
+    ctx->key_bits = key_bits;
 #else
-    if ((ret = mbedtls_cipher_setup(&ctx->keys[0].ctx, cipher_info)) != 0) {
-        return ret;
-    }
-
-    if ((ret = mbedtls_cipher_setup(&ctx->keys[1].ctx, cipher_info)) != 0) {
-        return ret;
-    }
+    ctx->cipher_info = cipher_info;
 #endif /* MBEDTLS_USE_PSA_CRYPTO */
 
-    if ((ret = ssl_ticket_gen_key(ctx, 0)) != 0 ||
-        (ret = ssl_ticket_gen_key(ctx, 1)) != 0) {
+    /* The lifetime of a key is the configured lifetime of the tickets when
+     * the key is created. */
+    if ((ret = ssl_ticket_gen_key(ctx, lifetime, &key)) != 0) {
+        ctx->f_rng = NULL;
         return ret;
     }
 
+    ctx->keys[0] = key;
+    ctx->key_count = 1;
+
     return 0;
 }
 
@@ -305,7 +536,7 @@ int mbedtls_ssl_ticket_write(void *p_ticket,
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_ssl_ticket_context *ctx = p_ticket;
-    mbedtls_ssl_ticket_key *key;
+    mbedtls_ssl_ticket_key *key = NULL;
     unsigned char *key_name = start;
     unsigned char *iv = start + TICKET_KEY_NAME_BYTES;
     unsigned char *state_len_bytes = iv + TICKET_IV_BYTES;
@@ -314,6 +545,10 @@ int mbedtls_ssl_ticket_write(void *p_ticket,
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
     psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+#else
+    mbedtls_cipher_context_t cipher;
+
+    mbedtls_cipher_init(&cipher);
 #endif
 
     *tlen = 0;
@@ -326,18 +561,11 @@ int mbedtls_ssl_ticket_write(void *p_ticket,
      * in addition to session itself, that will be checked when writing it. */
     MBEDTLS_SSL_CHK_BUF_PTR(start, end, TICKET_MIN_LEN);
 
-#if defined(MBEDTLS_THREADING_C)
-    if ((ret = mbedtls_mutex_lock(&ctx->mutex)) != 0) {
-        return ret;
-    }
-#endif
-
-    if ((ret = ssl_ticket_update_keys(ctx)) != 0) {
+    if ((ret = ssl_ticket_update_keys(ctx)) != 0 ||
+        (ret = ssl_ticket_acquire_key(ctx, NULL, &key)) != 0) {
         goto cleanup;
     }
 
-    key = &ctx->keys[ctx->active];
-
     *ticket_lifetime = key->lifetime;
 
     memcpy(key_name, key->name, TICKET_KEY_NAME_BYTES);
@@ -366,7 +594,11 @@ int mbedtls_ssl_ticket_write(void *p_ticket,
         goto cleanup;
     }
 #else
-    if ((ret = mbedtls_cipher_auth_encrypt_ext(&key->ctx,
+    if ((ret = ssl_ticket_cipher_setup(ctx, key, &cipher)) != 0) {
+        goto cleanup;
+    }
+
+    if ((ret = mbedtls_cipher_auth_encrypt_ext(&cipher,
                                                iv, TICKET_IV_BYTES,
                                                /* Additional data: key name, IV and length */
                                                key_name, TICKET_ADD_DATA_LEN,
@@ -385,31 +617,14 @@ int mbedtls_ssl_ticket_write(void *p_ticket,
     *tlen = TICKET_MIN_LEN + ciph_len - TICKET_AUTH_TAG_BYTES;
 
 cleanup:
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(&ctx->mutex) != 0) {
-        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
-    }
+#if !defined(MBEDTLS_USE_PSA_CRYPTO)
+    mbedtls_cipher_free(&cipher);
 #endif
-
-    return ret;
-}
-
-/*
- * Select key based on name
- */
-static mbedtls_ssl_ticket_key *ssl_ticket_select_key(
-    mbedtls_ssl_ticket_context *ctx,
-    const unsigned char name[4])
-{
-    unsigned char i;
-
-    for (i = 0; i < sizeof(ctx->keys) / sizeof(*ctx->keys); i++) {
-        if (memcmp(name, ctx->keys[i].name, 4) == 0) {
-            return &ctx->keys[i];
-        }
+    if (key != NULL) {
+        ssl_ticket_key_release(ctx, key);
     }
 
-    return NULL;
+    return ret;
 }
 
 /*
@@ -422,7 +637,7 @@ int mbedtls_ssl_ticket_parse(void *p_ticket,
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     mbedtls_ssl_ticket_context *ctx = p_ticket;
-    mbedtls_ssl_ticket_key *key;
+    mbedtls_ssl_ticket_key *key = NULL;
     unsigned char *key_name = buf;
     unsigned char *iv = buf + TICKET_KEY_NAME_BYTES;
     unsigned char *enc_len_p = iv + TICKET_IV_BYTES;
@@ -431,6 +646,10 @@ int mbedtls_ssl_ticket_parse(void *p_ticket,
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
     psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+#else
+    mbedtls_cipher_context_t cipher;
+
+    mbedtls_cipher_init(&cipher);
 #endif
 
     if (ctx == NULL || ctx->f_rng == NULL) {
@@ -441,12 +660,6 @@ int mbedtls_ssl_ticket_parse(void *p_ticket,
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
-#if defined(MBEDTLS_THREADING_C)
-    if ((ret = mbedtls_mutex_lock(&ctx->mutex)) != 0) {
-        return ret;
-    }
-#endif
-
     if ((ret = ssl_ticket_update_keys(ctx)) != 0) {
         goto cleanup;
     }
@@ -459,10 +672,7 @@ int mbedtls_ssl_ticket_parse(void *p_ticket,
     }
 
     /* Select key */
-    if ((key = ssl_ticket_select_key(ctx, key_name)) == NULL) {
-        /* We can't know for sure but this is a likely option unless we're
-         * under attack - this is only informative anyway */
-        ret = MBEDTLS_ERR_SSL_SESSION_TICKET_EXPIRED;
+    if ((ret = ssl_ticket_acquire_key(ctx, key_name, &key)) != 0) {
         goto cleanup;
     }
 
@@ -476,7 +686,11 @@ int mbedtls_ssl_ticket_parse(void *p_ticket,
         goto cleanup;
     }
 #else
-    if ((ret = mbedtls_cipher_auth_decrypt_ext(&key->ctx,
+    if ((ret = ssl_ticket_cipher_setup(ctx, key, &cipher)) != 0) {
+        goto cleanup;
+    }
+
+    if ((ret = mbedtls_cipher_auth_decrypt_ext(&cipher,
                                                iv, TICKET_IV_BYTES,
                                                /* Additional data: key name, IV and length */
                                                key_name, TICKET_ADD_DATA_LEN,
@@ -520,11 +734,12 @@ int mbedtls_ssl_ticket_parse(void *p_ticket,
 #endif
 
 cleanup:
-#if defined(MBEDTLS_THREADING_C)
-    if (mbedtls_mutex_unlock(&ctx->mutex) != 0) {
-        return MBEDTLS_ERR_THREADING_MUTEX_ERROR;
-    }
+#if !defined(MBEDTLS_USE_PSA_CRYPTO)
+    mbedtls_cipher_free(&cipher);
 #endif
+    if (key != NULL) {
+        ssl_ticket_key_release(ctx, key);
+    }
 
     return ret;
 }
@@ -534,13 +749,13 @@ cleanup:
  */
 void mbedtls_ssl_ticket_free(mbedtls_ssl_ticket_context *ctx)
 {
-#if defined(MBEDTLS_USE_PSA_CRYPTO)
-    psa_destroy_key(ctx->keys[0].key);
-    psa_destroy_key(ctx->keys[1].key);
-#else
-    mbedtls_cipher_free(&ctx->keys[0].ctx);
-    mbedtls_cipher_free(&ctx->keys[1].ctx);
-#endif /* MBEDTLS_USE_PSA_CRYPTO */
+    size_t i;
+
+    /* No operation can be in progress, so the context holds the only
+     * reference to each key. */
+    for (i = 0; i < ctx->key_count; i++) {
+        ssl_ticket_key_free(ctx->keys[i]);
+    }
 
 #if defined(MBEDTLS_THREADING_C)
     mbedtls_mutex_free(&ctx->mutex);
@@ -346,12 +346,19 @@ static void handle_buffer_resizing(mbedtls_ssl_context *ssl, int downsizing,
     int modified = 0;
     size_t written_in = 0, iv_offset_in = 0, len_offset_in = 0;
     size_t written_out = 0, iv_offset_out = 0, len_offset_out = 0;
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    /* Pool buffers always have the maximum size */
+    if (ssl->buffer_pool != NULL) {
+        return;
+    }
+#endif
     if (ssl->in_buf != NULL) {
         written_in = ssl->in_msg - ssl->in_buf;
         iv_offset_in = ssl->in_iv - ssl->in_buf;
         len_offset_in = ssl->in_len - ssl->in_buf;
         if (downsizing ?
-            ssl->in_buf_len > in_buf_new_len && ssl->in_left < in_buf_new_len :
+            ssl->in_buf_len > in_buf_new_len &&
+            (size_t) (ssl->in_hdr - ssl->in_buf) + ssl->in_left <= in_buf_new_len :
             ssl->in_buf_len < in_buf_new_len) {
             if (resize_buffer(&ssl->in_buf, in_buf_new_len, &ssl->in_buf_len) != 0) {
                 MBEDTLS_SSL_DEBUG_MSG(1, ("input buffer resizing failed - out of memory"));
@@ -1045,6 +1052,128 @@ void mbedtls_ssl_session_init(mbedtls_ssl_session *session)
     memset(session, 0, sizeof(mbedtls_ssl_session));
 }
 
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+/* Alignment of arena allocations, enough for any type on common platforms */
+#define SSL_HS_ARENA_ALIGN 16
+
+void *mbedtls_ssl_hs_calloc(mbedtls_ssl_context *ssl, size_t n, size_t size)
+{
+    mbedtls_ssl_handshake_params *handshake = ssl->handshake;
+    unsigned char *p;
+    size_t len;
+
+    if (handshake == NULL || handshake->arena == NULL ||
+        n == 0 || size == 0 || n > (SIZE_MAX - SSL_HS_ARENA_ALIGN) / size) {
+        return mbedtls_calloc(n, size);
+    }
+
+    len = (n * size + SSL_HS_ARENA_ALIGN - 1) &
+          ~((size_t) SSL_HS_ARENA_ALIGN - 1);
+    if (len > handshake->arena_size - handshake->arena_used) {
+        return mbedtls_calloc(n, size);
+    }
+
+    /* Arena memory is never handed out twice, so it is still zero */
+    p = handshake->arena + handshake->arena_used;
+    handshake->arena_used += len;
+
+    return p;
+}
+
+static int ssl_hs_arena_owns(const mbedtls_ssl_handshake_params *handshake,
+                             const void *ptr)
+{
+    uintptr_t base;
+
+    if (handshake == NULL || handshake->arena == NULL) {
+        return 0;
+    }
+
+    base = (uintptr_t) handshake->arena;
+    return (uintptr_t) ptr >= base &&
+           (uintptr_t) ptr - base < handshake->arena_size;
+}
+
+void mbedtls_ssl_hs_free(mbedtls_ssl_context *ssl, void *ptr)
+{
+    if (!ssl_hs_arena_owns(ssl->handshake, ptr)) {
+        mbedtls_free(ptr);
+    }
+}
+
+void mbedtls_ssl_hs_zeroize_and_free(mbedtls_ssl_context *ssl,
+                                     void *ptr, size_t len)
+{
+    if (ssl_hs_arena_owns(ssl->handshake, ptr)) {
+        mbedtls_platform_zeroize(ptr, len);
+    } else {
+        mbedtls_zeroize_and_free(ptr, len);
+    }
+}
+
+/* Everything allocated from the arena goes away at once */
+static void ssl_handshake_arena_free(mbedtls_ssl_context *ssl)
+{
+    mbedtls_ssl_handshake_params *handshake = ssl->handshake;
+
+    if (handshake->arena == NULL) {
+        return;
+    }
+
+    MBEDTLS_SSL_DEBUG_MSG(3, ("handshake arena: %" MBEDTLS_PRINTF_SIZET
+                              " of %" MBEDTLS_PRINTF_SIZET " bytes used",
+                              handshake->arena_used, handshake->arena_size));
+    mbedtls_zeroize_and_free(handshake->arena, handshake->arena_size);
+    handshake->arena = NULL;
+    handshake->arena_size = 0;
+    handshake->arena_used = 0;
+}
+
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+void mbedtls_ssl_handshake_arena_release(mbedtls_ssl_context *ssl)
+{
+    mbedtls_ssl_handshake_params *handshake = ssl->handshake;
+
+    if (handshake == NULL || handshake->arena == NULL) {
+        return;
+    }
+
+    /* Free every item that may live in the arena before the arena itself */
+    mbedtls_ssl_transform_free(handshake->transform_handshake);
+    mbedtls_ssl_hs_free(ssl, handshake->transform_handshake);
+    handshake->transform_handshake = NULL;
+#if defined(MBEDTLS_SSL_EARLY_DATA)
+    mbedtls_ssl_transform_free(handshake->transform_earlydata);
+    mbedtls_ssl_hs_free(ssl, handshake->transform_earlydata);
+    handshake->transform_earlydata = NULL;
+#endif
+#if defined(MBEDTLS_SSL_HANDSHAKE_WITH_CERT_ENABLED)
+    mbedtls_ssl_hs_free(ssl, handshake->certificate_request_context);
+    handshake->certificate_request_context = NULL;
+    handshake->certificate_request_context_len = 0;
+#endif
+#if defined(MBEDTLS_SSL_CLI_C)
+    mbedtls_ssl_hs_free(ssl, handshake->cookie);
+    handshake->cookie = NULL;
+    handshake->cookie_len = 0;
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECJPAKE_ENABLED) && defined(MBEDTLS_SSL_CLI_C)
+    mbedtls_ssl_hs_free(ssl, handshake->ecjpake_cache);
+    handshake->ecjpake_cache = NULL;
+    handshake->ecjpake_cache_len = 0;
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_SOME_ECDH_OR_ECDHE_ANY_ENABLED) || \
+    defined(MBEDTLS_KEY_EXCHANGE_WITH_ECDSA_ANY_ENABLED) || \
+    defined(MBEDTLS_KEY_EXCHANGE_ECJPAKE_ENABLED)
+    mbedtls_ssl_hs_free(ssl, (void *) handshake->curves_tls_id);
+    handshake->curves_tls_id = NULL;
+#endif
+
+    ssl_handshake_arena_free(ssl);
+}
+#endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
+#endif /* MBEDTLS_SSL_HANDSHAKE_ARENA */
+
 MBEDTLS_CHECK_RETURN_CRITICAL
 static int ssl_handshake_init(mbedtls_ssl_context *ssl)
 {
@@ -1123,6 +1252,18 @@ static int ssl_handshake_init(mbedtls_ssl_context *ssl)
     mbedtls_ssl_session_init(ssl->session_negotiate);
     ssl_handshake_params_init(ssl->handshake);
 
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+    if (ssl->conf->hs_arena_size != 0) {
+        /* Not fatal: without an arena, items are allocated one by one */
+        ssl->handshake->arena = mbedtls_calloc(1, ssl->conf->hs_arena_size);
+        if (ssl->handshake->arena != NULL) {
+            ssl->handshake->arena_size = ssl->conf->hs_arena_size;
+        } else {
+            MBEDTLS_SSL_DEBUG_MSG(1, ("alloc() of handshake arena failed"));
+        }
+    }
+#endif /* MBEDTLS_SSL_HANDSHAKE_ARENA */
+
 #if defined(MBEDTLS_SSL_PROTO_TLS1_2)
     mbedtls_ssl_transform_init(ssl->transform_negotiate);
 #endif
@@ -1387,6 +1528,121 @@ static int ssl_conf_check(const mbedtls_ssl_context *ssl)
     return 0;
 }
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+int mbedtls_ssl_buffers_acquire(mbedtls_ssl_context *ssl)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    unsigned char *buf;
+
+    if (ssl->buffer_pool == NULL || ssl->in_buf != NULL) {
+        return 0;
+    }
+
+    ret = mbedtls_ssl_buffer_pool_get(ssl->buffer_pool, &buf);
+    if (ret != 0) {
+        MBEDTLS_SSL_DEBUG_RET(1, "mbedtls_ssl_buffer_pool_get", ret);
+        return ret;
+    }
+
+    ssl->in_buf  = buf;
+    ssl->out_buf = buf + MBEDTLS_SSL_IN_BUFFER_LEN;
+
+    /* Nothing was in flight when the buffers were returned, so records
+     * start at the beginning of the buffers again. */
+    mbedtls_ssl_reset_in_out_pointers(ssl);
+    mbedtls_ssl_update_out_pointers(ssl, ssl->transform_out);
+
+    /* For TLS, the incoming record counter is kept in the input buffer */
+    memcpy(ssl->in_ctr, ssl->pool_in_ctr, MBEDTLS_SSL_SEQUENCE_NUMBER_LEN);
+
+    MBEDTLS_SSL_DEBUG_MSG(3, ("buffers borrowed from the pool"));
+
+    return 0;
+}
+
+static void ssl_buffers_release(mbedtls_ssl_context *ssl)
+{
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    unsigned char *pool_out_buf = ssl->in_buf + MBEDTLS_SSL_IN_BUFFER_LEN;
+    size_t i;
+
+    /* Queued records swap the output buffer with spare queue buffers, so
+     * the one from the pool may be in the queue now: swap it back. */
+    if (ssl->out_buf != pool_out_buf && ssl->out_queue != NULL) {
+        for (i = 0; i < MBEDTLS_SSL_OUT_QUEUE_LEN; i++) {
+            if (ssl->out_queue->item[i].buf == pool_out_buf) {
+                ssl->out_queue->item[i].buf = ssl->out_buf;
+                ssl->out_buf = pool_out_buf;
+                break;
+            }
+        }
+    }
+#endif
+
+    memcpy(ssl->pool_in_ctr, ssl->in_ctr, MBEDTLS_SSL_SEQUENCE_NUMBER_LEN);
+    mbedtls_ssl_buffer_pool_put(ssl->buffer_pool, ssl->in_buf);
+
+    ssl->in_buf = NULL;
+    ssl->out_buf = NULL;
+
+    ssl->in_hdr = NULL;
+    ssl->in_ctr = NULL;
+    ssl->in_len = NULL;
+    ssl->in_iv = NULL;
+    ssl->in_msg = NULL;
+
+    ssl->out_hdr = NULL;
+    ssl->out_ctr = NULL;
+    ssl->out_len = NULL;
+    ssl->out_iv = NULL;
+    ssl->out_msg = NULL;
+}
+
+void mbedtls_ssl_buffers_release_idle(mbedtls_ssl_context *ssl)
+{
+    if (ssl->buffer_pool == NULL || ssl->in_buf == NULL ||
+        ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        return;
+    }
+
+    /* Nothing left to send and no zero-copy write in progress */
+    if (ssl->out_left != 0 || ssl->out_reserved != 0 ||
+        ssl->out_commit_pending) {
+        return;
+    }
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    if (ssl->out_queue != NULL &&
+        (mbedtls_ssl_out_queue_pending(ssl) || ssl->out_queue->app_len != 0)) {
+        return;
+    }
+#endif
+
+    /* No partial record received and no unread data. The last handshake
+     * message of a record counts as consumed once it has been processed. */
+    if (ssl->in_left != ssl->next_record_offset ||
+        ssl->in_offt != NULL || ssl->keep_current_message != 0) {
+        return;
+    }
+    if (ssl->in_msglen != 0 &&
+        (ssl->in_hslen == 0 || ssl->in_hslen < ssl->in_msglen)) {
+        return;
+    }
+
+    ssl->in_left = 0;
+    ssl->next_record_offset = 0;
+    ssl->in_msglen = 0;
+    ssl->in_hslen = 0;
+    ssl_buffers_release(ssl);
+
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    /* The spare record buffers of the queue are as large as out_buf */
+    mbedtls_ssl_out_queue_free(ssl);
+#endif
+
+    MBEDTLS_SSL_DEBUG_MSG(3, ("buffers returned to the pool"));
+}
+#endif /* MBEDTLS_SSL_BUFFER_POOL_C */
+
 /*
  * Setup an SSL context
  */
@@ -1414,25 +1670,36 @@ int mbedtls_ssl_setup(mbedtls_ssl_context *ssl,
 
 #if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
     ssl->in_buf_len = in_buf_len;
+    ssl->out_buf_len = out_buf_len;
 #endif
-    ssl->in_buf = mbedtls_calloc(1, in_buf_len);
-    if (ssl->in_buf == NULL) {
-        MBEDTLS_SSL_DEBUG_MSG(1, ("alloc(%" MBEDTLS_PRINTF_SIZET " bytes) failed", in_buf_len));
-        ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
-        goto error;
-    }
 
-#if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
-    ssl->out_buf_len = out_buf_len;
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    /* Buffers are borrowed from the pool when they are needed */
+    if (conf->buffer_pool != NULL &&
+        conf->transport == MBEDTLS_SSL_TRANSPORT_STREAM) {
+        ssl->buffer_pool = conf->buffer_pool;
+        ssl->in_buf = NULL;
+    } else
 #endif
-    ssl->out_buf = mbedtls_calloc(1, out_buf_len);
-    if (ssl->out_buf == NULL) {
-        MBEDTLS_SSL_DEBUG_MSG(1, ("alloc(%" MBEDTLS_PRINTF_SIZET " bytes) failed", out_buf_len));
-        ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
-        goto error;
-    }
+    {
+        ssl->in_buf = mbedtls_calloc(1, in_buf_len);
+        if (ssl->in_buf == NULL) {
+            MBEDTLS_SSL_DEBUG_MSG(1, ("alloc(%" MBEDTLS_PRINTF_SIZET " bytes) failed",
+                                      in_buf_len));
+            ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+            goto error;
+        }
 
-    mbedtls_ssl_reset_in_out_pointers(ssl);
+        ssl->out_buf = mbedtls_calloc(1, out_buf_len);
+        if (ssl->out_buf == NULL) {
+            MBEDTLS_SSL_DEBUG_MSG(1, ("alloc(%" MBEDTLS_PRINTF_SIZET " bytes) failed",
+                                      out_buf_len));
+            ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
+            goto error;
+        }
+
+        mbedtls_ssl_reset_in_out_pointers(ssl);
+    }
 
 #if defined(MBEDTLS_SSL_DTLS_SRTP)
     memset(&ssl->dtls_srtp_info, 0, sizeof(ssl->dtls_srtp_info));
@@ -1445,6 +1712,9 @@ int mbedtls_ssl_setup(mbedtls_ssl_context *ssl,
     return 0;
 
 error:
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    ssl->buffer_pool = NULL;
+#endif
     mbedtls_free(ssl->in_buf);
     mbedtls_free(ssl->out_buf);
 
@@ -1497,7 +1767,17 @@ void mbedtls_ssl_session_reset_msg_layer(mbedtls_ssl_context *ssl,
     /* Cancel any possibly running timer */
     mbedtls_ssl_set_timer(ssl, 0);
 
-    mbedtls_ssl_reset_in_out_pointers(ssl);
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    /* A reset connection has nothing in flight, so it needs no buffers */
+    if (ssl->buffer_pool != NULL && ssl->in_buf != NULL) {
+        ssl_buffers_release(ssl);
+    }
+    memset(ssl->pool_in_ctr, 0, sizeof(ssl->pool_in_ctr));
+#endif
+
+    if (ssl->in_buf != NULL) {
+        mbedtls_ssl_reset_in_out_pointers(ssl);
+    }
 
     /* Reset incoming message parsing */
     ssl->in_offt    = NULL;
@@ -1508,15 +1788,17 @@ void mbedtls_ssl_session_reset_msg_layer(mbedtls_ssl_context *ssl,
     ssl->keep_current_message = 0;
     ssl->transform_in  = NULL;
 
-#if defined(MBEDTLS_SSL_PROTO_DTLS)
     ssl->next_record_offset = 0;
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
     ssl->in_epoch = 0;
 #endif
 
     /* Keep current datagram if partial == 1 */
     if (partial == 0) {
         ssl->in_left = 0;
-        memset(ssl->in_buf, 0, in_buf_len);
+        if (ssl->in_buf != NULL) {
+            memset(ssl->in_buf, 0, in_buf_len);
+        }
     }
 
     ssl->send_alert = 0;
@@ -1525,9 +1807,22 @@ void mbedtls_ssl_session_reset_msg_layer(mbedtls_ssl_context *ssl,
     ssl->out_msgtype = 0;
     ssl->out_msglen  = 0;
     ssl->out_left    = 0;
-    memset(ssl->out_buf, 0, out_buf_len);
+    ssl->out_reserved = 0;
+    ssl->out_commit_pending = 0;
+    if (ssl->out_buf != NULL) {
+        memset(ssl->out_buf, 0, out_buf_len);
+    }
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    mbedtls_ssl_out_queue_free(ssl);
+#endif
     memset(ssl->cur_out_ctr, 0, sizeof(ssl->cur_out_ctr));
     ssl->transform_out = NULL;
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+    ssl->drs_bytes_sent = 0;
+#endif
+#if defined(MBEDTLS_SSL_KTLS)
+    ssl->ktls = 0;
+#endif
 
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
     mbedtls_ssl_dtls_replay_reset(ssl);
@@ -1549,12 +1844,12 @@ void mbedtls_ssl_session_reset_msg_layer(mbedtls_ssl_context *ssl,
     if (ssl->handshake != NULL) {
 #if defined(MBEDTLS_SSL_EARLY_DATA)
         mbedtls_ssl_transform_free(ssl->handshake->transform_earlydata);
-        mbedtls_free(ssl->handshake->transform_earlydata);
+        mbedtls_ssl_hs_free(ssl, ssl->handshake->transform_earlydata);
         ssl->handshake->transform_earlydata = NULL;
 #endif
 
         mbedtls_ssl_transform_free(ssl->handshake->transform_handshake);
-        mbedtls_free(ssl->handshake->transform_handshake);
+        mbedtls_ssl_hs_free(ssl, ssl->handshake->transform_handshake);
         ssl->handshake->transform_handshake = NULL;
     }
 
@@ -1639,6 +1934,17 @@ void mbedtls_ssl_conf_dtls_anti_replay(mbedtls_ssl_config *conf, char mode)
 {
     conf->anti_replay = mode;
 }
+
+int mbedtls_ssl_conf_dtls_replay_window(mbedtls_ssl_config *conf,
+                                        unsigned window)
+{
+    if (window < 64 || window > MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    conf->replay_window = (uint16_t) window;
+    return 0;
+}
 #endif
 
 void mbedtls_ssl_conf_dtls_badmac_limit(mbedtls_ssl_config *conf, unsigned limit)
@@ -1705,6 +2011,183 @@ void mbedtls_ssl_set_bio(mbedtls_ssl_context *ssl,
     ssl->f_recv_timeout = f_recv_timeout;
 }
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+void mbedtls_ssl_set_bio_vec(mbedtls_ssl_context *ssl,
+                             mbedtls_ssl_send_vec_t *f_send_vec)
+{
+    ssl->f_send_vec = f_send_vec;
+}
+#endif /* MBEDTLS_SSL_VECTORED_SEND */
+
+#if defined(MBEDTLS_SSL_KTLS)
+/*
+ * Check that record protection in the given direction can be handed over
+ * to the kernel, and return the corresponding transform.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_ktls_get_transform(const mbedtls_ssl_context *ssl,
+                                  int direction,
+                                  const mbedtls_ssl_transform **transform)
+{
+    if (direction != MBEDTLS_SSL_KTLS_TX && direction != MBEDTLS_SSL_KTLS_RX) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("kernel TLS is not available with DTLS"));
+        return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+    }
+
+    if (ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("handshake not completed"));
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if ((ssl->ktls & direction) != 0) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("already handed over to the kernel"));
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+#if defined(MBEDTLS_SSL_RENEGOTIATION)
+    /* The library would have to hand the new keys over as well */
+    if (ssl->conf->disable_renegotiation != MBEDTLS_SSL_RENEGOTIATION_DISABLED) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("kernel TLS requires renegotiation to be disabled"));
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+#endif
+
+    if (direction == MBEDTLS_SSL_KTLS_TX) {
+        if (ssl->out_left != 0
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+            || mbedtls_ssl_out_queue_pending(ssl)
+#endif
+            ) {
+            MBEDTLS_SSL_DEBUG_MSG(1, ("there is pending outgoing data"));
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+        *transform = ssl->transform_out;
+    } else {
+        if (mbedtls_ssl_check_pending(ssl) != 0 ||
+            ssl->in_left > ssl->next_record_offset) {
+            MBEDTLS_SSL_DEBUG_MSG(1, ("there is pending incoming data"));
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+        *transform = ssl->transform_in;
+    }
+
+    if (*transform == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if ((*transform)->keylen == 0 ||
+        ((*transform)->cipher_type != MBEDTLS_CIPHER_AES_128_GCM &&
+         (*transform)->cipher_type != MBEDTLS_CIPHER_AES_256_GCM &&
+         (*transform)->cipher_type != MBEDTLS_CIPHER_CHACHA20_POLY1305)) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("kernel TLS is not available with this ciphersuite"));
+        return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+    }
+
+    return 0;
+}
+
+int mbedtls_ssl_get_ktls_info(const mbedtls_ssl_context *ssl,
+                              int direction,
+                              mbedtls_ssl_ktls_info *info)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const mbedtls_ssl_transform *transform = NULL;
+
+    if ((ret = ssl_ktls_get_transform(ssl, direction, &transform)) != 0) {
+        return ret;
+    }
+
+    memset(info, 0, sizeof(*info));
+    info->tls_version = transform->tls_version;
+    info->cipher = transform->cipher_type;
+    info->key_len = transform->keylen;
+    info->iv_len = transform->fixed_ivlen;
+
+    if (direction == MBEDTLS_SSL_KTLS_TX) {
+        memcpy(info->key, transform->key_enc, transform->keylen);
+        memcpy(info->iv, transform->iv_enc, transform->fixed_ivlen);
+        memcpy(info->rec_seq, ssl->cur_out_ctr, sizeof(info->rec_seq));
+    } else {
+        memcpy(info->key, transform->key_dec, transform->keylen);
+        memcpy(info->iv, transform->iv_dec, transform->fixed_ivlen);
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+        if (ssl->in_buf == NULL) {
+            memcpy(info->rec_seq, ssl->pool_in_ctr, sizeof(info->rec_seq));
+        } else
+#endif
+        memcpy(info->rec_seq, ssl->in_ctr, sizeof(info->rec_seq));
+    }
+
+    return 0;
+}
+
+int mbedtls_ssl_set_ktls(mbedtls_ssl_context *ssl,
+                         int directions,
+                         mbedtls_ssl_ktls_send_t *f_ktls_send,
+                         mbedtls_ssl_ktls_recv_t *f_ktls_recv)
+{
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+    const mbedtls_ssl_transform *transform = NULL;
+
+    if (directions == 0 ||
+        (directions & ~(MBEDTLS_SSL_KTLS_TX | MBEDTLS_SSL_KTLS_RX)) != 0) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+
+    if (directions & MBEDTLS_SSL_KTLS_TX) {
+        if (f_ktls_send == NULL) {
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+        if ((ret = ssl_ktls_get_transform(ssl, MBEDTLS_SSL_KTLS_TX,
+                                          &transform)) != 0) {
+            return ret;
+        }
+    }
+
+    if (directions & MBEDTLS_SSL_KTLS_RX) {
+        if (f_ktls_recv == NULL) {
+            return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+        }
+        if ((ret = ssl_ktls_get_transform(ssl, MBEDTLS_SSL_KTLS_RX,
+                                          &transform)) != 0) {
+            return ret;
+        }
+    }
+
+    /* Records in these directions are now plaintext for the library. The
+     * transforms stay owned by the context, and are freed as usual. */
+    if (directions & MBEDTLS_SSL_KTLS_TX) {
+        ssl->f_ktls_send = f_ktls_send;
+        ssl->transform_out = NULL;
+        if (ssl->out_buf != NULL) {
+            mbedtls_ssl_update_out_pointers(ssl, NULL);
+        }
+    }
+
+    if (directions & MBEDTLS_SSL_KTLS_RX) {
+        ssl->f_ktls_recv = f_ktls_recv;
+        ssl->transform_in = NULL;
+        ssl->in_left = 0;
+        ssl->next_record_offset = 0;
+        if (ssl->in_buf != NULL) {
+            mbedtls_ssl_update_in_pointers(ssl);
+        }
+    }
+
+    ssl->ktls |= (uint8_t) directions;
+
+    MBEDTLS_SSL_DEBUG_MSG(2, ("record protection handed over to the kernel: %s%s",
+                              (directions & MBEDTLS_SSL_KTLS_TX) ? "tx " : "",
+                              (directions & MBEDTLS_SSL_KTLS_RX) ? "rx" : ""));
+
+    return 0;
+}
+#endif /* MBEDTLS_SSL_KTLS */
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
 void mbedtls_ssl_set_mtu(mbedtls_ssl_context *ssl, uint16_t mtu)
 {
@@ -1717,6 +2200,38 @@ void mbedtls_ssl_conf_read_timeout(mbedtls_ssl_config *conf, uint32_t timeout)
     conf->read_timeout   = timeout;
 }
 
+void mbedtls_ssl_conf_read_ahead(mbedtls_ssl_config *conf, char mode)
+{
+    conf->read_ahead = mode;
+}
+
+#if defined(MBEDTLS_SSL_DYNAMIC_RECORD_SIZING)
+void mbedtls_ssl_conf_dynamic_record_sizing(mbedtls_ssl_config *conf,
+                                            uint16_t initial_len,
+                                            uint32_t boost_threshold,
+                                            uint32_t idle_timeout)
+{
+    conf->drs_initial_len     = initial_len;
+    conf->drs_boost_threshold = boost_threshold;
+    conf->drs_idle_timeout    = idle_timeout;
+}
+#endif /* MBEDTLS_SSL_DYNAMIC_RECORD_SIZING */
+
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+void mbedtls_ssl_conf_buffer_pool(mbedtls_ssl_config *conf,
+                                  mbedtls_ssl_buffer_pool *pool)
+{
+    conf->buffer_pool = pool;
+}
+#endif /* MBEDTLS_SSL_BUFFER_POOL_C */
+
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+void mbedtls_ssl_conf_handshake_arena(mbedtls_ssl_config *conf, size_t size)
+{
+    conf->hs_arena_size = size;
+}
+#endif /* MBEDTLS_SSL_HANDSHAKE_ARENA */
+
 void mbedtls_ssl_set_timer_cb(mbedtls_ssl_context *ssl,
                               void *p_timer,
                               mbedtls_ssl_set_timer_t *f_set_timer,
@@ -1793,6 +2308,48 @@ int mbedtls_ssl_set_session(mbedtls_ssl_context *ssl, const mbedtls_ssl_session
 }
 #endif /* MBEDTLS_SSL_CLI_C */
 
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+void mbedtls_ssl_conf_session_store(mbedtls_ssl_config *conf,
+                                    mbedtls_ssl_session_store_put_t *f_put,
+                                    mbedtls_ssl_session_store_take_t *f_take,
+                                    void *p_store)
+{
+    conf->f_session_store_put = f_put;
+    conf->f_session_store_take = f_take;
+    conf->p_session_store = p_store;
+}
+
+void mbedtls_ssl_set_peer_port(mbedtls_ssl_context *ssl, uint16_t port)
+{
+    ssl->peer_port = port;
+}
+
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+void mbedtls_ssl_conf_key_share_cache(mbedtls_ssl_config *conf,
+                                      mbedtls_ssl_key_share_get_t *f_get,
+                                      mbedtls_ssl_key_share_set_t *f_set,
+                                      void *p_cache)
+{
+    conf->f_key_share_get = f_get;
+    conf->f_key_share_set = f_set;
+    conf->p_key_share_cache = p_cache;
+}
+#endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
+
+void mbedtls_ssl_store_session(mbedtls_ssl_context *ssl)
+{
+    if (ssl->conf->f_session_store_put == NULL || ssl->hostname == NULL) {
+        return;
+    }
+
+    if (ssl->conf->f_session_store_put(ssl->conf->p_session_store,
+                                       ssl->hostname, ssl->peer_port,
+                                       ssl->session) != 0) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("session store did not store session"));
+    }
+}
+#endif /* MBEDTLS_SSL_CLI_C && MBEDTLS_X509_CRT_PARSE_C */
+
 void mbedtls_ssl_conf_ciphersuites(mbedtls_ssl_config *conf,
                                    const int *ciphersuites)
 {
@@ -1819,6 +2376,16 @@ void mbedtls_ssl_conf_max_early_data_size(
 {
     conf->max_early_data_size = max_early_data_size;
 }
+
+#if defined(MBEDTLS_HAVE_TIME)
+void mbedtls_ssl_conf_early_data_replay(mbedtls_ssl_config *conf,
+                                        mbedtls_ssl_early_data_replay_t *f_early_data_replay,
+                                        void *p_early_data_replay)
+{
+    conf->f_early_data_replay = f_early_data_replay;
+    conf->p_early_data_replay = p_early_data_replay;
+}
+#endif /* MBEDTLS_HAVE_TIME */
 #endif /* MBEDTLS_SSL_SRV_C */
 
 #endif /* MBEDTLS_SSL_EARLY_DATA */
@@ -2778,6 +3345,20 @@ void mbedtls_ssl_conf_groups(mbedtls_ssl_config *conf,
     conf->group_list = group_list;
 }
 
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3) && defined(MBEDTLS_SSL_CLI_C)
+void mbedtls_ssl_conf_tls13_key_shares(mbedtls_ssl_config *conf,
+                                       int num_key_shares)
+{
+    if (num_key_shares < 1) {
+        num_key_shares = 1;
+    } else if (num_key_shares > 2) {
+        num_key_shares = 2;
+    }
+
+    conf->tls13_key_shares = num_key_shares;
+}
+#endif /* MBEDTLS_SSL_PROTO_TLS1_3 && MBEDTLS_SSL_CLI_C */
+
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
 int mbedtls_ssl_set_hostname(mbedtls_ssl_context *ssl, const char *hostname)
 {
@@ -4488,6 +5069,16 @@ static int ssl_prepare_handshake_step(mbedtls_ssl_context *ssl)
      * `mbedtls_ssl_handle_pending_alert` in case an error that triggered an
      * alert occurred.
      */
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    /*
+     * Records queued for a vectored send are only sent once the handshake
+     * waits for input from the peer or is over, so that the whole flight
+     * leaves at once.
+     */
+    if (mbedtls_ssl_out_queue_pending(ssl) && ssl->out_left == 0) {
+        ret = 0;
+    } else
+#endif
     if ((ret = mbedtls_ssl_flush_output(ssl)) != 0) {
         return ret;
     }
@@ -4515,6 +5106,11 @@ int mbedtls_ssl_handshake_step(mbedtls_ssl_context *ssl)
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
+    ret = mbedtls_ssl_buffers_acquire(ssl);
+    if (ret != 0) {
+        return ret;
+    }
+
     ret = ssl_prepare_handshake_step(ssl);
     if (ret != 0) {
         return ret;
@@ -4586,6 +5182,13 @@ int mbedtls_ssl_handshake_step(mbedtls_ssl_context *ssl)
         }
     }
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    /* Send the last flight as soon as the handshake is over */
+    if (ret == 0 && ssl->state == MBEDTLS_SSL_HANDSHAKE_OVER) {
+        ret = mbedtls_ssl_flush_output(ssl);
+    }
+#endif
+
 cleanup:
     return ret;
 }
@@ -4623,6 +5226,13 @@ int mbedtls_ssl_handshake(mbedtls_ssl_context *ssl)
         }
     }
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    /* Finish sending the last flight if a previous call could not */
+    if (ret == 0 && (mbedtls_ssl_out_queue_pending(ssl) || ssl->out_left != 0)) {
+        ret = mbedtls_ssl_flush_output(ssl);
+    }
+#endif
+
     MBEDTLS_SSL_DEBUG_MSG(2, ("<= handshake"));
 
     return ret;
@@ -4721,6 +5331,10 @@ int mbedtls_ssl_renegotiate(mbedtls_ssl_context *ssl)
 
         ssl->renego_status = MBEDTLS_SSL_RENEGOTIATION_PENDING;
 
+        if ((ret = mbedtls_ssl_buffers_acquire(ssl)) != 0) {
+            return ret;
+        }
+
         /* Did we already try/start sending HelloRequest? */
         if (ssl->out_left != 0) {
             return mbedtls_ssl_flush_output(ssl);
@@ -4782,7 +5396,7 @@ void mbedtls_ssl_handshake_free(mbedtls_ssl_context *ssl)
 #endif /* MBEDTLS_DEPRECATED_REMOVED */
 #if defined(MBEDTLS_SSL_PROTO_TLS1_3)
     if (ssl->handshake->certificate_request_context) {
-        mbedtls_free((void *) handshake->certificate_request_context);
+        mbedtls_ssl_hs_free(ssl, handshake->certificate_request_context);
     }
 #endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
 #endif /* MBEDTLS_SSL_HANDSHAKE_WITH_CERT_ENABLED */
@@ -4833,7 +5447,7 @@ void mbedtls_ssl_handshake_free(mbedtls_ssl_context *ssl)
     mbedtls_ecjpake_free(&handshake->ecjpake_ctx);
 #endif /* MBEDTLS_USE_PSA_CRYPTO */
 #if defined(MBEDTLS_SSL_CLI_C)
-    mbedtls_free(handshake->ecjpake_cache);
+    mbedtls_ssl_hs_free(ssl, handshake->ecjpake_cache);
     handshake->ecjpake_cache = NULL;
     handshake->ecjpake_cache_len = 0;
 #endif
@@ -4843,7 +5457,7 @@ void mbedtls_ssl_handshake_free(mbedtls_ssl_context *ssl)
     defined(MBEDTLS_KEY_EXCHANGE_WITH_ECDSA_ANY_ENABLED) || \
     defined(MBEDTLS_KEY_EXCHANGE_ECJPAKE_ENABLED)
     /* explicit void pointer cast for buggy MS compiler */
-    mbedtls_free((void *) handshake->curves_tls_id);
+    mbedtls_ssl_hs_free(ssl, (void *) handshake->curves_tls_id);
 #endif
 
 #if defined(MBEDTLS_SSL_HANDSHAKE_WITH_PSK_ENABLED)
@@ -4888,12 +5502,12 @@ void mbedtls_ssl_handshake_free(mbedtls_ssl_context *ssl)
 
 #if defined(MBEDTLS_SSL_CLI_C) && \
     (defined(MBEDTLS_SSL_PROTO_DTLS) || defined(MBEDTLS_SSL_PROTO_TLS1_3))
-    mbedtls_free(handshake->cookie);
+    mbedtls_ssl_hs_free(ssl, handshake->cookie);
 #endif /* MBEDTLS_SSL_CLI_C &&
           ( MBEDTLS_SSL_PROTO_DTLS || MBEDTLS_SSL_PROTO_TLS1_3 ) */
 
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
-    mbedtls_ssl_flight_free(handshake->flight);
+    mbedtls_ssl_flight_free(ssl, handshake->flight);
     mbedtls_ssl_buffering_free(ssl);
 #endif /* MBEDTLS_SSL_PROTO_DTLS */
 
@@ -4902,16 +5516,24 @@ void mbedtls_ssl_handshake_free(mbedtls_ssl_context *ssl)
         psa_destroy_key(handshake->xxdh_psa_privkey);
     }
 #endif /* MBEDTLS_KEY_EXCHANGE_SOME_XXDH_PSA_ANY_ENABLED */
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3) && defined(MBEDTLS_SSL_CLI_C) && \
+    defined(MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED)
+    psa_destroy_key(handshake->extra_xxdh_psa_privkey);
+#endif
 
 #if defined(MBEDTLS_SSL_PROTO_TLS1_3)
     mbedtls_ssl_transform_free(handshake->transform_handshake);
-    mbedtls_free(handshake->transform_handshake);
+    mbedtls_ssl_hs_free(ssl, handshake->transform_handshake);
 #if defined(MBEDTLS_SSL_EARLY_DATA)
     mbedtls_ssl_transform_free(handshake->transform_earlydata);
-    mbedtls_free(handshake->transform_earlydata);
+    mbedtls_ssl_hs_free(ssl, handshake->transform_earlydata);
 #endif
 #endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
 
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+    ssl_handshake_arena_free(ssl);
+#endif
+
 
 #if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
     /* If the buffers are too big - reallocate. Because of the way Mbed TLS
@@ -4965,8 +5587,11 @@ void mbedtls_ssl_session_free(mbedtls_ssl_session *session)
 
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
 #define SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_ANTI_REPLAY 1u
+#define SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_REPLAY_WINDOW \
+    ((uint32_t) MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS - 1u)
 #else
 #define SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_ANTI_REPLAY 0u
+#define SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_REPLAY_WINDOW 0u
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
 #if defined(MBEDTLS_SSL_ALPN)
@@ -4979,6 +5604,7 @@ void mbedtls_ssl_session_free(mbedtls_ssl_session *session)
 #define SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_BADMAC_LIMIT_BIT     1
 #define SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_ANTI_REPLAY_BIT      2
 #define SSL_SERIALIZED_CONTEXT_CONFIG_ALPN_BIT                  3
+#define SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_REPLAY_WINDOW_BIT    4
 
 #define SSL_SERIALIZED_CONTEXT_CONFIG_BITFLAG   \
     ((uint32_t) (                              \
@@ -4989,6 +5615,8 @@ void mbedtls_ssl_session_free(mbedtls_ssl_session *session)
          (SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_ANTI_REPLAY << \
              SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_ANTI_REPLAY_BIT) | \
          (SSL_SERIALIZED_CONTEXT_CONFIG_ALPN << SSL_SERIALIZED_CONTEXT_CONFIG_ALPN_BIT) | \
+         (SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_REPLAY_WINDOW << \
+             SSL_SERIALIZED_CONTEXT_CONFIG_DTLS_REPLAY_WINDOW_BIT) | \
          0u))
 
 static const unsigned char ssl_serialized_context_header[] = {
@@ -5025,7 +5653,8 @@ static const unsigned char ssl_serialized_context_header[] = {
  *  // fields from ssl_context
  *  uint32 badmac_seen;         // DTLS: number of records with failing MAC
  *  uint64 in_window_top;       // DTLS: last validated record seq_num
- *  uint64 in_window;           // DTLS: bitmask for replay protection
+ *  uint64 in_window[n];        // DTLS: bitmask for replay protection,
+ *                              // n = context_format bits 4-9 plus 1
  *  uint8 disable_datagram_packing; // DTLS: only one record per datagram
  *  uint64 cur_out_ctr;         // Record layer: outgoing sequence number
  *  uint16 mtu;                 // DTLS: path mtu (max outgoing fragment size)
@@ -5170,13 +5799,13 @@ int mbedtls_ssl_context_save(mbedtls_ssl_context *ssl,
     }
 
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
-    used += 16;
+    used += 8 + 8 * MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS;
     if (used <= buf_len) {
         MBEDTLS_PUT_UINT64_BE(ssl->in_window_top, p, 0);
         p += 8;
 
-        MBEDTLS_PUT_UINT64_BE(ssl->in_window, p, 0);
-        p += 8;
+        mbedtls_ssl_dtls_replay_save(ssl, p);
+        p += 8 * MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS;
     }
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
@@ -5399,15 +6028,15 @@ static int ssl_context_load(mbedtls_ssl_context *ssl,
     p += 4;
 
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
-    if ((size_t) (end - p) < 16) {
+    if ((size_t) (end - p) < 8 + 8 * MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS) {
         return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
     }
 
     ssl->in_window_top = MBEDTLS_GET_UINT64_BE(p, 0);
     p += 8;
 
-    ssl->in_window = MBEDTLS_GET_UINT64_BE(p, 0);
-    p += 8;
+    mbedtls_ssl_dtls_replay_load(ssl, p);
+    p += 8 * MBEDTLS_SSL_DTLS_REPLAY_SAVED_WORDS;
 #endif /* MBEDTLS_SSL_DTLS_ANTI_REPLAY */
 
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
@@ -5475,7 +6104,9 @@ static int ssl_context_load(mbedtls_ssl_context *ssl,
 
     /* Adjust pointers for header fields of outgoing records to
      * the given transform, accounting for explicit IV and CID. */
-    mbedtls_ssl_update_out_pointers(ssl, ssl->transform);
+    if (ssl->out_buf != NULL) {
+        mbedtls_ssl_update_out_pointers(ssl, ssl->transform);
+    }
 
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     ssl->in_epoch = 1;
@@ -5529,6 +6160,12 @@ void mbedtls_ssl_free(mbedtls_ssl_context *ssl)
 
     MBEDTLS_SSL_DEBUG_MSG(2, ("=> free"));
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    if (ssl->buffer_pool != NULL && ssl->in_buf != NULL) {
+        ssl_buffers_release(ssl);
+    }
+#endif
+
     if (ssl->out_buf != NULL) {
 #if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
         size_t out_buf_len = ssl->out_buf_len;
@@ -5540,6 +6177,10 @@ void mbedtls_ssl_free(mbedtls_ssl_context *ssl)
         ssl->out_buf = NULL;
     }
 
+#if defined(MBEDTLS_SSL_VECTORED_SEND)
+    mbedtls_ssl_out_queue_free(ssl);
+#endif
+
     if (ssl->in_buf != NULL) {
 #if defined(MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH)
         size_t in_buf_len = ssl->in_buf_len;
@@ -5897,6 +6538,7 @@ int mbedtls_ssl_config_defaults(mbedtls_ssl_config *conf,
 
 #if defined(MBEDTLS_SSL_DTLS_ANTI_REPLAY)
     conf->anti_replay = MBEDTLS_SSL_ANTI_REPLAY_ENABLED;
+    conf->replay_window = 64;
 #endif
 
 #if defined(MBEDTLS_SSL_SRV_C)
@@ -5947,6 +6589,9 @@ int mbedtls_ssl_config_defaults(mbedtls_ssl_config *conf,
      * Allow all TLS 1.3 key exchange modes by default.
      */
     conf->tls13_kex_modes = MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_ALL;
+#if defined(MBEDTLS_SSL_CLI_C)
+    conf->tls13_key_shares = 1;
+#endif
 #endif /* MBEDTLS_SSL_PROTO_TLS1_3 */
 
     if (transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
@@ -8513,6 +9158,23 @@ void mbedtls_ssl_handshake_wrapup(mbedtls_ssl_context *ssl)
         }
     }
 
+#if defined(MBEDTLS_SSL_CLI_C) && defined(MBEDTLS_X509_CRT_PARSE_C)
+    /*
+     * Add session store entry. TLS 1.3 tickets are stored as they are
+     * received, a TLS 1.2 session when it is new or may have a new ticket.
+     */
+    if (ssl->conf->endpoint == MBEDTLS_SSL_IS_CLIENT &&
+        ssl->session->tls_version == MBEDTLS_SSL_VERSION_TLS1_2) {
+        int resumable = resume == 0 && ssl->session->id_len != 0;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        resumable |= ssl->session->ticket != NULL;
+#endif
+        if (resumable) {
+            mbedtls_ssl_store_session(ssl);
+        }
+    }
+#endif /* MBEDTLS_SSL_CLI_C && MBEDTLS_X509_CRT_PARSE_C */
+
 #if defined(MBEDTLS_SSL_PROTO_DTLS)
     if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM &&
         ssl->handshake->flight != NULL) {
@@ -9103,6 +9765,15 @@ static int ssl_tls12_populate_transform(mbedtls_ssl_transform *transform,
         goto end;
     }
 
+#if defined(MBEDTLS_SSL_KTLS)
+    if (keylen <= sizeof(transform->key_enc)) {
+        transform->cipher_type = (mbedtls_cipher_type_t) ciphersuite_info->cipher;
+        transform->keylen = keylen;
+        memcpy(transform->key_enc, key1, keylen);
+        memcpy(transform->key_dec, key2, keylen);
+    }
+#endif /* MBEDTLS_SSL_KTLS */
+
     if (ssl->f_export_keys != NULL) {
         ssl->f_export_keys(ssl->p_export_keys,
                            MBEDTLS_SSL_KEY_EXPORT_TLS12_MASTER_SECRET,
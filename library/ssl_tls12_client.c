@@ -185,7 +185,7 @@ static int ssl_write_ecjpake_kkpp_ext(mbedtls_ssl_context *ssl,
         }
 #endif /* MBEDTLS_USE_PSA_CRYPTO */
 
-        ssl->handshake->ecjpake_cache = mbedtls_calloc(1, kkpp_len);
+        ssl->handshake->ecjpake_cache = mbedtls_ssl_hs_calloc(ssl, 1, kkpp_len);
         if (ssl->handshake->ecjpake_cache == NULL) {
             MBEDTLS_SSL_DEBUG_MSG(1, ("allocation failed"));
             return MBEDTLS_ERR_SSL_ALLOC_FAILED;
@@ -870,7 +870,7 @@ static int ssl_parse_ecjpake_kkpp(mbedtls_ssl_context *ssl,
     }
 
     /* If we got here, we no longer need our cached extension */
-    mbedtls_free(ssl->handshake->ecjpake_cache);
+    mbedtls_ssl_hs_free(ssl, ssl->handshake->ecjpake_cache);
     ssl->handshake->ecjpake_cache = NULL;
     ssl->handshake->ecjpake_cache_len = 0;
 
@@ -1149,9 +1149,9 @@ static int ssl_parse_hello_verify_request(mbedtls_ssl_context *ssl)
     }
     MBEDTLS_SSL_DEBUG_BUF(3, "cookie", p, cookie_len);
 
-    mbedtls_free(ssl->handshake->cookie);
+    mbedtls_ssl_hs_free(ssl, ssl->handshake->cookie);
 
-    ssl->handshake->cookie = mbedtls_calloc(1, cookie_len);
+    ssl->handshake->cookie = mbedtls_ssl_hs_calloc(ssl, 1, cookie_len);
     if (ssl->handshake->cookie  == NULL) {
         MBEDTLS_SSL_DEBUG_MSG(1, ("alloc failed (%d bytes)", cookie_len));
         return MBEDTLS_ERR_SSL_ALLOC_FAILED;
@@ -1236,7 +1236,7 @@ static int ssl_parse_server_hello(mbedtls_ssl_context *ssl)
             return ssl_parse_hello_verify_request(ssl);
         } else {
             /* We made it through the verification process */
-            mbedtls_free(ssl->handshake->cookie);
+            mbedtls_ssl_hs_free(ssl, ssl->handshake->cookie);
             ssl->handshake->cookie = NULL;
             ssl->handshake->cookie_len = 0;
         }
@@ -216,8 +216,8 @@ static int ssl_parse_supported_groups_ext(mbedtls_ssl_context *ssl,
         our_size = MBEDTLS_ECP_DP_MAX;
     }
 
-    if ((curves_tls_id = mbedtls_calloc(our_size,
-                                        sizeof(*curves_tls_id))) == NULL) {
+    if ((curves_tls_id = mbedtls_ssl_hs_calloc(ssl, our_size,
+                                               sizeof(*curves_tls_id))) == NULL) {
         mbedtls_ssl_send_alert_message(ssl, MBEDTLS_SSL_ALERT_LEVEL_FATAL,
                                        MBEDTLS_SSL_ALERT_MSG_INTERNAL_ERROR);
         return MBEDTLS_ERR_SSL_ALLOC_FAILED;
@@ -1017,12 +1017,12 @@ read_record_header:
             }
 
             /* Done reading this record, get ready for the next one */
-#if defined(MBEDTLS_SSL_PROTO_DTLS)
-            if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
+            if (ssl->conf->transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM ||
+                ssl->conf->read_ahead == MBEDTLS_SSL_READ_AHEAD_ENABLED) {
                 ssl->next_record_offset = msg_len + mbedtls_ssl_in_hdr_len(ssl);
-            } else
-#endif
-            ssl->in_left = 0;
+            } else {
+                ssl->in_left = 0;
+            }
         }
     }
 
@@ -186,8 +186,11 @@ static int ssl_tls13_reset_key_share(mbedtls_ssl_context *ssl)
         int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
         psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
 
-        /* Destroy generated private key. */
+        /* Destroy generated private keys. */
         status = psa_destroy_key(ssl->handshake->xxdh_psa_privkey);
+        if (status == PSA_SUCCESS) {
+            status = psa_destroy_key(ssl->handshake->extra_xxdh_psa_privkey);
+        }
         if (status != PSA_SUCCESS) {
             ret = PSA_TO_MBEDTLS_ERR(status);
             MBEDTLS_SSL_DEBUG_RET(1, "psa_destroy_key", ret);
@@ -195,6 +198,8 @@ static int ssl_tls13_reset_key_share(mbedtls_ssl_context *ssl)
         }
 
         ssl->handshake->xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
+        ssl->handshake->extra_xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
+        ssl->handshake->extra_group_id = 0;
         return 0;
     } else
 #endif /* MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED */
@@ -209,40 +214,124 @@ static int ssl_tls13_reset_key_share(mbedtls_ssl_context *ssl)
  * Functions for writing key_share extension.
  */
 #if defined(MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED)
+static int ssl_tls13_group_is_usable(uint16_t group_id)
+{
+#if defined(PSA_WANT_ALG_ECDH)
+    if ((mbedtls_ssl_get_psa_curve_info_from_tls_id(
+             group_id, NULL, NULL) == PSA_SUCCESS) &&
+        mbedtls_ssl_tls13_named_group_is_ecdhe(group_id)) {
+        return 1;
+    }
+#endif
+#if defined(PSA_WANT_ALG_FFDH)
+    if (mbedtls_ssl_tls13_named_group_is_ffdh(group_id)) {
+        return 1;
+    }
+#endif
+    ((void) group_id);
+    return 0;
+}
+
+/*
+ * Pick the first available group compatible with TLS 1.3 other than
+ * `excluded_group_id`, or the group the server selected in the last
+ * handshake if the key share cache knows it and it is still configured.
+ */
 MBEDTLS_CHECK_RETURN_CRITICAL
 static int ssl_tls13_get_default_group_id(mbedtls_ssl_context *ssl,
+                                          uint16_t excluded_group_id,
                                           uint16_t *group_id)
 {
-    int ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
-
-
-#if defined(PSA_WANT_ALG_ECDH) || defined(PSA_WANT_ALG_FFDH)
     const uint16_t *group_list = mbedtls_ssl_get_groups(ssl);
-    /* Pick first available ECDHE group compatible with TLS 1.3 */
+
     if (group_list == NULL) {
         return MBEDTLS_ERR_SSL_BAD_CONFIG;
     }
 
-    for (; *group_list != 0; group_list++) {
-#if defined(PSA_WANT_ALG_ECDH)
-        if ((mbedtls_ssl_get_psa_curve_info_from_tls_id(
-                 *group_list, NULL, NULL) == PSA_SUCCESS) &&
-            mbedtls_ssl_tls13_named_group_is_ecdhe(*group_list)) {
-            *group_id = *group_list;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    if (excluded_group_id == 0 &&
+        ssl->conf->f_key_share_get != NULL && ssl->hostname != NULL) {
+        uint16_t cached_group_id;
+
+        if (ssl->conf->f_key_share_get(ssl->conf->p_key_share_cache,
+                                       ssl->hostname, ssl->peer_port,
+                                       &cached_group_id) == 0 &&
+            mbedtls_ssl_check_curve_tls_id(ssl, cached_group_id) == 0 &&
+            ssl_tls13_group_is_usable(cached_group_id)) {
+            MBEDTLS_SSL_DEBUG_MSG(3, ("predicted group: %s",
+                                      mbedtls_ssl_named_group_to_str(cached_group_id)));
+            *group_id = cached_group_id;
             return 0;
         }
-#endif
-#if defined(PSA_WANT_ALG_FFDH)
-        if (mbedtls_ssl_tls13_named_group_is_ffdh(*group_list)) {
+    }
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
+    for (; *group_list != 0; group_list++) {
+        if (*group_list != excluded_group_id &&
+            ssl_tls13_group_is_usable(*group_list)) {
             *group_id = *group_list;
             return 0;
         }
-#endif
     }
-#else
-    ((void) ssl);
-    ((void) group_id);
+
+    return MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+}
+
+/*
+ * Write a KeyShareEntry for `group_id`, generating its private key in
+ * ssl->handshake->xxdh_psa_privkey.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_tls13_write_key_share_entry(mbedtls_ssl_context *ssl,
+                                           uint16_t group_id,
+                                           unsigned char *buf,
+                                           unsigned char *end,
+                                           size_t *out_len)
+{
+    unsigned char *p = buf;
+    int ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+
+    *out_len = 0;
+
+    /*
+     * Dispatch to type-specific key generation function.
+     *
+     * So far, we're only supporting ECDHE. With the introduction
+     * of PQC KEMs, we'll want to have multiple branches, one per
+     * type of KEM, and dispatch to the corresponding crypto.
+     */
+#if defined(PSA_WANT_ALG_ECDH) || defined(PSA_WANT_ALG_FFDH)
+    if (mbedtls_ssl_tls13_named_group_is_ecdhe(group_id) ||
+        mbedtls_ssl_tls13_named_group_is_ffdh(group_id)) {
+        /* Length of key_exchange */
+        size_t key_exchange_len = 0;
+
+        /* Check there is space for header of KeyShareEntry
+         * - group                  (2 bytes)
+         * - key_exchange_length    (2 bytes)
+         */
+        MBEDTLS_SSL_CHK_BUF_PTR(p, end, 4);
+        p += 4;
+        ret = mbedtls_ssl_tls13_generate_and_write_xxdh_key_exchange(
+            ssl, group_id, p, end, &key_exchange_len);
+        p += key_exchange_len;
+        if (ret != 0) {
+            return ret;
+        }
+
+        /* Write group */
+        MBEDTLS_PUT_UINT16_BE(group_id, buf, 0);
+        /* Write key_exchange_length */
+        MBEDTLS_PUT_UINT16_BE(key_exchange_len, buf, 2);
+    } else
 #endif /* PSA_WANT_ALG_ECDH || PSA_WANT_ALG_FFDH */
+    if (0 /* other KEMs? */) {
+        /* Do something */
+    } else {
+        return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+    }
+
+    *out_len = p - buf;
 
     return ret;
 }
@@ -269,7 +358,8 @@ static int ssl_tls13_write_key_share_ext(mbedtls_ssl_context *ssl,
     unsigned char *p = buf;
     unsigned char *client_shares; /* Start of client_shares */
     size_t client_shares_len;     /* Length of client_shares */
-    uint16_t group_id;
+    size_t entry_len;
+    uint16_t group_id, extra_group_id;
     int ret = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
 
     *out_len = 0;
@@ -288,50 +378,38 @@ static int ssl_tls13_write_key_share_ext(mbedtls_ssl_context *ssl,
     group_id = ssl->handshake->offered_group_id;
     if (!mbedtls_ssl_tls13_named_group_is_ecdhe(group_id) &&
         !mbedtls_ssl_tls13_named_group_is_ffdh(group_id)) {
-        MBEDTLS_SSL_PROC_CHK(ssl_tls13_get_default_group_id(ssl,
+        MBEDTLS_SSL_PROC_CHK(ssl_tls13_get_default_group_id(ssl, 0,
                                                             &group_id));
     }
 
+    client_shares = p;
+    ret = ssl_tls13_write_key_share_entry(ssl, group_id, p, end, &entry_len);
+    if (ret != 0) {
+        return ret;
+    }
+    p += entry_len;
+
     /*
-     * Dispatch to type-specific key generation function.
-     *
-     * So far, we're only supporting ECDHE. With the introduction
-     * of PQC KEMs, we'll want to have multiple branches, one per
-     * type of KEM, and dispatch to the corresponding crypto. And
-     * only one key share entry is allowed.
+     * The first ClientHello may offer a second key share, for the next
+     * group, so that a server preferring it doesn't need an HRR. Its private
+     * key is set aside until the server selects one of the two groups.
      */
-    client_shares = p;
-#if defined(PSA_WANT_ALG_ECDH) || defined(PSA_WANT_ALG_FFDH)
-    if (mbedtls_ssl_tls13_named_group_is_ecdhe(group_id) ||
-        mbedtls_ssl_tls13_named_group_is_ffdh(group_id)) {
-        /* Pointer to group */
-        unsigned char *group = p;
-        /* Length of key_exchange */
-        size_t key_exchange_len = 0;
+    if (ssl->conf->tls13_key_shares > 1 &&
+        !ssl->handshake->hello_retry_request_flag &&
+        ssl_tls13_get_default_group_id(ssl, group_id, &extra_group_id) == 0) {
+        mbedtls_svc_key_id_t privkey = ssl->handshake->xxdh_psa_privkey;
 
-        /* Check there is space for header of KeyShareEntry
-         * - group                  (2 bytes)
-         * - key_exchange_length    (2 bytes)
-         */
-        MBEDTLS_SSL_CHK_BUF_PTR(p, end, 4);
-        p += 4;
-        ret = mbedtls_ssl_tls13_generate_and_write_xxdh_key_exchange(
-            ssl, group_id, p, end, &key_exchange_len);
-        p += key_exchange_len;
+        ssl->handshake->xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
+        ret = ssl_tls13_write_key_share_entry(ssl, extra_group_id,
+                                              p, end, &entry_len);
+        ssl->handshake->extra_xxdh_psa_privkey = ssl->handshake->xxdh_psa_privkey;
+        ssl->handshake->xxdh_psa_privkey = privkey;
         if (ret != 0) {
             return ret;
         }
+        p += entry_len;
 
-        /* Write group */
-        MBEDTLS_PUT_UINT16_BE(group_id, group, 0);
-        /* Write key_exchange_length */
-        MBEDTLS_PUT_UINT16_BE(key_exchange_len, group, 2);
-    } else
-#endif /* PSA_WANT_ALG_ECDH || PSA_WANT_ALG_FFDH */
-    if (0 /* other KEMs? */) {
-        /* Do something */
-    } else {
-        return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
+        ssl->handshake->extra_group_id = extra_group_id;
     }
 
     /* Length of client_shares */
@@ -429,7 +507,11 @@ static int ssl_tls13_parse_hrr_key_share_ext(mbedtls_ssl_context *ssl,
      * ClientHello then the client MUST abort the handshake with
      * an "illegal_parameter" alert.
      */
-    if (found == 0 || selected_group == ssl->handshake->offered_group_id) {
+    if (found == 0 || selected_group == ssl->handshake->offered_group_id
+#if defined(MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED)
+        || selected_group == ssl->handshake->extra_group_id
+#endif
+        ) {
         MBEDTLS_SSL_DEBUG_MSG(1, ("Invalid key share in HRR"));
         MBEDTLS_SSL_PEND_FATAL_ALERT(
             MBEDTLS_SSL_ALERT_MSG_ILLEGAL_PARAMETER,
@@ -449,6 +531,40 @@ static int ssl_tls13_parse_hrr_key_share_ext(mbedtls_ssl_context *ssl,
 #endif /* PSA_WANT_ALG_ECDH || PSA_WANT_ALG_FFDH */
 }
 
+#if defined(MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED)
+/*
+ * When two key shares were offered, keep the private key of the one the
+ * server selected, if any, and destroy the other one.
+ */
+MBEDTLS_CHECK_RETURN_CRITICAL
+static int ssl_tls13_keep_selected_key_share(mbedtls_ssl_context *ssl,
+                                             uint16_t group)
+{
+    mbedtls_ssl_handshake_params *handshake = ssl->handshake;
+    mbedtls_svc_key_id_t unused_privkey = handshake->extra_xxdh_psa_privkey;
+    psa_status_t status = PSA_ERROR_CORRUPTION_DETECTED;
+    int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
+
+    if (group == handshake->extra_group_id) {
+        unused_privkey = handshake->xxdh_psa_privkey;
+        handshake->xxdh_psa_privkey = handshake->extra_xxdh_psa_privkey;
+        handshake->offered_group_id = group;
+    }
+
+    handshake->extra_xxdh_psa_privkey = MBEDTLS_SVC_KEY_ID_INIT;
+    handshake->extra_group_id = 0;
+
+    status = psa_destroy_key(unused_privkey);
+    if (status != PSA_SUCCESS) {
+        ret = PSA_TO_MBEDTLS_ERR(status);
+        MBEDTLS_SSL_DEBUG_RET(1, "psa_destroy_key", ret);
+        return ret;
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED */
+
 /*
  * ssl_tls13_parse_key_share_ext()
  *      Parse key_share extension in Server Hello
@@ -478,6 +594,15 @@ static int ssl_tls13_parse_key_share_ext(mbedtls_ssl_context *ssl,
     group = MBEDTLS_GET_UINT16_BE(p, 0);
     p += 2;
 
+#if defined(MBEDTLS_SSL_TLS1_3_KEY_EXCHANGE_MODE_SOME_EPHEMERAL_ENABLED)
+    if (ssl->handshake->extra_group_id != 0) {
+        ret = ssl_tls13_keep_selected_key_share(ssl, group);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+#endif
+
     /* Check that the chosen group matches the one we offered. */
     offered_group = ssl->handshake->offered_group_id;
     if (offered_group != group) {
@@ -506,6 +631,16 @@ static int ssl_tls13_parse_key_share_ext(mbedtls_ssl_context *ssl,
         return MBEDTLS_ERR_SSL_INTERNAL_ERROR;
     }
 
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    /* Remember the group for the next handshakes with this server. Failing
+     * to do so is not fatal. */
+    if (ssl->conf->f_key_share_set != NULL && ssl->hostname != NULL) {
+        (void) ssl->conf->f_key_share_set(ssl->conf->p_key_share_cache,
+                                          ssl->hostname, ssl->peer_port,
+                                          group);
+    }
+#endif /* MBEDTLS_X509_CRT_PARSE_C */
+
     return ret;
 }
 
@@ -542,9 +677,9 @@ static int ssl_tls13_parse_cookie_ext(mbedtls_ssl_context *ssl,
     MBEDTLS_SSL_CHK_BUF_READ_PTR(p, end, cookie_len);
     MBEDTLS_SSL_DEBUG_BUF(3, "cookie extension", p, cookie_len);
 
-    mbedtls_free(handshake->cookie);
+    mbedtls_ssl_hs_free(ssl, handshake->cookie);
     handshake->cookie_len = 0;
-    handshake->cookie = mbedtls_calloc(1, cookie_len);
+    handshake->cookie = mbedtls_ssl_hs_calloc(ssl, 1, cookie_len);
     if (handshake->cookie == NULL) {
         MBEDTLS_SSL_DEBUG_MSG(1,
                               ("alloc failed ( %ud bytes )",
@@ -2414,7 +2549,7 @@ static int ssl_tls13_parse_certificate_request(mbedtls_ssl_context *ssl,
                               p, certificate_request_context_len);
 
         handshake->certificate_request_context =
-            mbedtls_calloc(1, certificate_request_context_len);
+            mbedtls_ssl_hs_calloc(ssl, 1, certificate_request_context_len);
         if (handshake->certificate_request_context == NULL) {
             MBEDTLS_SSL_DEBUG_MSG(1, ("buffer too small"));
             return MBEDTLS_ERR_SSL_ALLOC_FAILED;
@@ -3040,6 +3175,9 @@ static int ssl_tls13_process_new_session_ticket(mbedtls_ssl_context *ssl)
              * be exported now and we signal the ticket to the application.
              */
             ssl->session->exported = 0;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+            mbedtls_ssl_store_session(ssl);
+#endif
             ret = MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET;
             break;
 
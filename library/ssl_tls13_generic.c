@@ -1351,6 +1351,10 @@ void mbedtls_ssl_tls13_handshake_wrapup(mbedtls_ssl_context *ssl)
     ssl->session = ssl->session_negotiate;
     ssl->session_negotiate = NULL;
 
+    /* The handshake traffic keys and other transient state are not needed
+     * any more */
+    mbedtls_ssl_handshake_arena_release(ssl);
+
     MBEDTLS_SSL_DEBUG_MSG(3, ("<= handshake wrapup"));
 }
 
@@ -1005,6 +1005,15 @@ int mbedtls_ssl_tls13_populate_transform(
     memcpy(transform->iv_enc, iv_enc, traffic_keys->iv_len);
     memcpy(transform->iv_dec, iv_dec, traffic_keys->iv_len);
 
+#if defined(MBEDTLS_SSL_KTLS)
+    if (traffic_keys->key_len <= sizeof(transform->key_enc)) {
+        transform->cipher_type = (mbedtls_cipher_type_t) ciphersuite_info->cipher;
+        transform->keylen = traffic_keys->key_len;
+        memcpy(transform->key_enc, key_enc, traffic_keys->key_len);
+        memcpy(transform->key_dec, key_dec, traffic_keys->key_len);
+    }
+#endif /* MBEDTLS_SSL_KTLS */
+
 #if !defined(MBEDTLS_USE_PSA_CRYPTO)
     if ((ret = mbedtls_cipher_setkey(&transform->cipher_ctx_enc,
                                      key_enc, (int) mbedtls_cipher_info_get_key_bitlen(cipher_info),
@@ -1245,7 +1254,8 @@ int mbedtls_ssl_tls13_compute_early_transform(mbedtls_ssl_context *ssl)
         goto cleanup;
     }
 
-    transform_earlydata = mbedtls_calloc(1, sizeof(mbedtls_ssl_transform));
+    transform_earlydata = mbedtls_ssl_hs_calloc(ssl, 1,
+                                                sizeof(mbedtls_ssl_transform));
     if (transform_earlydata == NULL) {
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
         goto cleanup;
@@ -1266,7 +1276,7 @@ int mbedtls_ssl_tls13_compute_early_transform(mbedtls_ssl_context *ssl)
 cleanup:
     mbedtls_platform_zeroize(&traffic_keys, sizeof(traffic_keys));
     if (ret != 0) {
-        mbedtls_free(transform_earlydata);
+        mbedtls_ssl_hs_free(ssl, transform_earlydata);
     }
 
     return ret;
@@ -1717,7 +1727,8 @@ int mbedtls_ssl_tls13_compute_handshake_transform(mbedtls_ssl_context *ssl)
         goto cleanup;
     }
 
-    transform_handshake = mbedtls_calloc(1, sizeof(mbedtls_ssl_transform));
+    transform_handshake = mbedtls_ssl_hs_calloc(ssl, 1,
+                                                sizeof(mbedtls_ssl_transform));
     if (transform_handshake == NULL) {
         ret = MBEDTLS_ERR_SSL_ALLOC_FAILED;
         goto cleanup;
@@ -1738,7 +1749,7 @@ int mbedtls_ssl_tls13_compute_handshake_transform(mbedtls_ssl_context *ssl)
 cleanup:
     mbedtls_platform_zeroize(&traffic_keys, sizeof(traffic_keys));
     if (ret != 0) {
-        mbedtls_free(transform_handshake);
+        mbedtls_ssl_hs_free(ssl, transform_handshake);
     }
 
     return ret;
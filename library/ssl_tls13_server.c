@@ -685,6 +685,17 @@ static int ssl_tls13_parse_pre_shared_key_ext(
 
 #if defined(MBEDTLS_SSL_SESSION_TICKETS)
         if (psk->type == MBEDTLS_SSL_TLS1_3_PSK_RESUMPTION) {
+#if defined(MBEDTLS_SSL_EARLY_DATA) && defined(MBEDTLS_HAVE_TIME)
+            /* Early data can only be accepted with the first identity. The
+             * binder identifies the ClientHello for the anti-replay check. */
+            if (identity_id == 0 && binder_len <= MBEDTLS_MD_MAX_SIZE) {
+                memcpy(ssl->handshake->early_data_binder, binder, binder_len);
+                ssl->handshake->early_data_binder_len = (uint8_t) binder_len;
+                ssl->handshake->early_data_expected_arrival =
+                    session.ticket_creation_time +
+                    (uint32_t) (obfuscated_ticket_age - session.ticket_age_add);
+            }
+#endif
             ret = ssl_tls13_session_copy_ticket(ssl->session_negotiate,
                                                 &session);
             mbedtls_ssl_session_free(&session);
@@ -1875,6 +1886,40 @@ static int ssl_tls13_check_early_data_requirements(mbedtls_ssl_context *ssl)
 }
 #endif /* MBEDTLS_SSL_EARLY_DATA */
 
+#if defined(MBEDTLS_SSL_EARLY_DATA) && defined(MBEDTLS_HAVE_TIME)
+/* RFC 8446 section 8: make sure that a ClientHello is not replayed to make
+ * the server process the same early data twice. This is done last, so that
+ * only the ClientHellos whose early data is accepted are recorded. */
+static int ssl_tls13_check_early_data_replay(mbedtls_ssl_context *ssl)
+{
+    mbedtls_ssl_handshake_params *handshake = ssl->handshake;
+    int ret;
+
+    if (ssl->conf->f_early_data_replay == NULL) {
+        return 0;
+    }
+
+    if (handshake->early_data_binder_len == 0) {
+        MBEDTLS_SSL_DEBUG_MSG(1, ("EarlyData: rejected, no binder to check "
+                                  "against replays."));
+        return -1;
+    }
+
+    ret = ssl->conf->f_early_data_replay(ssl->conf->p_early_data_replay,
+                                         handshake->early_data_binder,
+                                         handshake->early_data_binder_len,
+                                         handshake->early_data_expected_arrival);
+    if (ret != 0) {
+        MBEDTLS_SSL_DEBUG_RET(3, "f_early_data_replay", ret);
+        MBEDTLS_SSL_DEBUG_MSG(1, ("EarlyData: rejected, the ClientHello may be "
+                                  "a replay or is not fresh."));
+        return -1;
+    }
+
+    return 0;
+}
+#endif /* MBEDTLS_SSL_EARLY_DATA && MBEDTLS_HAVE_TIME */
+
 /* Update the handshake state machine */
 
 MBEDTLS_CHECK_RETURN_CRITICAL
@@ -1906,6 +1951,12 @@ static int ssl_tls13_postprocess_client_hello(mbedtls_ssl_context *ssl,
     if (ssl->handshake->received_extensions & MBEDTLS_SSL_EXT_MASK(EARLY_DATA)) {
         ssl->handshake->early_data_accepted =
             (!hrr_required) && (ssl_tls13_check_early_data_requirements(ssl) == 0);
+#if defined(MBEDTLS_HAVE_TIME)
+        if (ssl->handshake->early_data_accepted) {
+            ssl->handshake->early_data_accepted =
+                (ssl_tls13_check_early_data_replay(ssl) == 0);
+        }
+#endif
 
         if (ssl->handshake->early_data_accepted) {
             ret = mbedtls_ssl_tls13_compute_early_transform(ssl);
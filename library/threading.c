@@ -153,6 +153,9 @@ void mbedtls_threading_set_alt(void (*mutex_init)(mbedtls_threading_mutex_t *),
     mbedtls_mutex_init(&mbedtls_threading_psa_globaldata_mutex);
     mbedtls_mutex_init(&mbedtls_threading_psa_rngdata_mutex);
 #endif
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+    mbedtls_mutex_init(&mbedtls_threading_ffdhe_mutex);
+#endif
 }
 
 /*
@@ -171,6 +174,9 @@ void mbedtls_threading_free_alt(void)
     mbedtls_mutex_free(&mbedtls_threading_psa_globaldata_mutex);
     mbedtls_mutex_free(&mbedtls_threading_psa_rngdata_mutex);
 #endif
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+    mbedtls_mutex_free(&mbedtls_threading_ffdhe_mutex);
+#endif
 }
 #endif /* MBEDTLS_THREADING_ALT */
 
@@ -191,5 +197,8 @@ mbedtls_threading_mutex_t mbedtls_threading_key_slot_mutex MUTEX_INIT;
 mbedtls_threading_mutex_t mbedtls_threading_psa_globaldata_mutex MUTEX_INIT;
 mbedtls_threading_mutex_t mbedtls_threading_psa_rngdata_mutex MUTEX_INIT;
 #endif
+#if defined(MBEDTLS_FFDHE_FIXED_BASE)
+mbedtls_threading_mutex_t mbedtls_threading_ffdhe_mutex MUTEX_INIT;
+#endif
 
 #endif /* MBEDTLS_THREADING_C */
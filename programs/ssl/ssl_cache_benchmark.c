@@ -0,0 +1,320 @@
+/*
+ *  Session cache benchmark: compares the list-based cache of ssl_cache.h
+ *  with the hash-indexed cache of ssl_cache_hash.h
+ *
+ *  Copyright The Mbed TLS Contributors
+ *  SPDX-License-Identifier: Apache-2.0 OR GPL-2.0-or-later
+ */
+
+#include "mbedtls/build_info.h"
+
+#include "mbedtls/platform.h"
+
+#if !defined(MBEDTLS_SSL_CACHE_C) || !defined(MBEDTLS_SSL_CACHE_HASH_C) || \
+    !defined(MBEDTLS_SSL_PROTO_TLS1_2) || !defined(MBEDTLS_TIMING_C)
+int main(void)
+{
+    mbedtls_printf("MBEDTLS_SSL_CACHE_C and/or MBEDTLS_SSL_CACHE_HASH_C "
+                   "and/or MBEDTLS_SSL_PROTO_TLS1_2 and/or MBEDTLS_TIMING_C "
+                   "not defined.\n");
+    mbedtls_exit(0);
+}
+#else
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_cache_hash.h"
+#include "mbedtls/timing.h"
+#include "mbedtls/error.h"
+
+#if defined(MBEDTLS_THREADING_PTHREAD)
+#include <pthread.h>
+#endif
+
+#define DFL_ENTRIES             10000
+#define DFL_STRIPES             0
+#define DFL_LOOKUPS             100000
+#define DFL_THREADS             4
+
+#define USAGE \
+    "\n usage: ssl_cache_benchmark param=<>...\n"                   \
+    "\n acceptable parameters:\n"                                   \
+    "    entries=%%d         default: 10000 (cached sessions)\n"    \
+    "    stripes=%%d         default: 0 (hash cache default)\n"     \
+    "    lookups=%%d         default: 100000 (per thread)\n"        \
+    "    threads=%%d         default: 4 (with MBEDTLS_THREADING_PTHREAD)\n" \
+    "\n"
+
+#define HEADER_FORMAT   "  %-36s :  "
+
+typedef int (*cache_get_t)(void *, unsigned char const *, size_t,
+                           mbedtls_ssl_session *);
+typedef int (*cache_set_t)(void *, unsigned char const *, size_t,
+                           const mbedtls_ssl_session *);
+
+static struct options {
+    int entries;
+    int stripes;
+    int lookups;
+    int threads;
+} opt;
+
+typedef struct {
+    void *cache;
+    cache_get_t f_get;
+    unsigned seed;
+    unsigned long misses;
+    int ret;
+} lookup_job;
+
+static void make_id(unsigned char id[32], unsigned i)
+{
+    /* Spread the IDs like random ones, which server session IDs are */
+    unsigned x = i * 2654435761u;
+
+    memset(id, 0x5A, 32);
+    id[0] = (unsigned char) (x >> 24);
+    id[1] = (unsigned char) (x >> 16);
+    id[2] = (unsigned char) (x >> 8);
+    id[3] = (unsigned char) x;
+    id[28] = (unsigned char) (i >> 24);
+    id[29] = (unsigned char) (i >> 16);
+    id[30] = (unsigned char) (i >> 8);
+    id[31] = (unsigned char) i;
+}
+
+static int fill(void *cache, cache_set_t f_set, mbedtls_ssl_session *session)
+{
+    unsigned char id[32];
+    int i, ret;
+
+    for (i = 0; i < opt.entries; i++) {
+        make_id(id, (unsigned) i);
+        if ((ret = f_set(cache, id, sizeof(id), session)) != 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+static void *lookups(void *arg)
+{
+    lookup_job *job = (lookup_job *) arg;
+    mbedtls_ssl_session session;
+    unsigned char id[32];
+    unsigned x = job->seed;
+    int i;
+
+    job->misses = 0;
+    job->ret = 0;
+    for (i = 0; i < opt.lookups && job->ret == 0; i++) {
+        x = x * 1103515245u + 12345u;
+        make_id(id, (x >> 8) % (unsigned) opt.entries);
+
+        mbedtls_ssl_session_init(&session);
+        job->ret = job->f_get(job->cache, id, sizeof(id), &session);
+        mbedtls_ssl_session_free(&session);
+
+        /* The hash cache limits each stripe separately, so a few sessions
+         * may have been evicted before the cache was full. */
+        if (job->ret == MBEDTLS_ERR_SSL_CACHE_ENTRY_NOT_FOUND) {
+            job->misses++;
+            job->ret = 0;
+        }
+    }
+
+    return NULL;
+}
+
+static unsigned long per_second(unsigned long ops, unsigned long ms)
+{
+    return ms == 0 ? ops * 1000 : ops * 1000 / ms;
+}
+
+static int run(const char *name, void *cache,
+               cache_get_t f_get, cache_set_t f_set,
+               mbedtls_ssl_session *session)
+{
+    struct mbedtls_timing_hr_time timer;
+    lookup_job job;
+    unsigned long ms;
+    char title[64];
+    int ret;
+
+    mbedtls_snprintf(title, sizeof(title), "%s, store", name);
+    mbedtls_printf(HEADER_FORMAT, title);
+    fflush(stdout);
+    (void) mbedtls_timing_get_timer(&timer, 1);
+    if ((ret = fill(cache, f_set, session)) != 0) {
+        return ret;
+    }
+    ms = mbedtls_timing_get_timer(&timer, 0);
+    mbedtls_printf("%9lu sessions/s\n", per_second((unsigned long) opt.entries, ms));
+
+    mbedtls_snprintf(title, sizeof(title), "%s, lookup", name);
+    mbedtls_printf(HEADER_FORMAT, title);
+    fflush(stdout);
+    job.cache = cache;
+    job.f_get = f_get;
+    job.seed = 1;
+    (void) mbedtls_timing_get_timer(&timer, 1);
+    lookups(&job);
+    if (job.ret != 0) {
+        return job.ret;
+    }
+    ms = mbedtls_timing_get_timer(&timer, 0);
+    mbedtls_printf("%9lu lookups/s, %lu misses\n",
+                   per_second((unsigned long) opt.lookups, ms), job.misses);
+
+#if defined(MBEDTLS_THREADING_PTHREAD)
+    if (opt.threads > 1) {
+        pthread_t *tids = mbedtls_calloc((size_t) opt.threads, sizeof(pthread_t));
+        lookup_job *jobs = mbedtls_calloc((size_t) opt.threads, sizeof(lookup_job));
+        int i, started;
+
+        if (tids == NULL || jobs == NULL) {
+            mbedtls_free(tids);
+            mbedtls_free(jobs);
+            return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+        }
+
+        mbedtls_snprintf(title, sizeof(title), "%s, lookup, %d threads",
+                         name, opt.threads);
+        mbedtls_printf(HEADER_FORMAT, title);
+        fflush(stdout);
+        (void) mbedtls_timing_get_timer(&timer, 1);
+        for (started = 0; started < opt.threads; started++) {
+            jobs[started].cache = cache;
+            jobs[started].f_get = f_get;
+            jobs[started].seed = (unsigned) started + 1;
+            if (pthread_create(&tids[started], NULL, lookups,
+                               &jobs[started]) != 0) {
+                ret = MBEDTLS_ERR_THREADING_MUTEX_ERROR;
+                break;
+            }
+        }
+        for (i = 0; i < started; i++) {
+            pthread_join(tids[i], NULL);
+            if (jobs[i].ret != 0) {
+                ret = jobs[i].ret;
+            }
+        }
+        ms = mbedtls_timing_get_timer(&timer, 0);
+        if (ret == 0) {
+            mbedtls_printf("%9lu lookups/s\n",
+                           per_second((unsigned long) opt.lookups *
+                                      (unsigned long) opt.threads, ms));
+        }
+
+        mbedtls_free(tids);
+        mbedtls_free(jobs);
+    }
+#endif /* MBEDTLS_THREADING_PTHREAD */
+
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    int ret = 1, i;
+    int exit_code = MBEDTLS_EXIT_FAILURE;
+    char *p, *q;
+    mbedtls_ssl_session session;
+    mbedtls_ssl_cache_context cache;
+    mbedtls_ssl_cache_hash_context hash_cache;
+
+    mbedtls_ssl_session_init(&session);
+    mbedtls_ssl_cache_init(&cache);
+    mbedtls_ssl_cache_hash_init(&hash_cache);
+
+    opt.entries = DFL_ENTRIES;
+    opt.stripes = DFL_STRIPES;
+    opt.lookups = DFL_LOOKUPS;
+    opt.threads = DFL_THREADS;
+
+    for (i = 1; i < argc; i++) {
+        p = argv[i];
+        if ((q = strchr(p, '=')) == NULL) {
+            goto usage;
+        }
+        *q++ = '\0';
+
+        if (strcmp(p, "entries") == 0) {
+            opt.entries = atoi(q);
+            if (opt.entries < 1) {
+                goto usage;
+            }
+        } else if (strcmp(p, "stripes") == 0) {
+            opt.stripes = atoi(q);
+            if (opt.stripes < 0) {
+                goto usage;
+            }
+        } else if (strcmp(p, "lookups") == 0) {
+            opt.lookups = atoi(q);
+            if (opt.lookups < 1) {
+                goto usage;
+            }
+        } else if (strcmp(p, "threads") == 0) {
+            opt.threads = atoi(q);
+            if (opt.threads < 1) {
+                goto usage;
+            }
+        } else {
+            goto usage;
+        }
+    }
+
+    /* A typical TLS 1.2 session without the peer certificate */
+    session.MBEDTLS_PRIVATE(tls_version) = MBEDTLS_SSL_VERSION_TLS1_2;
+    session.MBEDTLS_PRIVATE(endpoint) = MBEDTLS_SSL_IS_SERVER;
+    session.MBEDTLS_PRIVATE(ciphersuite) = 0xC02F;
+    session.MBEDTLS_PRIVATE(id_len) = 32;
+    memset(session.MBEDTLS_PRIVATE(master), 0x17,
+           sizeof(session.MBEDTLS_PRIVATE(master)));
+
+    mbedtls_ssl_cache_set_max_entries(&cache, opt.entries);
+    if ((ret = mbedtls_ssl_cache_hash_setup(&hash_cache, (size_t) opt.entries,
+                                            (size_t) opt.stripes)) != 0) {
+        goto exit;
+    }
+
+    mbedtls_printf("\n  %d cached sessions\n\n", opt.entries);
+
+    ret = run("ssl_cache (list)", &cache,
+              mbedtls_ssl_cache_get, mbedtls_ssl_cache_set, &session);
+    if (ret != 0) {
+        goto exit;
+    }
+
+    ret = run("ssl_cache_hash", &hash_cache,
+              mbedtls_ssl_cache_hash_get, mbedtls_ssl_cache_hash_set, &session);
+    if (ret != 0) {
+        goto exit;
+    }
+
+    mbedtls_printf("\n");
+    exit_code = MBEDTLS_EXIT_SUCCESS;
+    goto exit;
+
+usage:
+    mbedtls_printf(USAGE);
+    ret = 0;
+
+exit:
+    if (ret != 0) {
+        mbedtls_printf("FAILED: -0x%04x\n", (unsigned int) -ret);
+    }
+
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_cache_free(&cache);
+    mbedtls_ssl_cache_hash_free(&hash_cache);
+
+    mbedtls_exit(exit_code);
+}
+
+#endif /* MBEDTLS_SSL_CACHE_C && MBEDTLS_SSL_CACHE_HASH_C &&
+          MBEDTLS_SSL_PROTO_TLS1_2 && MBEDTLS_TIMING_C */
@@ -61,6 +61,8 @@ int main(void)
 #define CONTEXT_CONFIG_DTLS_BADMAC_LIMIT_BIT     (1 << 1)
 #define CONTEXT_CONFIG_DTLS_ANTI_REPLAY_BIT      (1 << 2)
 #define CONTEXT_CONFIG_ALPN_BIT                  (1 << 3)
+#define CONTEXT_CONFIG_DTLS_REPLAY_WINDOW_SHIFT  4
+#define CONTEXT_CONFIG_DTLS_REPLAY_WINDOW_MASK   0x3F
 
 #define TRANSFORM_RANDBYTE_LEN  64
 
@@ -736,7 +738,8 @@ void print_deserialized_ssl_session(const uint8_t *ssl, uint32_t len,
  *  // fields from ssl_context
  *  uint32 badmac_seen;         // DTLS: number of records with failing MAC
  *  uint64 in_window_top;       // DTLS: last validated record seq_num
- *  uint64 in_window;           // DTLS: bitmask for replay protection
+ *  uint64 in_window[n];        // DTLS: bitmask for replay protection,
+ *                              // n = configuration bits 4-9 plus 1
  *  uint8 disable_datagram_packing; // DTLS: only one record per datagram
  *  uint64 cur_out_ctr;         // Record layer: outgoing sequence number
  *  uint16 mtu;                 // DTLS: path mtu (max outgoing fragment size)
@@ -752,6 +755,7 @@ void print_deserialized_ssl_context(const uint8_t *ssl, size_t len)
     uint32_t session_len;
     int session_cfg_flag;
     int context_cfg_flag;
+    size_t window_words;
 
     printf("\nMbed TLS version:\n");
 
@@ -859,10 +863,12 @@ void print_deserialized_ssl_context(const uint8_t *ssl, size_t len)
         ssl += 8;
 
         /* value 'in_window' from mbedtls_ssl_context */
+        window_words = ((context_cfg_flag >> CONTEXT_CONFIG_DTLS_REPLAY_WINDOW_SHIFT) &
+                        CONTEXT_CONFIG_DTLS_REPLAY_WINDOW_MASK) + 1;
         printf("\tbitmask for replay detection       : ");
-        CHECK_SSL_END(8);
-        print_hex(ssl, 8, 20, "");
-        ssl += 8;
+        CHECK_SSL_END(8 * window_words);
+        print_hex(ssl, 8 * window_words, 8, "\t                                     ");
+        ssl += 8 * window_words;
     }
 
     if (conf_dtls_proto) {
@@ -44,6 +44,10 @@ int main(void)
 #include "mbedtls/net_sockets.h"
 #include "mbedtls/timing.h"
 
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+#include "mbedtls/ssl_cache_shm.h"
+#endif
+
 #include <string.h>
 #include <signal.h>
 
@@ -83,6 +87,9 @@ int main(void)
     mbedtls_ssl_config conf;
     mbedtls_x509_crt srvcert;
     mbedtls_pk_context pkey;
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    mbedtls_ssl_cache_shm_context cache;
+#endif
 
     mbedtls_net_init(&listen_fd);
     mbedtls_net_init(&client_fd);
@@ -92,6 +99,9 @@ int main(void)
     mbedtls_pk_init(&pkey);
     mbedtls_x509_crt_init(&srvcert);
     mbedtls_ctr_drbg_init(&ctr_drbg);
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    mbedtls_ssl_cache_shm_init(&cache);
+#endif
 
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
     psa_status_t status = psa_crypto_init();
@@ -177,6 +187,19 @@ int main(void)
         goto exit;
     }
 
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    /* Set up the cache before forking, so that all the children share it
+     * and can resume the sessions established by the others. */
+    if ((ret = mbedtls_ssl_cache_shm_setup(&cache, NULL, 1000)) != 0) {
+        mbedtls_printf(" failed!  mbedtls_ssl_cache_shm_setup returned %d\n\n", ret);
+        goto exit;
+    }
+
+    mbedtls_ssl_conf_session_cache(&conf, &cache,
+                                   mbedtls_ssl_cache_shm_get,
+                                   mbedtls_ssl_cache_shm_set);
+#endif
+
     mbedtls_printf(" ok\n");
 
     /*
@@ -369,6 +392,9 @@ exit:
     mbedtls_ssl_config_free(&conf);
     mbedtls_ctr_drbg_free(&ctr_drbg);
     mbedtls_entropy_free(&entropy);
+#if defined(MBEDTLS_SSL_CACHE_SHM_C)
+    mbedtls_ssl_cache_shm_free(&cache);
+#endif
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
     mbedtls_psa_crypto_free();
 #endif /* MBEDTLS_USE_PSA_CRYPTO */
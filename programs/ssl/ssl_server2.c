@@ -137,6 +137,7 @@ int main(void)
 #define DFL_EXTENDED_MS         -1
 #define DFL_ETM                 -1
 #define DFL_SERIALIZE           0
+#define DFL_KTLS                0
 #define DFL_CONTEXT_FILE        ""
 #define DFL_EXTENDED_MS_ENFORCE -1
 #define DFL_CA_CALLBACK         0
@@ -476,6 +477,16 @@ int main(void)
 #define USAGE_SERIALIZATION ""
 #endif
 
+#if defined(MBEDTLS_SSL_KTLS)
+#define USAGE_KTLS \
+    "    ktls=%%d             default: 0 (disabled)\n"                         \
+    "                        options: 1 (hand record protection over to the\n" \
+    "                                    kernel after the handshake, if\n"     \
+    "                                    available)\n"
+#else
+#define USAGE_KTLS ""
+#endif
+
 #define USAGE_KEY_OPAQUE_ALGS \
     "    key_opaque_algs=%%s  Allowed opaque key 1 algorithms.\n"                      \
     "                        comma-separated pair of values among the following:\n"    \
@@ -583,6 +594,7 @@ int main(void)
     "                                otherwise. The expansion of the macro\n" \
     "                                is printed if it is defined\n"           \
     USAGE_SERIALIZATION                                                       \
+    USAGE_KTLS                                                                \
     "\n"
 
 #define PUT_UINT64_BE(out_be, in_le, i)                                   \
@@ -690,6 +702,7 @@ struct options {
                                  * during renegotiation                     */
     const char *cid_val;        /* the CID to use for incoming messages     */
     int serialize;              /* serialize/deserialize connection         */
+    int ktls;                   /* hand records over to the kernel          */
     const char *context_file;   /* the file to write a serialized connection
                                  * in the form of base64 code (serialize
                                  * option must be set)                      */
@@ -1765,6 +1778,7 @@ int main(int argc, char *argv[])
     opt.extended_ms         = DFL_EXTENDED_MS;
     opt.etm                 = DFL_ETM;
     opt.serialize           = DFL_SERIALIZE;
+    opt.ktls                = DFL_KTLS;
     opt.context_file        = DFL_CONTEXT_FILE;
     opt.eap_tls             = DFL_EAP_TLS;
     opt.reproducible        = DFL_REPRODUCIBLE;
@@ -2263,6 +2277,11 @@ usage:
             }
         } else if (strcmp(p, "context_file") == 0) {
             opt.context_file = q;
+        } else if (strcmp(p, "ktls") == 0) {
+            opt.ktls = atoi(q);
+            if (opt.ktls < 0 || opt.ktls > 1) {
+                goto usage;
+            }
         } else if (strcmp(p, "eap_tls") == 0) {
             opt.eap_tls = atoi(q);
             if (opt.eap_tls < 0 || opt.eap_tls > 1) {
@@ -3713,6 +3732,27 @@ handshake:
                    (unsigned long) current_heap_memory, (unsigned long) peak_heap_memory);
 #endif  /* MBEDTLS_MEMORY_DEBUG */
 
+#if defined(MBEDTLS_SSL_KTLS)
+    if (opt.ktls != 0) {
+        mbedtls_printf("  . Handing record protection over to the kernel...");
+        fflush(stdout);
+
+        ret = mbedtls_net_ktls_enable(&client_fd, &ssl,
+                                      MBEDTLS_SSL_KTLS_TX | MBEDTLS_SSL_KTLS_RX);
+        if (ret == MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE) {
+            mbedtls_printf(" not available\n");
+        } else if (ret < 0) {
+            mbedtls_printf(" failed\n  ! mbedtls_net_ktls_enable returned -0x%x\n\n",
+                           (unsigned int) -ret);
+            goto reset;
+        } else {
+            mbedtls_printf(" ok [%s%s ]\n",
+                           (ret & MBEDTLS_SSL_KTLS_TX) ? " tx" : "",
+                           (ret & MBEDTLS_SSL_KTLS_RX) ? " rx" : "");
+        }
+    }
+#endif /* MBEDTLS_SSL_KTLS */
+
     if (opt.exchanges == 0) {
         goto close_notify;
     }
@@ -267,6 +267,10 @@ EXCLUDE_FROM_BAREMETAL = frozenset([
     'MBEDTLS_PSA_CRYPTO_SE_C', # requires a filesystem and PSA_CRYPTO_STORAGE_C
     'MBEDTLS_PSA_CRYPTO_STORAGE_C', # requires a filesystem
     'MBEDTLS_PSA_ITS_FILE_C', # requires a filesystem
+    'MBEDTLS_SSL_CACHE_SHM_C', # requires mmap and process-shared mutexes
+    'MBEDTLS_SSL_DTLS_MUX_C', # requires a clock
+    'MBEDTLS_SSL_EARLY_DATA_REPLAY_C', # requires a clock
+    'MBEDTLS_SSL_SESSION_STORE_C', # requires a clock
     'MBEDTLS_THREADING_C', # requires a threading interface
     'MBEDTLS_THREADING_PTHREAD', # requires pthread
     'MBEDTLS_TIMING_C', # requires a clock
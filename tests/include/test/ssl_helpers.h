@@ -31,6 +31,10 @@
 #include "mbedtls/ssl_cache.h"
 #endif
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+#include "mbedtls/ssl_buffer_pool.h"
+#endif
+
 #if defined(MBEDTLS_USE_PSA_CRYPTO)
 #define PSA_TO_MBEDTLS_ERR(status) PSA_TO_MBEDTLS_ERR_LIST(status, \
                                                            psa_to_ssl_errors, \
@@ -122,6 +126,12 @@ typedef struct mbedtls_test_handshake_test_options {
 #if defined(MBEDTLS_SSL_CACHE_C)
     mbedtls_ssl_cache_context *cache;
 #endif
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    mbedtls_ssl_buffer_pool *buffer_pool;
+#endif
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+    size_t hs_arena_size;
+#endif
 #if defined(MBEDTLS_SSL_ALPN)
     const char *alpn_list[MBEDTLS_TEST_MAX_ALPN_LIST_SIZE];
 #endif
@@ -959,6 +959,11 @@ helper_disable_builtin_curves() {
     for curve in $allowed_list; do
         scripts/config.py set $curve
     done
+
+    case " $allowed_list " in
+        *" MBEDTLS_ECP_DP_CURVE448_ENABLED "*) ;;
+        *) scripts/config.py unset MBEDTLS_ECP_CURVE448_OPTIM;;
+    esac
 }
 
 # Helper returning the list of supported elliptic curves from CRYPTO_CONFIG_H,
@@ -1456,6 +1461,8 @@ component_test_no_ctr_drbg_classic () {
     scripts/config.py unset MBEDTLS_CTR_DRBG_C
     scripts/config.py unset MBEDTLS_USE_PSA_CRYPTO
     scripts/config.py unset MBEDTLS_SSL_PROTO_TLS1_3
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C # requires MBEDTLS_SSL_EARLY_DATA
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C # requires MBEDTLS_SSL_PROTO_TLS1_3
 
     CC=$ASAN_CC cmake -D CMAKE_BUILD_TYPE:String=Asan .
     make
@@ -1502,6 +1509,8 @@ component_test_no_hmac_drbg_classic () {
     scripts/config.py unset MBEDTLS_ECDSA_DETERMINISTIC # requires HMAC_DRBG
     scripts/config.py unset MBEDTLS_USE_PSA_CRYPTO
     scripts/config.py unset MBEDTLS_SSL_PROTO_TLS1_3
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C # requires MBEDTLS_SSL_EARLY_DATA
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C # requires MBEDTLS_SSL_PROTO_TLS1_3
 
     CC=$ASAN_CC cmake -D CMAKE_BUILD_TYPE:String=Asan .
     make
@@ -1555,6 +1564,8 @@ component_test_psa_external_rng_no_drbg_classic () {
     scripts/config.py full
     scripts/config.py unset MBEDTLS_USE_PSA_CRYPTO
     scripts/config.py unset MBEDTLS_SSL_PROTO_TLS1_3
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C # requires MBEDTLS_SSL_EARLY_DATA
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C # requires MBEDTLS_SSL_PROTO_TLS1_3
     scripts/config.py set MBEDTLS_PSA_CRYPTO_EXTERNAL_RNG
     scripts/config.py unset MBEDTLS_ENTROPY_C
     scripts/config.py unset MBEDTLS_ENTROPY_NV_SEED
@@ -1692,6 +1703,10 @@ component_test_full_no_cipher_no_psa_crypto () {
     scripts/config.py unset MBEDTLS_PSA_CRYPTO_CLIENT
     scripts/config.py unset MBEDTLS_SSL_TLS_C
     scripts/config.py unset MBEDTLS_SSL_TICKET_C
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C
+    scripts/config.py unset MBEDTLS_SSL_SESSION_STORE_C
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C
+    scripts/config.py unset MBEDTLS_SSL_DTLS_MUX_C
     # Disable features that depend on PSA_CRYPTO_C
     scripts/config.py unset MBEDTLS_PSA_CRYPTO_SE_C
     scripts/config.py unset MBEDTLS_PSA_CRYPTO_STORAGE_C
@@ -1861,6 +1876,8 @@ component_test_full_no_bignum () {
     scripts/config.py unset MBEDTLS_SSL_SERVER_NAME_INDICATION
     scripts/config.py unset MBEDTLS_SSL_ASYNC_PRIVATE
     scripts/config.py unset MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK
+    scripts/config.py unset MBEDTLS_SSL_SESSION_STORE_C
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C
 
     make
 
@@ -2100,6 +2117,7 @@ component_test_everest_curve25519_only () {
     # Disable all curves
     scripts/config.py unset-all "MBEDTLS_ECP_DP_[0-9A-Z_a-z]*_ENABLED"
     scripts/config.py set MBEDTLS_ECP_DP_CURVE25519_ENABLED
+    scripts/config.py unset MBEDTLS_ECP_CURVE448_OPTIM
 
     make CC=$ASAN_CC CFLAGS="$ASAN_CFLAGS" LDFLAGS="$ASAN_CFLAGS"
 
@@ -2149,6 +2167,16 @@ component_test_small_mbedtls_ssl_dtls_max_buffering () {
     tests/ssl-opt.sh -f "DTLS reordering: Buffer encrypted Finished message, drop for fragmented NewSessionTicket"
 }
 
+component_test_large_ssl_dtls_replay_window () {
+    msg "build: large MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX (ASan build)"
+    scripts/config.py set MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX 4096
+    CC=$ASAN_CC cmake -D CMAKE_BUILD_TYPE:String=Asan .
+    make
+
+    msg "test: large MBEDTLS_SSL_DTLS_REPLAY_WINDOW_MAX - test_suite_ssl"
+    cd tests; ./test_suite_ssl; cd ..
+}
+
 component_test_psa_collect_statuses () {
   msg "build+test: psa_collect_statuses" # ~30s
   scripts/config.py full
@@ -2568,6 +2596,7 @@ component_build_module_alt () {
     scripts/config.py unset MBEDTLS_ECP_RESTARTABLE
     # You can only have one threading implementation: alt or pthread, not both.
     scripts/config.py unset MBEDTLS_THREADING_PTHREAD
+    scripts/config.py unset MBEDTLS_SSL_CACHE_SHM_C # requires MBEDTLS_THREADING_PTHREAD
     # The SpecifiedECDomain parsing code accesses mbedtls_ecp_group fields
     # directly and assumes the implementation works with partial groups.
     scripts/config.py unset MBEDTLS_PK_PARSE_EC_EXTENDED
@@ -2607,6 +2636,8 @@ component_test_no_psa_crypto_full_cmake_asan() {
     scripts/config.py unset MBEDTLS_PSA_CRYPTO_CLIENT
     scripts/config.py unset MBEDTLS_USE_PSA_CRYPTO
     scripts/config.py unset MBEDTLS_SSL_PROTO_TLS1_3
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C # requires MBEDTLS_SSL_EARLY_DATA
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C # requires MBEDTLS_SSL_PROTO_TLS1_3
     scripts/config.py unset MBEDTLS_PSA_ITS_FILE_C
     scripts/config.py unset MBEDTLS_PSA_CRYPTO_SE_C
     scripts/config.py unset MBEDTLS_PSA_CRYPTO_STORAGE_C
@@ -3507,7 +3538,9 @@ component_full_without_ecdhe_ecdsa () {
 
 component_full_without_ecdhe_ecdsa_and_tls13 () {
     build_full_minus_something_and_test_tls "MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
-                                             MBEDTLS_SSL_PROTO_TLS1_3"
+                                             MBEDTLS_SSL_PROTO_TLS1_3
+                                             MBEDTLS_SSL_EARLY_DATA_REPLAY_C
+                                             MBEDTLS_SSL_KEY_SHARE_CACHE_C"
 }
 
 # This is an helper used by:
@@ -3526,6 +3559,8 @@ build_and_test_psa_want_key_pair_partial() {
     scripts/config.py full
     scripts/config.py unset MBEDTLS_USE_PSA_CRYPTO
     scripts/config.py unset MBEDTLS_SSL_PROTO_TLS1_3
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C # requires MBEDTLS_SSL_EARLY_DATA
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C # requires MBEDTLS_SSL_PROTO_TLS1_3
 
     # All the PSA_WANT_KEY_TYPE_xxx_KEY_PAIR_yyy are enabled by default in
     # crypto_config.h so we just disable the one we don't want.
@@ -4350,6 +4385,8 @@ component_build_no_ssl_srv () {
     msg "build: full config except SSL server, make, gcc" # ~ 30s
     scripts/config.py full
     scripts/config.py unset MBEDTLS_SSL_SRV_C
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C
+    scripts/config.py unset MBEDTLS_SSL_DTLS_MUX_C
     make CC=gcc CFLAGS='-Werror -Wall -Wextra -O1'
 }
 
@@ -4357,6 +4394,8 @@ component_build_no_ssl_cli () {
     msg "build: full config except SSL client, make, gcc" # ~ 30s
     scripts/config.py full
     scripts/config.py unset MBEDTLS_SSL_CLI_C
+    scripts/config.py unset MBEDTLS_SSL_SESSION_STORE_C
+    scripts/config.py unset MBEDTLS_SSL_KEY_SHARE_CACHE_C
     make CC=gcc CFLAGS='-Werror -Wall -Wextra -O1'
 }
 
@@ -4518,6 +4557,16 @@ component_test_no_date_time () {
     make test
 }
 
+component_test_session_store () {
+    msg "build: default config with MBEDTLS_SSL_SESSION_STORE_C"
+    scripts/config.py set MBEDTLS_SSL_SESSION_STORE_C
+    cmake -D CMAKE_BUILD_TYPE:String=Check .
+    make
+
+    msg "test: MBEDTLS_SSL_SESSION_STORE_C - main suites"
+    make test
+}
+
 component_test_platform_calloc_macro () {
     msg "build: MBEDTLS_PLATFORM_{CALLOC/FREE}_MACRO enabled (ASan build)"
     scripts/config.py set MBEDTLS_PLATFORM_MEMORY
@@ -5811,6 +5860,7 @@ component_test_full_minus_session_tickets() {
     scripts/config.py full
     scripts/config.py unset MBEDTLS_SSL_SESSION_TICKETS
     scripts/config.py unset MBEDTLS_SSL_EARLY_DATA
+    scripts/config.py unset MBEDTLS_SSL_EARLY_DATA_REPLAY_C
     CC=gcc cmake -D CMAKE_BUILD_TYPE:String=Asan .
     make
     msg "test: full config without session tickets"
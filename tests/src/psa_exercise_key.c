@@ -855,8 +855,10 @@ int mbedtls_test_psa_exported_key_sanity_check(
         uint8_t *p = (uint8_t *) exported;
         const uint8_t *end = exported + exported_length;
         size_t len;
+        int version = 0;
+        size_t min_prime_bits = bits / 2;
         /*   RSAPrivateKey ::= SEQUENCE {
-         *       version             INTEGER,  -- must be 0
+         *       version             INTEGER,  -- 0, or 1 for multi-prime
          *       modulus             INTEGER,  -- n
          *       publicExponent      INTEGER,  -- e
          *       privateExponent     INTEGER,  -- d
@@ -865,15 +867,23 @@ int mbedtls_test_psa_exported_key_sanity_check(
          *       exponent1           INTEGER,  -- d mod (p-1)
          *       exponent2           INTEGER,  -- d mod (q-1)
          *       coefficient         INTEGER,  -- (inverse of q) mod p
+         *       otherPrimeInfos     OtherPrimeInfos OPTIONAL
          *   }
          */
         TEST_EQUAL(mbedtls_asn1_get_tag(&p, end, &len,
                                         MBEDTLS_ASN1_SEQUENCE |
                                         MBEDTLS_ASN1_CONSTRUCTED), 0);
         TEST_EQUAL(len, end - p);
-        if (!mbedtls_test_asn1_skip_integer(&p, end, 0, 0, 0)) {
-            goto exit;
+        TEST_EQUAL(mbedtls_asn1_get_int(&p, end, &version), 0);
+#if defined(MBEDTLS_RSA_MULTI_PRIME)
+        /* The primes of a multi-prime key are smaller than half of n. */
+        TEST_ASSERT(version == 0 || version == 1);
+        if (version == 1) {
+            min_prime_bits = 1;
         }
+#else
+        TEST_EQUAL(version, 0);
+#endif
         if (!mbedtls_test_asn1_skip_integer(&p, end, bits, bits, 1)) {
             goto exit;
         }
@@ -885,10 +895,10 @@ int mbedtls_test_psa_exported_key_sanity_check(
             goto exit;
         }
         /* Require p and q to be at most half the size of n, rounded up. */
-        if (!mbedtls_test_asn1_skip_integer(&p, end, bits / 2, bits / 2 + 1, 1)) {
+        if (!mbedtls_test_asn1_skip_integer(&p, end, min_prime_bits, bits / 2 + 1, 1)) {
             goto exit;
         }
-        if (!mbedtls_test_asn1_skip_integer(&p, end, bits / 2, bits / 2 + 1, 1)) {
+        if (!mbedtls_test_asn1_skip_integer(&p, end, min_prime_bits, bits / 2 + 1, 1)) {
             goto exit;
         }
         if (!mbedtls_test_asn1_skip_integer(&p, end, 1, bits / 2 + 1, 0)) {
@@ -900,6 +910,12 @@ int mbedtls_test_psa_exported_key_sanity_check(
         if (!mbedtls_test_asn1_skip_integer(&p, end, 1, bits / 2 + 1, 0)) {
             goto exit;
         }
+        if (version == 1) {
+            TEST_EQUAL(mbedtls_asn1_get_tag(&p, end, &len,
+                                            MBEDTLS_ASN1_SEQUENCE |
+                                            MBEDTLS_ASN1_CONSTRUCTED), 0);
+            p += len;
+        }
         TEST_EQUAL(p - end, 0);
 
         TEST_ASSERT(exported_length <= PSA_EXPORT_KEY_PAIR_MAX_SIZE);
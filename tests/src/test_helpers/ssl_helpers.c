@@ -849,6 +849,16 @@ int mbedtls_test_ssl_endpoint_init(
     }
 #endif
 
+#if defined(MBEDTLS_SSL_BUFFER_POOL_C)
+    if (options->buffer_pool != NULL) {
+        mbedtls_ssl_conf_buffer_pool(&(ep->conf), options->buffer_pool);
+    }
+#endif
+
+#if defined(MBEDTLS_SSL_HANDSHAKE_ARENA)
+    mbedtls_ssl_conf_handshake_arena(&(ep->conf), options->hs_arena_size);
+#endif
+
     ret = mbedtls_ssl_setup(&(ep->ssl), &(ep->conf));
     TEST_ASSERT(ret == 0);
 